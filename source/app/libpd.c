@@ -12,6 +12,12 @@
 #include "libpd.h"
 #include "webpa_adapter.h"
 #include "webpa_rbus.h"
+#include "webpa_outbox.h"
+#include "webpa_notify_retry.h"
+#include "webpa_notify_metrics.h"
+#include "webpa_request_queue.h"
+#include "webpa_response_format.h"
+#include "webpa_compression.h"
 #ifdef FEATURE_SUPPORT_WEBCONFIG
 #include <webcfg_generic.h>
 #endif
@@ -38,13 +44,30 @@
 static void connect_parodus();
 static void get_parodus_url(char **parodus_url, char **client_url);
 static void parodus_receive();
+static void processWrpRequest(void *data);
+static void rejectWrpRequest(void *data, int reqType);
+static int sendWrpMessage(wrp_msg_t *msg);
+static void compressWrpPayload(void **payload, size_t *payloadSize, headers_t **headers);
+static void initResponse(wrp_msg_t *res_wrp_msg, wrp_msg_t *wrp_msg, const char *contentType);
+static void freeResponse(wrp_msg_t *res_wrp_msg);
 static void initParallelProcess();
 static char* generate_trans_uuid();
+static int sendEvent(wrp_msg_t *notif_wrp_msg);
+static int sendScheduledEvent(void *data);
+static void freeScheduledEvent(void *data);
+static int sendOutboxEvent(const char *source, const char *dest, const char *payload, size_t payloadLen, void *userData);
+static int replayNotifyOutbox();
+static int retryNotifyOutbox(void *data);
 libpd_instance_t current_instance;
 char *cloud_status = "offline";
 int wakeUpFlag = 0;
 pthread_mutex_t cloud_mut=PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t cloud_con;
+static NotifyOutbox *notifyOutbox = NULL;
+static pthread_mutex_t notify_send_mut = PTHREAD_MUTEX_INITIALIZER;
+// responses, events and retrieve requests all go out on current_instance one at a time
+static pthread_mutex_t wrp_send_mut = PTHREAD_MUTEX_INITIALIZER;
+static int outboxRetryScheduled = 0;
 
 static void connect_parodus()
 {
@@ -149,14 +172,9 @@ void set_global_cloud_status(char *status)
 	
 static void parodus_receive()
 {
-        int rtn;
+        int rtn, reqType = -1;
+        REQUEST_CLASS reqClass = REQUEST_CLASS_INTERACTIVE;
         wrp_msg_t *wrp_msg;
-        wrp_msg_t *res_wrp_msg ;
-
-        struct timespec start,end,*startPtr,*endPtr;
-        startPtr = &start;
-        endPtr = &end;
-        char *contentType = NULL;
         char *sourceService, *sourceApplication =NULL;
         char *status=NULL;
 
@@ -178,6 +196,61 @@ static void parodus_receive()
         {
             if (wrp_msg->msg_type == WRP_MSG_TYPE__REQ)
             {
+                    // workers send the response when done, the receiver goes on with the next message
+                    reqType = getRequestType((const char *)wrp_msg->u.req.payload, wrp_msg->u.req.payload_size);
+                    sourceService = wrp_get_msg_element(WRP_ID_ELEMENT__SERVICE, wrp_msg, SOURCE);
+                    reqClass = getWebpaRequestClass(reqType, (const char *)wrp_msg->u.req.payload, wrp_msg->u.req.payload_size, sourceService);
+                    free(sourceService);
+                    sourceService = NULL;
+                    rtn = submitWebpaRequest(wrp_msg, reqType, reqClass);
+                    if(rtn == 1)
+                    {
+                            rejectWrpRequest(wrp_msg, reqType);
+                    }
+                    else if(rtn != 0)
+                    {
+                            processWrpRequest(wrp_msg);
+                    }
+	    }
+
+            //handle cloud-status retrieve response received from parodus
+            else if (wrp_msg->msg_type == WRP_MSG_TYPE__RETREIVE)
+            {
+				sourceService = wrp_get_msg_element(WRP_ID_ELEMENT__SERVICE, wrp_msg, SOURCE);
+				sourceApplication = wrp_get_msg_element(WRP_ID_ELEMENT__APPLICATION, wrp_msg, SOURCE);
+
+				if(sourceService != NULL && sourceApplication != NULL && strcmp(sourceService,"parodus")== 0 && strcmp(sourceApplication,"cloud-status")== 0)
+				{
+					WalInfo("cloud-status Retrieve response received from parodus : %s len %lu transaction_uuid %s\n",(char *)wrp_msg->u.crud.payload, strlen(wrp_msg->u.crud.payload), wrp_msg->u.crud.transaction_uuid );
+
+					status = parsePayloadForStatus(wrp_msg->u.crud.payload);
+					if(status !=NULL)
+					{
+						//set this as global conn status. add lock before update it.
+						set_global_cloud_status(status);
+						WalPrint("set cloud-status value as %s\n", status);
+					}
+				}
+				wrp_free_struct (wrp_msg);
+            }
+        }
+}
+
+/*
+ * @brief processWrpRequest processes a request and sends its response, the
+ * response carries the transaction_uuid of the request. Frees the request.
+ */
+static void processWrpRequest(void *data)
+{
+        wrp_msg_t *wrp_msg = (wrp_msg_t *) data;
+        wrp_msg_t *res_wrp_msg ;
+
+        struct timespec start,end,*startPtr,*endPtr;
+        startPtr = &start;
+        endPtr = &end;
+        WEBPA_RESPONSE_FORMAT format = WEBPA_FORMAT_JSON;
+        size_t payloadSize = 0;
+
                     res_wrp_msg = (wrp_msg_t *)malloc(sizeof(wrp_msg_t));
                     
 
@@ -195,13 +268,16 @@ static void parodus_receive()
 				}
 				else {
 					WalError("Memory not allocated for response headers\n");
+					wrp_free_struct (res_wrp_msg);
+					wrp_free_struct (wrp_msg);
 					return;
 				}	
 			}
 			else {
                                 WalPrint("Request headers field is empty so, Memory not allocated for response headers\n");
                         }
-			processRequest((char *)wrp_msg->u.req.payload, wrp_msg->u.req.transaction_uuid, ((char **)(&(res_wrp_msg->u.req.payload))), wrp_msg->u.req.headers, res_headers);
+			format = getResponseFormat(wrp_msg->u.req.content_type, wrp_msg->u.req.headers);
+			format = processRequestFormat((char *)wrp_msg->u.req.payload, wrp_msg->u.req.transaction_uuid, format, ((char **)(&(res_wrp_msg->u.req.payload))), &payloadSize, wrp_msg->u.req.headers, res_headers);
 			if(res_headers != NULL && res_headers->headers[0] != NULL && res_headers->headers[1] != NULL) {
                                 if(strlen(res_headers->headers[0]) > 0 && strlen(res_headers->headers[1]) > 0) {
                                           res_headers->count = wrp_msg->u.req.headers->count;
@@ -223,28 +299,18 @@ static void parodus_receive()
 			 			
                         if(res_wrp_msg->u.req.payload !=NULL)
                         {   
-                                WalPrint("Response payload is %s\n",(char *)(res_wrp_msg->u.req.payload));
-                                res_wrp_msg->u.req.payload_size = strlen(res_wrp_msg->u.req.payload);
+                                if(format == WEBPA_FORMAT_JSON)
+                                {
+                                        WalPrint("Response payload is %s\n",(char *)(res_wrp_msg->u.req.payload));
+                                }
+                                res_wrp_msg->u.req.payload_size = payloadSize;
+                                if(acceptsCompression(wrp_msg->u.req.headers))
+                                {
+                                        compressWrpPayload(&res_wrp_msg->u.req.payload, &res_wrp_msg->u.req.payload_size, &res_wrp_msg->u.req.headers);
+                                }
                         }
-                        res_wrp_msg->msg_type = wrp_msg->msg_type;
-			if(wrp_msg->u.req.dest != NULL)
-			{
-				res_wrp_msg->u.req.source = strdup(wrp_msg->u.req.dest);
-			}
-			if(wrp_msg->u.req.source != NULL)
-			{
-				res_wrp_msg->u.req.dest = strdup(wrp_msg->u.req.source);
-			}
-			if(wrp_msg->u.req.transaction_uuid != NULL)
-			{
-				res_wrp_msg->u.req.transaction_uuid = strdup(wrp_msg->u.req.transaction_uuid);
-			}
-                        contentType = strdup(CONTENT_TYPE_JSON);
-                        if(contentType != NULL)
-                        {
-                            res_wrp_msg->u.req.content_type = contentType;
-                        }
-                        int sendStatus = libparodus_send(current_instance, res_wrp_msg);
+                        initResponse(res_wrp_msg, wrp_msg, (format == WEBPA_FORMAT_MSGPACK) ? CONTENT_TYPE_MSGPACK : CONTENT_TYPE_JSON);
+                        int sendStatus = sendWrpMessage(res_wrp_msg);
                         WalPrint("sendStatus is %d\n",sendStatus);
                         if(sendStatus == 0)
                         {
@@ -257,32 +323,70 @@ static void parodus_receive()
                         }
                         getCurrentTime(endPtr);
                         WalInfo("Elapsed time : %ld ms\n", timeValDiff(startPtr, endPtr));
-			wrp_free_struct (res_wrp_msg);
+			freeResponse (res_wrp_msg);
                     }
 		    wrp_free_struct (wrp_msg);
-	    }
+}
 
-            //handle cloud-status retrieve response received from parodus
-            else if (wrp_msg->msg_type == WRP_MSG_TYPE__RETREIVE)
-            {
-				sourceService = wrp_get_msg_element(WRP_ID_ELEMENT__SERVICE, wrp_msg, SOURCE);
-				sourceApplication = wrp_get_msg_element(WRP_ID_ELEMENT__APPLICATION, wrp_msg, SOURCE);
+/*
+ * @brief rejectWrpRequest answers a request over the admission limits with
+ * WDMP_ERR_MAX_REQUEST without processing it. Frees the request.
+ */
+static void rejectWrpRequest(void *data, int reqType)
+{
+        wrp_msg_t *wrp_msg = (wrp_msg_t *) data;
+        wrp_msg_t *res_wrp_msg = NULL;
+        char *payload = NULL;
+        int sendStatus = -1;
+
+        formRejectResponse(reqType, WDMP_ERR_MAX_REQUEST, &payload);
+        res_wrp_msg = (wrp_msg_t *)malloc(sizeof(wrp_msg_t));
+        if(payload == NULL || res_wrp_msg == NULL)
+        {
+                WalError("Failed to form reject response\n");
+                free(payload);
+                free(res_wrp_msg);
+                wrp_free_struct (wrp_msg);
+                return;
+        }
+        memset(res_wrp_msg, 0, sizeof(wrp_msg_t));
+        res_wrp_msg->u.req.payload = payload;
+        res_wrp_msg->u.req.payload_size = strlen(payload);
+        initResponse(res_wrp_msg, wrp_msg, CONTENT_TYPE_JSON);
+        sendStatus = sendWrpMessage(res_wrp_msg);
+        if(sendStatus != 0)
+        {
+                WalError("Failed to send reject response: '%s'\n",libparodus_strerror(sendStatus));
+        }
+        freeResponse (res_wrp_msg);
+        wrp_free_struct (wrp_msg);
+}
 
-				if(sourceService != NULL && sourceApplication != NULL && strcmp(sourceService,"parodus")== 0 && strcmp(sourceApplication,"cloud-status")== 0)
-				{
-					WalInfo("cloud-status Retrieve response received from parodus : %s len %lu transaction_uuid %s\n",(char *)wrp_msg->u.crud.payload, strlen(wrp_msg->u.crud.payload), wrp_msg->u.crud.transaction_uuid );
+/*
+ * @brief initResponse addresses a response back to the sender of a request.
+ * Source, dest and transaction id point into the request and the content type
+ * is a constant, so the response is freed with freeResponse() before the request.
+ */
+static void initResponse(wrp_msg_t *res_wrp_msg, wrp_msg_t *wrp_msg, const char *contentType)
+{
+        res_wrp_msg->msg_type = wrp_msg->msg_type;
+        res_wrp_msg->u.req.source = wrp_msg->u.req.dest;
+        res_wrp_msg->u.req.dest = wrp_msg->u.req.source;
+        res_wrp_msg->u.req.transaction_uuid = wrp_msg->u.req.transaction_uuid;
+        res_wrp_msg->u.req.content_type = (char *) contentType;
+}
 
-					status = parsePayloadForStatus(wrp_msg->u.crud.payload);
-					if(status !=NULL)
-					{
-						//set this as global conn status. add lock before update it.
-						set_global_cloud_status(status);
-						WalPrint("set cloud-status value as %s\n", status);
-					}
-				}
-				wrp_free_struct (wrp_msg);
-            }
-        }
+/*
+ * @brief freeResponse frees a response built by initResponse(), the fields
+ * it does not own are left to the request
+ */
+static void freeResponse(wrp_msg_t *res_wrp_msg)
+{
+        res_wrp_msg->u.req.source = NULL;
+        res_wrp_msg->u.req.dest = NULL;
+        res_wrp_msg->u.req.transaction_uuid = NULL;
+        res_wrp_msg->u.req.content_type = NULL;
+        wrp_free_struct (res_wrp_msg);
 }
 
 void *parallelProcessTask(void *id)
@@ -324,6 +428,8 @@ void parodus_receive_wait()
         {
                 WalInfo("Parallel request processing is enabled\n");
         }
+        initRequestQueue(processWrpRequest, rejectWrpRequest);
+        startRequestWorkers(WEBPA_REQUEST_WORKERS);
         initParallelProcess();
         parallelProcessTask(NULL);
         libparodus_shutdown(&current_instance);
@@ -439,7 +545,7 @@ int getConnCloudStatus(char *device_mac)
 						WalInfo("transaction_uuid generated is %s\n", req_wrp_msg->u.crud.transaction_uuid);
 					}
 
-					sendStatus = libparodus_send(current_instance, req_wrp_msg);
+					sendStatus = sendWrpMessage(req_wrp_msg);
 					WalPrint("sendStatus is %d\n",sendStatus);
 					if(sendStatus == 0)
 					{
@@ -488,14 +594,23 @@ int getConnCloudStatus(char *device_mac)
 void sendNotification(char *payload, char *source, char *destination)
 {
     wrp_msg_t *notif_wrp_msg = NULL;
-    int retry_count = 0;
-    int sendStatus = -1;
-    int backoffRetryTime = 0;
-    int c=2;
     char *contentType = NULL;
 
     if(source != NULL && destination != NULL)
     {
+        // event stays in the outbox until parodus accepts it, older pending events are sent first
+        if(notifyOutbox != NULL && outboxAppend(notifyOutbox, source, destination, payload, (payload != NULL) ? strlen(payload) : 0, NULL) == 0)
+        {
+            if(payload != NULL)
+            {
+                WalInfo("Notification payload: %s\n",payload);
+                WAL_FREE(payload);
+            }
+            WAL_FREE(source);
+            replayNotifyOutbox();
+            return;
+        }
+
         notif_wrp_msg = (wrp_msg_t *)malloc(sizeof(wrp_msg_t));
         
 
@@ -520,36 +635,47 @@ void sendNotification(char *payload, char *source, char *destination)
 	        WalInfo("Notification payload: %s\n",payload);
 		notif_wrp_msg ->u.event.payload = (void *)payload;
                 notif_wrp_msg ->u.event.payload_size = strlen(notif_wrp_msg ->u.event.payload);
-            }
-
-            while(retry_count<=3)
-            {
-                backoffRetryTime = (int) pow(2, c) -1;
-
-                sendStatus = libparodus_send(current_instance, notif_wrp_msg );
-                if(sendStatus == 0)
+                if(isEventCompressEnabled())
                 {
-                    retry_count = 0;
-                    WalInfo("Notification successfully sent to parodus\n");
-                    break;
-                }
-                else
-                {
-                    WalError("Failed to send Notification: '%s', retrying ....\n",libparodus_strerror(sendStatus));
-                    WalPrint("sendNotification backoffRetryTime %d seconds\n", backoffRetryTime);
-                    sleep(backoffRetryTime);
-                    c++;
-                    retry_count++;
+                    compressWrpPayload(&notif_wrp_msg->u.event.payload, &notif_wrp_msg->u.event.payload_size, &notif_wrp_msg->u.event.headers);
                 }
             }
 
-            WalPrint("sendStatus is %d\n",sendStatus);
-            wrp_free_struct (notif_wrp_msg );
-            WalPrint("Freed notif_wrp_msg struct.\n");
+            // failed event is retried by the retry task, the caller goes on with the next one
+            if(sendEvent(notif_wrp_msg) == 0 || scheduleNotifyRetry(notif_wrp_msg, sendScheduledEvent, freeScheduledEvent, WEBPA_NOTIFY_MAX_RETRY_COUNT) != 0)
+            {
+                wrp_free_struct (notif_wrp_msg );
+                WalPrint("Freed notif_wrp_msg struct.\n");
+            }
         }
     }
 }
 
+/*
+ * @brief initNotifyOutbox starts the notification retry task and opens the
+ * outbox, events left pending by a previous run are scheduled for replay
+ */
+void initNotifyOutbox()
+{
+    NotifyOutboxStats stats;
+
+    startNotifyRetryTask();
+    notifyOutbox = outboxOpen(WEBPA_OUTBOX_FILE, WEBPA_OUTBOX_SIZE, WEBPA_OUTBOX_MAX_AGE_SEC);
+    if(notifyOutbox == NULL)
+    {
+        WalError("Notification outbox is disabled, notifications are dropped after send retries\n");
+        return;
+    }
+    outboxGetStats(notifyOutbox, &stats);
+    if(stats.pendingCount > 0)
+    {
+        WalInfo("%lu notifications pending in outbox, scheduling replay\n", stats.pendingCount);
+        pthread_mutex_lock(&notify_send_mut);
+        outboxRetryScheduled = (scheduleNotifyRetry(NULL, retryNotifyOutbox, NULL, 0) == 0) ? 1 : 0;
+        pthread_mutex_unlock(&notify_send_mut);
+    }
+}
+
 void libpd_client_mgr()
 {
 	WalPrint("Connect parodus \n");
@@ -671,3 +797,162 @@ const char *rdk_logger_module_fetch(void)
 {
     return "LOG.RDK.WEBPA";
 }
+
+static int sendEvent(wrp_msg_t *notif_wrp_msg)
+{
+    int sendStatus = -1;
+    struct timespec start;
+
+    notifyMetricsStart(&start);
+    sendStatus = sendWrpMessage(notif_wrp_msg);
+    recordNotifyLatency(NOTIFY_METRIC_SEND, &start);
+    if(sendStatus == 0)
+    {
+        WalInfo("Notification successfully sent to parodus\n");
+    }
+    else
+    {
+        WalError("Failed to send Notification: '%s'\n",libparodus_strerror(sendStatus));
+    }
+    return sendStatus;
+}
+
+/*
+ * @brief sendWrpMessage is the single writer to parodus, sends from the
+ * request workers and the notification tasks do not interleave
+ */
+static int sendWrpMessage(wrp_msg_t *msg)
+{
+    int sendStatus = -1;
+
+    pthread_mutex_lock(&wrp_send_mut);
+    sendStatus = libparodus_send(current_instance, msg);
+    pthread_mutex_unlock(&wrp_send_mut);
+    return sendStatus;
+}
+
+/*
+ * @brief compressWrpPayload replaces a payload at or above the compression
+ * threshold by its gzip form and adds the Content-Encoding header, the
+ * payload is left as is when it does not shrink
+ */
+static void compressWrpPayload(void **payload, size_t *payloadSize, headers_t **headers)
+{
+    void *compressed = NULL;
+    size_t compressedSize = 0;
+
+    if(*payload == NULL || compressPayload(*payload, *payloadSize, &compressed, &compressedSize) != 0)
+    {
+        return;
+    }
+    if(addContentEncoding(headers) != 0)
+    {
+        WalError("Failed to add content encoding header, sending payload uncompressed\n");
+        free(compressed);
+        return;
+    }
+    WalInfo("Payload compressed from %zu to %zu bytes\n", *payloadSize, compressedSize);
+    free(*payload);
+    *payload = compressed;
+    *payloadSize = compressedSize;
+}
+
+static int sendScheduledEvent(void *data)
+{
+    return sendEvent((wrp_msg_t *) data);
+}
+
+static void freeScheduledEvent(void *data)
+{
+    wrp_free_struct((wrp_msg_t *) data);
+}
+
+/*
+ * @brief sendOutboxEvent sends one outbox event. An event that can not be built
+ * into a WRP message is reported as rejected, a libparodus send error as failed.
+ */
+static int sendOutboxEvent(const char *source, const char *dest, const char *payload, size_t payloadLen, void *userData)
+{
+    wrp_msg_t *notif_wrp_msg = NULL;
+    int sendStatus = WEBPA_OUTBOX_SEND_REJECTED;
+
+    (void) userData;
+    notif_wrp_msg = (wrp_msg_t *)malloc(sizeof(wrp_msg_t));
+    if(notif_wrp_msg == NULL)
+    {
+        WalError("Failed to allocate memory for outbox event\n");
+        return sendStatus;
+    }
+    memset(notif_wrp_msg, 0, sizeof(wrp_msg_t));
+    notif_wrp_msg->msg_type = WRP_MSG_TYPE__EVENT;
+    notif_wrp_msg->u.event.source = strdup(source);
+    notif_wrp_msg->u.event.dest = strdup(dest);
+    notif_wrp_msg->u.event.content_type = strdup(CONTENT_TYPE_JSON);
+    if(payloadLen > 0)
+    {
+        notif_wrp_msg->u.event.payload = malloc(payloadLen);
+        if(notif_wrp_msg->u.event.payload != NULL)
+        {
+            memcpy(notif_wrp_msg->u.event.payload, payload, payloadLen);
+            notif_wrp_msg->u.event.payload_size = payloadLen;
+            if(isEventCompressEnabled())
+            {
+                compressWrpPayload(&notif_wrp_msg->u.event.payload, &notif_wrp_msg->u.event.payload_size, &notif_wrp_msg->u.event.headers);
+            }
+        }
+    }
+    if(notif_wrp_msg->u.event.source == NULL || notif_wrp_msg->u.event.dest == NULL ||
+        notif_wrp_msg->u.event.content_type == NULL || (payloadLen > 0 && notif_wrp_msg->u.event.payload == NULL))
+    {
+        WalError("Failed to build WRP message for outbox event\n");
+    }
+    else
+    {
+        sendStatus = (sendEvent(notif_wrp_msg) == 0) ? WEBPA_OUTBOX_SEND_OK : WEBPA_OUTBOX_SEND_FAILED;
+    }
+    wrp_free_struct(notif_wrp_msg);
+    return sendStatus;
+}
+
+/*
+ * @brief replayNotifyOutbox sends pending outbox events in order. When parodus
+ * does not accept them the replay is handed to the retry task, new events then
+ * wait behind the scheduled replay so they are still sent in order.
+ */
+static int replayNotifyOutbox()
+{
+    int sent = -1;
+
+    pthread_mutex_lock(&notify_send_mut);
+    if(!outboxRetryScheduled)
+    {
+        sent = outboxReplay(notifyOutbox, sendOutboxEvent, NULL);
+        if(sent < 0)
+        {
+            WalError("Notification kept in outbox, it is replayed once parodus accepts events\n");
+            outboxRetryScheduled = (scheduleNotifyRetry(NULL, retryNotifyOutbox, NULL, 0) == 0) ? 1 : 0;
+        }
+    }
+    pthread_mutex_unlock(&notify_send_mut);
+    return sent;
+}
+
+/*
+ * @brief retryNotifyOutbox is run by the retry task, it keeps being retried
+ * until every pending outbox event was sent
+ */
+static int retryNotifyOutbox(void *data)
+{
+    int sent = 0;
+
+    (void) data;
+    pthread_mutex_lock(&notify_send_mut);
+    sent = outboxReplay(notifyOutbox, sendOutboxEvent, NULL);
+    if(sent >= 0)
+    {
+        WalInfo("%d notifications replayed from outbox\n", sent);
+        outboxRetryScheduled = 0;
+    }
+    pthread_mutex_unlock(&notify_send_mut);
+    return (sent >= 0) ? 0 : -1;
+}
@@ -7,4 +7,5 @@
  */
 
 void libpd_client_mgr();
+void initNotifyOutbox();
 int getConnCloudStatus(char *device_mac);
@@ -64,6 +64,7 @@ int main()
         }
 	ret = waitForOperationalReadyCondition();
 	libpd_client_mgr();
+	initNotifyOutbox();
 	WalInfo("Syncing backend manager with DB....\n");
 	CosaWebpaSyncDB();
 	WalInfo("Webpa backend manager is in sync with DB\n");
@@ -12,6 +12,7 @@
 #include "webpa_adapter.h"
 #include "ccsp_psm_helper.h"
 #include "webpa_internal.h"
+#include "webpa_sync_state.h"
 
 /* 
  * To enable when all webpa params getting from syscfg.db file otherwise keep 
@@ -57,6 +58,7 @@ CosaDmlWEBPA_SetConfiguration( PCOSA_DML_WEBPA_CONFIG  pWebpaCfg, char* ParamNam
 		{
 			memset( pWebpaCfg->X_COMCAST_COM_CID, 0, sizeof(pWebpaCfg->X_COMCAST_COM_CID));
 			AnscCopyString(pWebpaCfg->X_COMCAST_COM_CID, (char*)pvParamValue);
+			refreshSyncStateCID((char*)pvParamValue);
 		}
 	}
 	else if( AnscEqualString(ParamName, "X_COMCAST-COM_SyncProtocolVersion", TRUE))
@@ -78,6 +80,7 @@ CosaDmlWEBPA_SetConfiguration( PCOSA_DML_WEBPA_CONFIG  pWebpaCfg, char* ParamNam
 		if ( returnstatus )
 		{
 			pWebpaCfg->X_COMCAST_COM_CMC = *((ULONG*)pvParamValue);
+			refreshSyncStateCMC(pWebpaCfg->X_COMCAST_COM_CMC);
 		}
 	}
 
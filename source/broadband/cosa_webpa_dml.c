@@ -7,9 +7,14 @@
 #include "plugin_main_apis.h"
 #include "webpa_internal.h"
 #include "webpa_notification.h"
+#include "webpa_sync_state.h"
+#include "webpa_notify_metrics.h"
+#include "webpa_notify_retry.h"
 
 #define WEBPA_PARAM_VERSION                 "Device.X_RDKCENTRAL-COM_Webpa.Version"
 #define WEBPA_PARAM_PROTOCOL_VERSION        "Device.DeviceInfo.Webpa.X_COMCAST-COM_SyncProtocolVersion"
+#define WEBPA_STATISTICS_OBJECT             "Device.X_RDKCENTRAL-COM_Webpa.Statistics."
+#define WEBPA_STATISTICS_VALUE_LEN          512
 #define WiFi_FactoryResetRadioAndAp	    "Device.WiFi.X_CISCO_COM_FactoryResetRadioAndAp"
 #ifdef WEBCONFIG_BIN_SUPPORT
 #define CONN_CLIENT_PARAM		    "Device.NotifyComponent.X_RDKCENTRAL-COM_Connected-Client"
@@ -25,6 +30,207 @@ extern PCOSA_BACKEND_MANAGER_OBJECT g_pCosaBEManager;
 
 void (*notifyCbFnPtr)(NotifyData*) = NULL;
 
+/* Notification pipeline counters under Device.X_RDKCENTRAL-COM_Webpa.Statistics. */
+static const char *webpaStatisticsCounters[] = {"NotifyQueueDepth", "NotifyQueueHighWatermark", "NotifyQueueEnqueued", "NotifyQueueDropped", "NotifyRetryPending", "NotifyRetryDropped"};
+/* Latency histograms, in NOTIFY_METRIC order */
+static const char *webpaStatisticsLatencies[NOTIFY_METRIC_COUNT] = {"QueueWaitLatency", "CMCGetLatency", "CMCSetLatency", "SettleLatency", "SendLatency", "EndToEndLatency"};
+/* Processing time histograms, in NOTIFY_TYPE order */
+static const char *webpaStatisticsProcessLatencies[] = {"ParamNotifyProcessLatency", "TransStatusProcessLatency", "ConnectedClientProcessLatency", "DeviceStatusProcessLatency", "FactoryResetProcessLatency", "FirmwareUpgradeProcessLatency", "SyncRetryProcessLatency"};
+
+static BOOL getWebpaStatisticsUlong(const char *name, ULONG *value)
+{
+	NotifyQueueStats queueStats;
+	NotifyRetryStats retryStats;
+
+	getNotifyQueueTotals(&queueStats);
+	getNotifyRetryStats(&retryStats);
+	if(strcmp(name, "NotifyQueueDepth") == 0)
+	{
+		*value = queueStats.depth;
+	}
+	else if(strcmp(name, "NotifyQueueHighWatermark") == 0)
+	{
+		*value = queueStats.highWatermark;
+	}
+	else if(strcmp(name, "NotifyQueueEnqueued") == 0)
+	{
+		*value = queueStats.enqueueCount;
+	}
+	else if(strcmp(name, "NotifyQueueDropped") == 0)
+	{
+		*value = queueStats.dropCount;
+	}
+	else if(strcmp(name, "NotifyRetryPending") == 0)
+	{
+		*value = retryStats.pendingCount;
+	}
+	else if(strcmp(name, "NotifyRetryDropped") == 0)
+	{
+		*value = retryStats.dropCount;
+	}
+	else
+	{
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static BOOL getWebpaStatisticsString(const char *name, char *value, size_t size)
+{
+	NotifyLatencyStats stats;
+	int i = 0;
+
+	for(i = 0; i < NOTIFY_METRIC_COUNT; i++)
+	{
+		if(strcmp(name, webpaStatisticsLatencies[i]) == 0)
+		{
+			getNotifyLatencyStats((NOTIFY_METRIC) i, &stats);
+			formatNotifyLatencyStats(&stats, value, size);
+			return TRUE;
+		}
+	}
+	for(i = 0; i < (int)(sizeof(webpaStatisticsProcessLatencies)/sizeof(webpaStatisticsProcessLatencies[0])); i++)
+	{
+		if(strcmp(name, webpaStatisticsProcessLatencies[i]) == 0)
+		{
+			getNotifyProcessLatencyStats(i, &stats);
+			formatNotifyLatencyStats(&stats, value, size);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * Adds Device.X_RDKCENTRAL-COM_Webpa.Statistics. parameters to a GET response, the named one or
+ * all of them for the object name. reserved is 1 when paramVal already has a slot for this name.
+ * Returns the number of parameters added, -1 when memory could not be allocated. paramVal stays
+ * valid on failure and holds the k parameters added so far.
+ */
+static int addWebpaStatistics(const char *paramName, parameterValStruct_t ***paramVal, int *localCount, int *k, int reserved)
+{
+	const char *names[sizeof(webpaStatisticsCounters)/sizeof(webpaStatisticsCounters[0]) + NOTIFY_METRIC_COUNT + sizeof(webpaStatisticsProcessLatencies)/sizeof(webpaStatisticsProcessLatencies[0])];
+	int counterCount = sizeof(webpaStatisticsCounters)/sizeof(webpaStatisticsCounters[0]);
+	int nameCount = 0, matchCount = 0, i = 0;
+	int isObject = (strcmp(paramName, WEBPA_STATISTICS_OBJECT) == 0) ? 1 : 0;
+	const char *subName = paramName + strlen(WEBPA_STATISTICS_OBJECT);
+	char fullName[MAX_PARAMETERNAME_LEN];
+	char value[WEBPA_STATISTICS_VALUE_LEN];
+	ULONG ulValue = 0;
+	parameterValStruct_t *param = NULL;
+	parameterValStruct_t **newParamVal = NULL;
+
+	for(i = 0; i < counterCount; i++)
+	{
+		names[nameCount++] = webpaStatisticsCounters[i];
+	}
+	for(i = 0; i < NOTIFY_METRIC_COUNT; i++)
+	{
+		names[nameCount++] = webpaStatisticsLatencies[i];
+	}
+	for(i = 0; i < (int)(sizeof(webpaStatisticsProcessLatencies)/sizeof(webpaStatisticsProcessLatencies[0])); i++)
+	{
+		names[nameCount++] = webpaStatisticsProcessLatencies[i];
+	}
+
+	for(i = 0; i < nameCount; i++)
+	{
+		if(isObject || strcmp(subName, names[i]) == 0)
+		{
+			matchCount++;
+		}
+	}
+	if(matchCount > reserved)
+	{
+		newParamVal = (parameterValStruct_t **) realloc(*paramVal, sizeof(parameterValStruct_t *) * (*localCount + matchCount - reserved));
+		if(newParamVal == NULL)
+		{
+			WalError("Failed to allocate memory for %s\n", paramName);
+			return -1;
+		}
+		*paramVal = newParamVal;
+		*localCount = *localCount + matchCount - reserved;
+	}
+
+	matchCount = 0;
+	for(i = 0; i < nameCount; i++)
+	{
+		if(!isObject && strcmp(subName, names[i]) != 0)
+		{
+			continue;
+		}
+		param = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t));
+		if(param == NULL)
+		{
+			WalError("Failed to allocate memory for %s\n", names[i]);
+			return -1;
+		}
+		snprintf(fullName, sizeof(fullName), "%s%s", WEBPA_STATISTICS_OBJECT, names[i]);
+		param->parameterName = strndup(fullName, MAX_PARAMETERNAME_LEN);
+		if(i < counterCount)
+		{
+			getWebpaStatisticsUlong(names[i], &ulValue);
+			snprintf(value, sizeof(value), "%lu", ulValue);
+			param->type = ccsp_unsignedInt;
+		}
+		else
+		{
+			getWebpaStatisticsString(names[i], value, sizeof(value));
+			param->type = ccsp_string;
+		}
+		param->parameterValue = strndup(value, MAX_PARAMETERVALUE_LEN);
+		if(param->parameterName == NULL || param->parameterValue == NULL)
+		{
+			WalError("Failed to allocate memory for %s\n", names[i]);
+			free(param->parameterName);
+			free(param->parameterValue);
+			WAL_FREE(param);
+			return -1;
+		}
+		(*paramVal)[(*k)++] = param;
+		matchCount++;
+	}
+	return matchCount;
+}
+
+/*
+ * CMC/CID set by the notification path may still be waiting to be written to DB.
+ * Once the sync state is initialized GETs copy it under its lock and never write
+ * the shared config, before that the value is loaded from DB.
+ */
+static unsigned int readWebpaCMC(PCOSA_DML_WEBPA_CONFIG pWebpaCfg)
+{
+	unsigned int cmc = 0;
+	char tmpchar[128] = { 0 };
+
+	if(getSyncStateCMC(&cmc) == WDMP_SUCCESS)
+	{
+		return cmc;
+	}
+	if(pWebpaCfg->X_COMCAST_COM_CMC == 0)
+	{
+		CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CMC", tmpchar );
+		pWebpaCfg->X_COMCAST_COM_CMC = atoi(tmpchar);
+	}
+	return pWebpaCfg->X_COMCAST_COM_CMC;
+}
+
+static void readWebpaCID(PCOSA_DML_WEBPA_CONFIG pWebpaCfg, char *cid, size_t cidLen)
+{
+	unsigned int cmc = 0;
+
+	if(getSyncStateValues(&cmc, cid, cidLen) == WDMP_SUCCESS)
+	{
+		return;
+	}
+	if((strlen(pWebpaCfg->X_COMCAST_COM_CID) == 0) || (strcmp(pWebpaCfg->X_COMCAST_COM_CID, "0") == 0))
+	{
+		WalPrint("CID is empty or 0, get value from DB\n");
+		CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CID", pWebpaCfg->X_COMCAST_COM_CID );
+	}
+	snprintf(cid, cidLen, "%s", pWebpaCfg->X_COMCAST_COM_CID);
+}
+
 BOOL
 Webpa_SetParamStringValue
     (
@@ -302,11 +508,18 @@ Webpa_GetParamStringValue
         PCOSA_DML_WEBPA             pWebpa    = (PCOSA_DML_WEBPA) hWebpa->pWebpa;
 	PCOSA_DML_WEBPA_CONFIG      pWebpaCfg = (PCOSA_DML_WEBPA_CONFIG)pWebpa->pWebpaCfg;
 	char buf[32] ={'\0'};
+	char cid[SYNC_STATE_CID_LEN] = {'\0'};
+	unsigned int cmc = 0;
 
 	/* Required for xPC sync */
         if( AnscEqualString(ParamName, "X_COMCAST-COM_CID", TRUE))
         {
                 WalPrint("X_COMCAST-COM_CID\n");
+		if(getSyncStateValues(&cmc, cid, sizeof(cid)) == WDMP_SUCCESS)
+		{
+			AnscCopyString(pValue, cid);
+			return 0;
+		}
 		CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CID", pWebpaCfg->X_COMCAST_COM_CID );
 		AnscCopyString(pValue, pWebpaCfg->X_COMCAST_COM_CID);
 		return 0;
@@ -346,10 +559,16 @@ Webpa_GetParamUlongValue
         PCOSA_DML_WEBPA             pWebpa    = (PCOSA_DML_WEBPA) hWebpa->pWebpa;
 	PCOSA_DML_WEBPA_CONFIG      pWebpaCfg = (PCOSA_DML_WEBPA_CONFIG)pWebpa->pWebpaCfg;
 	char tmpchar[128] = { 0 };
+	unsigned int cmc = 0;
 	
         if( AnscEqualString(ParamName, "X_COMCAST-COM_CMC", TRUE))
         {
                 WalPrint("X_COMCAST-COM_CMC\n");
+				if(getSyncStateCMC(&cmc) == WDMP_SUCCESS)
+				{
+					*puLong = cmc;
+					return TRUE;
+				}
 				/* X_COMCAST-COM_CMC */
 				CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CMC", tmpchar );
 				if(strlen(tmpchar)>0)
@@ -389,6 +608,42 @@ Webpa_SetParamUlongValue
     return FALSE;
 }
 
+BOOL
+WebpaStatistics_GetParamUlongValue
+    (
+        ANSC_HANDLE                 hInsContext,
+        char*                       ParamName,
+        ULONG*                      puLong
+    )
+{
+	return getWebpaStatisticsUlong(ParamName, puLong);
+}
+
+ULONG
+WebpaStatistics_GetParamStringValue
+    (
+        ANSC_HANDLE                 hInsContext,
+        char*                       ParamName,
+        char*                       pValue,
+        ULONG*                      pUlSize
+    )
+{
+	char buf[WEBPA_STATISTICS_VALUE_LEN] = {'\0'};
+
+	if(!getWebpaStatisticsString(ParamName, buf, sizeof(buf)))
+	{
+		WalError("Unsupported parameter '%s'\n", ParamName);
+		return -1;
+	}
+	if(strlen(buf) >= *pUlSize)
+	{
+		*pUlSize = strlen(buf) + 1;
+		return 1;
+	}
+	AnscCopyString(pValue, buf);
+	return 0;
+}
+
 ULONG
 WebpaServer_GetParamStringValue
     (
@@ -464,9 +719,9 @@ int getWebpaParameterValues(char **parameterNames, int paramCount, int *val_size
     int objSize = sizeof(webpaObjects)/sizeof(webpaObjects[0]);
     parameterValStruct_t **paramVal = NULL;
     paramVal = (parameterValStruct_t **) malloc(sizeof(parameterValStruct_t *)*paramCount);
-    int i=0, j=0, k=0, l=0, isWildcard = 0, matchFound = 0;
+    int i=0, j=0, k=0, l=0, isWildcard = 0, matchFound = 0, statCount = 0, allocFailed = 0;
     int localCount = paramCount;
-    char tmpchar[128] = { 0 };
+    char cid[SYNC_STATE_CID_LEN] = {'\0'};
     WalPrint("*********** %s ***************\n",__FUNCTION__);
 
     PCOSA_DATAMODEL_WEBPA       hWebpa    = (PCOSA_DATAMODEL_WEBPA)g_pCosaBEManager->hWebpa;
@@ -501,24 +756,15 @@ int getWebpaParameterValues(char **parameterNames, int paramCount, int *val_size
                             {
                                 paramVal[k]->parameterName = strndup(PARAM_CMC, MAX_PARAMETERNAME_LEN);
                                 paramVal[k]->parameterValue = (char *)malloc(sizeof(char)*MAX_PARAMETERVALUE_LEN);
-				if(pWebpaCfg->X_COMCAST_COM_CMC == 0)
-				{
-					CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CMC", tmpchar );
-					pWebpaCfg->X_COMCAST_COM_CMC = atoi(tmpchar);
-				}
-                                snprintf(paramVal[k]->parameterValue,MAX_PARAMETERVALUE_LEN,"%d",pWebpaCfg->X_COMCAST_COM_CMC);
+                                snprintf(paramVal[k]->parameterValue,MAX_PARAMETERVALUE_LEN,"%u",readWebpaCMC(pWebpaCfg));
                                 paramVal[k]->type = ccsp_unsignedInt;
                                 k++;
                             }
                             else if(strcmp(parameterNames[i], PARAM_CID) == 0)
                             {
                                 paramVal[k]->parameterName = strndup(PARAM_CID, MAX_PARAMETERNAME_LEN);
-				if((strlen(pWebpaCfg->X_COMCAST_COM_CID) == 0) || (strcmp(pWebpaCfg->X_COMCAST_COM_CID, "0") == 0))
-				{
-					WalPrint("CID is empty or 0, get value from DB\n");
-					CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CID", pWebpaCfg->X_COMCAST_COM_CID );
-				}
-                                paramVal[k]->parameterValue = strndup(pWebpaCfg->X_COMCAST_COM_CID,MAX_PARAMETERVALUE_LEN);
+                                readWebpaCID(pWebpaCfg, cid, sizeof(cid));
+                                paramVal[k]->parameterValue = strndup(cid,MAX_PARAMETERVALUE_LEN);
                                 paramVal[k]->type = ccsp_string;
                                 k++;
                             }
@@ -548,23 +794,13 @@ int getWebpaParameterValues(char **parameterNames, int paramCount, int *val_size
                                 paramVal[k] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t));
                                 paramVal[k]->parameterName = strndup(PARAM_CMC, MAX_PARAMETERNAME_LEN);
                                 paramVal[k]->parameterValue = (char *)malloc(sizeof(char)*MAX_PARAMETERVALUE_LEN);
-				if(pWebpaCfg->X_COMCAST_COM_CMC == 0)
-				{
-					CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CMC", tmpchar );
-					pWebpaCfg->X_COMCAST_COM_CMC = atoi(tmpchar);
-
-				}
-                                snprintf(paramVal[k]->parameterValue,MAX_PARAMETERVALUE_LEN,"%d",pWebpaCfg->X_COMCAST_COM_CMC);
+                                snprintf(paramVal[k]->parameterValue,MAX_PARAMETERVALUE_LEN,"%u",readWebpaCMC(pWebpaCfg));
                                 paramVal[k]->type = ccsp_unsignedInt;
                                 k++;
                                 paramVal[k] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t));
                                 paramVal[k]->parameterName = strndup(PARAM_CID, MAX_PARAMETERNAME_LEN);
-				if((strlen(pWebpaCfg->X_COMCAST_COM_CID) == 0) || (strcmp(pWebpaCfg->X_COMCAST_COM_CID, "0") == 0))
-				{
-					WalPrint("CID is empty or 0, get value from DB\n");
-					CosaDmlWEBPA_GetValueFromDB( "X_COMCAST-COM_CID", pWebpaCfg->X_COMCAST_COM_CID );
-				}
-                                paramVal[k]->parameterValue = strndup(pWebpaCfg->X_COMCAST_COM_CID,MAX_PARAMETERVALUE_LEN);
+                                readWebpaCID(pWebpaCfg, cid, sizeof(cid));
+                                paramVal[k]->parameterValue = strndup(cid,MAX_PARAMETERVALUE_LEN);
                                 paramVal[k]->type = ccsp_string;
                                 k++;
                                 paramVal[k] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t));
@@ -629,6 +865,19 @@ int getWebpaParameterValues(char **parameterNames, int paramCount, int *val_size
                                 paramVal[k]->type = ccsp_string;
                                 k++;
 			    }	
+			    else if(strncmp(parameterNames[i], WEBPA_STATISTICS_OBJECT, strlen(WEBPA_STATISTICS_OBJECT)) == 0)  //Device.X_RDKCENTRAL-COM_Webpa.Statistics.*
+			    {
+                                WAL_FREE(paramVal[k]);
+                                statCount = addWebpaStatistics(parameterNames[i], &paramVal, &localCount, &k, 1);
+                                if(statCount == 0)
+                                {
+                                    matchFound = 0;
+                                }
+                                else if(statCount < 0)
+                                {
+                                    allocFailed = 1;
+                                }
+			    }
                             else
                             {    
                                 WAL_FREE(paramVal[k]);
@@ -678,7 +927,19 @@ int getWebpaParameterValues(char **parameterNames, int paramCount, int *val_size
                                              paramVal[k]->parameterValue = strndup(pWebpaCfg->DNS_Text_URL,MAX_PARAMETERVALUE_LEN);
                                              paramVal[k]->type = ccsp_string;
                                              k++;
+
+					     if(addWebpaStatistics(WEBPA_STATISTICS_OBJECT, &paramVal, &localCount, &k, 0) < 0)
+					     {
+						     allocFailed = 1;
+					     }
 			          }
+				  else if(strcmp(parameterNames[i], WEBPA_STATISTICS_OBJECT) == 0)  //Device.X_RDKCENTRAL-COM_Webpa.Statistics.
+				  {
+					     if(addWebpaStatistics(WEBPA_STATISTICS_OBJECT, &paramVal, &localCount, &k, 1) < 0)
+					     {
+						     allocFailed = 1;
+					     }
+				  }
 				  else 
 				  {
                                          char *webpaSubObjects[] ={"Device.X_RDKCENTRAL-COM_Webpa.Server.", "Device.X_RDKCENTRAL-COM_Webpa.TokenServer.", "Device.X_RDKCENTRAL-COM_Webpa.DNSText."};
@@ -752,6 +1013,19 @@ int getWebpaParameterValues(char **parameterNames, int paramCount, int *val_size
                 break;
             }
         }
+        if(allocFailed == 1)
+        {
+            *val = NULL;
+            *val_size = 0;
+            for(k=k-1;k>=0;k--)
+            {
+                WAL_FREE(paramVal[k]->parameterName);
+                WAL_FREE(paramVal[k]->parameterValue);
+                WAL_FREE(paramVal[k]);
+            }
+            WAL_FREE(paramVal);
+            return CCSP_FAILURE;
+        }
         if(matchFound == 0)
         {
             WalError("%s is invalid parameter\n",parameterNames[i]);
@@ -803,6 +1077,7 @@ int setWebpaParameterValues(parameterValStruct_t *val, int paramCount, char **fa
                 {
                     memset( pWebpaCfg->X_COMCAST_COM_CID, 0, sizeof(pWebpaCfg->X_COMCAST_COM_CID));
                     AnscCopyString(pWebpaCfg->X_COMCAST_COM_CID, val[i].parameterValue);
+                    refreshSyncStateCID(val[i].parameterValue);
 		        }
 		        else
 		        {
@@ -814,6 +1089,7 @@ int setWebpaParameterValues(parameterValStruct_t *val, int paramCount, char **fa
                 if(TRUE == CosaDmlWEBPA_StoreValueIntoDB( subStr, val[i].parameterValue ))
                 {
                     pWebpaCfg->X_COMCAST_COM_CMC = atoi(val[i].parameterValue);
+                    refreshSyncStateCMC(pWebpaCfg->X_COMCAST_COM_CMC);
                 }
                 else
                 {
@@ -9,6 +9,9 @@
 #include "cosa_webpa_internal.h"
 #include "plugin_main_apis.h"
 #include "plugin_main.h"
+#include "webpa_sync_state.h"
+
+static WDMP_STATUS CosaWebpaStoreSyncState(const char *name, const char *value);
 
 /**********************************************************************
 
@@ -143,6 +146,39 @@ CosaWebpaSyncDB
 	CosaDmlWEBPA_GetConfiguration( pWebpaCfg );
 	WalInfo("CID = %s CMC = %d Version = %s\n",pWebpaCfg->X_COMCAST_COM_CID,pWebpaCfg->X_COMCAST_COM_CMC,pWebpaCfg->X_COMCAST_COM_SyncProtocolVersion);
 	pWebpa->pWebpaCfg	  = pWebpaCfg;
+
+	/* Notification path reads and updates CMC/CID in memory from here on */
+	initSyncState(pWebpaCfg->X_COMCAST_COM_CMC, pWebpaCfg->X_COMCAST_COM_CID, CosaWebpaStoreSyncState);
+}
+
+/**********************************************************************
+    caller:     sync state write-behind thread
+    prototype:
+        WDMP_STATUS
+        CosaWebpaStoreSyncState
+            (
+		const char *name,
+		const char *value
+            );
+    description:
+        This function persists CMC/CID updated by the notification path.
+    argument:   name - X_COMCAST-COM_CMC or X_COMCAST-COM_CID
+                value - value to store
+    return:     WDMP_SUCCESS on success.
+**********************************************************************/
+static WDMP_STATUS
+CosaWebpaStoreSyncState
+    (
+	const char *name,
+	const char *value
+    )
+{
+	/* Readers take CMC/CID from the sync state, the backend manager copy is left alone */
+	if(TRUE != CosaDmlWEBPA_StoreValueIntoDB( (char *)name, (char *)value ))
+	{
+		return WDMP_FAILURE;
+	}
+	return WDMP_SUCCESS;
 }
 
 /**********************************************************************
@@ -88,6 +88,23 @@ WebpaServer_GetParamStringValue
         ULONG*                      pUlSize
     );
 
+BOOL
+WebpaStatistics_GetParamUlongValue
+    (
+        ANSC_HANDLE                 hInsContext,
+        char*                       ParamName,
+        ULONG*                      puLong
+    );
+
+ULONG
+WebpaStatistics_GetParamStringValue
+    (
+        ANSC_HANDLE                 hInsContext,
+        char*                       ParamName,
+        char*                       pValue,
+        ULONG*                      pUlSize
+    );
+
 ULONG
 WebpaTokenServer_GetParamStringValue
     (
@@ -0,0 +1,86 @@
+/**
+ * @file webpa_attribute_cache.h
+ *
+ * @description This file describes the mirror of notification attributes set
+ * by WebPA, used to answer GET_ATTRIBUTES without a bus call
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_ATTRIBUTE_CACHE_H_
+#define _WEBPA_ATTRIBUTE_CACHE_H_
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#ifndef WEBPA_ATTR_CACHE_MAX_ENTRIES
+#define WEBPA_ATTR_CACHE_MAX_ENTRIES            512
+#endif
+#define WEBPA_ATTR_CACHE_BUCKETS                128
+/* Attributes changed by TR-069 or dmcli are not signalled, entries are trusted for this long */
+#define WEBPA_ATTR_CACHE_TTL_SEC                60
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Snapshot of the mirror counters.
+ */
+typedef struct
+{
+    unsigned long entryCount;       /**< Attributes currently mirrored */
+    unsigned long hitCount;         /**< Lookups served from the mirror */
+    unsigned long missCount;        /**< Lookups that needed a bus call */
+    unsigned long evictionCount;    /**< Least recently used attributes dropped to make room */
+    unsigned long expiredCount;     /**< Attributes dropped after WEBPA_ATTR_CACHE_TTL_SEC */
+} AttrCacheStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief lookupAttrCache returns the notification attribute WebPA last set on
+ * a parameter, entries older than WEBPA_ATTR_CACHE_TTL_SEC are dropped
+ *
+ * @param[in] name parameter name in WebPA format
+ * @param[out] notification mirrored notification attribute
+ * @return 0 on a hit, -1 on a miss
+ */
+int lookupAttrCache(const char *name, int *notification);
+
+/**
+ * @brief addAttrCache records a notification attribute set on the stack. Only
+ * leaves are mirrored, an object name ("Device.X.") drops the entries below it.
+ * The least recently used entry is evicted when the mirror is full.
+ *
+ * @param[in] name parameter or object name in WebPA format
+ * @param[in] compName component owning the parameter
+ * @param[in] notification notification attribute set
+ */
+void addAttrCache(const char *name, const char *compName, int notification);
+
+/**
+ * @brief invalidateAttrCacheByName drops the entry of a parameter, or every
+ * entry below an object name, used when a set may have been applied partly
+ *
+ * @param[in] name parameter or object name in WebPA format
+ * @return number of entries dropped
+ */
+int invalidateAttrCacheByName(const char *name);
+
+/**
+ * @brief invalidateAttrCache drops the notification attributes mirrored for a
+ * component, used when the component restarted and lost them
+ *
+ * @param[in] compName component name, NULL drops every entry
+ * @return number of entries dropped
+ */
+int invalidateAttrCache(const char *compName);
+
+/**
+ * @brief getAttrCacheStats returns the mirror counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getAttrCacheStats(AttrCacheStats *stats);
+
+#endif /* _WEBPA_ATTRIBUTE_CACHE_H_ */
@@ -0,0 +1,92 @@
+/**
+ * @file webpa_client_notify.h
+ *
+ * @description This file describes the aggregation window for connected
+ * client notifications
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_CLIENT_NOTIFY_H_
+#define _WEBPA_CLIENT_NOTIFY_H_
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#ifndef WEBPA_CLIENT_NOTIFY_WINDOW_SEC
+#define WEBPA_CLIENT_NOTIFY_WINDOW_SEC          2
+#endif
+#ifndef WEBPA_CLIENT_NOTIFY_MAX_CLIENTS
+#define WEBPA_CLIENT_NOTIFY_MAX_CLIENTS         256
+#endif
+#define WEBPA_CLIENT_NOTIFY_MAC_LEN             32
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Emits the latest state of a client once its window ended, the callee owns the node.
+ */
+typedef void (*clientNotifyEmitCB)(void *node);
+
+/**
+ * @brief Releases a client state that was replaced or suppressed.
+ */
+typedef void (*clientNotifyFreeCB)(void *node);
+
+/**
+ * @brief Snapshot of the aggregation counters.
+ */
+typedef struct
+{
+    unsigned long receivedCount;    /**< Client state changes handed to the aggregator */
+    unsigned long emittedCount;     /**< Notifications emitted after a window */
+    unsigned long mergedCount;      /**< Changes replaced by a later change of the same client */
+    unsigned long suppressedCount;  /**< Windows that ended in the state last emitted */
+    unsigned long trackedCount;     /**< Clients currently in the table */
+    unsigned long pendingCount;     /**< Clients with an open window */
+} ClientNotifyStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief initClientNotifyAggregator sets up the aggregation window
+ *
+ * @param[in] windowSec seconds a client change waits for later changes of the same client
+ * @param[in] emit called for each client whose window ended with a new state
+ * @param[in] freeNode releases replaced and suppressed client states
+ */
+void initClientNotifyAggregator(unsigned int windowSec, clientNotifyEmitCB emit, clientNotifyFreeCB freeNode);
+
+/**
+ * @brief aggregateClientNotify records the latest state of a client. The first
+ * change opens a window, later changes inside the window replace the pending state.
+ *
+ * @param[in] mac client MAC, compared case insensitively
+ * @param[in] signature value identifying the reported state (status, interface, address)
+ * @param[in] node client state, owned by the aggregator on success
+ * @return 0 when the node was taken, -1 when the caller has to send it right away
+ */
+int aggregateClientNotify(const char *mac, unsigned int signature, void *node);
+
+/**
+ * @brief flushClientNotify emits every client whose window ended
+ *
+ * @param[in] force emit all pending clients regardless of their window
+ * @return number of clients still pending
+ */
+int flushClientNotify(int force);
+
+/**
+ * @brief startClientNotifyTask ends the windows from the shared timer task
+ */
+void startClientNotifyTask();
+
+/**
+ * @brief getClientNotifyStats returns the aggregation counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getClientNotifyStats(ClientNotifyStats *stats);
+
+#endif /* _WEBPA_CLIENT_NOTIFY_H_ */
@@ -0,0 +1,84 @@
+/**
+ * @file webpa_component_cache.h
+ *
+ * @description This file describes the cache of components learned from
+ * namespace discovery
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_COMPONENT_CACHE_H_
+#define _WEBPA_COMPONENT_CACHE_H_
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#ifndef WEBPA_COMPONENT_CACHE_SIZE
+#define WEBPA_COMPONENT_CACHE_SIZE              256
+#endif
+#define WEBPA_COMPONENT_CACHE_BUCKETS           512
+/* Discovery results with more owners than this are not cached */
+#define WEBPA_COMPONENT_CACHE_MAX_OWNERS        8
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Snapshot of the cache counters.
+ */
+typedef struct
+{
+    unsigned long entryCount;       /**< Names currently cached */
+    unsigned long hitCount;         /**< Lookups served from the cache */
+    unsigned long missCount;        /**< Lookups that needed a discovery */
+    unsigned long evictionCount;    /**< Least recently used names dropped to make room */
+} ComponentCacheStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief lookupComponentCache returns the owners of a parameter or object name.
+ * A name matches an entry of the same name, or a cached object ("Device.X.Y.")
+ * with a single owner that the name lies below. The deepest such object wins.
+ *
+ * @param[in] name parameter name or object name ending with '.'
+ * @param[out] compName component names, released with free_componentDetails()
+ * @param[out] dbusPath dbus paths, released with free_componentDetails()
+ * @param[out] count number of owners
+ * @return 0 on a hit, -1 on a miss
+ */
+int lookupComponentCache(const char *name, char ***compName, char ***dbusPath, int *count);
+
+/**
+ * @brief addComponentCache remembers the owners returned by a discovery of name,
+ * the least recently used entry is evicted when the cache is full
+ *
+ * @param[in] name parameter name or object name the discovery was made for
+ * @param[in] compName component names
+ * @param[in] dbusPath dbus paths
+ * @param[in] count number of owners
+ */
+void addComponentCache(const char *name, char **compName, char **dbusPath, int count);
+
+/**
+ * @brief clearComponentCache drops every entry
+ */
+void clearComponentCache();
+
+/**
+ * @brief invalidateComponentCache drops the entries owned by a component, used
+ * when the component restarted and may now be reached on another path
+ *
+ * @param[in] compName component name
+ * @return number of entries dropped
+ */
+int invalidateComponentCache(const char *compName);
+
+/**
+ * @brief getComponentCacheStats returns the cache counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getComponentCacheStats(ComponentCacheStats *stats);
+
+#endif /* _WEBPA_COMPONENT_CACHE_H_ */
@@ -0,0 +1,114 @@
+/**
+ * @file webpa_component_health.h
+ *
+ * @description This file describes the health table of the components webpa
+ * routes requests to
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_COMPONENT_HEALTH_H_
+#define _WEBPA_COMPONENT_HEALTH_H_
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define WEBPA_COMPONENT_HEALTH_MAX              64
+#define WEBPA_COMPONENT_HEALTH_NAME_LEN         128
+/* Green components are probed once a minute, the others every few seconds */
+#define WEBPA_COMPONENT_HEALTH_INTERVAL_SEC     60
+#define WEBPA_COMPONENT_HEALTH_RETRY_SEC        5
+/* Consecutive failed health queries before a component is reported down */
+#define WEBPA_COMPONENT_HEALTH_DOWN_PROBES      3
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef enum
+{
+    COMPONENT_HEALTH_UNKNOWN = 0,   /**< Not watched or not probed yet */
+    COMPONENT_HEALTH_DOWN,          /**< Health queries keep failing, the component is not reachable */
+    COMPONENT_HEALTH_RED,           /**< Component answered with a health other than Green */
+    COMPONENT_HEALTH_GREEN          /**< Component answered Green */
+} ComponentHealth;
+
+/**
+ * @brief Queries the health of a component, called from the monitor without locks held.
+ */
+typedef ComponentHealth (*componentHealthProbeCB)(const char *compName, const char *dbusPath);
+
+/**
+ * @brief Snapshot of the monitor counters.
+ */
+typedef struct
+{
+    unsigned long watchedCount;     /**< Components in the table */
+    unsigned long probeCount;       /**< Health queries made */
+    unsigned long changeCount;      /**< Probes that changed the health of a component */
+} ComponentHealthStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief initComponentHealthMonitor sets the function that queries a component
+ *
+ * @param[in] probe health query
+ */
+void initComponentHealthMonitor(componentHealthProbeCB probe);
+
+/**
+ * @brief watchComponentHealth adds a component to the table, or updates its
+ * dbus path, and has it probed on the next run
+ *
+ * @param[in] compName component name
+ * @param[in] dbusPath dbus path
+ * @return 0 on success, -1 when the table is full
+ */
+int watchComponentHealth(const char *compName, const char *dbusPath);
+
+/**
+ * @brief getComponentHealth returns the last known health of a component
+ *
+ * @param[in] compName component name
+ * @return health, COMPONENT_HEALTH_UNKNOWN when the component is not watched
+ */
+ComponentHealth getComponentHealth(const char *compName);
+
+/**
+ * @brief waitForComponentHealth waits until a watched component is Green.
+ * Returns the current health right away when the monitor task is not running.
+ *
+ * @param[in] compName component name
+ * @param[in] timeoutSec longest wait
+ * @return health when the wait ended
+ */
+ComponentHealth waitForComponentHealth(const char *compName, unsigned int timeoutSec);
+
+/**
+ * @brief refreshComponentHealth has a watched component probed on the next run,
+ * used when an event hints that its health changed
+ *
+ * @param[in] compName component name
+ */
+void refreshComponentHealth(const char *compName);
+
+/**
+ * @brief runComponentHealthChecks probes every component that is due
+ *
+ * @return number of components probed
+ */
+int runComponentHealthChecks();
+
+/**
+ * @brief startComponentHealthTask starts the monitor thread
+ */
+void startComponentHealthTask();
+
+/**
+ * @brief getComponentHealthStats returns the monitor counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getComponentHealthStats(ComponentHealthStats *stats);
+
+#endif /* _WEBPA_COMPONENT_HEALTH_H_ */
@@ -0,0 +1,89 @@
+/**
+ * @file webpa_compression.h
+ *
+ * @description This file describes the gzip compression of large WRP payloads
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_COMPRESSION_H_
+#define _WEBPA_COMPRESSION_H_
+
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+/* Payloads smaller than this are sent as is, 0 disables compression */
+#define WEBPA_COMPRESS_THRESHOLD                4096
+#define WEBPA_COMPRESS_LEVEL                    6
+#define WEBPA_ACCEPT_ENCODING_HEADER            "Accept-Encoding:"
+#define WEBPA_CONTENT_ENCODING_GZIP             "Content-Encoding: gzip"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Snapshot of the compression counters.
+ */
+typedef struct
+{
+    unsigned long compressedCount;  /**< Payloads sent compressed */
+    unsigned long skippedCount;     /**< Payloads over the threshold that did not shrink */
+    unsigned long long bytesIn;     /**< Size of the compressed payloads before compression */
+    unsigned long long bytesOut;    /**< Size of the compressed payloads after compression */
+} WebpaCompressStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief setCompressConfig sets when payloads are compressed
+ *
+ * @param[in] threshold smallest payload compressed, 0 disables compression
+ * @param[in] compressEvents 1 to compress notifications as well, responses
+ * are only compressed for requests that accept gzip
+ */
+void setCompressConfig(size_t threshold, int compressEvents);
+
+/**
+ * @brief isEventCompressEnabled tells whether notifications are compressed
+ *
+ * @return 1 when enabled, 0 otherwise
+ */
+int isEventCompressEnabled();
+
+/**
+ * @brief acceptsCompression looks for "Accept-Encoding: gzip" in request headers
+ *
+ * @param[in] headers headers of the request, may be NULL
+ * @return 1 when the sender accepts gzip, 0 otherwise
+ */
+int acceptsCompression(const headers_t *headers);
+
+/**
+ * @brief compressPayload gzips a payload at or above the threshold
+ *
+ * @param[in] payload payload to compress
+ * @param[in] payloadSize payload length
+ * @param[out] compressed gzip payload, to be freed by the caller
+ * @param[out] compressedSize gzip payload length
+ * @return 0 when compressed, 1 when the payload is to be sent as is, -1 on failure
+ */
+int compressPayload(const void *payload, size_t payloadSize, void **compressed, size_t *compressedSize);
+
+/**
+ * @brief addContentEncoding appends the "Content-Encoding: gzip" header
+ *
+ * @param[inout] headers headers of the message, allocated when NULL
+ * @return 0 on success, -1 on failure
+ */
+int addContentEncoding(headers_t **headers);
+
+/**
+ * @brief getCompressStats returns the compression counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getCompressStats(WebpaCompressStats *stats);
+
+#endif /* _WEBPA_COMPRESSION_H_ */
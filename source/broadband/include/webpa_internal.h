@@ -47,18 +47,25 @@
 #define WAL_COMPONENT_INIT_RETRY_INTERVAL       10
 #define WEBPA_RETRY_MIN_COUNT                   1
 #define WEBPA_RETRY_MAX_COUNT                   4
-#define WEBPA_SYSTEM_READY_SLEEP                5
+/* CR is queried again if the system ready signal did not arrive within this many seconds */
+#define WEBPA_SYSTEM_READY_QUERY_INTERVAL       120
+#define WEBPA_SYSTEM_READY_MAX_WAIT             420
 #else
 #define WAL_COMPONENT_INIT_RETRY_COUNT          1
 #define WAL_COMPONENT_INIT_RETRY_INTERVAL       1
 #define WEBPA_RETRY_MIN_COUNT                   1
 #define WEBPA_RETRY_MAX_COUNT                   1
-#define WEBPA_SYSTEM_READY_SLEEP                1
+#define WEBPA_SYSTEM_READY_QUERY_INTERVAL       1
+#define WEBPA_SYSTEM_READY_MAX_WAIT             1
 #endif
+/* Left for scripts and for a restarted WebPA, readiness itself is signalled in process */
+#define WEBPA_CACHE_READY_FILE                  "/var/tmp/cacheready"
 
 #define CCSP_ERR_WIFI_BUSY			503
 #define CCSP_ERR_INVALID_WIFI_INDEX             504
 #define CCSP_ERR_INVALID_RADIO_INDEX            505
+/* Request not sent, the health monitor found the component unreachable */
+#define CCSP_ERR_COMPONENT_UNREACHABLE          506
 #define MAX_ROW_COUNT                           128
 #define NAME_VALUE_COUNT                        2 	
 
@@ -199,6 +206,33 @@ int getComponentDetails(char *parameterName,char ***compName,char ***dbusPath, i
  */
 void free_componentDetails(char **compName,char **dbusPath,int size);
 
+/**
+ * @brief publishComponentValCache makes the current ComponentValArray and
+ * SubComponentValArray visible to request threads as an immutable snapshot.
+ * Lookups started on the previous snapshot keep using it until they finish.
+ */
+void publishComponentValCache();
+
+/**
+ * @brief reportComponentFailure counts a failed call to a cached component. Objects
+ * of a component that keeps failing are rediscovered.
+ *
+ * @param[in] compName component name the call was routed to
+ * @param[in] dbusPath dbus path the call was routed to
+ * @param[in] ret CCSP status of the call
+ */
+void reportComponentFailure(const char *compName, const char *dbusPath, int ret);
+
+/**
+ * @brief isComponentReachable tells whether requests can be routed to a component.
+ * Only components the health monitor found unreachable are skipped, callers
+ * then fail the request with CCSP_ERR_COMPONENT_UNREACHABLE.
+ *
+ * @param[in] compName component name, with or without the subsystem prefix
+ * @return FALSE when the last WEBPA_COMPONENT_HEALTH_DOWN_PROBES health queries of the component failed
+ */
+BOOL isComponentReachable(const char *compName);
+
  /**
  * @brief prepareParamGroups groups parameters based on component 
  *
@@ -7,8 +7,10 @@
  */
 #include <cJSON.h>
 #include "stdlib.h"
+#include <time.h>
 #include "wdmp-c.h"
 #include "webpa_adapter.h"
+#include "webpa_notify_queue.h"
 
 
 /*----------------------------------------------------------------------------*/
@@ -93,6 +95,7 @@ typedef struct
         NodeData * node;
         DeviceStatus *device;
     } u;
+    struct timespec queueTime;      /**< when the notification was queued, used for latency metrics */
 } NotifyData;
 
 /**
@@ -141,5 +144,12 @@ WDMP_STATUS validate_conn_client_notify_data(char *notify_param_name, char* inte
 WDMP_STATUS validate_webpa_notification_data(char *notify_param_name, char *write_id);
 void FR_CloudSyncCheck();
 
+/**
+ * @brief getNotifyQueueTotals returns the counters of the notification queue summed over its priority classes
+ *
+ * @param[out] stats queue counters, latencyMaxMs is the largest of the classes
+ */
+void getNotifyQueueTotals(NotifyQueueStats *stats);
+
 int read_sync_notify_from_file();
 int write_sync_notify_into_file(char *buff);
\ No newline at end of file
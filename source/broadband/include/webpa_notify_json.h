@@ -0,0 +1,129 @@
+/**
+ * @file webpa_notify_json.h
+ *
+ * @description This file describes the JSON writer used to build outbound
+ * notification payloads
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_NOTIFY_JSON_H_
+#define _WEBPA_NOTIFY_JSON_H_
+
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+/* Fits every fixed-shape notification payload, larger ones move to the heap */
+#define WEBPA_NOTIFY_JSON_BUFFER_SIZE           1024
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Appends JSON straight into a caller provided buffer. Output matches
+ * cJSON_PrintUnformatted() for the same fields added in the same order.
+ */
+typedef struct
+{
+    char *buf;
+    size_t len;
+    size_t size;
+    int onHeap;         /**< buf outgrew the caller buffer and was allocated */
+    int needComma;
+    int failed;         /**< an allocation failed, output is incomplete */
+} NotifyJsonWriter;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief notifyJsonInit starts writing into buf
+ *
+ * @param[in] writer writer to set up
+ * @param[in] buf initial buffer, usually on the caller stack
+ * @param[in] size size of buf
+ */
+void notifyJsonInit(NotifyJsonWriter *writer, char *buf, size_t size);
+
+/**
+ * @brief notifyJsonRelease frees the heap buffer of a writer that outgrew its initial buffer
+ *
+ * @param[in] writer writer to release
+ */
+void notifyJsonRelease(NotifyJsonWriter *writer);
+
+/**
+ * @brief notifyJsonBeginObject opens an object
+ *
+ * @param[in] writer writer
+ * @param[in] key member name, NULL for the root or an array element
+ */
+void notifyJsonBeginObject(NotifyJsonWriter *writer, const char *key);
+
+/**
+ * @brief notifyJsonEndObject closes the current object
+ *
+ * @param[in] writer writer
+ */
+void notifyJsonEndObject(NotifyJsonWriter *writer);
+
+/**
+ * @brief notifyJsonBeginArray opens an array
+ *
+ * @param[in] writer writer
+ * @param[in] key member name
+ */
+void notifyJsonBeginArray(NotifyJsonWriter *writer, const char *key);
+
+/**
+ * @brief notifyJsonEndArray closes the current array
+ *
+ * @param[in] writer writer
+ */
+void notifyJsonEndArray(NotifyJsonWriter *writer);
+
+/**
+ * @brief notifyJsonAddString adds an escaped string member, skipped when value is NULL like cJSON
+ *
+ * @param[in] writer writer
+ * @param[in] key member name
+ * @param[in] value string value
+ */
+void notifyJsonAddString(NotifyJsonWriter *writer, const char *key, const char *value);
+
+/**
+ * @brief notifyJsonAddNumber adds an integer member
+ *
+ * @param[in] writer writer
+ * @param[in] key member name
+ * @param[in] value integer value
+ */
+void notifyJsonAddNumber(NotifyJsonWriter *writer, const char *key, long value);
+
+/**
+ * @brief notifyJsonAddRaw adds a member whose value is already serialized JSON
+ *
+ * @param[in] writer writer
+ * @param[in] key member name
+ * @param[in] json serialized value
+ */
+void notifyJsonAddRaw(NotifyJsonWriter *writer, const char *key, const char *json);
+
+/**
+ * @brief notifyJsonGet returns the JSON written so far
+ *
+ * @param[in] writer writer
+ * @return NUL terminated JSON or NULL when the writer failed
+ */
+const char * notifyJsonGet(NotifyJsonWriter *writer);
+
+/**
+ * @brief notifyJsonDetach returns the written JSON in a single allocation and releases the writer
+ *
+ * @param[in] writer writer
+ * @return JSON to be freed by the caller or NULL when the writer failed
+ */
+char * notifyJsonDetach(NotifyJsonWriter *writer);
+
+#endif /* _WEBPA_NOTIFY_JSON_H_ */
@@ -0,0 +1,126 @@
+/**
+ * @file webpa_notify_metrics.h
+ *
+ * @description This file describes the latency counters of the notification
+ * pipeline
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_NOTIFY_METRICS_H_
+#define _WEBPA_NOTIFY_METRICS_H_
+
+#include <stddef.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+/* Histogram bucket upper bounds in ms, the last bucket takes everything above */
+#define WEBPA_NOTIFY_LATENCY_BOUNDS_MS          {1, 5, 10, 50, 100, 500, 1000, 5000, 10000}
+#define WEBPA_NOTIFY_LATENCY_BUCKETS            10
+/* Processing time is kept per notification type, types at or above this share the last slot */
+#define WEBPA_NOTIFY_METRICS_MAX_TYPES          8
+#ifndef WEBPA_NOTIFY_METRICS_LOG_INTERVAL_SEC
+#define WEBPA_NOTIFY_METRICS_LOG_INTERVAL_SEC   900
+#endif
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Stages of the notification pipeline that are timed.
+ */
+typedef enum
+{
+    NOTIFY_METRIC_QUEUE_WAIT = 0,   /**< Enqueue to dequeue */
+    NOTIFY_METRIC_CMC_GET,          /**< Reading CMC */
+    NOTIFY_METRIC_CMC_SET,          /**< Updating CMC */
+    NOTIFY_METRIC_SETTLE,           /**< Wait for values to settle before a sync notification */
+    NOTIFY_METRIC_SEND,             /**< Handing one event to parodus */
+    NOTIFY_METRIC_END_TO_END,       /**< Enqueue to payload handed to the sender */
+    NOTIFY_METRIC_COUNT
+} NOTIFY_METRIC;
+
+/**
+ * @brief Snapshot of one latency histogram.
+ */
+typedef struct
+{
+    unsigned long count;
+    unsigned long totalMs;
+    unsigned long maxMs;
+    unsigned long buckets[WEBPA_NOTIFY_LATENCY_BUCKETS];
+} NotifyLatencyStats;
+
+/**
+ * @brief Adds lines of other pipeline counters to the periodic summary.
+ */
+typedef void (*notifyMetricsLogCB)();
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief notifyMetricsStart returns the start time of a timed stage
+ *
+ * @param[out] start monotonic start time
+ */
+void notifyMetricsStart(struct timespec *start);
+
+/**
+ * @brief recordNotifyLatency records the time since start for a pipeline stage
+ *
+ * @param[in] metric pipeline stage
+ * @param[in] start time returned by notifyMetricsStart()
+ */
+void recordNotifyLatency(NOTIFY_METRIC metric, const struct timespec *start);
+
+/**
+ * @brief recordNotifyProcessLatency records the processing time of one notification
+ *
+ * @param[in] type notification type
+ * @param[in] start time returned by notifyMetricsStart()
+ */
+void recordNotifyProcessLatency(int type, const struct timespec *start);
+
+/**
+ * @brief getNotifyLatencyStats returns the histogram of a pipeline stage
+ *
+ * @param[in] metric pipeline stage
+ * @param[out] stats histogram snapshot
+ */
+void getNotifyLatencyStats(NOTIFY_METRIC metric, NotifyLatencyStats *stats);
+
+/**
+ * @brief getNotifyProcessLatencyStats returns the processing time histogram of a notification type
+ *
+ * @param[in] type notification type
+ * @param[out] stats histogram snapshot
+ */
+void getNotifyProcessLatencyStats(int type, NotifyLatencyStats *stats);
+
+/**
+ * @brief formatNotifyLatencyStats prints a histogram as
+ * "count=N,avg=N,max=N,le1=N,...,le10000=N,inf=N"
+ *
+ * @param[in] stats histogram
+ * @param[out] buf output buffer
+ * @param[in] size size of buf
+ * @return length of the formatted text, may exceed size like snprintf
+ */
+int formatNotifyLatencyStats(const NotifyLatencyStats *stats, char *buf, size_t size);
+
+/**
+ * @brief logNotifyMetrics logs every non empty histogram
+ */
+void logNotifyMetrics();
+
+/**
+ * @brief startNotifyMetricsTask logs the summary periodically from the shared timer task
+ *
+ * @param[in] intervalSec seconds between summaries, 0 disables the summary
+ * @param[in] logExtra logs other pipeline counters along with the summary, may be NULL
+ */
+void startNotifyMetricsTask(unsigned int intervalSec, notifyMetricsLogCB logExtra);
+
+#endif /* _WEBPA_NOTIFY_METRICS_H_ */
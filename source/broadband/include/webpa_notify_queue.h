@@ -0,0 +1,213 @@
+/**
+ * @file webpa_notify_queue.h
+ *
+ * @description This file describes the bounded notification queue used between
+ * the stack callbacks (producers) and the notification task (consumer)
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_NOTIFY_QUEUE_H_
+#define _WEBPA_NOTIFY_QUEUE_H_
+
+#include <pthread.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#ifndef WEBPA_NOTIFY_QUEUE_CAPACITY
+#define WEBPA_NOTIFY_QUEUE_CAPACITY             1024
+#endif
+#define WEBPA_NOTIFY_QUEUE_MAX_CAPACITY         65536
+#define WEBPA_NOTIFY_PRIORITY_MAX_CLASSES       8
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Action taken by a producer when the queue is full.
+ */
+typedef enum
+{
+    NOTIFY_QUEUE_DROP_NEWEST = 0,   /**< Reject the new message, producer never waits */
+    NOTIFY_QUEUE_BLOCK              /**< Producer waits until the consumer frees a slot */
+} NOTIFY_QUEUE_OVERFLOW_POLICY;
+
+typedef struct
+{
+    volatile unsigned long sequence;
+    void *data;
+    struct timespec enqueueTime;
+} NotifyQueueCell;
+
+/**
+ * @brief Bounded multi-producer single-consumer ring. Producers reserve a slot
+ * with a single atomic compare-and-swap, the consumer never takes a lock unless
+ * the ring is empty and it has to sleep.
+ */
+typedef struct
+{
+    NotifyQueueCell *cells;
+    unsigned long mask;
+    unsigned int capacity;
+    NOTIFY_QUEUE_OVERFLOW_POLICY policy;
+    volatile unsigned long enqueuePos;
+    volatile unsigned long dequeuePos;
+    volatile unsigned long enqueueCount;
+    volatile unsigned long dequeueCount;
+    volatile unsigned long dropCount;
+    volatile unsigned long highWatermark;
+    volatile unsigned long long latencyTotalMs;
+    volatile unsigned long latencyMaxMs;
+    volatile int consumerWaiting;
+    volatile int producersWaiting;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+} NotifyQueue;
+
+/**
+ * @brief Snapshot of the queue counters.
+ */
+typedef struct
+{
+    unsigned int capacity;
+    unsigned long depth;
+    unsigned long enqueueCount;
+    unsigned long dequeueCount;
+    unsigned long dropCount;
+    unsigned long highWatermark;
+    unsigned long latencyAvgMs;     /**< Average time from push to pop */
+    unsigned long latencyMaxMs;
+} NotifyQueueStats;
+
+/**
+ * @brief Set of rings, one per priority class, drained by a single consumer.
+ * The consumer takes up to weight messages from a class before each lower
+ * class gets its turn, so a busy high class can not starve the others and a
+ * flood in a low class delays a high class message by at most one round.
+ */
+typedef struct
+{
+    NotifyQueue *queues[WEBPA_NOTIFY_PRIORITY_MAX_CLASSES];
+    unsigned int weights[WEBPA_NOTIFY_PRIORITY_MAX_CLASSES];
+    unsigned int credits[WEBPA_NOTIFY_PRIORITY_MAX_CLASSES];
+    unsigned int classCount;
+    volatile int consumerWaiting;
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+} NotifyPriorityQueue;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief notifyQueueCreate creates a bounded notification queue
+ *
+ * @param[in] capacity number of slots, rounded up to the next power of two
+ * @param[in] policy action taken when the queue is full
+ * @return NotifyQueue* queue or NULL on allocation failure
+ */
+NotifyQueue * notifyQueueCreate(unsigned int capacity, NOTIFY_QUEUE_OVERFLOW_POLICY policy);
+
+/**
+ * @brief notifyQueueDestroy releases the queue. Messages still queued are not freed.
+ *
+ * @param[in] queue queue to destroy
+ */
+void notifyQueueDestroy(NotifyQueue *queue);
+
+/**
+ * @brief notifyQueuePush adds a message to the queue. Safe to call from any thread.
+ *
+ * @param[in] queue queue to add to
+ * @param[in] data message to add
+ * @return 0 on success, -1 when the message was dropped
+ */
+int notifyQueuePush(NotifyQueue *queue, void *data);
+
+/**
+ * @brief notifyQueuePop removes the oldest message without waiting. Consumer thread only.
+ *
+ * @param[in] queue queue to remove from
+ * @return oldest message or NULL when the queue is empty
+ */
+void * notifyQueuePop(NotifyQueue *queue);
+
+/**
+ * @brief notifyQueuePeek returns the oldest message without removing it. Consumer thread only.
+ *
+ * @param[in] queue queue to read
+ * @return oldest message or NULL when the queue is empty
+ */
+void * notifyQueuePeek(NotifyQueue *queue);
+
+/**
+ * @brief notifyQueueWait blocks the consumer until the queue is not empty.
+ *
+ * @param[in] queue queue to wait on
+ */
+void notifyQueueWait(NotifyQueue *queue);
+
+/**
+ * @brief notifyQueueGetStats returns the queue counters
+ *
+ * @param[in] queue queue to read
+ * @param[out] stats counters snapshot
+ */
+void notifyQueueGetStats(NotifyQueue *queue, NotifyQueueStats *stats);
+
+/**
+ * @brief notifyPriorityQueueCreate creates one bounded ring per priority class
+ *
+ * @param[in] classCount number of classes, class 0 has the highest priority
+ * @param[in] capacity number of slots of each class ring
+ * @param[in] weights messages taken from each class per round, 0 is treated as 1
+ * @param[in] policy action taken when a class ring is full
+ * @return NotifyPriorityQueue* queue or NULL on failure
+ */
+NotifyPriorityQueue * notifyPriorityQueueCreate(unsigned int classCount, unsigned int capacity, const unsigned int *weights, NOTIFY_QUEUE_OVERFLOW_POLICY policy);
+
+/**
+ * @brief notifyPriorityQueueDestroy releases the queue. Messages still queued are not freed.
+ *
+ * @param[in] queue queue to destroy
+ */
+void notifyPriorityQueueDestroy(NotifyPriorityQueue *queue);
+
+/**
+ * @brief notifyPriorityQueuePush adds a message to a class. Safe to call from any thread.
+ *
+ * @param[in] queue queue to add to
+ * @param[in] priorityClass class of the message
+ * @param[in] data message to add
+ * @return 0 on success, -1 when the message was dropped
+ */
+int notifyPriorityQueuePush(NotifyPriorityQueue *queue, unsigned int priorityClass, void *data);
+
+/**
+ * @brief notifyPriorityQueuePop removes the next message by weighted priority. Consumer thread only.
+ *
+ * @param[in] queue queue to remove from
+ * @param[out] priorityClass class of the message, may be NULL
+ * @return next message or NULL when every class is empty
+ */
+void * notifyPriorityQueuePop(NotifyPriorityQueue *queue, unsigned int *priorityClass);
+
+/**
+ * @brief notifyPriorityQueueWait blocks the consumer until a class is not empty.
+ *
+ * @param[in] queue queue to wait on
+ */
+void notifyPriorityQueueWait(NotifyPriorityQueue *queue);
+
+/**
+ * @brief notifyPriorityQueueGetStats returns the counters of one class
+ *
+ * @param[in] queue queue to read
+ * @param[in] priorityClass class to read
+ * @param[out] stats counters snapshot
+ */
+void notifyPriorityQueueGetStats(NotifyPriorityQueue *queue, unsigned int priorityClass, NotifyQueueStats *stats);
+
+#endif /* _WEBPA_NOTIFY_QUEUE_H_ */
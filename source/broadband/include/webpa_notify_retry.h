@@ -0,0 +1,80 @@
+/**
+ * @file webpa_notify_retry.h
+ *
+ * @description This file describes the retry scheduler for outbound
+ * notifications that parodus did not accept
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_NOTIFY_RETRY_H_
+#define _WEBPA_NOTIFY_RETRY_H_
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define WEBPA_NOTIFY_MAX_RETRY_COUNT            3
+/* Retry n waits 2^(n+2)-1 seconds, capped at 2^WEBPA_NOTIFY_RETRY_BACKOFF_MAX-1 */
+#define WEBPA_NOTIFY_RETRY_BACKOFF_MAX          7
+/* Up to this much is added at random to every retry timer */
+#define WEBPA_NOTIFY_RETRY_JITTER_MSEC          1000
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Sends one scheduled message, returns 0 when it was accepted.
+ */
+typedef int (*notifyRetrySendCB)(void *data);
+
+/**
+ * @brief Releases a message that was sent or dropped.
+ */
+typedef void (*notifyRetryFreeCB)(void *data);
+
+/**
+ * @brief Snapshot of the retry counters.
+ */
+typedef struct
+{
+    unsigned long pendingCount;
+    unsigned long retryCount;
+    unsigned long retrySuccessCount;
+    unsigned long dropCount;
+    long oldestPendingAgeSec;
+} NotifyRetryStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief scheduleNotifyRetry hands over a message whose first send failed.
+ * The caller returns right away, the message is retried with its own backoff.
+ *
+ * @param[in] data message to retry
+ * @param[in] send sends the message
+ * @param[in] freeData releases the message once it is sent or dropped, may be NULL
+ * @param[in] maxRetries retries before the message is dropped, 0 retries until sent
+ * @return 0 on success, -1 when the message could not be scheduled
+ */
+int scheduleNotifyRetry(void *data, notifyRetrySendCB send, notifyRetryFreeCB freeData, int maxRetries);
+
+/**
+ * @brief runNotifyRetries retries every message that is due
+ *
+ * @return number of messages still waiting to be retried
+ */
+int runNotifyRetries();
+
+/**
+ * @brief startNotifyRetryTask runs due retries from the shared timer task
+ */
+void startNotifyRetryTask();
+
+/**
+ * @brief getNotifyRetryStats returns the retry counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getNotifyRetryStats(NotifyRetryStats *stats);
+
+#endif /* _WEBPA_NOTIFY_RETRY_H_ */
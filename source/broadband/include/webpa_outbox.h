@@ -0,0 +1,160 @@
+/**
+ * @file webpa_outbox.h
+ *
+ * @description This file describes the disk-backed outbox that keeps outbound
+ * notifications until parodus has accepted them
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_OUTBOX_H_
+#define _WEBPA_OUTBOX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#if defined(BUILD_YOCTO)
+    #define WEBPA_OUTBOX_FILE                   "/nvram/webpa_outbox.bin"
+#else
+    #define WEBPA_OUTBOX_FILE                   "/tmp/webpa_outbox.bin"
+#endif
+#ifndef WEBPA_OUTBOX_SIZE
+#define WEBPA_OUTBOX_SIZE                       (256 * 1024)
+#endif
+#ifndef WEBPA_OUTBOX_MAX_AGE_SEC
+#define WEBPA_OUTBOX_MAX_AGE_SEC                (24 * 60 * 60)
+#endif
+/* Rejected sends after which an event no longer holds back the events behind it */
+#ifndef WEBPA_OUTBOX_MAX_ATTEMPTS
+#define WEBPA_OUTBOX_MAX_ATTEMPTS               5
+#endif
+/* Changes stay in the page cache in between, the outbox flushes them at most once per interval */
+#ifndef WEBPA_OUTBOX_SYNC_INTERVAL_SEC
+#define WEBPA_OUTBOX_SYNC_INTERVAL_SEC          30
+#endif
+/* Values returned by outboxSendCB */
+#define WEBPA_OUTBOX_SEND_OK                    0
+#define WEBPA_OUTBOX_SEND_FAILED                -1
+#define WEBPA_OUTBOX_SEND_REJECTED              -2
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Append-only log of outbound events in a memory-mapped file. Events
+ * are added before they are sent and acknowledged once parodus accepted them,
+ * acknowledged and expired events are reclaimed when the log runs out of space.
+ */
+typedef struct
+{
+    char *path;
+    int fd;
+    unsigned char *map;
+    size_t mapSize;
+    unsigned int capacity;
+    unsigned int maxAgeSec;
+    int dirty;
+    time_t lastSync;
+    unsigned long pendingCount;
+    unsigned long appendCount;
+    unsigned long ackCount;
+    unsigned long dropCount;
+    unsigned long expiredCount;
+    unsigned long syncCount;
+    pthread_mutex_t mutex;
+} NotifyOutbox;
+
+/**
+ * @brief Snapshot of the outbox counters.
+ */
+typedef struct
+{
+    unsigned int capacity;
+    unsigned int used;
+    unsigned long pendingCount;
+    unsigned long appendCount;
+    unsigned long ackCount;
+    unsigned long dropCount;
+    unsigned long expiredCount;
+    unsigned long syncCount;
+} NotifyOutboxStats;
+
+/**
+ * @brief Sends one replayed event.
+ *
+ * @return WEBPA_OUTBOX_SEND_OK when the event was accepted and can be acknowledged,
+ * WEBPA_OUTBOX_SEND_REJECTED when this event can not be sent (e.g. it fails to encode),
+ * WEBPA_OUTBOX_SEND_FAILED or any other value when parodus did not take it
+ */
+typedef int (*outboxSendCB)(const char *source, const char *dest, const char *payload, size_t payloadLen, void *userData);
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief outboxOpen maps the outbox file, events left by a previous run are kept
+ *
+ * @param[in] path outbox file
+ * @param[in] capacity size of the event area in bytes
+ * @param[in] maxAgeSec events older than this are dropped instead of sent
+ * @return NotifyOutbox* outbox or NULL when the file can not be mapped
+ */
+NotifyOutbox * outboxOpen(const char *path, unsigned int capacity, unsigned int maxAgeSec);
+
+/**
+ * @brief outboxClose flushes pending changes and unmaps the outbox
+ *
+ * @param[in] outbox outbox to close
+ */
+void outboxClose(NotifyOutbox *outbox);
+
+/**
+ * @brief outboxAppend adds an event as pending. When the outbox is full,
+ * acknowledged and expired events are reclaimed first, then the oldest pending ones.
+ *
+ * @param[in] outbox outbox to add to
+ * @param[in] source event source
+ * @param[in] dest event destination
+ * @param[in] payload event payload, may be NULL
+ * @param[in] payloadLen payload length
+ * @param[out] seq sequence number used to acknowledge the event, may be NULL
+ * @return 0 on success, -1 when the event does not fit
+ */
+int outboxAppend(NotifyOutbox *outbox, const char *source, const char *dest, const char *payload, size_t payloadLen, uint64_t *seq);
+
+/**
+ * @brief outboxAck marks an event as sent
+ *
+ * @param[in] outbox outbox
+ * @param[in] seq sequence number returned by outboxAppend
+ * @return 0 on success, -1 when the event is no longer in the outbox
+ */
+int outboxAck(NotifyOutbox *outbox, uint64_t seq);
+
+/**
+ * @brief outboxReplay sends pending events oldest first and acknowledges each
+ * one the callback accepted. Stops at the first event that could not be sent
+ * and leaves it and the events behind it as they are. Only rejected events count
+ * as attempts: once an event was rejected WEBPA_OUTBOX_MAX_ATTEMPTS times it is
+ * skipped, and dropped once an event behind it was sent in the same replay.
+ *
+ * @param[in] outbox outbox
+ * @param[in] send callback sending one event, called without the outbox lock held
+ * @param[in] userData passed to the callback
+ * @return number of events sent, -1 when an event could not be sent
+ */
+int outboxReplay(NotifyOutbox *outbox, outboxSendCB send, void *userData);
+
+/**
+ * @brief outboxGetStats returns the outbox counters
+ *
+ * @param[in] outbox outbox to read
+ * @param[out] stats counters snapshot
+ */
+void outboxGetStats(NotifyOutbox *outbox, NotifyOutboxStats *stats);
+
+#endif /* _WEBPA_OUTBOX_H_ */
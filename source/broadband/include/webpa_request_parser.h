@@ -0,0 +1,59 @@
+/**
+ * @file webpa_request_parser.h
+ *
+ * @description This file describes the parser of WebPA request payloads
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_REQUEST_PARSER_H_
+#define _WEBPA_REQUEST_PARSER_H_
+
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Parser that built a request, tells how it is freed.
+ */
+typedef enum
+{
+    WEBPA_PARSER_NONE = 0,      /**< Payload was not a valid request */
+    WEBPA_PARSER_FAST,          /**< Plain GET or SET, built in a single allocation */
+    WEBPA_PARSER_FULL           /**< Built by wdmp_parse_request */
+} WEBPA_REQUEST_PARSER;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief parseWebpaRequest parses a request payload, plain GET and SET requests
+ * are parsed in place and the others are handed to wdmp_parse_request
+ *
+ * @param[in] payload JSON request payload
+ * @param[out] reqObj parsed request, freed with freeWebpaRequest()
+ * @return parser that built the request
+ */
+WEBPA_REQUEST_PARSER parseWebpaRequest(char *payload, req_struct **reqObj);
+
+/**
+ * @brief parseFastRequest parses {"command":"GET","names":[...]} and
+ * {"command":"SET","parameters":[{"name","value","dataType"}...]} requests.
+ * The request, its arrays and strings share one allocation.
+ *
+ * @param[in] payload JSON request payload, need not be NULL terminated
+ * @param[in] payloadSize payload length
+ * @param[out] reqObj parsed request, to be freed with free()
+ * @return 0 on success, -1 when the payload needs the full parser
+ */
+int parseFastRequest(const char *payload, size_t payloadSize, req_struct **reqObj);
+
+/**
+ * @brief freeWebpaRequest frees a request built by parseWebpaRequest()
+ *
+ * @param[in] reqObj request, may be NULL
+ * @param[in] parser parser that built the request
+ */
+void freeWebpaRequest(req_struct *reqObj, WEBPA_REQUEST_PARSER parser);
+
+#endif /* _WEBPA_REQUEST_PARSER_H_ */
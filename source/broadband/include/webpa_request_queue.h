@@ -0,0 +1,168 @@
+/**
+ * @file webpa_request_queue.h
+ *
+ * @description This file describes the queue that hands received requests
+ * to a pool of worker threads, by weighted priority class
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_REQUEST_QUEUE_H_
+#define _WEBPA_REQUEST_QUEUE_H_
+
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#ifndef WEBPA_REQUEST_WORKERS
+#define WEBPA_REQUEST_WORKERS                   4
+#endif
+/* One per wdmp REQ_TYPE, GET through DELETE_ROW */
+#define WEBPA_REQUEST_TYPES                     8
+/* Default admission limits, 0 disables a limit */
+#define WEBPA_REQUEST_MAX_IN_FLIGHT             32
+#define WEBPA_REQUEST_MAX_WAIT_MS               20000
+/* Requests taken from each class per round */
+#define WEBPA_REQUEST_CLASS_WEIGHT_CONTROL      8
+#define WEBPA_REQUEST_CLASS_WEIGHT_INTERACTIVE  4
+#define WEBPA_REQUEST_CLASS_WEIGHT_BULK         1
+/* GET and SET payloads larger than this are bulk */
+#define WEBPA_REQUEST_SMALL_PAYLOAD             1024
+#define WEBPA_REQUEST_BULK_SOURCES_MAX          8
+#define WEBPA_REQUEST_SOURCE_LEN                64
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Scheduling class of a request, class 0 has the highest priority.
+ */
+typedef enum
+{
+    REQUEST_CLASS_CONTROL = 0,      /**< TEST_AND_SET, reboot and other small SETs */
+    REQUEST_CLASS_INTERACTIVE,      /**< Small GETs, row adds and deletes */
+    REQUEST_CLASS_BULK,             /**< Wildcard or large GETs, REPLACE_ROWS, bulk sources */
+    REQUEST_CLASS_COUNT
+} REQUEST_CLASS;
+
+/**
+ * @brief Processes a request and sends its response, the callee owns the request.
+ */
+typedef void (*webpaRequestCB)(void *request);
+
+/**
+ * @brief Answers a request refused by admission control, the callee owns the request.
+ */
+typedef void (*webpaRejectCB)(void *request, int reqType);
+
+/**
+ * @brief Admission limits, 0 disables a limit.
+ */
+typedef struct
+{
+    unsigned int maxInFlight;                       /**< Requests queued or processed at once */
+    unsigned int maxPerType[WEBPA_REQUEST_TYPES];   /**< Same, per request type */
+    unsigned int maxWaitMs;                         /**< Longest wait for a worker */
+} WebpaRequestLimits;
+
+/**
+ * @brief Snapshot of the queue counters.
+ */
+typedef struct
+{
+    unsigned long submittedCount;   /**< Requests handed to the queue */
+    unsigned long completedCount;   /**< Requests processed */
+    unsigned long pendingCount;     /**< Requests waiting for a worker */
+    unsigned long activeCount;      /**< Requests being processed */
+    unsigned long maxActiveCount;   /**< Most requests processed at the same time */
+    unsigned long rejectedCount;    /**< Requests refused when submitted */
+    unsigned long expiredCount;     /**< Requests refused after waiting too long */
+    unsigned long submittedPerClass[REQUEST_CLASS_COUNT];   /**< Requests queued in each class */
+} WebpaRequestStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief initRequestQueue sets the functions that process and reject a request
+ *
+ * @param[in] handler called for each request by a worker
+ * @param[in] rejectHandler called by a worker for a request that waited too long
+ */
+void initRequestQueue(webpaRequestCB handler, webpaRejectCB rejectHandler);
+
+/**
+ * @brief setWebpaRequestLimits sets the admission limits, requests already
+ * queued are not affected
+ *
+ * @param[in] limits new limits
+ */
+void setWebpaRequestLimits(const WebpaRequestLimits *limits);
+
+/**
+ * @brief getWebpaRequestLimits returns the admission limits
+ *
+ * @param[out] limits current limits
+ */
+void getWebpaRequestLimits(WebpaRequestLimits *limits);
+
+/**
+ * @brief setWebpaRequestBulkSources sets the source services whose requests
+ * are always bulk, e.g. data harvesters
+ *
+ * @param[in] sources source service names
+ * @param[in] count number of names, at most WEBPA_REQUEST_BULK_SOURCES_MAX are kept
+ */
+void setWebpaRequestBulkSources(const char **sources, int count);
+
+/**
+ * @brief getWebpaRequestClass classifies a request by type, payload and source
+ *
+ * @param[in] reqType wdmp request type, -1 when unknown
+ * @param[in] payload request payload, may not be NULL terminated
+ * @param[in] payloadSize payload length
+ * @param[in] sourceService source service of the request, may be NULL
+ * @return class of the request
+ */
+REQUEST_CLASS getWebpaRequestClass(int reqType, const char *payload, size_t payloadSize, const char *sourceService);
+
+/**
+ * @brief submitWebpaRequest queues a request for the workers
+ *
+ * @param[in] request request, owned by the queue on success
+ * @param[in] reqType wdmp request type, -1 when unknown. Unknown requests
+ * only count against maxInFlight.
+ * @param[in] reqClass scheduling class of the request
+ * @return 0 when queued, 1 when over a limit and the caller has to reject it,
+ * -1 when the caller has to process it itself
+ */
+int submitWebpaRequest(void *request, int reqType, REQUEST_CLASS reqClass);
+
+/**
+ * @brief processNextRequest processes the next queued request in the calling
+ * thread, or rejects it when it waited longer than maxWaitMs. Each class is
+ * served up to its weight per round, oldest request first. Writes (SET,
+ * SET_ATTRIBUTES, TEST_AND_SET and table requests) run one at a time, a write
+ * waiting for another one is skipped in favour of the requests behind it.
+ *
+ * @return 1 when a request was taken, 0 when no queued request can be taken
+ */
+int processNextRequest();
+
+/**
+ * @brief startRequestWorkers starts the worker threads, requests are only
+ * queued once they run
+ *
+ * @param[in] count number of workers
+ * @return number of workers started
+ */
+int startRequestWorkers(unsigned int count);
+
+/**
+ * @brief getWebpaRequestStats returns the queue counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getWebpaRequestStats(WebpaRequestStats *stats);
+
+#endif /* _WEBPA_REQUEST_QUEUE_H_ */
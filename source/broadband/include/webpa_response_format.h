@@ -0,0 +1,79 @@
+/**
+ * @file webpa_response_format.h
+ *
+ * @description This file describes the encodings of a WebPA response payload
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_RESPONSE_FORMAT_H_
+#define _WEBPA_RESPONSE_FORMAT_H_
+
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define CONTENT_TYPE_MSGPACK                    "application/msgpack"
+#define WEBPA_ACCEPT_HEADER                     "Accept:"
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief getResponseFormat picks the response encoding asked for by a request,
+ * either by its content type or by an "Accept: application/msgpack" header.
+ * The request payload itself is always JSON.
+ *
+ * @param[in] contentType content type of the request, may be NULL
+ * @param[in] headers headers of the request, may be NULL
+ * @return WEBPA_FORMAT_MSGPACK when asked for, WEBPA_FORMAT_JSON otherwise
+ */
+WEBPA_RESPONSE_FORMAT getResponseFormat(const char *contentType, const headers_t *headers);
+
+/**
+ * @brief formMsgpackResponse encodes a response as msgpack with the same
+ * schema as the JSON of wdmp_form_response. Successful GET responses and
+ * statusCode/message error responses are packed directly, the others are
+ * converted from their JSON form.
+ *
+ * @param[in] resObj response to encode
+ * @param[out] payload msgpack payload, to be freed by the caller
+ * @param[out] payloadSize payload length
+ * @return 0 on success, -1 on failure
+ */
+int formMsgpackResponse(res_struct *resObj, char **payload, size_t *payloadSize);
+
+/**
+ * @brief estimateJsonResponseSize returns the exact buffer size of the JSON
+ * of a successful GET response, written without building a cJSON tree
+ *
+ * @param[in] resObj response to encode
+ * @return size including the terminating NULL, 0 when the response is left to
+ * wdmp_form_response
+ */
+size_t estimateJsonResponseSize(const res_struct *resObj);
+
+/**
+ * @brief formJsonResponse encodes a response as JSON. Successful GET responses
+ * are written into a single buffer of estimateJsonResponseSize() bytes, the
+ * others are formed by wdmp_form_response.
+ *
+ * @param[in] resObj response to encode
+ * @param[out] payload JSON payload, to be freed by the caller
+ * @param[out] payloadSize payload length
+ * @return 0 on success, -1 on failure
+ */
+int formJsonResponse(res_struct *resObj, char **payload, size_t *payloadSize);
+
+/**
+ * @brief convertJsonToMsgpack encodes a JSON document as msgpack, objects
+ * become maps and integral numbers become integers
+ *
+ * @param[in] json JSON text
+ * @param[out] payload msgpack payload, to be freed by the caller
+ * @param[out] payloadSize payload length
+ * @return 0 on success, -1 on failure
+ */
+int convertJsonToMsgpack(const char *json, char **payload, size_t *payloadSize);
+
+#endif /* _WEBPA_RESPONSE_FORMAT_H_ */
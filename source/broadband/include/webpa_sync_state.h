@@ -0,0 +1,104 @@
+/**
+ * @file webpa_sync_state.h
+ *
+ * @description This file describes the in-memory CMC/CID sync state shared by
+ * the notification path and the Webpa data model
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_SYNC_STATE_H_
+#define _WEBPA_SYNC_STATE_H_
+
+#include "wdmp-c.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define SYNC_STATE_CMC_NAME                 "X_COMCAST-COM_CMC"
+#define SYNC_STATE_CID_NAME                 "X_COMCAST-COM_CID"
+#define SYNC_STATE_CID_LEN                  64
+#define SYNC_STATE_STORE_RETRY_SEC          5
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Persists one sync state value, name is SYNC_STATE_CMC_NAME or SYNC_STATE_CID_NAME.
+ */
+typedef WDMP_STATUS (*syncStateStoreCB)(const char *name, const char *value);
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief initSyncState seeds the sync state with the values loaded from DB and
+ * starts the write-behind thread. Until it is called every getter returns failure.
+ *
+ * @param[in] cmc CMC value loaded from DB
+ * @param[in] cid CID value loaded from DB
+ * @param[in] store callback used to persist updated values
+ */
+void initSyncState(unsigned int cmc, const char *cid, syncStateStoreCB store);
+
+/**
+ * @brief isSyncStateInitialized returns 1 once initSyncState has been called
+ */
+int isSyncStateInitialized();
+
+/**
+ * @brief getSyncStateCMC returns the current CMC
+ *
+ * @param[out] cmc current CMC
+ * @return WDMP_SUCCESS or WDMP_FAILURE when the state is not initialized
+ */
+WDMP_STATUS getSyncStateCMC(unsigned int *cmc);
+
+/**
+ * @brief getSyncStateCID returns a copy of the current CID, caller frees it
+ *
+ * @param[out] cid current CID
+ * @return WDMP_SUCCESS or WDMP_FAILURE when the state is not initialized
+ */
+WDMP_STATUS getSyncStateCID(char **cid);
+
+/**
+ * @brief getSyncStateValues copies CMC and CID taken together under the state lock
+ *
+ * @param[out] cmc current CMC
+ * @param[out] cid buffer receiving the current CID
+ * @param[in] cidLen size of the cid buffer
+ * @return WDMP_SUCCESS or WDMP_FAILURE when the state is not initialized
+ */
+WDMP_STATUS getSyncStateValues(unsigned int *cmc, char *cid, size_t cidLen);
+
+/**
+ * @brief updateSyncStateCMC updates CMC in memory and queues it for persistence
+ *
+ * @param[in] cmc new CMC
+ * @return WDMP_SUCCESS or WDMP_FAILURE when the state is not initialized
+ */
+WDMP_STATUS updateSyncStateCMC(unsigned int cmc);
+
+/**
+ * @brief updateSyncStateCID updates CID in memory and queues it for persistence
+ *
+ * @param[in] cid new CID
+ * @return WDMP_SUCCESS or WDMP_FAILURE when the state is not initialized
+ */
+WDMP_STATUS updateSyncStateCID(const char *cid);
+
+/**
+ * @brief refreshSyncStateCMC/refreshSyncStateCID update memory with a value the
+ * caller has already written to DB, nothing is queued for persistence
+ */
+void refreshSyncStateCMC(unsigned int cmc);
+void refreshSyncStateCID(const char *cid);
+
+/**
+ * @brief flushSyncState persists pending values in the caller thread
+ *
+ * @return WDMP_SUCCESS when nothing is left pending
+ */
+WDMP_STATUS flushSyncState();
+
+#endif /* _WEBPA_SYNC_STATE_H_ */
@@ -0,0 +1,94 @@
+/**
+ * @file webpa_timer.h
+ *
+ * @description This file describes the timer wheel shared by the background
+ * retry and window tasks, and the work thread running its blocking callbacks
+ *
+ * Copyright (c) 2015  Comcast
+ */
+#ifndef _WEBPA_TIMER_H_
+#define _WEBPA_TIMER_H_
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define WEBPA_TIMER_TICK_MSEC                   100
+/* 64 slots per level, level n holds timers due within 64^(n+1) ticks */
+#define WEBPA_TIMER_WHEEL_BITS                  6
+#define WEBPA_TIMER_WHEEL_LEVELS                4
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Called on the timer thread once the timer expired, must not block for long.
+ * Callbacks scheduled with scheduleWebpaWork() run on the work thread and may block.
+ */
+typedef void (*webpaTimerCB)(void *arg);
+
+/**
+ * @brief Snapshot of the timer wheel counters.
+ */
+typedef struct
+{
+    unsigned long pendingCount;
+    unsigned long firedCount;
+    unsigned long cancelledCount;
+    unsigned long workPendingCount;     /**< Expired work waiting for the work thread */
+} WebpaTimerStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief scheduleWebpaTimer runs a callback once after a delay
+ *
+ * @param[in] delayMs delay in milliseconds, rounded up to the tick
+ * @param[in] jitterMs up to this many milliseconds are added at random, 0 for none
+ * @param[in] cb callback
+ * @param[in] arg callback argument
+ * @return timer id to cancel the timer, 0 on failure
+ */
+unsigned long scheduleWebpaTimer(unsigned long delayMs, unsigned long jitterMs, webpaTimerCB cb, void *arg);
+
+/**
+ * @brief scheduleWebpaWork runs a callback once after a delay on the work thread,
+ * for callbacks that call D-Bus or send to parodus. Work runs one at a time.
+ *
+ * @param[in] delayMs delay in milliseconds, rounded up to the tick
+ * @param[in] jitterMs up to this many milliseconds are added at random, 0 for none
+ * @param[in] cb callback
+ * @param[in] arg callback argument
+ * @return timer id to cancel the work before it expired, 0 on failure
+ */
+unsigned long scheduleWebpaWork(unsigned long delayMs, unsigned long jitterMs, webpaTimerCB cb, void *arg);
+
+/**
+ * @brief cancelWebpaTimer removes a timer that did not fire yet
+ *
+ * @param[in] timerId id returned by scheduleWebpaTimer() or scheduleWebpaWork()
+ * @return 0 when the timer was cancelled, -1 when it already fired or is unknown
+ */
+int cancelWebpaTimer(unsigned long timerId);
+
+/**
+ * @brief runWebpaTimers advances the wheel to the current time and runs the expired callbacks,
+ * expired work is handed to the work thread
+ *
+ * @return number of callbacks run
+ */
+int runWebpaTimers();
+
+/**
+ * @brief startWebpaTimerTask starts the thread driving the wheel, later calls do nothing
+ */
+void startWebpaTimerTask();
+
+/**
+ * @brief getWebpaTimerStats returns the timer wheel counters
+ *
+ * @param[out] stats counters snapshot
+ */
+void getWebpaTimerStats(WebpaTimerStats *stats);
+
+#endif /* _WEBPA_TIMER_H_ */
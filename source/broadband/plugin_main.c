@@ -63,6 +63,8 @@ COSA_Init
     pPlugInfo->RegisterFunction(pPlugInfo->hContext, "WebpaServer_GetParamStringValue", WebpaServer_GetParamStringValue);
     pPlugInfo->RegisterFunction(pPlugInfo->hContext, "WebpaTokenServer_GetParamStringValue", WebpaTokenServer_GetParamStringValue);
     pPlugInfo->RegisterFunction(pPlugInfo->hContext, "WebpaDNSText_GetParamStringValue", WebpaDNSText_GetParamStringValue);
+    pPlugInfo->RegisterFunction(pPlugInfo->hContext, "WebpaStatistics_GetParamUlongValue", WebpaStatistics_GetParamUlongValue);
+    pPlugInfo->RegisterFunction(pPlugInfo->hContext, "WebpaStatistics_GetParamStringValue", WebpaStatistics_GetParamStringValue);
 #ifdef WEBCONFIG_BIN_SUPPORT
     pPlugInfo->RegisterFunction(pPlugInfo->hContext, "X_RDK_Webpa_SetParamStringValue", X_RDK_Webpa_SetParamStringValue);
 #endif
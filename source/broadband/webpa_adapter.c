@@ -9,6 +9,8 @@
 #include "webpa_notification.h"
 #include "webpa_internal.h"
 #include "webpa_rbus.h"
+#include "webpa_response_format.h"
+#include "webpa_request_parser.h"
 #ifdef FEATURE_SUPPORT_WEBCONFIG
 #include <webcfg_generic.h>
 #endif
@@ -18,14 +20,31 @@
 
 #define WEBPA_DEVICE_REBOOT_PARAM          "Device.X_CISCO_COM_DeviceControl.RebootDevice"
 #define WEBPA_DEVICE_REBOOT_VALUE          "Device"
+#define WEBPA_REQUEST_COMMAND_KEY          "\"command\""
 
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
+typedef struct
+{
+    const char *command;
+    REQ_TYPE reqType;
+} RequestCommand;
 
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
+// command names as sent by the server, matched exactly
+static const RequestCommand requestCommands[] = {
+    {"GET", GET},
+    {"GET_ATTRIBUTES", GET_ATTRIBUTES},
+    {"SET", SET},
+    {"SET_ATTRIBUTES", SET_ATTRIBUTES},
+    {"TEST_AND_SET", TEST_AND_SET},
+    {"REPLACE_ROWS", REPLACE_ROWS},
+    {"ADD_ROW", ADD_ROWS},
+    {"DELETE_ROW", DELETE_ROW}
+};
 
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
@@ -34,17 +53,103 @@ static WDMP_STATUS validate_cmc_and_cid(test_set_req_t *testSetReq, char *dbCMC,
 static WDMP_STATUS set_cmc_and_cid(char *dbCMC, char *cid, int isNew);
 static WDMP_STATUS validate_table_object(table_req_t *tableObj);
 static void setRebootReason(param_t param, WEBPA_SET_TYPE setType);
+static const char * findInPayload(const char *payload, size_t payloadSize, const char *key);
+static int lookupRequestCommand(const char *command, size_t len);
 
 extern ANSC_HANDLE bus_handle;
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
+int getRequestType(const char *payload, size_t payloadSize)
+{
+	const char *cur = NULL, *end = NULL, *command = NULL;
+
+	if(payload == NULL)
+	{
+		return -1;
+	}
+	end = payload + payloadSize;
+	cur = findInPayload(payload, payloadSize, WEBPA_REQUEST_COMMAND_KEY);
+	if(cur == NULL)
+	{
+		return -1;
+	}
+	cur += strlen(WEBPA_REQUEST_COMMAND_KEY);
+	while(cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r' || *cur == ':'))
+	{
+		cur++;
+	}
+	if(cur >= end || *cur != '"')
+	{
+		return -1;
+	}
+	command = ++cur;
+	while(cur < end && *cur != '"')
+	{
+		cur++;
+	}
+	if(cur >= end)
+	{
+		return -1;
+	}
+	return lookupRequestCommand(command, cur - command);
+}
+
+int getRequestTypeByName(const char *command)
+{
+	if(command == NULL)
+	{
+		return -1;
+	}
+	return lookupRequestCommand(command, strlen(command));
+}
+
+void formRejectResponse(int reqType, WDMP_STATUS status, char **resPayload)
+{
+	res_struct *resObj = NULL;
+
+	*resPayload = NULL;
+	resObj = (res_struct *) malloc(sizeof(res_struct));
+	if(resObj == NULL)
+	{
+		return;
+	}
+	memset(resObj, 0, sizeof(res_struct));
+	resObj->reqType = (reqType >= 0) ? (REQ_TYPE) reqType : GET;
+	resObj->paramCnt = 1;
+	resObj->retStatus = (WDMP_STATUS *) malloc(sizeof(WDMP_STATUS));
+	if(resObj->retStatus == NULL)
+	{
+		wdmp_free_res_struct(resObj);
+		return;
+	}
+	*resObj->retStatus = status;
+	// same shape as a request that failed validation
+	if(resObj->reqType == SET || resObj->reqType == SET_ATTRIBUTES)
+	{
+		resObj->u.paramRes = (param_res_t *) malloc(sizeof(param_res_t));
+		if(resObj->u.paramRes != NULL)
+		{
+			memset(resObj->u.paramRes, 0, sizeof(param_res_t));
+		}
+	}
+	wdmp_form_response(resObj, resPayload);
+	WalPrint("Reject response payload : %s\n", (*resPayload != NULL) ? *resPayload : "NULL");
+	wdmp_free_res_struct(resObj);
+}
+
 
 void processRequest(char *reqPayload,char *transactionId, char **resPayload, headers_t *req_headers, headers_t *res_headers)
+{
+        processRequestFormat(reqPayload, transactionId, WEBPA_FORMAT_JSON, resPayload, NULL, req_headers, res_headers);
+}
+
+WEBPA_RESPONSE_FORMAT processRequestFormat(char *reqPayload, char *transactionId, WEBPA_RESPONSE_FORMAT format, char **resPayload, size_t *resPayloadSize, headers_t *req_headers, headers_t *res_headers)
 {
         req_struct *reqObj = NULL;
         res_struct *resObj = NULL;
         char *payload = NULL;
+        size_t payloadSize = 0;
         WDMP_STATUS ret = WDMP_FAILURE, setRet = WDMP_FAILURE;
         int paramCount = 0, i = 0, wildcardParamCount = 0,nonWildcardParamCount = 0, retCount=0, index = 0, error = 0;
 	int ccspStatus = 0;
@@ -54,13 +159,15 @@ void processRequest(char *reqPayload,char *transactionId, char **resPayload, hea
         WDMP_STATUS setCidStatus = WDMP_SUCCESS, setCmcStatus = WDMP_SUCCESS;
         const char *wildcardList[1];
         char *param = NULL;
+        size_t paramLen = 0;
+        WEBPA_REQUEST_PARSER parser = WEBPA_PARSER_NONE;
 	char *dbCID = NULL;
 	char *dbCMC = NULL;
 	char newCMC[32]={'\0'};
 	
         WalPrint("************** processRequest *****************\n");
         
-        wdmp_parse_request(reqPayload,&reqObj);
+        parser = parseWebpaRequest(reqPayload, &reqObj);
         (req_headers != NULL && req_headers->headers[0] != NULL && req_headers->headers[1] != NULL) ? WalInfo("transactionId : %s, traceParent : %s, traceState : %s in request\n", transactionId, req_headers->headers[0], req_headers->headers[1]) : WalInfo("transactionId in request: %s\n", transactionId);
         OnboardLog("%s\n",transactionId);
         
@@ -97,14 +204,15 @@ void processRequest(char *reqPayload,char *transactionId, char **resPayload, hea
                                                 error = 1;
 						break;
 					}
-                                        if(strlen(param) >= MAX_PARAMETERNAME_LEN)
+                                        paramLen = strlen(param);
+                                        if(paramLen >= MAX_PARAMETERNAME_LEN)
                                         {
                                                 *resObj->retStatus = WDMP_ERR_INVALID_PARAM;
                                                 error = 1;
                                                 break;
                                         }
 
-                                        if(param[(strlen(param)-1)] == '.')
+                                        if(param[paramLen - 1] == '.')
                                         {
                                                 wildcardGetParamList[wildcardParamCount] = param;
                                                 wildcardParamCount++; 
@@ -198,14 +306,15 @@ void processRequest(char *reqPayload,char *transactionId, char **resPayload, hea
                                 for (i = 0; i < paramCount; i++) 
                                 {
                                         WalPrint("Request:> paramNames[%d] = %s\n",i,reqObj->u.getReq->paramNames[i]);
-                                        if(strlen(reqObj->u.getReq->paramNames[i]) >= MAX_PARAMETERNAME_LEN)
+                                        paramLen = strlen(reqObj->u.getReq->paramNames[i]);
+                                        if(paramLen >= MAX_PARAMETERNAME_LEN)
                                         {
                                                 *resObj->retStatus = WDMP_ERR_INVALID_PARAM;
                                                 error = 1;
                                                 break;
                                         }
 
-                                        if(reqObj->u.getReq->paramNames[i][(strlen(reqObj->u.getReq->paramNames[i])-1)] == '.')
+                                        if(reqObj->u.getReq->paramNames[i][paramLen - 1] == '.')
                                         {
                                                 *resObj->retStatus = WDMP_ERR_WILDCARD_NOT_SUPPORTED;
                                                 error = 1;
@@ -536,21 +645,29 @@ void processRequest(char *reqPayload,char *transactionId, char **resPayload, hea
 		WalError("Command is NULL\n");
 	}
 
-        wdmp_form_response(resObj,&payload);
-        WalPrint("payload : %s\n",payload);
+        if(format == WEBPA_FORMAT_MSGPACK && formMsgpackResponse(resObj, &payload, &payloadSize) == 0)
+        {
+                WalPrint("Response:> msgpack payload size = %zu\n", payloadSize);
+        }
+        else
+        {
+                format = WEBPA_FORMAT_JSON;
+                formJsonResponse(resObj, &payload, &payloadSize);
+                WalPrint("Response:> Payload = %s\n", payload);
+        }
         *resPayload = payload;
-        
-        WalPrint("Response:> Payload = %s\n", *resPayload);
-        
-        if(NULL != reqObj)
+        if(resPayloadSize != NULL)
         {
-                wdmp_free_req_struct(reqObj);
+                *resPayloadSize = payloadSize;
         }
+        
+        freeWebpaRequest(reqObj, parser);
         if(NULL != resObj)
         {
                 wdmp_free_res_struct(resObj);
         }
         WalPrint("************** processRequest *****************\n");
+        return format;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -774,3 +891,34 @@ static void setRebootReason(param_t param, WEBPA_SET_TYPE setType)
 	}
 	
 }
+
+/*
+ * @brief findInPayload returns the first occurrence of key in the payload, which may not be NULL terminated
+ */
+static const char * findInPayload(const char *payload, size_t payloadSize, const char *key)
+{
+	size_t keyLen = strlen(key), i = 0;
+
+	for(i = 0; i + keyLen <= payloadSize; i++)
+	{
+		if(payload[i] == key[0] && strncmp(payload + i, key, keyLen) == 0)
+		{
+			return payload + i;
+		}
+	}
+	return NULL;
+}
+
+static int lookupRequestCommand(const char *command, size_t len)
+{
+	size_t i = 0;
+
+	for(i = 0; i < sizeof(requestCommands)/sizeof(requestCommands[0]); i++)
+	{
+		if(strlen(requestCommands[i].command) == len && strncmp(requestCommands[i].command, command, len) == 0)
+		{
+			return requestCommands[i].reqType;
+		}
+	}
+	return -1;
+}
@@ -7,10 +7,12 @@
  */
 
 #include "webpa_internal.h"
+#include "webpa_attribute_cache.h"
 
 /*----------------------------------------------------------------------------*/
 /*                                   Macros                                   */
 /*----------------------------------------------------------------------------*/
+#define WEBPA_ATTR_VALUE_LEN                    12
 
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
@@ -25,6 +27,8 @@
 /*----------------------------------------------------------------------------*/
 static int getParamAttributes(char *parameterNames[], int paramCount, char *CompName, char *dbusPath, money_trace_spans *timeSpan, param_t **attr, int index);
 static int setParamAttributes(param_t *attArr,int paramCount, money_trace_spans *timeSpan);
+static void orderAttrsByRequest(const char *paramName[], int paramCount, param_t *attr);
+static char * formatAttrValue(int notification);
 
 extern BOOL applySettingsFlag;
 /*----------------------------------------------------------------------------*/
@@ -34,7 +38,7 @@ extern BOOL applySettingsFlag;
 
 void getAttributes(const char *paramName[], const unsigned int paramCount, money_trace_spans *timeSpan, param_t **attr, int *retAttrCount, WDMP_STATUS *retStatus)
 {
-	int cnt1=0,cnt2=0, ret = -1, index = 0,error = 0, compCount=0, count =0, i= 0;
+	int cnt1=0,cnt2=0, ret = -1, index = 0,error = 0, compCount=0, count =0, i= 0, notification = 0;
 	char parameterName[MAX_PARAMETERNAME_LEN] = {'\0'};
 	ParamCompList *ParamGroup = NULL;
 	char **compName = NULL;
@@ -42,6 +46,16 @@ void getAttributes(const char *paramName[], const unsigned int paramCount, money
 	
 	for(cnt1 = 0; cnt1 < paramCount; cnt1++)
 	{
+		// Attributes set by WebPA itself are answered from the local mirror
+		if(lookupAttrCache(paramName[cnt1], &notification) == 0)
+		{
+			WalPrint("Attribute of %s served from cache\n", paramName[cnt1]);
+			(*attr)[index].name = strdup(paramName[cnt1]);
+			(*attr)[index].value = formatAttrValue(notification);
+			(*attr)[index].type = WDMP_INT;
+			index++;
+			continue;
+		}
 		// Get the matching component index from cache
 		walStrncpy(parameterName,paramName[cnt1],sizeof(parameterName));
 		// To get list of component name and dbuspath
@@ -60,6 +74,10 @@ void getAttributes(const char *paramName[], const unsigned int paramCount, money
 	}//End of for loop
 	   
 	WalPrint("Number of parameter groups : %d\n",compCount);
+	if(error != 1 && compCount == 0 && index > 0)
+	{
+		ret = CCSP_SUCCESS;
+	}
 	if(error != 1)
 	{
 		for(cnt1 = 0; cnt1 < compCount; cnt1++)
@@ -91,6 +109,11 @@ void getAttributes(const char *paramName[], const unsigned int paramCount, money
 		}
 	}
 	
+	if(ret == CCSP_SUCCESS && index > 0 && compCount > 0)
+	{
+		// cache hits were filled ahead of the bus results
+		orderAttrsByRequest(paramName, paramCount, *attr);
+	}
 	*retStatus = mapStatus(ret);
 	*retAttrCount = paramCount;	
 	
@@ -176,13 +199,10 @@ static int getParamAttributes(char *parameterNames[], int paramCount, char *Comp
 			        
 		                WalPrint("Stack:> success: %s %d \n",ppAttrArray[cnt]->parameterName,ppAttrArray[cnt]->notification);
 		                
-				(*attr)[index].name = (char *) malloc(sizeof(char) * MAX_PARAMETERNAME_LEN);
-				(*attr)[index].value = (char *) malloc(sizeof(char) * MAX_PARAMETERVALUE_LEN);
-
 				IndexMpa_CPEtoWEBPA(&ppAttrArray[cnt]->parameterName);
 				WalPrint("ppAttrArray[cnt]->parameterName : %s\n",ppAttrArray[cnt]->parameterName);
-				walStrncpy((*attr)[index].name, ppAttrArray[cnt]->parameterName,MAX_PARAMETERNAME_LEN);
-				sprintf((*attr)[index].value, "%d", ppAttrArray[cnt]->notification);
+				(*attr)[index].name = strdup(ppAttrArray[cnt]->parameterName);
+				(*attr)[index].value = formatAttrValue(ppAttrArray[cnt]->notification);
 				(*attr)[index].type = WDMP_INT;
 				WalPrint("success: %s %s %d \n",(*attr)[index].name,(*attr)[index].value,(*attr)[index].type);
 				index++;
@@ -329,6 +349,15 @@ static int setParamAttributes(param_t *attArr,int paramCount, money_trace_spans
 		}
 		for (cnt = 0; cnt < paramCount; cnt++) 
 		{
+			if (CCSP_SUCCESS == ret)
+			{
+				addAttrCache(attArr[cnt].name, compName[0], attriStruct[cnt].notification);
+			}
+			else
+			{
+				// the component may have applied part of the request
+				invalidateAttrCacheByName(attArr[cnt].name);
+			}
 			WAL_FREE(attriStruct[cnt].parameterName);
 		}
 	}
@@ -337,3 +366,41 @@ static int setParamAttributes(param_t *attArr,int paramCount, money_trace_spans
 	return ret;
 }
 
+/*
+ * @brief orderAttrsByRequest Moves the attributes into the order of the requested names
+ */
+static void orderAttrsByRequest(const char *paramName[], int paramCount, param_t *attr)
+{
+	int i = 0, j = 0;
+	param_t tmp;
+
+	for(i = 0; i < paramCount; i++)
+	{
+		for(j = i; j < paramCount; j++)
+		{
+			if(attr[j].name != NULL && strcmp(attr[j].name, paramName[i]) == 0)
+			{
+				break;
+			}
+		}
+		if(j < paramCount && j != i)
+		{
+			tmp = attr[i];
+			attr[i] = attr[j];
+			attr[j] = tmp;
+		}
+	}
+}
+
+/*
+ * @brief formatAttrValue Returns the notification attribute as an allocated string
+ */
+static char * formatAttrValue(int notification)
+{
+	char *value = (char *) malloc(WEBPA_ATTR_VALUE_LEN);
+	if(value != NULL)
+	{
+		snprintf(value, WEBPA_ATTR_VALUE_LEN, "%d", notification);
+	}
+	return value;
+}
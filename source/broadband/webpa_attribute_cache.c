@@ -0,0 +1,342 @@
+/**
+ * @file webpa_attribute_cache.c
+ *
+ * @description This file describes a bounded LRU mirror of the notification
+ * attributes WebPA set on the stack. Entries expire, attributes changed by
+ * other management interfaces are read from the bus again.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "webpa_attribute_cache.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct _AttrCacheEntry
+{
+    char *name;
+    char *compName;
+    unsigned int hash;
+    int notification;
+    time_t setTime;
+    struct _AttrCacheEntry *hashNext;
+    struct _AttrCacheEntry *lruPrev;
+    struct _AttrCacheEntry *lruNext;
+} AttrCacheEntry;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static AttrCacheEntry *cacheBuckets[WEBPA_ATTR_CACHE_BUCKETS];
+static AttrCacheEntry *lruHead = NULL;
+static AttrCacheEntry *lruTail = NULL;
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static AttrCacheStats cacheStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static unsigned int hashName(const char *name);
+static time_t cacheNow();
+static AttrCacheEntry * findEntry(const char *name);
+static void unlinkEntry(AttrCacheEntry *entry);
+static void removeFromBucket(AttrCacheEntry *entry);
+static void pushFront(AttrCacheEntry *entry);
+static void freeEntry(AttrCacheEntry *entry);
+static int dropEntries(const char *compName, const char *name);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+int lookupAttrCache(const char *name, int *notification)
+{
+	AttrCacheEntry *entry = NULL;
+	int rc = -1;
+
+	if(name == NULL || name[0] == '\0')
+	{
+		return -1;
+	}
+	pthread_mutex_lock(&cacheMutex);
+	entry = findEntry(name);
+	if(entry != NULL && cacheNow() - entry->setTime >= WEBPA_ATTR_CACHE_TTL_SEC)
+	{
+		unlinkEntry(entry);
+		removeFromBucket(entry);
+		cacheStats.entryCount--;
+		cacheStats.expiredCount++;
+		freeEntry(entry);
+		entry = NULL;
+	}
+	if(entry != NULL)
+	{
+		unlinkEntry(entry);
+		pushFront(entry);
+		*notification = entry->notification;
+		cacheStats.hitCount++;
+		rc = 0;
+	}
+	else
+	{
+		cacheStats.missCount++;
+	}
+	pthread_mutex_unlock(&cacheMutex);
+	return rc;
+}
+
+void addAttrCache(const char *name, const char *compName, int notification)
+{
+	AttrCacheEntry *entry = NULL, *evicted = NULL;
+	size_t len = 0;
+
+	if(name == NULL || compName == NULL)
+	{
+		return;
+	}
+	len = strlen(name);
+	if(len == 0 || name[len - 1] == '.')
+	{
+		// leaves below the object may now have another attribute
+		invalidateAttrCacheByName(name);
+		return;
+	}
+	pthread_mutex_lock(&cacheMutex);
+	entry = findEntry(name);
+	if(entry != NULL)
+	{
+		unlinkEntry(entry);
+	}
+	else
+	{
+		entry = (AttrCacheEntry *) calloc(1, sizeof(AttrCacheEntry));
+		if(entry != NULL)
+		{
+			entry->name = strdup(name);
+			entry->compName = strdup(compName);
+		}
+		if(entry == NULL || entry->name == NULL || entry->compName == NULL)
+		{
+			pthread_mutex_unlock(&cacheMutex);
+			if(entry != NULL)
+			{
+				free(entry->name);
+				free(entry->compName);
+			}
+			free(entry);
+			WalError("Failed to allocate attribute cache entry\n");
+			return;
+		}
+		entry->hash = hashName(name);
+		entry->hashNext = cacheBuckets[entry->hash];
+		cacheBuckets[entry->hash] = entry;
+		if(cacheStats.entryCount >= WEBPA_ATTR_CACHE_MAX_ENTRIES)
+		{
+			evicted = lruTail;
+			unlinkEntry(evicted);
+			removeFromBucket(evicted);
+			cacheStats.evictionCount++;
+			cacheStats.entryCount--;
+		}
+		cacheStats.entryCount++;
+	}
+	entry->notification = notification;
+	entry->setTime = cacheNow();
+	pushFront(entry);
+	pthread_mutex_unlock(&cacheMutex);
+
+	if(evicted != NULL)
+	{
+		WalPrint("Attribute cache is full, evicted %s\n", evicted->name);
+		freeEntry(evicted);
+	}
+	WalPrint("Cached attribute of %s\n", name);
+}
+
+int invalidateAttrCacheByName(const char *name)
+{
+	int count = 0;
+
+	if(name == NULL || name[0] == '\0')
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&cacheMutex);
+	count = dropEntries(NULL, name);
+	pthread_mutex_unlock(&cacheMutex);
+	if(count > 0)
+	{
+		WalPrint("Dropped %d cached attribute(s) of %s\n", count, name);
+	}
+	return count;
+}
+
+int invalidateAttrCache(const char *compName)
+{
+	int count = 0;
+
+	pthread_mutex_lock(&cacheMutex);
+	count = dropEntries(compName, NULL);
+	pthread_mutex_unlock(&cacheMutex);
+	if(count > 0)
+	{
+		WalInfo("Dropped %d cached attribute(s) of %s\n", count, (compName != NULL) ? compName : "all components");
+	}
+	return count;
+}
+
+void getAttrCacheStats(AttrCacheStats *stats)
+{
+	pthread_mutex_lock(&cacheMutex);
+	*stats = cacheStats;
+	pthread_mutex_unlock(&cacheMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static unsigned int hashName(const char *name)
+{
+	unsigned int hash = 5381;
+
+	while(*name != '\0')
+	{
+		hash = ((hash << 5) + hash) + (unsigned char) *name++;
+	}
+	return hash % WEBPA_ATTR_CACHE_BUCKETS;
+}
+
+/*
+ * @brief cacheNow returns the monotonic time in seconds used to age the entries
+ */
+static time_t cacheNow()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec;
+}
+
+/*
+ * @brief findEntry returns the entry of a parameter name, caller holds cacheMutex
+ */
+static AttrCacheEntry * findEntry(const char *name)
+{
+	AttrCacheEntry *entry = NULL;
+
+	for(entry = cacheBuckets[hashName(name)]; entry != NULL; entry = entry->hashNext)
+	{
+		if(strcmp(entry->name, name) == 0)
+		{
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief unlinkEntry takes an entry out of the LRU list, caller holds cacheMutex
+ */
+static void unlinkEntry(AttrCacheEntry *entry)
+{
+	if(entry->lruPrev != NULL)
+	{
+		entry->lruPrev->lruNext = entry->lruNext;
+	}
+	else if(lruHead == entry)
+	{
+		lruHead = entry->lruNext;
+	}
+	if(entry->lruNext != NULL)
+	{
+		entry->lruNext->lruPrev = entry->lruPrev;
+	}
+	else if(lruTail == entry)
+	{
+		lruTail = entry->lruPrev;
+	}
+	entry->lruPrev = NULL;
+	entry->lruNext = NULL;
+}
+
+/*
+ * @brief removeFromBucket takes an entry out of its hash bucket, caller holds cacheMutex
+ */
+static void removeFromBucket(AttrCacheEntry *entry)
+{
+	AttrCacheEntry **link = &cacheBuckets[entry->hash];
+
+	while(*link != NULL)
+	{
+		if(*link == entry)
+		{
+			*link = entry->hashNext;
+			break;
+		}
+		link = &(*link)->hashNext;
+	}
+	entry->hashNext = NULL;
+}
+
+/*
+ * @brief pushFront makes an entry the most recently used, caller holds cacheMutex
+ */
+static void pushFront(AttrCacheEntry *entry)
+{
+	entry->lruPrev = NULL;
+	entry->lruNext = lruHead;
+	if(lruHead != NULL)
+	{
+		lruHead->lruPrev = entry;
+	}
+	lruHead = entry;
+	if(lruTail == NULL)
+	{
+		lruTail = entry;
+	}
+}
+
+static void freeEntry(AttrCacheEntry *entry)
+{
+	WAL_FREE(entry->name);
+	WAL_FREE(entry->compName);
+	WAL_FREE(entry);
+}
+
+/*
+ * @brief dropEntries removes the entries of a component, or the entry of a name
+ * and the entries below it when the name is an object. With both NULL every
+ * entry is removed. Caller holds cacheMutex.
+ */
+static int dropEntries(const char *compName, const char *name)
+{
+	AttrCacheEntry *entry = NULL, *next = NULL;
+	size_t len = (name != NULL) ? strlen(name) : 0;
+	int object = (len > 0 && name[len - 1] == '.') ? 1 : 0;
+	int count = 0;
+
+	for(entry = lruHead; entry != NULL; entry = next)
+	{
+		next = entry->lruNext;
+		if(compName != NULL && strcmp(entry->compName, compName) != 0)
+		{
+			continue;
+		}
+		if(name != NULL && (object ? strncmp(entry->name, name, len) : strcmp(entry->name, name)) != 0)
+		{
+			continue;
+		}
+		unlinkEntry(entry);
+		removeFromBucket(entry);
+		freeEntry(entry);
+		cacheStats.entryCount--;
+		count++;
+	}
+	return count;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file webpa_client_notify.c
+ *
+ * @description This file describes the per client aggregation window for
+ * connected client notifications. Changes of one client inside the window are
+ * collapsed into its latest state and a window that ends in the state last
+ * reported (a flap) is not reported again.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
+#include "webpa_client_notify.h"
+#include "webpa_timer.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct
+{
+    char mac[WEBPA_CLIENT_NOTIFY_MAC_LEN];
+    int used;
+    int emitted;
+    unsigned int lastSignature;
+    void *pending;
+    unsigned int pendingSignature;
+    struct timespec windowEnd;
+    time_t lastActivity;
+} ClientNotifyEntry;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static ClientNotifyEntry clientTable[WEBPA_CLIENT_NOTIFY_MAX_CLIENTS];
+static pthread_mutex_t clientMutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int clientWindowSec = 0;
+static clientNotifyEmitCB emitClientCB = NULL;
+static clientNotifyFreeCB freeClientCB = NULL;
+static int clientTaskStarted = 0;
+static unsigned long clientTimerId = 0;
+static ClientNotifyStats clientStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static void clientNotifyTimerCB(void *arg);
+static void armClientTimer();
+static ClientNotifyEntry * getClientEntry(const char *mac, time_t now);
+static ClientNotifyEntry * getEarliestWindow();
+static int isWindowEnded(struct timespec *windowEnd, struct timespec *now);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void initClientNotifyAggregator(unsigned int windowSec, clientNotifyEmitCB emit, clientNotifyFreeCB freeNode)
+{
+	pthread_mutex_lock(&clientMutex);
+	clientWindowSec = windowSec;
+	emitClientCB = emit;
+	freeClientCB = freeNode;
+	pthread_mutex_unlock(&clientMutex);
+	WalInfo("Connected client notification window is %u seconds\n", windowSec);
+}
+
+int aggregateClientNotify(const char *mac, unsigned int signature, void *node)
+{
+	ClientNotifyEntry *entry = NULL;
+	struct timespec now;
+	void *replaced = NULL;
+
+	if(mac == NULL || node == NULL)
+	{
+		return -1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&clientMutex);
+	if(clientWindowSec == 0 || emitClientCB == NULL || (entry = getClientEntry(mac, now.tv_sec)) == NULL)
+	{
+		pthread_mutex_unlock(&clientMutex);
+		return -1;
+	}
+	if(entry->pending != NULL)
+	{
+		replaced = entry->pending;
+		clientStats.mergedCount++;
+	}
+	else
+	{
+		entry->windowEnd = now;
+		entry->windowEnd.tv_sec += clientWindowSec;
+		clientStats.pendingCount++;
+		// a later window never ends before the armed one
+		if(clientTimerId == 0)
+		{
+			armClientTimer();
+		}
+	}
+	entry->pending = node;
+	entry->pendingSignature = signature;
+	entry->lastActivity = now.tv_sec;
+	clientStats.receivedCount++;
+	pthread_mutex_unlock(&clientMutex);
+
+	if(replaced != NULL)
+	{
+		WalPrint("Client %s changed again inside its window, keeping latest state\n", mac);
+		if(freeClientCB != NULL)
+		{
+			freeClientCB(replaced);
+		}
+	}
+	return 0;
+}
+
+int flushClientNotify(int force)
+{
+	void *emitList[WEBPA_CLIENT_NOTIFY_MAX_CLIENTS];
+	void *freeList[WEBPA_CLIENT_NOTIFY_MAX_CLIENTS];
+	int emitCount = 0, freeCount = 0, pending = 0, i = 0;
+	ClientNotifyEntry *entry = NULL;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&clientMutex);
+	for(i = 0; i < WEBPA_CLIENT_NOTIFY_MAX_CLIENTS; i++)
+	{
+		entry = &clientTable[i];
+		if(!entry->used || entry->pending == NULL || (!force && !isWindowEnded(&entry->windowEnd, &now)))
+		{
+			continue;
+		}
+		if(entry->emitted && entry->pendingSignature == entry->lastSignature)
+		{
+			WalPrint("Client %s is back in its last reported state, not notifying\n", entry->mac);
+			freeList[freeCount++] = entry->pending;
+			clientStats.suppressedCount++;
+		}
+		else
+		{
+			emitList[emitCount++] = entry->pending;
+			entry->lastSignature = entry->pendingSignature;
+			entry->emitted = 1;
+			clientStats.emittedCount++;
+		}
+		entry->pending = NULL;
+		clientStats.pendingCount--;
+	}
+	pending = (int) clientStats.pendingCount;
+	armClientTimer();
+	pthread_mutex_unlock(&clientMutex);
+
+	for(i = 0; i < emitCount; i++)
+	{
+		emitClientCB(emitList[i]);
+	}
+	for(i = 0; i < freeCount && freeClientCB != NULL; i++)
+	{
+		freeClientCB(freeList[i]);
+	}
+	if(emitCount > 0 || freeCount > 0)
+	{
+		WalInfo("Connected client window ended: %d notified, %d suppressed\n", emitCount, freeCount);
+	}
+	return pending;
+}
+
+void startClientNotifyTask()
+{
+	pthread_mutex_lock(&clientMutex);
+	if(clientTaskStarted)
+	{
+		pthread_mutex_unlock(&clientMutex);
+		return;
+	}
+	clientTaskStarted = 1;
+	armClientTimer();
+	pthread_mutex_unlock(&clientMutex);
+	startWebpaTimerTask();
+	WalInfo("Connected client windows are ended from the timer task\n");
+}
+
+void getClientNotifyStats(ClientNotifyStats *stats)
+{
+	int i = 0;
+
+	pthread_mutex_lock(&clientMutex);
+	*stats = clientStats;
+	stats->trackedCount = 0;
+	for(i = 0; i < WEBPA_CLIENT_NOTIFY_MAX_CLIENTS; i++)
+	{
+		if(clientTable[i].used)
+		{
+			stats->trackedCount++;
+		}
+	}
+	pthread_mutex_unlock(&clientMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static void clientNotifyTimerCB(void *arg)
+{
+	(void) arg;
+	pthread_mutex_lock(&clientMutex);
+	clientTimerId = 0;
+	pthread_mutex_unlock(&clientMutex);
+	flushClientNotify(0);
+}
+
+/*
+ * @brief armClientTimer points the window timer at the window ending first, caller holds clientMutex
+ */
+static void armClientTimer()
+{
+	ClientNotifyEntry *earliest = NULL;
+	struct timespec now;
+	long delayMs = 0;
+
+	if(!clientTaskStarted)
+	{
+		return;
+	}
+	if(clientTimerId != 0)
+	{
+		cancelWebpaTimer(clientTimerId);
+		clientTimerId = 0;
+	}
+	earliest = getEarliestWindow();
+	if(earliest == NULL)
+	{
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	delayMs = (earliest->windowEnd.tv_sec - now.tv_sec) * 1000 + (earliest->windowEnd.tv_nsec - now.tv_nsec) / 1000000;
+	clientTimerId = scheduleWebpaTimer((delayMs > 0) ? (unsigned long) delayMs : 0, 0, clientNotifyTimerCB, NULL);
+}
+
+/*
+ * @brief getClientEntry finds the entry of a client or takes a free one. When the
+ * table is full the least recently changed client without an open window is replaced.
+ * Caller holds clientMutex.
+ */
+static ClientNotifyEntry * getClientEntry(const char *mac, time_t now)
+{
+	ClientNotifyEntry *freeEntry = NULL, *oldest = NULL;
+	int i = 0;
+
+	for(i = 0; i < WEBPA_CLIENT_NOTIFY_MAX_CLIENTS; i++)
+	{
+		if(!clientTable[i].used)
+		{
+			if(freeEntry == NULL)
+			{
+				freeEntry = &clientTable[i];
+			}
+		}
+		else if(strcasecmp(clientTable[i].mac, mac) == 0)
+		{
+			return &clientTable[i];
+		}
+		else if(clientTable[i].pending == NULL && (oldest == NULL || clientTable[i].lastActivity < oldest->lastActivity))
+		{
+			oldest = &clientTable[i];
+		}
+	}
+
+	if(freeEntry == NULL)
+	{
+		freeEntry = oldest;
+	}
+	if(freeEntry != NULL)
+	{
+		memset(freeEntry, 0, sizeof(ClientNotifyEntry));
+		snprintf(freeEntry->mac, sizeof(freeEntry->mac), "%s", mac);
+		freeEntry->used = 1;
+		freeEntry->lastActivity = now;
+	}
+	return freeEntry;
+}
+
+/*
+ * @brief getEarliestWindow returns the pending client whose window ends first, caller holds clientMutex
+ */
+static ClientNotifyEntry * getEarliestWindow()
+{
+	ClientNotifyEntry *earliest = NULL;
+	int i = 0;
+
+	for(i = 0; i < WEBPA_CLIENT_NOTIFY_MAX_CLIENTS; i++)
+	{
+		if(clientTable[i].used && clientTable[i].pending != NULL &&
+			(earliest == NULL || !isWindowEnded(&earliest->windowEnd, &clientTable[i].windowEnd)))
+		{
+			earliest = &clientTable[i];
+		}
+	}
+	return earliest;
+}
+
+static int isWindowEnded(struct timespec *windowEnd, struct timespec *now)
+{
+	return (windowEnd->tv_sec < now->tv_sec || (windowEnd->tv_sec == now->tv_sec && windowEnd->tv_nsec <= now->tv_nsec)) ? 1 : 0;
+}
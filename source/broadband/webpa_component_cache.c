@@ -0,0 +1,395 @@
+/**
+ * @file webpa_component_cache.c
+ *
+ * @description This file describes a bounded LRU cache of the components that
+ * own a parameter or object name. Entries are learned from discovery results,
+ * so names outside the objects cached at start up are discovered only once.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "webpa_component_cache.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct _ComponentCacheEntry
+{
+    char *name;
+    unsigned int hash;
+    int count;
+    char *compName[WEBPA_COMPONENT_CACHE_MAX_OWNERS];
+    char *dbusPath[WEBPA_COMPONENT_CACHE_MAX_OWNERS];
+    struct _ComponentCacheEntry *hashNext;
+    struct _ComponentCacheEntry *lruPrev;
+    struct _ComponentCacheEntry *lruNext;
+} ComponentCacheEntry;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static ComponentCacheEntry *cacheBuckets[WEBPA_COMPONENT_CACHE_BUCKETS];
+static ComponentCacheEntry *lruHead = NULL;
+static ComponentCacheEntry *lruTail = NULL;
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static ComponentCacheStats cacheStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static unsigned int hashName(const char *name, size_t len);
+static ComponentCacheEntry * findEntry(const char *name, size_t len);
+static void unlinkEntry(ComponentCacheEntry *entry);
+static void removeFromBucket(ComponentCacheEntry *entry);
+static void pushFront(ComponentCacheEntry *entry);
+static void freeOwners(ComponentCacheEntry *entry);
+static void freeEntry(ComponentCacheEntry *entry);
+static int copyOwners(ComponentCacheEntry *entry, char ***compName, char ***dbusPath, int *count);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+int lookupComponentCache(const char *name, char ***compName, char ***dbusPath, int *count)
+{
+	ComponentCacheEntry *entry = NULL;
+	size_t len = 0;
+	int rc = -1;
+
+	if(name == NULL || name[0] == '\0')
+	{
+		return -1;
+	}
+	len = strlen(name);
+	pthread_mutex_lock(&cacheMutex);
+	entry = findEntry(name, len);
+	// otherwise the deepest object above the name, it has to cover the whole subtree
+	while(entry == NULL && len > 1)
+	{
+		len--;
+		while(len > 0 && name[len - 1] != '.')
+		{
+			len--;
+		}
+		if(len > 0)
+		{
+			entry = findEntry(name, len);
+			if(entry != NULL && entry->count != 1)
+			{
+				entry = NULL;
+			}
+		}
+	}
+	if(entry != NULL)
+	{
+		unlinkEntry(entry);
+		pushFront(entry);
+		rc = copyOwners(entry, compName, dbusPath, count);
+	}
+	if(rc == 0)
+	{
+		cacheStats.hitCount++;
+	}
+	else
+	{
+		cacheStats.missCount++;
+	}
+	pthread_mutex_unlock(&cacheMutex);
+	return rc;
+}
+
+void addComponentCache(const char *name, char **compName, char **dbusPath, int count)
+{
+	ComponentCacheEntry *entry = NULL, *evicted = NULL;
+	size_t len = 0;
+	int i = 0;
+
+	if(name == NULL || name[0] == '\0' || count <= 0 || count > WEBPA_COMPONENT_CACHE_MAX_OWNERS)
+	{
+		return;
+	}
+	len = strlen(name);
+	pthread_mutex_lock(&cacheMutex);
+	entry = findEntry(name, len);
+	if(entry != NULL)
+	{
+		unlinkEntry(entry);
+		freeOwners(entry);
+	}
+	else
+	{
+		entry = (ComponentCacheEntry *) calloc(1, sizeof(ComponentCacheEntry));
+		if(entry != NULL)
+		{
+			entry->name = strdup(name);
+		}
+		if(entry == NULL || entry->name == NULL)
+		{
+			pthread_mutex_unlock(&cacheMutex);
+			WAL_FREE(entry);
+			WalError("Failed to allocate component cache entry\n");
+			return;
+		}
+		entry->hash = hashName(name, len);
+		entry->hashNext = cacheBuckets[entry->hash];
+		cacheBuckets[entry->hash] = entry;
+		if(cacheStats.entryCount >= WEBPA_COMPONENT_CACHE_SIZE)
+		{
+			evicted = lruTail;
+			unlinkEntry(evicted);
+			removeFromBucket(evicted);
+			cacheStats.evictionCount++;
+			cacheStats.entryCount--;
+		}
+		cacheStats.entryCount++;
+	}
+	for(i = 0; i < count; i++)
+	{
+		entry->compName[i] = strdup(compName[i]);
+		entry->dbusPath[i] = strdup(dbusPath[i]);
+		if(entry->compName[i] == NULL || entry->dbusPath[i] == NULL)
+		{
+			// the entry stays without owners and never matches
+			freeOwners(entry);
+			break;
+		}
+		entry->count = i + 1;
+	}
+	pushFront(entry);
+	pthread_mutex_unlock(&cacheMutex);
+
+	if(evicted != NULL)
+	{
+		WalPrint("Component cache is full, evicted %s\n", evicted->name);
+		freeEntry(evicted);
+	}
+	WalPrint("Cached %d component(s) for %s\n", count, name);
+}
+
+void clearComponentCache()
+{
+	ComponentCacheEntry *entry = NULL, *next = NULL;
+
+	pthread_mutex_lock(&cacheMutex);
+	entry = lruHead;
+	lruHead = NULL;
+	lruTail = NULL;
+	memset(cacheBuckets, 0, sizeof(cacheBuckets));
+	cacheStats.entryCount = 0;
+	pthread_mutex_unlock(&cacheMutex);
+
+	while(entry != NULL)
+	{
+		next = entry->lruNext;
+		freeEntry(entry);
+		entry = next;
+	}
+}
+
+int invalidateComponentCache(const char *compName)
+{
+	ComponentCacheEntry *entry = NULL, *next = NULL, *dropped = NULL;
+	int i = 0, count = 0;
+
+	if(compName == NULL)
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&cacheMutex);
+	for(entry = lruHead; entry != NULL; entry = next)
+	{
+		next = entry->lruNext;
+		for(i = 0; i < entry->count; i++)
+		{
+			if(strcmp(entry->compName[i], compName) == 0)
+			{
+				unlinkEntry(entry);
+				removeFromBucket(entry);
+				cacheStats.entryCount--;
+				entry->lruNext = dropped;
+				dropped = entry;
+				count++;
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&cacheMutex);
+
+	while(dropped != NULL)
+	{
+		next = dropped->lruNext;
+		freeEntry(dropped);
+		dropped = next;
+	}
+	if(count > 0)
+	{
+		WalInfo("Dropped %d cached name(s) owned by %s\n", count, compName);
+	}
+	return count;
+}
+
+void getComponentCacheStats(ComponentCacheStats *stats)
+{
+	pthread_mutex_lock(&cacheMutex);
+	*stats = cacheStats;
+	pthread_mutex_unlock(&cacheMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static unsigned int hashName(const char *name, size_t len)
+{
+	unsigned int hash = 5381;
+	size_t i = 0;
+
+	for(i = 0; i < len; i++)
+	{
+		hash = ((hash << 5) + hash) + (unsigned char) name[i];
+	}
+	return hash % WEBPA_COMPONENT_CACHE_BUCKETS;
+}
+
+/*
+ * @brief findEntry returns the entry named by the first len characters of name, caller holds cacheMutex
+ */
+static ComponentCacheEntry * findEntry(const char *name, size_t len)
+{
+	ComponentCacheEntry *entry = NULL;
+
+	for(entry = cacheBuckets[hashName(name, len)]; entry != NULL; entry = entry->hashNext)
+	{
+		if(strncmp(entry->name, name, len) == 0 && entry->name[len] == '\0')
+		{
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief unlinkEntry takes an entry out of the LRU list, caller holds cacheMutex
+ */
+static void unlinkEntry(ComponentCacheEntry *entry)
+{
+	if(entry->lruPrev != NULL)
+	{
+		entry->lruPrev->lruNext = entry->lruNext;
+	}
+	else if(lruHead == entry)
+	{
+		lruHead = entry->lruNext;
+	}
+	if(entry->lruNext != NULL)
+	{
+		entry->lruNext->lruPrev = entry->lruPrev;
+	}
+	else if(lruTail == entry)
+	{
+		lruTail = entry->lruPrev;
+	}
+	entry->lruPrev = NULL;
+	entry->lruNext = NULL;
+}
+
+/*
+ * @brief removeFromBucket takes an entry out of its hash bucket, caller holds cacheMutex
+ */
+static void removeFromBucket(ComponentCacheEntry *entry)
+{
+	ComponentCacheEntry **link = &cacheBuckets[entry->hash];
+
+	while(*link != NULL)
+	{
+		if(*link == entry)
+		{
+			*link = entry->hashNext;
+			break;
+		}
+		link = &(*link)->hashNext;
+	}
+	entry->hashNext = NULL;
+}
+
+/*
+ * @brief pushFront makes an entry the most recently used, caller holds cacheMutex
+ */
+static void pushFront(ComponentCacheEntry *entry)
+{
+	entry->lruPrev = NULL;
+	entry->lruNext = lruHead;
+	if(lruHead != NULL)
+	{
+		lruHead->lruPrev = entry;
+	}
+	lruHead = entry;
+	if(lruTail == NULL)
+	{
+		lruTail = entry;
+	}
+}
+
+static void freeOwners(ComponentCacheEntry *entry)
+{
+	int i = 0;
+
+	for(i = 0; i < WEBPA_COMPONENT_CACHE_MAX_OWNERS; i++)
+	{
+		free(entry->compName[i]);
+		free(entry->dbusPath[i]);
+		entry->compName[i] = NULL;
+		entry->dbusPath[i] = NULL;
+	}
+	entry->count = 0;
+}
+
+static void freeEntry(ComponentCacheEntry *entry)
+{
+	freeOwners(entry);
+	WAL_FREE(entry->name);
+	WAL_FREE(entry);
+}
+
+/*
+ * @brief copyOwners returns copies of the owners of an entry, caller holds cacheMutex
+ */
+static int copyOwners(ComponentCacheEntry *entry, char ***compName, char ***dbusPath, int *count)
+{
+	char **localCompName = NULL, **localDbusPath = NULL;
+	int i = 0;
+
+	if(entry->count <= 0)
+	{
+		return -1;
+	}
+	localCompName = (char **) calloc(entry->count, sizeof(char *));
+	localDbusPath = (char **) calloc(entry->count, sizeof(char *));
+	for(i = 0; localCompName != NULL && localDbusPath != NULL && i < entry->count; i++)
+	{
+		localCompName[i] = strdup(entry->compName[i]);
+		localDbusPath[i] = strdup(entry->dbusPath[i]);
+		if(localCompName[i] == NULL || localDbusPath[i] == NULL)
+		{
+			break;
+		}
+	}
+	if(localCompName == NULL || localDbusPath == NULL || i < entry->count)
+	{
+		for(i = 0; i < entry->count && localCompName != NULL && localDbusPath != NULL; i++)
+		{
+			free(localCompName[i]);
+			free(localDbusPath[i]);
+		}
+		free(localCompName);
+		free(localDbusPath);
+		return -1;
+	}
+	*compName = localCompName;
+	*dbusPath = localDbusPath;
+	*count = entry->count;
+	return 0;
+}
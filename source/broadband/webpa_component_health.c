@@ -0,0 +1,379 @@
+/**
+ * @file webpa_component_health.c
+ *
+ * @description This file describes a monitor thread that keeps the health of
+ * the components webpa routes requests to. Components are probed on a schedule
+ * and on events, callers read or wait for the health without probing themselves.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "webpa_component_health.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct
+{
+    char name[WEBPA_COMPONENT_HEALTH_NAME_LEN];
+    char dbusPath[WEBPA_COMPONENT_HEALTH_NAME_LEN];
+    ComponentHealth health;
+    int failedProbes;
+    time_t nextProbe;
+} ComponentHealthEntry;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static ComponentHealthEntry healthTable[WEBPA_COMPONENT_HEALTH_MAX];
+static int healthCount = 0;
+static componentHealthProbeCB healthProbe = NULL;
+static pthread_mutex_t healthMutex = PTHREAD_MUTEX_INITIALIZER;
+// waiters for a health change
+static pthread_cond_t healthCond = PTHREAD_COND_INITIALIZER;
+// wakes the monitor when a component has to be probed early
+static pthread_cond_t healthTaskCond = PTHREAD_COND_INITIALIZER;
+static int healthTaskStarted = 0;
+static ComponentHealthStats healthStats;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static void *componentHealthTask(void *arg);
+static ComponentHealthEntry * findEntry(const char *compName);
+static ComponentHealthEntry * nextDueEntry(time_t now);
+static int getNextProbe(time_t *nextProbe);
+static time_t getMonotonicSec();
+static const char * healthName(ComponentHealth health);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void initComponentHealthMonitor(componentHealthProbeCB probe)
+{
+	pthread_mutex_lock(&healthMutex);
+	healthProbe = probe;
+	pthread_mutex_unlock(&healthMutex);
+}
+
+int watchComponentHealth(const char *compName, const char *dbusPath)
+{
+	ComponentHealthEntry *entry = NULL;
+
+	if(compName == NULL || dbusPath == NULL)
+	{
+		return -1;
+	}
+	pthread_mutex_lock(&healthMutex);
+	entry = findEntry(compName);
+	if(entry == NULL)
+	{
+		if(healthCount >= WEBPA_COMPONENT_HEALTH_MAX)
+		{
+			pthread_mutex_unlock(&healthMutex);
+			WalError("Component health table is full, %s is not watched\n", compName);
+			return -1;
+		}
+		entry = &healthTable[healthCount++];
+		memset(entry, 0, sizeof(ComponentHealthEntry));
+		snprintf(entry->name, sizeof(entry->name), "%s", compName);
+		healthStats.watchedCount = healthCount;
+	}
+	else if(strcmp(entry->dbusPath, dbusPath) == 0)
+	{
+		pthread_mutex_unlock(&healthMutex);
+		return 0;
+	}
+	snprintf(entry->dbusPath, sizeof(entry->dbusPath), "%s", dbusPath);
+	entry->failedProbes = 0;
+	entry->nextProbe = 0;
+	if(healthTaskStarted)
+	{
+		pthread_cond_signal(&healthTaskCond);
+	}
+	pthread_mutex_unlock(&healthMutex);
+	WalPrint("Watching health of %s at %s\n", compName, dbusPath);
+	return 0;
+}
+
+ComponentHealth getComponentHealth(const char *compName)
+{
+	ComponentHealthEntry *entry = NULL;
+	ComponentHealth health = COMPONENT_HEALTH_UNKNOWN;
+
+	if(compName == NULL)
+	{
+		return COMPONENT_HEALTH_UNKNOWN;
+	}
+	pthread_mutex_lock(&healthMutex);
+	entry = findEntry(compName);
+	if(entry != NULL)
+	{
+		health = entry->health;
+	}
+	pthread_mutex_unlock(&healthMutex);
+	return health;
+}
+
+ComponentHealth waitForComponentHealth(const char *compName, unsigned int timeoutSec)
+{
+	ComponentHealthEntry *entry = NULL;
+	ComponentHealth health = COMPONENT_HEALTH_UNKNOWN;
+	struct timespec deadline;
+	int rc = 0;
+
+	if(compName == NULL)
+	{
+		return COMPONENT_HEALTH_UNKNOWN;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += timeoutSec;
+	pthread_mutex_lock(&healthMutex);
+	entry = findEntry(compName);
+	while(healthTaskStarted && entry != NULL && entry->health != COMPONENT_HEALTH_GREEN && rc != ETIMEDOUT)
+	{
+		rc = pthread_cond_timedwait(&healthCond, &healthMutex, &deadline);
+	}
+	if(entry != NULL)
+	{
+		health = entry->health;
+	}
+	pthread_mutex_unlock(&healthMutex);
+	return health;
+}
+
+void refreshComponentHealth(const char *compName)
+{
+	ComponentHealthEntry *entry = NULL;
+
+	if(compName == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&healthMutex);
+	entry = findEntry(compName);
+	if(entry != NULL)
+	{
+		entry->nextProbe = 0;
+		if(healthTaskStarted)
+		{
+			pthread_cond_signal(&healthTaskCond);
+		}
+	}
+	pthread_mutex_unlock(&healthMutex);
+}
+
+int runComponentHealthChecks()
+{
+	ComponentHealthEntry *entry = NULL;
+	ComponentHealth health = COMPONENT_HEALTH_UNKNOWN, previous = COMPONENT_HEALTH_UNKNOWN;
+	componentHealthProbeCB probe = NULL;
+	char name[WEBPA_COMPONENT_HEALTH_NAME_LEN];
+	char dbusPath[WEBPA_COMPONENT_HEALTH_NAME_LEN];
+	time_t now = 0;
+	int count = 0;
+
+	while(1)
+	{
+		now = getMonotonicSec();
+		pthread_mutex_lock(&healthMutex);
+		probe = healthProbe;
+		entry = (probe != NULL) ? nextDueEntry(now) : NULL;
+		if(entry == NULL)
+		{
+			pthread_mutex_unlock(&healthMutex);
+			break;
+		}
+		// not due again in this run while its probe is outstanding
+		entry->nextProbe = now + WEBPA_COMPONENT_HEALTH_RETRY_SEC;
+		snprintf(name, sizeof(name), "%s", entry->name);
+		snprintf(dbusPath, sizeof(dbusPath), "%s", entry->dbusPath);
+		pthread_mutex_unlock(&healthMutex);
+
+		// probes block on the bus, they run without the lock
+		health = probe(name, dbusPath);
+		count++;
+
+		pthread_mutex_lock(&healthMutex);
+		healthStats.probeCount++;
+		entry = findEntry(name);
+		if(entry != NULL)
+		{
+			previous = entry->health;
+			// a single failed query is not enough, the bus may just be busy. Keep the
+			// last health and probe again soon until enough queries failed in a row
+			entry->failedProbes = (health == COMPONENT_HEALTH_DOWN) ? entry->failedProbes + 1 : 0;
+			if(health == COMPONENT_HEALTH_DOWN && entry->failedProbes < WEBPA_COMPONENT_HEALTH_DOWN_PROBES)
+			{
+				health = previous;
+			}
+			entry->health = health;
+			entry->nextProbe = getMonotonicSec() + ((health == COMPONENT_HEALTH_GREEN && entry->failedProbes == 0) ? WEBPA_COMPONENT_HEALTH_INTERVAL_SEC : WEBPA_COMPONENT_HEALTH_RETRY_SEC);
+			if(previous != health)
+			{
+				healthStats.changeCount++;
+				if(healthTaskStarted)
+				{
+					pthread_cond_broadcast(&healthCond);
+				}
+			}
+		}
+		pthread_mutex_unlock(&healthMutex);
+		if(entry != NULL && previous != health)
+		{
+			WalInfo("%s component health is %s\n", name, healthName(health));
+		}
+	}
+	return count;
+}
+
+void startComponentHealthTask()
+{
+	pthread_condattr_t attr;
+	pthread_t threadId;
+	int err = 0;
+
+	pthread_mutex_lock(&healthMutex);
+	if(healthTaskStarted)
+	{
+		pthread_mutex_unlock(&healthMutex);
+		return;
+	}
+	// probe schedule and waits are measured on CLOCK_MONOTONIC
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_destroy(&healthCond);
+	pthread_cond_init(&healthCond, &attr);
+	pthread_cond_destroy(&healthTaskCond);
+	pthread_cond_init(&healthTaskCond, &attr);
+	pthread_condattr_destroy(&attr);
+	healthTaskStarted = 1;
+	pthread_mutex_unlock(&healthMutex);
+
+	err = pthread_create(&threadId, NULL, componentHealthTask, NULL);
+	if (err != 0)
+	{
+		WalError("Error creating componentHealthTask thread :[%s]\n", strerror(err));
+	}
+	else
+	{
+		WalInfo("componentHealthTask thread created Successfully\n");
+	}
+}
+
+void getComponentHealthStats(ComponentHealthStats *stats)
+{
+	pthread_mutex_lock(&healthMutex);
+	*stats = healthStats;
+	pthread_mutex_unlock(&healthMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static void *componentHealthTask(void *arg)
+{
+	struct timespec deadline;
+
+	(void) arg;
+	pthread_detach(pthread_self());
+	while(FOREVER())
+	{
+		runComponentHealthChecks();
+
+		// a component watched or refreshed meanwhile is already due and ends the wait at once
+		pthread_mutex_lock(&healthMutex);
+		if(!getNextProbe(&deadline.tv_sec))
+		{
+			pthread_cond_wait(&healthTaskCond, &healthMutex);
+		}
+		else
+		{
+			deadline.tv_nsec = 0;
+			pthread_cond_timedwait(&healthTaskCond, &healthMutex, &deadline);
+		}
+		pthread_mutex_unlock(&healthMutex);
+	}
+	return NULL;
+}
+
+/*
+ * @brief findEntry returns the entry of a component, caller holds healthMutex
+ */
+static ComponentHealthEntry * findEntry(const char *compName)
+{
+	int i = 0;
+
+	for(i = 0; i < healthCount; i++)
+	{
+		if(strcmp(healthTable[i].name, compName) == 0)
+		{
+			return &healthTable[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief nextDueEntry returns a component whose probe is due, caller holds healthMutex
+ */
+static ComponentHealthEntry * nextDueEntry(time_t now)
+{
+	int i = 0;
+
+	for(i = 0; i < healthCount; i++)
+	{
+		if(healthTable[i].nextProbe <= now)
+		{
+			return &healthTable[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief getNextProbe returns 1 and the earliest probe time when a component is watched, caller holds healthMutex
+ */
+static int getNextProbe(time_t *nextProbe)
+{
+	int i = 0;
+
+	for(i = 0; i < healthCount; i++)
+	{
+		if(i == 0 || healthTable[i].nextProbe < *nextProbe)
+		{
+			*nextProbe = healthTable[i].nextProbe;
+		}
+	}
+	return (healthCount > 0);
+}
+
+static time_t getMonotonicSec()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec;
+}
+
+static const char * healthName(ComponentHealth health)
+{
+	switch(health)
+	{
+		case COMPONENT_HEALTH_GREEN:
+			return "Green";
+		case COMPONENT_HEALTH_RED:
+			return "Red";
+		case COMPONENT_HEALTH_DOWN:
+			return "Down";
+		default:
+			return "Unknown";
+	}
+}
@@ -0,0 +1,193 @@
+/**
+ * @file webpa_compression.c
+ *
+ * @description This file describes the gzip compression of large WRP payloads.
+ * Small payloads are left alone, compressing them costs more than it saves.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "webpa_compression.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+/* Window bits of a gzip stream, 15 plus 16 for the gzip wrapper */
+#define WEBPA_COMPRESS_GZIP_WINDOW_BITS         (15 + 16)
+#define WEBPA_COMPRESS_MEM_LEVEL                8
+#define WEBPA_GZIP_ENCODING                     "gzip"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static size_t compressThreshold = WEBPA_COMPRESS_THRESHOLD;
+static int eventCompressEnabled = 0;
+static WebpaCompressStats compressStats;
+static pthread_mutex_t compressMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static int hasGzipToken(const char *value);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void setCompressConfig(size_t threshold, int compressEvents)
+{
+	pthread_mutex_lock(&compressMutex);
+	compressThreshold = threshold;
+	eventCompressEnabled = (threshold > 0 && compressEvents) ? 1 : 0;
+	pthread_mutex_unlock(&compressMutex);
+	WalInfo("Payload compression threshold %zu, notifications %s\n", threshold, eventCompressEnabled ? "compressed" : "not compressed");
+}
+
+int isEventCompressEnabled()
+{
+	int enabled = 0;
+
+	pthread_mutex_lock(&compressMutex);
+	enabled = eventCompressEnabled;
+	pthread_mutex_unlock(&compressMutex);
+	return enabled;
+}
+
+int acceptsCompression(const headers_t *headers)
+{
+	size_t i = 0, len = strlen(WEBPA_ACCEPT_ENCODING_HEADER);
+
+	for(i = 0; headers != NULL && i < headers->count; i++)
+	{
+		if(headers->headers[i] != NULL && strncasecmp(headers->headers[i], WEBPA_ACCEPT_ENCODING_HEADER, len) == 0 && hasGzipToken(headers->headers[i] + len))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int compressPayload(const void *payload, size_t payloadSize, void **compressed, size_t *compressedSize)
+{
+	z_stream strm;
+	size_t threshold = 0;
+	uLong bound = 0;
+	int ret = 0;
+
+	*compressed = NULL;
+	*compressedSize = 0;
+	pthread_mutex_lock(&compressMutex);
+	threshold = compressThreshold;
+	pthread_mutex_unlock(&compressMutex);
+	if(payload == NULL || threshold == 0 || payloadSize < threshold)
+	{
+		return 1;
+	}
+
+	memset(&strm, 0, sizeof(z_stream));
+	if(deflateInit2(&strm, WEBPA_COMPRESS_LEVEL, Z_DEFLATED, WEBPA_COMPRESS_GZIP_WINDOW_BITS, WEBPA_COMPRESS_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		WalError("Failed to initialize payload compression\n");
+		return -1;
+	}
+	bound = deflateBound(&strm, (uLong) payloadSize);
+	*compressed = malloc(bound);
+	if(*compressed == NULL)
+	{
+		deflateEnd(&strm);
+		return -1;
+	}
+	strm.next_in = (Bytef *) payload;
+	strm.avail_in = (uInt) payloadSize;
+	strm.next_out = (Bytef *) *compressed;
+	strm.avail_out = (uInt) bound;
+	ret = deflate(&strm, Z_FINISH);
+	*compressedSize = strm.total_out;
+	deflateEnd(&strm);
+	if(ret != Z_STREAM_END)
+	{
+		WalError("Failed to compress payload of %zu bytes, ret %d\n", payloadSize, ret);
+		free(*compressed);
+		*compressed = NULL;
+		*compressedSize = 0;
+		return -1;
+	}
+
+	pthread_mutex_lock(&compressMutex);
+	if(*compressedSize >= payloadSize)
+	{
+		compressStats.skippedCount++;
+		pthread_mutex_unlock(&compressMutex);
+		free(*compressed);
+		*compressed = NULL;
+		*compressedSize = 0;
+		return 1;
+	}
+	compressStats.compressedCount++;
+	compressStats.bytesIn += payloadSize;
+	compressStats.bytesOut += *compressedSize;
+	pthread_mutex_unlock(&compressMutex);
+	return 0;
+}
+
+int addContentEncoding(headers_t **headers)
+{
+	headers_t *newHeaders = NULL;
+	size_t count = (*headers != NULL) ? (*headers)->count : 0;
+
+	newHeaders = (headers_t *) realloc(*headers, sizeof(headers_t) + sizeof(char *) * (count + 1));
+	if(newHeaders == NULL)
+	{
+		return -1;
+	}
+	newHeaders->count = count;
+	*headers = newHeaders;
+	newHeaders->headers[count] = strdup(WEBPA_CONTENT_ENCODING_GZIP);
+	if(newHeaders->headers[count] == NULL)
+	{
+		return -1;
+	}
+	newHeaders->count = count + 1;
+	return 0;
+}
+
+void getCompressStats(WebpaCompressStats *stats)
+{
+	pthread_mutex_lock(&compressMutex);
+	*stats = compressStats;
+	pthread_mutex_unlock(&compressMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief hasGzipToken looks for gzip in a comma separated header value,
+ * e.g. "deflate, gzip;q=0.8"
+ */
+static int hasGzipToken(const char *value)
+{
+	size_t len = strlen(WEBPA_GZIP_ENCODING);
+
+	while(*value != '\0')
+	{
+		while(*value == ' ' || *value == ',')
+		{
+			value++;
+		}
+		if(strncasecmp(value, WEBPA_GZIP_ENCODING, len) == 0 && (value[len] == '\0' || value[len] == ',' || value[len] == ';' || value[len] == ' '))
+		{
+			return 1;
+		}
+		while(*value != '\0' && *value != ',')
+		{
+			value++;
+		}
+	}
+	return 0;
+}
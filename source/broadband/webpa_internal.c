@@ -7,12 +7,16 @@
  */
 
 #include <pthread.h>
-
-#ifdef _WNXL11BWL_PRODUCT_REQ_
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
-#endif
 
 #include "webpa_internal.h"
+#include "webpa_component_cache.h"
+#include "webpa_attribute_cache.h"
+#include "webpa_timer.h"
+#include "webpa_component_health.h"
 
 #if defined(FEATURE_SUPPORT_WEBCONFIG)
 #include <webcfg_log.h>
@@ -23,6 +27,41 @@
 #ifdef RDKB_BUILD
 #include <syscfg/syscfg.h>
 #endif
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+/* A replaced snapshot is freed once no lookup can still be reading it */
+#define WEBPA_CACHE_SNAPSHOT_GRACE_SEC          30
+/* Lets a restarted component finish registering before it is rediscovered */
+#define WEBPA_COMPONENT_REFRESH_DELAY_MSEC      1000
+#define WEBPA_COMPONENT_REFRESH_RETRY_MSEC      30000
+/* Routing failures of an entry within the window that make it stale */
+#define WEBPA_COMPONENT_FAILURE_THRESHOLD       3
+#define WEBPA_COMPONENT_FAILURE_WINDOW_SEC      10
+/* Longest wait for a component to turn Green at start up */
+#define WEBPA_COMPONENT_READY_WAIT_SEC          300
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/* Immutable copy of the component cache, readers use it without locking */
+typedef struct _ComponentValSnapshot
+{
+    int compCount;
+    int subCompCount;
+    ComponentVal comp[RDKB_TR181_OBJECT_LEVEL1_COUNT];
+    ComponentVal subComp[RDKB_TR181_OBJECT_LEVEL2_COUNT];
+    time_t retiredAt;
+    struct _ComponentValSnapshot *next;
+} ComponentValSnapshot;
+
+/* Routing failures seen for a cache entry in the current window */
+typedef struct
+{
+    int count;
+    time_t windowStart;
+} ComponentFailureRate;
+
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
@@ -150,22 +189,44 @@ CpeWebpaIndexMap IndexMap[WIFI_INDEX_MAP_SIZE] = {
 {10208, 24}
 };
 BOOL eth_wan_status = FALSE;
+static pthread_mutex_t systemReadyMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t systemReadyCond = PTHREAD_COND_INITIALIZER;
+static int systemReady = 0;
+static ComponentValSnapshot *componentValSnapshot = NULL;
+static ComponentValSnapshot *retiredSnapshots = NULL;
+static pthread_mutex_t snapshotMutex = PTHREAD_MUTEX_INITIALIZER;
+// guards the cache entries once start up caching is done, taken before snapshotMutex
+static pthread_mutex_t componentValMutex = PTHREAD_MUTEX_INITIALIZER;
+static ComponentFailureRate compFailureRate[RDKB_TR181_OBJECT_LEVEL1_COUNT];
+static ComponentFailureRate subCompFailureRate[RDKB_TR181_OBJECT_LEVEL2_COUNT];
+static unsigned long componentRefreshTimer = 0;
 
 /*----------------------------------------------------------------------------*/
 /*                             Function Prototypes                            */
 /*----------------------------------------------------------------------------*/
-static int getComponentInfoFromCache(char *parameterName, char *objectName, char *compName, char *dbusPath);
-static int getMatchingComponentValArrayIndex(char *objectName);
-static int getMatchingSubComponentValArrayIndex(char *objectName);
+static int getComponentInfoFromCache(const ComponentValSnapshot *cache, char *parameterName, char *objectName, char *compName, char *dbusPath);
+static int getMatchingComponentValArrayIndex(const ComponentValSnapshot *cache, char *objectName);
+static int getMatchingSubComponentValArrayIndex(const ComponentValSnapshot *cache, char *objectName);
+static void copyComponentVal(ComponentVal *dest, const ComponentVal *src);
+static void freeComponentValSnapshot(ComponentValSnapshot *snapshot);
+static void ccspComponentRegistrationSignalCB(char *componentName, char *dbusPath, dbus_bool isAvailable, void *user_data);
+static int markComponentStale(const char *componentName, const char *dbusPath);
+static int markStaleEntries(ComponentVal *array, ComponentFailureRate *rate, int count, const char *componentName, const char *dbusPath);
+static int countRoutingFailure(ComponentVal *array, ComponentFailureRate *rate, int count, const char *compName, const char *dbusPath, time_t now);
+static void scheduleComponentRefresh(unsigned long delayMs);
+static void componentRefreshTimerCB(void *arg);
+static int refreshStaleEntries(ComponentVal *array, int *count, int level);
+static int isRoutingFailure(int ret);
 static void getObjectName(char *str, char *objectName, int objectLevel);
 static int waitForComponentReady(char *compName, char *dbusPath);
-#if 0
-static void checkComponentReady(char *compName, char *dbusPath);
-#endif
-static void checkComponentHealthStatus(char * compName, char * dbusPath, char *status, int *retStatus);
+static ComponentHealth getComponentHealthStatus(const char *compName, const char *dbusPath);
+static const char * getShortComponentName(const char *compName);
+static void watchCachedComponent(const ComponentVal *val);
 static void waitUntilSystemReady();
 static void ccspSystemReadySignalCB(void* user_data);
 static int checkIfSystemReady();
+static int markSystemReady();
+static int isSystemReady();
 extern ANSC_HANDLE bus_handle;
 extern char        g_Subsystem[32];
 static void *WALInit(void *status);
@@ -422,9 +483,22 @@ static void *WALInit(void *status)
 	subCompCacheFailedCnt = count1;
 	WalPrint("subCompCacheSuccessCnt : %d\n", subCompCacheSuccessCnt);
 	WalPrint("subCompCacheFailedCnt : %d\n", subCompCacheFailedCnt);
-	retryFailedComponentCaching();
+	// Objects that failed are discovered on demand meanwhile, the retry only adds entries
 	WalInfo("Component caching is completed. Hence setting cachingStatus to active\n");
-	cachingStatus = 1;
+	publishComponentValCache();
+	// the health monitor keeps every cached component, requests skip the unreachable ones
+	for(i = 0; i < compCacheSuccessCnt; i++)
+	{
+		watchCachedComponent(&ComponentValArray[i]);
+	}
+	for(i = 0; i < subCompCacheSuccessCnt; i++)
+	{
+		watchCachedComponent(&SubComponentValArray[i]);
+	}
+	// Components that restart re-register with CR, their entries are refreshed then
+	CcspBaseIf_Register_Event(bus_handle, NULL, "deviceProfileChangeSignal");
+	CcspBaseIf_SetCallback2(bus_handle, "deviceProfileChangeSignal", ccspComponentRegistrationSignalCB, NULL);
+	retryFailedComponentCaching();
 	WalPrint("-------- End of populateComponentValArray -------\n");
 	return NULL;
 }
@@ -440,6 +514,7 @@ int getComponentDetails(char *parameterName,char ***compName,char ***dbusPath, i
 	char tempParamName[MAX_PARAMETERNAME_LEN] = {'\0'};
 	char tempCompName[MAX_PARAMETERNAME_LEN/2] = {'\0'};
 	char tempDbusPath[MAX_PARAMETERNAME_LEN/2] = {'\0'};
+	const ComponentValSnapshot *cache = NULL;
 	
 	componentStruct_t ** ppComponents = NULL;
 #if !defined(RDKB_EMU)
@@ -448,10 +523,12 @@ int getComponentDetails(char *parameterName,char ***compName,char ***dbusPath, i
 	snprintf(dst_pathname_cr, sizeof(dst_pathname_cr),"%s%s", l_Subsystem, CCSP_DBUS_INTERFACE_CR);
 	walStrncpy(tempParamName, parameterName,sizeof(tempParamName));
 	WalPrint("======= start of getComponentDetails ========\n");
-	if(cachingStatus == 1)
+	// the snapshot stays valid for the lookup even if a newer one is published meanwhile
+	cache = __atomic_load_n(&componentValSnapshot, __ATOMIC_ACQUIRE);
+	if(cache != NULL)
 	{
 	        WalPrint("Component caching is ready, fetch component details from cache\n");
-	        index = getComponentInfoFromCache(tempParamName, objectName, tempCompName, tempDbusPath);
+	        index = getComponentInfoFromCache(cache, tempParamName, objectName, tempCompName, tempDbusPath);
         }
         else
         {
@@ -460,17 +537,26 @@ int getComponentDetails(char *parameterName,char ***compName,char ***dbusPath, i
         }
 	WalPrint("index : %d\n",index);
 	// Cannot identify the component from cache, make DBUS call to fetch component
-	if(index == -1 || ComponentValArray[index].comp_size > 2 || SubComponentValArray[index].comp_size >= 2) //comp size anything > 2 and sub comp size >1 . TCCBR-5475 allows dbus calls when sub comp size>1.
+	if(index == -1 || cache->comp[index].comp_size > 2 || cache->subComp[index].comp_size >= 2) //comp size anything > 2 and sub comp size >1 . TCCBR-5475 allows dbus calls when sub comp size>1.
 	{
+		// Names discovered earlier are served from the learned cache
+		if(lookupComponentCache(tempParamName, &localCompName, &localDbusPath, &size) == 0)
+		{
+			WalPrint("Component details for %s found in learned cache, size : %d\n", tempParamName, size);
+			*compName = localCompName;
+			*dbusPath = localDbusPath;
+			*retCount = size;
+			return CCSP_SUCCESS;
+		}
 		WalPrint("in if for size >2\n");
 		// GET Component for parameter from stack
-		if(index > 0 && ComponentValArray[index].comp_size > 2)
+		if(index > 0 && cache->comp[index].comp_size > 2)
 		{
-		        WalPrint("ComponentValArray[index].comp_size : %d\n",ComponentValArray[index].comp_size);
+		        WalPrint("ComponentValArray[index].comp_size : %d\n",cache->comp[index].comp_size);
 		}
-		else if(index > 0 && SubComponentValArray[index].comp_size >= 2)
+		else if(index > 0 && cache->subComp[index].comp_size >= 2)
 		{
-		        WalPrint("SubComponentValArray[index].comp_size : %d\n",SubComponentValArray[index].comp_size);
+		        WalPrint("SubComponentValArray[index].comp_size : %d\n",cache->subComp[index].comp_size);
 		}
 		retIndex = IndexMpa_WEBPAtoCPE(tempParamName);
 		if(retIndex == -1)
@@ -508,6 +594,11 @@ int getComponentDetails(char *parameterName,char ***compName,char ***dbusPath, i
 				strcpy(localDbusPath[i],ppComponents[i]->dbusPath);
 				WalPrint("localCompName[%d] : %s, localDbusPath[%d] : %s\n",i,localCompName[i],i, localDbusPath[i]);
 			}
+			// Owners may still register until the system is ready, learn only after that
+			if(isSystemReady())
+			{
+				addComponentCache(parameterName, localCompName, localDbusPath, size);
+			}
 			
 			*retCount = size;
 			free_componentStruct_t(bus_handle, size, ppComponents);
@@ -692,6 +783,9 @@ WDMP_STATUS mapStatus(int ret)
 			return WDMP_ERR_INVALID_WIFI_INDEX;
 		case CCSP_ERR_INVALID_RADIO_INDEX:
 			return WDMP_ERR_INVALID_RADIO_INDEX;
+		case CCSP_ERR_COMPONENT_UNREACHABLE:
+			// same outcome the cloud sees when the bus call times out
+			return WDMP_ERR_TIMEOUT;
 		case CCSP_ERR_METHOD_NOT_SUPPORTED:
 		    return WDMP_ERR_METHOD_NOT_SUPPORTED;
 		case CCSP_CR_ERR_SESSION_IN_PROGRESS:
@@ -925,6 +1019,98 @@ void macToLower(char macValue[],char macConverted[])
 	}
 }
 
+void publishComponentValCache()
+{
+	ComponentValSnapshot *snapshot = NULL, *old = NULL, **link = NULL, *expired = NULL;
+	struct timespec now;
+	int i = 0;
+
+	snapshot = (ComponentValSnapshot *) calloc(1, sizeof(ComponentValSnapshot));
+	if(snapshot == NULL)
+	{
+		WalError("Failed to allocate component cache snapshot\n");
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&snapshotMutex);
+	snapshot->compCount = compCacheSuccessCnt;
+	snapshot->subCompCount = subCompCacheSuccessCnt;
+	for(i = 0; i < snapshot->compCount; i++)
+	{
+		copyComponentVal(&snapshot->comp[i], &ComponentValArray[i]);
+	}
+	for(i = 0; i < snapshot->subCompCount; i++)
+	{
+		copyComponentVal(&snapshot->subComp[i], &SubComponentValArray[i]);
+	}
+	old = __atomic_exchange_n(&componentValSnapshot, snapshot, __ATOMIC_ACQ_REL);
+	cachingStatus = 1;
+
+	// lookups finish long before the grace period, older snapshots can go
+	for(link = &retiredSnapshots; *link != NULL;)
+	{
+		if(now.tv_sec - (*link)->retiredAt >= WEBPA_CACHE_SNAPSHOT_GRACE_SEC)
+		{
+			ComponentValSnapshot *done = *link;
+
+			*link = done->next;
+			done->next = expired;
+			expired = done;
+		}
+		else
+		{
+			link = &(*link)->next;
+		}
+	}
+	if(old != NULL)
+	{
+		old->retiredAt = now.tv_sec;
+		old->next = retiredSnapshots;
+		retiredSnapshots = old;
+	}
+	pthread_mutex_unlock(&snapshotMutex);
+
+	while(expired != NULL)
+	{
+		old = expired->next;
+		freeComponentValSnapshot(expired);
+		expired = old;
+	}
+	WalInfo("Published component cache with %d objects and %d sub objects\n", snapshot->compCount, snapshot->subCompCount);
+}
+
+void reportComponentFailure(const char *compName, const char *dbusPath, int ret)
+{
+	struct timespec now;
+	int stale = 0;
+
+	// entries are only stale when the system is up and the owner stopped answering
+	if(compName == NULL || dbusPath == NULL || !isRoutingFailure(ret) || !isSystemReady())
+	{
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&componentValMutex);
+	stale = countRoutingFailure(ComponentValArray, compFailureRate, compCacheSuccessCnt, compName, dbusPath, now.tv_sec);
+	stale |= countRoutingFailure(SubComponentValArray, subCompFailureRate, subCompCacheSuccessCnt, compName, dbusPath, now.tv_sec);
+	pthread_mutex_unlock(&componentValMutex);
+	if(stale)
+	{
+		WalError("%s at %s keeps failing, ret = %d. Rediscovering its objects\n", compName, dbusPath, ret);
+		OnboardLog("%s at %s keeps failing, ret = %d. Rediscovering its objects\n", compName, dbusPath, ret);
+		markComponentStale(compName, NULL);
+	}
+}
+
+BOOL isComponentReachable(const char *compName)
+{
+	if(compName == NULL)
+	{
+		return TRUE;
+	}
+	return (getComponentHealth(getShortComponentName(compName)) != COMPONENT_HEALTH_DOWN) ? TRUE : FALSE;
+}
+
 BOOL get_eth_wan_status()
 {
     return eth_wan_status;
@@ -939,15 +1125,15 @@ BOOL get_eth_wan_status()
  * param[in] objectName 
  * @return matching ComponentValArray index
  */
-static int getMatchingComponentValArrayIndex(char *objectName)
+static int getMatchingComponentValArrayIndex(const ComponentValSnapshot *cache, char *objectName)
 {
 	int i =0,index = -1;
 
-	for(i = 0; i < compCacheSuccessCnt ; i++)
+	for(i = 0; i < cache->compCount ; i++)
 	{
-		if(ComponentValArray[i].obj_name != NULL && !strcmp(objectName,ComponentValArray[i].obj_name))
+		if(cache->comp[i].obj_name != NULL && !strcmp(objectName,cache->comp[i].obj_name))
 		{
-	      		index = ComponentValArray[i].comp_id;
+	      		index = cache->comp[i].comp_id;
 			WalPrint("Matching Component Val Array index for object %s : %d\n",objectName, index);
 			break;
 		}	    
@@ -962,15 +1148,15 @@ static int getMatchingComponentValArrayIndex(char *objectName)
  * param[in] objectName 
  * @return matching ComponentValArray index
  */
-static int getMatchingSubComponentValArrayIndex(char *objectName)
+static int getMatchingSubComponentValArrayIndex(const ComponentValSnapshot *cache, char *objectName)
 {
 	int i =0,index = -1;
 	
-	for(i = 0; i < subCompCacheSuccessCnt ; i++)
+	for(i = 0; i < cache->subCompCount ; i++)
 	{
-		if(SubComponentValArray[i].obj_name != NULL && !strcmp(objectName,SubComponentValArray[i].obj_name))
+		if(cache->subComp[i].obj_name != NULL && !strcmp(objectName,cache->subComp[i].obj_name))
 		{
-		      	index = SubComponentValArray[i].comp_id;
+		      	index = cache->subComp[i].comp_id;
 			WalPrint("Matching Sub-Component Val Array index for object %s : %d\n",objectName, index);
 			break;
 		}	    
@@ -1002,7 +1188,7 @@ static int getObjectLevelFromParameter(char *parameterName)
  * @param[out] compName component name array
  * @param[out] dbusPath dbuspath array
  */
-static int getComponentInfoFromCache(char *parameterName, char *objectName, char *compName, char *dbusPath)
+static int getComponentInfoFromCache(const ComponentValSnapshot *cache, char *parameterName, char *objectName, char *compName, char *dbusPath)
 {   
 	int index = -1, level = 0;
 
@@ -1012,25 +1198,30 @@ static int getComponentInfoFromCache(char *parameterName, char *objectName, char
 	if(level > 1)
 	{
 		getObjectName(parameterName, objectName, 2);
-		index = getMatchingSubComponentValArrayIndex(objectName);
+		index = getMatchingSubComponentValArrayIndex(cache, objectName);
 		WalPrint("objectLevel: 2, parameterName: %s, objectName: %s, matching index=%d\n",parameterName,objectName,index);
 	
+		if(index != -1 && cache->subComp[index].comp_size == 0)
+		{
+			// owner restarted, discover it until the entry is refreshed
+			return -1;
+		}
 		if(index != -1 )
 		{
-			strcpy(compName,SubComponentValArray[index].comp_name);
-			strcpy(dbusPath,SubComponentValArray[index].dbus_path); 
+			strcpy(compName,cache->subComp[index].comp_name);
+			strcpy(dbusPath,cache->subComp[index].dbus_path); 
 		}
 	}
 	if(index < 0)
 	{
 		getObjectName(parameterName, objectName, 1);
-		index = getMatchingComponentValArrayIndex(objectName);
+		index = getMatchingComponentValArrayIndex(cache, objectName);
 		WalPrint("objectLevel: 1, parameterName: %s, objectName: %s, matching index: %d\n",parameterName,objectName,index);
 		 
-		if((index != -1) && (ComponentValArray[index].comp_size == 1))
+		if((index != -1) && (cache->comp[index].comp_size == 1))
 		{
-			strcpy(compName,ComponentValArray[index].comp_name);
-			strcpy(dbusPath,ComponentValArray[index].dbus_path);
+			strcpy(compName,cache->comp[index].comp_name);
+			strcpy(dbusPath,cache->comp[index].dbus_path);
 		}
 		else
 		{
@@ -1062,6 +1253,254 @@ static int getComponentInfoFromCache(char *parameterName, char *objectName, char
 	return index;	
 }
 
+/**
+ * @brief copyComponentVal Deep copies a cache entry into a snapshot
+ */
+static void copyComponentVal(ComponentVal *dest, const ComponentVal *src)
+{
+	dest->comp_id = src->comp_id;
+	dest->comp_size = src->comp_size;
+	dest->obj_name = (src->obj_name != NULL) ? strdup(src->obj_name) : NULL;
+	dest->comp_name = (src->comp_name != NULL) ? strdup(src->comp_name) : NULL;
+	dest->dbus_path = (src->dbus_path != NULL) ? strdup(src->dbus_path) : NULL;
+}
+
+static void freeComponentValSnapshot(ComponentValSnapshot *snapshot)
+{
+	int i = 0;
+
+	for(i = 0; i < snapshot->compCount; i++)
+	{
+		free(snapshot->comp[i].obj_name);
+		free(snapshot->comp[i].comp_name);
+		free(snapshot->comp[i].dbus_path);
+	}
+	for(i = 0; i < snapshot->subCompCount; i++)
+	{
+		free(snapshot->subComp[i].obj_name);
+		free(snapshot->subComp[i].comp_name);
+		free(snapshot->subComp[i].dbus_path);
+	}
+	WAL_FREE(snapshot);
+}
+
+/**
+ * @brief ccspComponentRegistrationSignalCB Call back function to be executed when a component registers with or leaves CR.
+ */
+static void ccspComponentRegistrationSignalCB(char *componentName, char *dbusPath, dbus_bool isAvailable, void *user_data)
+{
+	if(componentName == NULL)
+	{
+		return;
+	}
+	WalInfo("Component %s %s at %s\n", componentName, isAvailable ? "registered" : "deregistered", (dbusPath != NULL) ? dbusPath : "NULL");
+	// a component that registers again on the path it had keeps its entries
+	markComponentStale(componentName, isAvailable ? dbusPath : NULL);
+	if(isAvailable && dbusPath != NULL && getComponentHealth(getShortComponentName(componentName)) != COMPONENT_HEALTH_UNKNOWN)
+	{
+		watchComponentHealth(getShortComponentName(componentName), dbusPath);
+	}
+	refreshComponentHealth(getShortComponentName(componentName));
+}
+
+/**
+ * @brief markComponentStale Makes lookups of the objects owned by a component discover
+ * the owner until a refresh found it again
+ *
+ * @param[in] componentName component that restarted or stopped answering
+ * @param[in] dbusPath path the component registered on, NULL when unknown
+ * @return number of cache entries marked stale
+ */
+static int markComponentStale(const char *componentName, const char *dbusPath)
+{
+	int count = 0;
+
+	invalidateComponentCache(componentName);
+	invalidateAttrCache(componentName);
+	pthread_mutex_lock(&componentValMutex);
+	if(cachingStatus == 1)
+	{
+		count = markStaleEntries(ComponentValArray, compFailureRate, compCacheSuccessCnt, componentName, dbusPath);
+		count += markStaleEntries(SubComponentValArray, subCompFailureRate, subCompCacheSuccessCnt, componentName, dbusPath);
+		if(count > 0)
+		{
+			publishComponentValCache();
+		}
+	}
+	pthread_mutex_unlock(&componentValMutex);
+
+	if(count > 0)
+	{
+		WalInfo("Marked %d cached object(s) of %s stale\n", count, componentName);
+		scheduleComponentRefresh(WEBPA_COMPONENT_REFRESH_DELAY_MSEC);
+	}
+	return count;
+}
+
+/*
+ * @brief markStaleEntries sets comp_size of the entries owned by componentName to 0, caller holds componentValMutex
+ */
+static int markStaleEntries(ComponentVal *array, ComponentFailureRate *rate, int count, const char *componentName, const char *dbusPath)
+{
+	int i = 0, marked = 0;
+
+	for(i = 0; i < count; i++)
+	{
+		if(array[i].comp_size == 0 || array[i].comp_name == NULL || strcmp(array[i].comp_name, componentName) != 0)
+		{
+			continue;
+		}
+		if(dbusPath != NULL && array[i].dbus_path != NULL && strcmp(array[i].dbus_path, dbusPath) == 0)
+		{
+			continue;
+		}
+		array[i].comp_size = 0;
+		rate[i].count = 0;
+		marked++;
+	}
+	return marked;
+}
+
+/*
+ * @brief countRoutingFailure counts a failure against the entries routed to compName, caller holds componentValMutex
+ * @return 1 when an entry reached WEBPA_COMPONENT_FAILURE_THRESHOLD within the window
+ */
+static int countRoutingFailure(ComponentVal *array, ComponentFailureRate *rate, int count, const char *compName, const char *dbusPath, time_t now)
+{
+	int i = 0, stale = 0;
+
+	for(i = 0; i < count; i++)
+	{
+		if(array[i].comp_size == 0 || array[i].comp_name == NULL || array[i].dbus_path == NULL ||
+			strcmp(array[i].comp_name, compName) != 0 || strcmp(array[i].dbus_path, dbusPath) != 0)
+		{
+			continue;
+		}
+		if(rate[i].count == 0 || now - rate[i].windowStart >= WEBPA_COMPONENT_FAILURE_WINDOW_SEC)
+		{
+			rate[i].windowStart = now;
+			rate[i].count = 0;
+		}
+		rate[i].count++;
+		if(rate[i].count >= WEBPA_COMPONENT_FAILURE_THRESHOLD)
+		{
+			stale = 1;
+		}
+	}
+	return stale;
+}
+
+static void scheduleComponentRefresh(unsigned long delayMs)
+{
+	unsigned long timerId = 0;
+
+	pthread_mutex_lock(&componentValMutex);
+	if(componentRefreshTimer == 0)
+	{
+		timerId = scheduleWebpaWork(delayMs, 0, componentRefreshTimerCB, NULL);
+		componentRefreshTimer = timerId;
+	}
+	pthread_mutex_unlock(&componentValMutex);
+}
+
+/**
+ * @brief componentRefreshTimerCB Rediscovers the owners of stale cache entries and publishes them
+ */
+static void componentRefreshTimerCB(void *arg)
+{
+	int stale = 0;
+
+	pthread_mutex_lock(&componentValMutex);
+	componentRefreshTimer = 0;
+	pthread_mutex_unlock(&componentValMutex);
+
+	stale = refreshStaleEntries(ComponentValArray, &compCacheSuccessCnt, 1);
+	stale += refreshStaleEntries(SubComponentValArray, &subCompCacheSuccessCnt, 2);
+
+	pthread_mutex_lock(&componentValMutex);
+	publishComponentValCache();
+	pthread_mutex_unlock(&componentValMutex);
+	if(stale > 0)
+	{
+		// owner did not come back yet, lookups keep discovering it meanwhile
+		WalInfo("%d cached object(s) still have no owner, retrying later\n", stale);
+		scheduleComponentRefresh(WEBPA_COMPONENT_REFRESH_RETRY_MSEC);
+	}
+}
+
+/*
+ * @brief refreshStaleEntries discovers the owners of stale entries, CR is queried without holding componentValMutex
+ * @return number of entries that are still stale
+ */
+static int refreshStaleEntries(ComponentVal *array, int *count, int level)
+{
+	char dst_pathname_cr[MAX_PATHNAME_CR_LEN] = { 0 };
+	char l_Subsystem[MAX_DBUS_INTERFACE_LEN] = { 0 };
+	char paramName[MAX_PARAMETERNAME_LEN] = { 0 };
+	componentStruct_t ** ppComponents = NULL;
+	int i = 0, ret = 0, size = 0, stale = 0, total = 0;
+
+	strncpy(l_Subsystem, "eRT.",sizeof(l_Subsystem));
+	snprintf(dst_pathname_cr, sizeof(dst_pathname_cr),"%s%s", l_Subsystem, CCSP_DBUS_INTERFACE_CR);
+	pthread_mutex_lock(&componentValMutex);
+	total = *count;
+	pthread_mutex_unlock(&componentValMutex);
+
+	for(i = 0; i < total; i++)
+	{
+		pthread_mutex_lock(&componentValMutex);
+		paramName[0] = '\0';
+		if(array[i].comp_size == 0 && array[i].obj_name != NULL)
+		{
+			walStrncpy(paramName, array[i].obj_name, sizeof(paramName));
+		}
+		pthread_mutex_unlock(&componentValMutex);
+		if(paramName[0] == '\0')
+		{
+			continue;
+		}
+
+		size = 0;
+		ppComponents = NULL;
+		ret = CcspBaseIf_discComponentSupportingNamespace(bus_handle,
+				dst_pathname_cr, paramName, l_Subsystem, &ppComponents, &size);
+		pthread_mutex_lock(&componentValMutex);
+		if(ret == CCSP_SUCCESS && size > 0 && array[i].comp_size == 0)
+		{
+			strncpy(array[i].comp_name,ppComponents[0]->componentName,MAX_PARAMETERNAME_LEN/2);
+			strncpy(array[i].dbus_path,ppComponents[0]->dbusPath,MAX_PARAMETERNAME_LEN/2);
+			array[i].comp_size = size;
+			WalInfo("Refreshed level %d object %s, owner %s at %s\n", level, paramName, array[i].comp_name, array[i].dbus_path);
+		}
+		else if(array[i].comp_size == 0)
+		{
+			WalError("Failed to refresh component for object %s: ret = %d, size = %d\n", paramName, ret, size);
+			stale++;
+		}
+		pthread_mutex_unlock(&componentValMutex);
+		free_componentStruct_t(bus_handle, size, ppComponents);
+	}
+	return stale;
+}
+
+/*
+ * @brief isRoutingFailure returns 1 for errors that mean the component is not reachable where it was cached
+ */
+static int isRoutingFailure(int ret)
+{
+	switch(ret)
+	{
+		case CCSP_ERR_TIMEOUT:
+		case CCSP_MESSAGE_BUS_CANNOT_CONNECT:
+		case CCSP_MESSAGE_BUS_TIMEOUT:
+		case CCSP_MESSAGE_BUS_NOT_EXIST:
+		case CCSP_CR_ERR_UNSUPPORTED_NAMESPACE:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
 /**
  * @brief getObjectName Get object name from parameter name. Example WiFi from "Device.WiFi.SSID."
  * objectName parameter should be initialized with null terminating characters to handle error scenarios
@@ -1099,72 +1538,88 @@ static void getObjectName(char *str, char *objectName, int objectLevel)
 
 static void waitUntilSystemReady()
 {
-    if(checkIfSystemReady())
+	pthread_condattr_t attr;
+	struct timespec deadline;
+	int waited = 0, rc = 0;
+
+	if(checkIfSystemReady())
 	{
 		WalInfo("Checked CR - System is ready, proceed with component caching\n");
-		system("touch /var/tmp/cacheready");
-		processDeviceManageableNotification();
+		if(markSystemReady())
+		{
+			processDeviceManageableNotification();
+		}
+		return;
 	}
-	else
+
+	// waits are measured on CLOCK_MONOTONIC so a time sync does not cut them short
+	pthread_mutex_lock(&systemReadyMutex);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_destroy(&systemReadyCond);
+	pthread_cond_init(&systemReadyCond, &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_mutex_unlock(&systemReadyMutex);
+
+	CcspBaseIf_Register_Event(bus_handle, NULL, "systemReadySignal");
+
+	CcspBaseIf_SetCallback2
+	(
+		bus_handle,
+		"systemReadySignal",
+		ccspSystemReadySignalCB,
+		NULL
+	);
+
+	// In case of Web PA restart, we should be having cacheready already touched.
+	if(access(WEBPA_CACHE_READY_FILE, F_OK) == 0)
 	{
-	    CcspBaseIf_Register_Event(bus_handle, NULL, "systemReadySignal");
+		WalInfo("%s file exists, hence can proceed with component caching\n", WEBPA_CACHE_READY_FILE);
+		// readiness was announced before the restart, only record it so isSystemReady() reports it
+		markSystemReady();
+		return;
+	}
 
-            CcspBaseIf_SetCallback2
-	    (
-		    bus_handle,
-		    "systemReadySignal",
-		    ccspSystemReadySignalCB,
-		    NULL
-	    );
+	// Wait till the call back signals readiness, query CR every 2 mins in case the signal was missed
+	WalInfo("Waiting for system ready signal\n");
+	pthread_mutex_lock(&systemReadyMutex);
+	while(!systemReady)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += WEBPA_SYSTEM_READY_QUERY_INTERVAL;
+		rc = 0;
+		while(!systemReady && rc != ETIMEDOUT)
+		{
+			rc = pthread_cond_timedwait(&systemReadyCond, &systemReadyMutex, &deadline);
+		}
+		if(systemReady)
+		{
+			break;
+		}
+		waited += WEBPA_SYSTEM_READY_QUERY_INTERVAL;
+		pthread_mutex_unlock(&systemReadyMutex);
 
-	    FILE *file;
-#ifndef TEST
-	    int wait_time = 0;
-	    int total_wait_time = 0;
-#else
-//To get 1 sec delay the below wait_time and total_wait_time is initialised
-	    int wait_time = 23;
-	    int total_wait_time = 83;
-#endif
-	    // Wait till Call back touches the indicator to proceed further
-	    while((file = fopen("/var/tmp/cacheready", "r")) == NULL)
-	    {
-		    WalInfo("Waiting for system ready signal\n");
-		    // After waiting for 24 * 5 = 120s (2mins) send dbus message to CR to query for system ready
-		    if(wait_time == 24)
-		    {
-			    wait_time = 0;
-			    if(checkIfSystemReady())
-			    {
-				    WalInfo("Checked CR - System is ready, proceed with component caching\n");
-				    system("touch /var/tmp/cacheready");
-				    processDeviceManageableNotification();
-				    break;
-				    //Break out, System ready signal already delivered
-			    }
-			    else
-			    {
-				    WalInfo("Queried CR for system ready after waiting for 2 mins, it is still not ready\n");
-				    if(total_wait_time >= 84)
-				    {
-					    WalInfo("Queried CR for system ready after waiting for 7 mins, it is still not ready. Proceeding ...\n");
-					    OnboardLog("Queried CR for system ready after waiting for 7 mins, it is still not ready. Proceeding ...\n");
-					    break;
-				    }
-			    }
-		    }
-		    sleep(WEBPA_SYSTEM_READY_SLEEP);
-		    wait_time++;
-		    total_wait_time++;
-	    };
-	    // In case of Web PA restart, we should be having cacheready already touched.
-	    // In normal boot up we will reach here only when system ready is received.
-	    if(file != NULL)
-	    {
-		    WalInfo("/var/tmp/cacheready file exists, hence can proceed with component caching\n");
-		    fclose(file);
-	    }
-    }
+		if(checkIfSystemReady())
+		{
+			WalInfo("Checked CR - System is ready, proceed with component caching\n");
+			if(markSystemReady())
+			{
+				processDeviceManageableNotification();
+			}
+			//Break out, System ready signal already delivered
+			return;
+		}
+		WalInfo("Queried CR for system ready after waiting for %d seconds, it is still not ready\n", waited);
+		if(waited >= WEBPA_SYSTEM_READY_MAX_WAIT)
+		{
+			WalInfo("Queried CR for system ready after waiting for 7 mins, it is still not ready. Proceeding ...\n");
+			OnboardLog("Queried CR for system ready after waiting for 7 mins, it is still not ready. Proceeding ...\n");
+			return;
+		}
+		pthread_mutex_lock(&systemReadyMutex);
+	}
+	pthread_mutex_unlock(&systemReadyMutex);
+	WalInfo("System ready signal received, proceed with component caching\n");
 }
 
 /**
@@ -1173,11 +1628,56 @@ static void waitUntilSystemReady()
  */
 static void ccspSystemReadySignalCB(void* user_data)
 {
-	// Touch a file to indicate that Web PA can proceed with
-	// component caching.
-	system("touch /var/tmp/cacheready");
-	WalInfo("Received system ready signal, created /var/tmp/cacheready file\n");
-	processDeviceManageableNotification();
+	// Wakes WALInit right away so that component caching starts.
+	if(markSystemReady())
+	{
+		WalInfo("Received system ready signal\n");
+		processDeviceManageableNotification();
+	}
+}
+
+/**
+ * @brief markSystemReady Records that the system is ready, wakes the thread waiting for it and
+ * creates the cacheready file for compatibility.
+ * @return 1 the first time, 0 when readiness was already recorded
+ */
+static int markSystemReady()
+{
+	int fd = -1;
+
+	pthread_mutex_lock(&systemReadyMutex);
+	if(systemReady)
+	{
+		pthread_mutex_unlock(&systemReadyMutex);
+		return 0;
+	}
+	systemReady = 1;
+	pthread_cond_broadcast(&systemReadyCond);
+	pthread_mutex_unlock(&systemReadyMutex);
+
+	fd = open(WEBPA_CACHE_READY_FILE, O_WRONLY | O_CREAT, 0644);
+	if(fd < 0)
+	{
+		WalError("Failed to create %s file: %s\n", WEBPA_CACHE_READY_FILE, strerror(errno));
+	}
+	else
+	{
+		close(fd);
+	}
+	return 1;
+}
+
+/**
+ * @brief isSystemReady Returns 1 once the system ready signal was received or CR reported ready
+ */
+static int isSystemReady()
+{
+	int ready = 0;
+
+	pthread_mutex_lock(&systemReadyMutex);
+	ready = systemReady;
+	pthread_mutex_unlock(&systemReadyMutex);
+	return ready;
 }
 
 /**
@@ -1204,108 +1704,85 @@ static int checkIfSystemReady()
  */
 static int waitForComponentReady(char *compName, char *dbusPath)
 {
-	char status[32] = {'\0'};
-	int ret = -1;
-	int count = 0;
-	while(1)
+	ComponentHealth health = COMPONENT_HEALTH_UNKNOWN;
+
+	// the monitor probes the component, this thread only waits for the result
+	initComponentHealthMonitor(getComponentHealthStatus);
+	startComponentHealthTask();
+	watchComponentHealth(compName, dbusPath);
+	health = waitForComponentHealth(compName, WEBPA_COMPONENT_READY_WAIT_SEC);
+	if(health == COMPONENT_HEALTH_GREEN)
 	{
-		checkComponentHealthStatus(compName, dbusPath, status,&ret);
-		if(ret == CCSP_SUCCESS && (strcmp(status, "Green") == 0))
-		{
-                        WalInfo("%s component health is %s, continue\n", compName, status);
-			break;
-		}
-		else
-		{
-                        count++;
-                        if(count > 60)
-                        {
-                                WalError("%s component Health check failed (ret:%d), continue\n",compName, ret);
-                                break;
-                        }
-			if(count%5 == 0)
-			{
-				WalError("%s component Health, ret:%d, waiting\n", compName, ret);
-			}
-			sleep(5);
-		}
+		WalInfo("%s component health is Green, continue\n", compName);
+		return CCSP_SUCCESS;
 	}
-	return ret;
+	WalError("%s component Health check failed (health:%d), continue\n",compName, health);
+	// a component that answers is used even when it never turned Green
+	return (health == COMPONENT_HEALTH_RED) ? CCSP_SUCCESS : CCSP_FAILURE;
 }
 
 /**
- * @brief checkComponentHealthStatus Query the health of the given component
+ * @brief getComponentHealthStatus Query the health of the given component, probe of the health monitor
  * @param[in] compName RDKB Component Name
  * @param[in] dbusPath RDKB Dbus Path name
- * @param[out] status describes component health Red/Green
- * @param[out] retStatus error or status code returned by stack call
+ * @return COMPONENT_HEALTH_GREEN, COMPONENT_HEALTH_RED or COMPONENT_HEALTH_DOWN when the query failed
  */
-static void checkComponentHealthStatus(char * compName, char * dbusPath, char *status, int *retStatus)
+static ComponentHealth getComponentHealthStatus(const char *compName, const char *dbusPath)
 {
 	int ret = 0, val_size = 0;
+	ComponentHealth health = COMPONENT_HEALTH_DOWN;
 	parameterValStruct_t **parameterval = NULL;
 	char *parameterNames[1] = {};
-	char tmp[MAX_PARAMETERNAME_LEN];
-	char str[MAX_PARAMETERNAME_LEN/2];     
+	char tmp[WEBPA_COMPONENT_HEALTH_NAME_LEN + sizeof(".Health")];
+	char str[MAX_PARAMETERNAME_LEN/2];
 	char l_Subsystem[MAX_DBUS_INTERFACE_LEN] = { 0 };
-	
-	sprintf(tmp,"%s.%s",compName, "Health");
+
+	snprintf(tmp, sizeof(tmp), "%s.Health", compName);
 	parameterNames[0] = tmp;
 #if !defined(RDKB_EMU)
 	walStrncpy(l_Subsystem, "eRT.",sizeof(l_Subsystem));
 #endif
 	snprintf(str, sizeof(str), "%s%s", l_Subsystem, compName);
 	WalPrint("str is:%s\n", str);
-		
-	ret = CcspBaseIf_getParameterValues(bus_handle, str, dbusPath,  parameterNames, 1, &val_size, &parameterval);
+
+	ret = CcspBaseIf_getParameterValues(bus_handle, str, (char *) dbusPath, parameterNames, 1, &val_size, &parameterval);
 	WalPrint("ret = %d val_size = %d\n",ret,val_size);
-	if(ret == CCSP_SUCCESS)
+	if(ret == CCSP_SUCCESS && val_size > 0 && parameterval[0]->parameterValue != NULL)
 	{
 		WalPrint("parameterval[0]->parameterName : %s parameterval[0]->parameterValue : %s\n",parameterval[0]->parameterName,parameterval[0]->parameterValue);
-		strcpy(status, parameterval[0]->parameterValue);
-		WalPrint("status of component:%s\n", status);
+		health = (strcmp(parameterval[0]->parameterValue, "Green") == 0) ? COMPONENT_HEALTH_GREEN : COMPONENT_HEALTH_RED;
 	}
 	free_parameterValStruct_t (bus_handle, val_size, parameterval);
-	
-	*retStatus = ret;
+	return health;
 }
 
-#if 0
-/**
- * @brief checkComponentReady Checks if the given component is ready, its health is green
-   if not green, retry for 4 times and proceed .
- * @param[in] compName RDKB Component Name
- * @param[in] dbusPath RDKB Dbus Path name
+/*
+ * @brief getShortComponentName returns the component name without the subsystem prefix, as the health monitor keys it
  */
-static void checkComponentReady(char *compName, char *dbusPath)
+static const char * getShortComponentName(const char *compName)
 {
-	char status[32] = {'\0'};
-	int ret = -1;
-	int retrycount = 0;
-	
-	while(retrycount <= 3)
+	if(strncmp(compName, "eRT.", strlen("eRT.")) == 0)
 	{
-		checkComponentHealthStatus(compName, dbusPath, status,&ret);
-		if(ret == CCSP_SUCCESS && (strcmp(status, "Green") == 0))
-		{
-			WalInfo("checkComponentReady: %s component health is %s, continue\n", compName, status);
-			break;
-		}
-		else
-		{
-			retrycount++;
-			WalError("%s component Health, ret:%d, retrying ...%d...\n", compName, ret, retrycount);
-			sleep(5);
-			
-			if(retrycount > 3)
-			{
-				WalError("Proceeding as component %s is not up even after retry\n", compName);
-				OnboardLog("Proceeding as component %s is not up even after retry\n", compName);
-			}
-		}
-	} 
+		return compName + strlen("eRT.");
+	}
+	return compName;
+}
+
+static void watchCachedComponent(const ComponentVal *val)
+{
+	const char *name = NULL;
+
+	if(val->comp_name == NULL || val->dbus_path == NULL)
+	{
+		return;
+	}
+	name = getShortComponentName(val->comp_name);
+	// webpa answers its own parameters without the bus
+	if(strcmp(name, RDKB_WEBPA_COMPONENT_NAME) != 0)
+	{
+		watchComponentHealth(name, val->dbus_path);
+	}
 }
-#endif
 
 /*
  * @brief To retry component caching for failed objects
@@ -1422,10 +1899,13 @@ static void retryFailedComponentCaching()
 			}while((retryCount > WEBPA_RETRY_MIN_COUNT) && (retryCount <= WEBPA_RETRY_MAX_COUNT));
 		}
 
+		pthread_mutex_lock(&componentValMutex);
 		compCacheSuccessCnt = cnt;
 		WalPrint("compCacheSuccessCnt : %d after retry...\n", compCacheSuccessCnt);
 		subCompCacheSuccessCnt = cnt1;
 		WalPrint("subCompCacheSuccessCnt : %d after retry...\n", subCompCacheSuccessCnt);
+		publishComponentValCache();
+		pthread_mutex_unlock(&componentValMutex);
 	}
 }
 
@@ -13,6 +13,15 @@
 #include <errno.h>
 #include "webpa_notification.h"
 #include "webpa_internal.h"
+#include "webpa_notify_queue.h"
+#include "webpa_sync_state.h"
+#include "webpa_client_notify.h"
+#include "webpa_notify_json.h"
+#include "webpa_notify_metrics.h"
+#include "webpa_notify_retry.h"
+#include "webpa_compression.h"
+#include "webpa_request_queue.h"
+#include "webpa_timer.h"
 #ifdef RDKB_BUILD
 #include <sysevent/sysevent.h>
 #endif
@@ -26,6 +35,7 @@
 /* Notify Macros */
 #define WEBPA_SET_INITIAL_NOTIFY_RETRY_COUNT            7
 #define WEBPA_SET_INITIAL_NOTIFY_RETRY_SEC              15
+#define WEBPA_SET_INITIAL_NOTIFY_BACKOFF_MAX            10
 #define WEBPA_NOTIFY_EVENT_HANDLE_INTERVAL_MSEC         250
 #define BACKOFF_MAX_RETRY_SEC							512
 #define WEBPA_NOTIFY_EVENT_MAX_LENGTH                   256
@@ -33,38 +43,95 @@
 #define WEBPA_PARAM_HOSTS_NAME		        "Device.Hosts.Host."
 #define WRP_TRANSACTION_ID			"transaction_uuid"
 #define PARAM_HOSTS_VERSION	        "Device.Hosts.X_RDKCENTRAL-COM_HostVersionId"
-#define PARAM_SYSTEM_TIME		        "Device.DeviceInfo.X_RDKCENTRAL-COM_SystemTime"
 #define PARAM_FIRMWARE_VERSION		        "Device.DeviceInfo.X_CISCO_COM_FirmwareName"
 #define WEBPA_CFG_FIRMWARE_VER		"oldFirmwareVersion"
 #define DEVICE_BOOT_TIME                "Device.DeviceInfo.X_RDKCENTRAL-COM_BootTime"
 #define FP_PARAM                  "Device.DeviceInfo.X_RDKCENTRAL-COM_DeviceFingerPrint.Enable"
 #define CLOUD_STATUS 				"cloud-status"
+#define WEBPA_CFG_NOTIFY_QUEUE_CAPACITY	"notifyQueueCapacity"
+#define WEBPA_CFG_NOTIFY_QUEUE_POLICY	"notifyQueueOverflowPolicy"
+#define WEBPA_CFG_CLIENT_NOTIFY_WINDOW	"clientNotifyWindowSec"
+#define WEBPA_CFG_METRICS_LOG_INTERVAL	"notifyMetricsLogIntervalSec"
+#define WEBPA_CFG_COMPRESS_THRESHOLD	"compressThreshold"
+#define WEBPA_CFG_COMPRESS_NOTIFICATIONS	"compressNotifications"
+#define WEBPA_CFG_REQUEST_MAX_IN_FLIGHT	"requestMaxInFlight"
+#define WEBPA_CFG_REQUEST_MAX_PER_TYPE	"requestMaxPerType"
+#define WEBPA_CFG_REQUEST_MAX_WAIT	"requestMaxWaitMs"
+#define WEBPA_CFG_REQUEST_BULK_SOURCES	"requestBulkSources"
+/* Hosts version is read once per client notification burst */
+#define WEBPA_CLIENT_NOTIFY_GET_CACHE_SEC	1
+/* Notifications taken from each class per round, see getNotifyClass() */
+#define WEBPA_NOTIFY_CLASS_WEIGHT_CONTROL	8
+#define WEBPA_NOTIFY_CLASS_WEIGHT_PARAM		4
+#define WEBPA_NOTIFY_CLASS_WEIGHT_CLIENT	1
+/* Sync notification is retried twice, 7mins apart, while CPE and cloud are out of sync */
+#define WEBPA_SYNC_NOTIFY_RETRY_SEC		420
+#define WEBPA_SYNC_NOTIFY_RETRY_COUNT		2
 
 pthread_mutex_t sync_mutex=PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t sync_condition=PTHREAD_COND_INITIALIZER;
 /*----------------------------------------------------------------------------*/
 /*                               Data Structures                              */
 /*----------------------------------------------------------------------------*/
 
-typedef struct NotifyMsg__
+/* Priority classes of the notification queue, highest first */
+typedef enum
 {
-	NotifyData *notifyData;
-	struct NotifyMsg__ *next;
-} NotifyMsg;
+    NOTIFY_CLASS_CONTROL = 0,       /* TRANS_STATUS, DEVICE_STATUS, FACTORY_RESET, FIRMWARE_UPGRADE */
+    NOTIFY_CLASS_PARAM,             /* PARAM_NOTIFY, PARAM_NOTIFY_RETRY */
+    NOTIFY_CLASS_CLIENT,            /* CONNECTED_CLIENT_NOTIFY */
+    NOTIFY_CLASS_COUNT
+} NOTIFY_CLASS;
 
 typedef struct
 {
     char oldFirmwareVersion[256];
+    unsigned int notifyQueueCapacity;
+    NOTIFY_QUEUE_OVERFLOW_POLICY notifyQueuePolicy;
+    unsigned int clientNotifyWindowSec;
+    unsigned int metricsLogIntervalSec;
 } WebPaCfg;
+
+/* Parameter value shared by the connected client notifications of one burst */
+typedef struct
+{
+	char *paramName;
+	char *value;
+	time_t fetchTime;
+} CachedNotifyValue;
+
+/* Initial notify parameters owned by one component, set with a single SetAttributes call */
+typedef struct
+{
+	char *compName;
+	const char **paramNames;
+	int paramCount;
+	int done;
+	int retry;
+	int backoffCount;
+	int backoffRetryTime;
+	time_t nextAttempt;
+} InitialNotifyGroup;
 /*----------------------------------------------------------------------------*/
 /*                            File Scoped Variables                           */
 /*----------------------------------------------------------------------------*/
-static NotifyMsg *notifyMsgQ = NULL;
+static NotifyPriorityQueue *notifyQueue = NULL;
+static const char *notifyClassNames[NOTIFY_CLASS_COUNT] = {"control", "param", "client"};
+static const unsigned int notifyClassWeights[NOTIFY_CLASS_COUNT] = {WEBPA_NOTIFY_CLASS_WEIGHT_CONTROL, WEBPA_NOTIFY_CLASS_WEIGHT_PARAM, WEBPA_NOTIFY_CLASS_WEIGHT_CLIENT};
+static CachedNotifyValue hostsVersionCache = {PARAM_HOSTS_VERSION, NULL, 0};
 void (*notifyCbFn)(NotifyData*) = NULL;
 static WebPaCfg webPaCfg;
 char deviceMAC[32]={'\0'};
 
-static int g_syncRetryThreadStarted = 0;
+static int g_syncRetryStarted = 0;
+static unsigned long syncRetryTimerId = 0;
+static int syncRetryCount = 0;
+/* Initial notify groups still being set, owned by the timer work thread once setInitialNotify returns */
+static InitialNotifyGroup *initialNotifyGroups = NULL;
+static int initialNotifyGroupCount = 0;
+/* Retries of the whole setup when the groups could not be formed */
+static int initialNotifySetupRetry = 0;
+static int initialNotifySetupBackoffCount = 2;
+static int initialNotifySetupBackoffTime = 0;
 
 //This flag is used to avoid sync notification retry when param notification is already in progress.
 int g_syncNotifyInProgress = 0;
@@ -245,14 +312,41 @@ void *FactoryResetCloudSync();
 static void notifyCallback(NotifyData *notifyData);
 static void addNotifyMsgToQueue(NotifyData *notifyData);
 static void handleNotificationEvents();
+static unsigned int getNotifyClass(NOTIFY_TYPE type);
+static void logNotifyQueueStats();
+static void logNotifyPipelineStats();
 static void freeNotifyMessage(NotifyData *notifyData);
+static void freeNodeData(void *node);
+static void emitClientNotification(void *node);
+static unsigned int getNodeSignature(NodeData *node);
+static char * getCachedNotifyValue(CachedNotifyValue *cache);
 static void getNotifyParamList(const char ***paramList,int *size);
+static void loadCompressConfig(cJSON *webpa_cfg);
+static void loadRequestLimits(cJSON *webpa_cfg);
+static InitialNotifyGroup * groupInitialNotifyParams(const char **paramList, int paramCount, int *groupCount);
+static int retryInitialNotifyGroups(time_t now, time_t *nextAttempt);
+static void runInitialNotify();
+static void initialNotifyTimerCB(void *arg);
+static void scheduleInitialNotifySetup();
+static void initialNotifySetupTimerCB(void *arg);
+static int getInitialNotifyBackoff(int *backoffCount, int *backoffRetryTime);
+static int isInitialNotifyParamError(WDMP_STATUS ret);
+static void freeInitialNotifyGroups(InitialNotifyGroup *groups, int groupCount);
+static WDMP_STATUS setInitialNotifyParams(const char **paramNames, int paramCount);
+static WDMP_STATUS setInitialNotifyForGroup(InitialNotifyGroup *group);
 void processNotification(NotifyData *notifyData);
 void sendNotificationForFactoryReset();
 void sendNotificationForFirmwareUpgrade();
 static WDMP_STATUS addOrUpdateFirmwareVerToConfigFile(char *value);
-static WDMP_STATUS processParamNotification(ParamNotify *paramNotify, unsigned int *cmc, char **cid);
+static WDMP_STATUS processParamNotification(ParamNotify *paramNotify, unsigned int oldCMC, unsigned int *cmc, char **cid);
+static int isSyncNotifyPending(ParamNotify *paramNotify, unsigned int cmc);
+static void settleParamNotification();
+static void coalesceParamNotifications(ParamNotify *paramNotify);
 static WDMP_STATUS getCmcCidValues(unsigned int *cmc, char **cid);
+static WDMP_STATUS getCmcValue(unsigned int *cmc);
+static WDMP_STATUS getCidValue(char **cid);
+static WDMP_STATUS setCmcValue(unsigned int cmc);
+static WDMP_STATUS setCidValue(const char *cid);
 static void processConnectedClientNotification(NodeData *connectedNotify, char *deviceId, char **version, char ** nodeMacId, char **timeStamp, char **destination);
 static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, unsigned int *cmc, char **cid, char **reason);
 static WDMP_STATUS processFirmwareUpgradeNotification(ParamNotify *paramNotify, unsigned int *cmc, char **cid);
@@ -262,7 +356,9 @@ void getDeviceMac();
 static WDMP_STATUS processParamNotificationRetry(unsigned int *cmc, char **cid);
 static char* generate_trans_uuid();
 void SyncNotifyRetryTask();
-void *SyncNotifyRetry();
+void resetSyncNotifyRetry();
+void syncNotifyRetryTimerCB(void *arg);
+static void armSyncNotifyRetry();
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -273,10 +369,11 @@ void initNotifyTask(int status)
 {
 	int err = 0;
 	pthread_t threadId;
-	notifyMsgQ = NULL;
 	int *device_status = (int *) malloc(sizeof(int));
 	*device_status = status;
 
+	// loaded here so the request limits are in place before parodus_receive_wait starts the workers
+	loadCfgFile();
 	err = pthread_create(&threadId, NULL, notifyTask, (void *) device_status);
 	if (err != 0) 
 	{
@@ -343,8 +440,7 @@ void *FactoryResetCloudSync()
 			{
 				//check CID
 				WalPrint("check CID \n");
-				dbCID = getParameterValue(PARAM_CID);
-				if(dbCID == NULL)
+				if(getCidValue(&dbCID) != WDMP_SUCCESS)
 				{
 					WalError("Unable to get dbCID value\n");
 					return NULL;
@@ -382,111 +478,99 @@ void *FactoryResetCloudSync()
 
 void SyncNotifyRetryTask()
 {
-	int err = 0;
-	pthread_t threadId;
-	err = pthread_create(&threadId, NULL, SyncNotifyRetry, NULL);
-	if (err != 0)
-	{
-		WalError("Error creating SyncNotifyRetry thread :[%s]\n", strerror(err));
-	}
-	else
+	pthread_mutex_lock(&sync_mutex);
+	if(g_syncRetryStarted)
 	{
-		WalInfo("SyncNotifyRetry Thread created Successfully\n");
-		g_syncRetryThreadStarted = 1;
-		//When CPE and cloud are out of sync, retry sync notification twice with a 7mins delay between attempts
-		g_checkSyncNotifyRetry = 1;
+		pthread_mutex_unlock(&sync_mutex);
+		return;
 	}
+	g_syncRetryStarted = 1;
+	//When CPE and cloud are out of sync, retry sync notification twice with a 7mins delay between attempts
+	g_checkSyncNotifyRetry = 1;
+	armSyncNotifyRetry();
+	pthread_mutex_unlock(&sync_mutex);
+	startWebpaTimerTask();
+	WalInfo("Sync notification retries are run from the timer work thread\n");
 }
 
-void *SyncNotifyRetry()
+/*
+ * @brief resetSyncNotifyRetry restarts the retry wait and count, called whenever a new sync notification is sent
+ */
+void resetSyncNotifyRetry()
 {
-	pthread_detach(pthread_self());
-	char *dbCMC = NULL;
-	int RetryTime = 420;//7mins
-	struct timespec ts;
-	int  rv;
-	int retry_count = 0;    
-	WalInfo("SyncNotifyRetry: max_retry_sleep is 15mins\n");
-
-	while(FOREVER())
-	{
-		clock_gettime(CLOCK_REALTIME, &ts);
-		ts.tv_sec += RetryTime;
-		//wait for delay for retransmission
-		if(g_checkSyncNotifyRetry == 1)
-		{
-			WalInfo("Wait for %d sec to check sync notification retry\n", RetryTime);
-		}
-
-		rv = pthread_cond_timedwait(&sync_condition, &sync_mutex, &ts);
-		if (rv == 0)
-		{
-			WalPrint("new sync notification is received during waiting period and resetting the timer.\n");
-			retry_count = 0;
-			continue;
-		} 
-		else if (rv == ETIMEDOUT) 
-		{
-			WalPrint("SyncNotifyRetry thread: Timeout occurred., proceed to retry\n");
-		} 
-		else 
-		{
-			WalError("SyncNotifyRetry thread: Error occurred: %d\n", rv);	
-			continue;
-		}
+	WalPrint("new sync notification is received during waiting period and resetting the timer.\n");
+	pthread_mutex_lock(&sync_mutex);
+	syncRetryCount = 0;
+	armSyncNotifyRetry();
+	pthread_mutex_unlock(&sync_mutex);
+}
 
-		if(g_syncNotifyInProgress == 1)
-		{	
-			WalInfo("PARAM_NOTIFY is in progress\n");
-			retry_count = 0;
-			continue;
-		}
+/*
+ * @brief syncNotifyRetryTimerCB retries the sync notification when cloud and CPE are still out of sync
+ */
+void syncNotifyRetryTimerCB(void *arg)
+{
+	unsigned int dbCMC = 0;
 
-		if(g_checkSyncNotifyRetry)
-		{
-			dbCMC = getParameterValue(PARAM_CMC);
-		}
-		else
-		{
-			WalPrint("g_checkSyncNotifyRetry is 0 and skip dbCMC sync checking\n");
-			continue;
-		}
+	(void) arg;
+	pthread_mutex_lock(&sync_mutex);
+	syncRetryTimerId = 0;
+	pthread_mutex_unlock(&sync_mutex);
+	WalPrint("SyncNotifyRetry: Timeout occurred., proceed to retry\n");
 
-		if(NULL == dbCMC)
+	if(g_syncNotifyInProgress == 1)
+	{
+		WalInfo("PARAM_NOTIFY is in progress\n");
+		pthread_mutex_lock(&sync_mutex);
+		syncRetryCount = 0;
+		pthread_mutex_unlock(&sync_mutex);
+	}
+	else if(!g_checkSyncNotifyRetry)
+	{
+		WalPrint("g_checkSyncNotifyRetry is 0 and skip dbCMC sync checking\n");
+	}
+	else if(getCmcValue(&dbCMC) != WDMP_SUCCESS)
+	{
+		WalError("SyncNotifyRetry: dbCMC is Null\n");
+	}
+	else if(dbCMC != CHANGED_BY_XPC)
+	{
+		//Retry sending sync notification to cloud
+		WalInfo("Retrying sync notification as cloud and CPE are out of sync, dbCMC is %u\n", dbCMC);
+		NotifyData *notifyData = (NotifyData *)malloc(sizeof(NotifyData) * 1);
+		if(notifyData != NULL)
 		{
-			WalError("SyncNotifyRetry thread: dbCMC is Null\n");	
-			continue;
-		} 		
-		if(strcmp(dbCMC,"512"))
-		{       
-			//Retry sending sync notification to cloud			
-			WalInfo("Retrying sync notification as cloud and CPE are out of sync, dbCMC is %s\n", dbCMC);
-			NotifyData *notifyData = (NotifyData *)malloc(sizeof(NotifyData) * 1);
-			if(notifyData != NULL)
-			{
-				memset(notifyData,0,sizeof(NotifyData));
-				notifyData->type = PARAM_NOTIFY_RETRY;
-				processNotification(notifyData);
-			}
-			WalPrint("After Sending processNotification\n");
-			retry_count++;
-			if(retry_count >= 2)
-			{
-				retry_count = 0;
-				g_checkSyncNotifyRetry = 0;
-				WalError("sync retry notification has reached max attempts, proceeding though cloud and CPE are out of sync\n");
-			}
+			memset(notifyData,0,sizeof(NotifyData));
+			notifyData->type = PARAM_NOTIFY_RETRY;
+			processNotification(notifyData);
 		}
-		else
+		WalPrint("After Sending processNotification\n");
+		pthread_mutex_lock(&sync_mutex);
+		if(++syncRetryCount >= WEBPA_SYNC_NOTIFY_RETRY_COUNT)
 		{
+			syncRetryCount = 0;
 			g_checkSyncNotifyRetry = 0;
-			retry_count = 0;
-			WalInfo("CMC is equal to 512, cloud and CPE are in sync\n");
-			WalInfo("g_checkSyncNotifyRetry is set to 0\n");
+			WalError("sync retry notification has reached max attempts, proceeding though cloud and CPE are out of sync\n");
 		}
-		WAL_FREE(dbCMC);			
+		pthread_mutex_unlock(&sync_mutex);
+	}
+	else
+	{
+		g_checkSyncNotifyRetry = 0;
+		pthread_mutex_lock(&sync_mutex);
+		syncRetryCount = 0;
+		pthread_mutex_unlock(&sync_mutex);
+		WalInfo("CMC is equal to 512, cloud and CPE are in sync\n");
+		WalInfo("g_checkSyncNotifyRetry is set to 0\n");
+	}
+
+	pthread_mutex_lock(&sync_mutex);
+	// a sync notification sent meanwhile already restarted the wait
+	if(syncRetryTimerId == 0)
+	{
+		armSyncNotifyRetry();
 	}
-	return NULL;	
+	pthread_mutex_unlock(&sync_mutex);
 }
 
 void ccspWebPaValueChangedCB(parameterSigStruct_t* val, int size, void* user_data)
@@ -516,6 +600,7 @@ void ccspWebPaValueChangedCB(parameterSigStruct_t* val, int size, void* user_dat
 	paramNotify->changeSource = mapWriteID(val->writeID);
 
 	NotifyData *notifyDataPtr = (NotifyData *) malloc(sizeof(NotifyData) * 1);
+	memset(notifyDataPtr, 0, sizeof(NotifyData));
 	notifyDataPtr->type = PARAM_NOTIFY;
 	notifyDataPtr->u.notify = paramNotify;
 
@@ -563,43 +648,30 @@ void processTransactionNotification(char transId[])
 
 void sendConnectedClientNotification(char * macId, char *status, char *interface, char *hostname, char *ipv4)
 {
-
-	NotifyData *notifyDataPtr = (NotifyData *) malloc(sizeof(NotifyData) * 1);
 	NodeData * node = NULL;
 
-	notifyDataPtr->type = CONNECTED_CLIENT_NOTIFY;
 	if(macId != NULL && status != NULL && interface != NULL && hostname != NULL)
 	{
 		node = (NodeData *) malloc(sizeof(NodeData) * 1);
 		memset(node, 0, sizeof(NodeData));
 		WalPrint("macId : %s status : %s interface : %s hostname :%s ipv4 : %s\n",macId,status, interface, hostname, ipv4 ? ipv4 : "");
-		node->nodeMacId = (char *)(malloc(sizeof(char) * strlen(macId) + 1));
-		strncpy(node->nodeMacId, macId, strlen(macId) + 1);
-
-		node->status = (char *)(malloc(sizeof(char) * strlen(status) + 1));
-		strncpy(node->status, status, strlen(status) + 1);
-		
-		node->interface = (char *)(malloc(sizeof(char) * strlen(interface) + 1));
-		strncpy(node->interface, interface, strlen(interface) + 1);
-		
-		node->hostname = (char *)(malloc(sizeof(char) * strlen(hostname) + 1));
-		strncpy(node->hostname, hostname, strlen(hostname) + 1);
-
+		node->nodeMacId = strdup(macId);
+		node->status = strdup(status);
+		node->interface = strdup(interface);
+		node->hostname = strdup(hostname);
 		// Handle NULL ipv4 by assigning empty string
-		if(ipv4 != NULL) {
-			node->ipv4 = (char *)(malloc(sizeof(char) * strlen(ipv4) + 1));
-			strncpy(node->ipv4, ipv4, strlen(ipv4) + 1);
-		} else {
-			node->ipv4 = (char *)(malloc(sizeof(char) * 1));
-			strcpy(node->ipv4, "");
-		}
+		node->ipv4 = strdup((ipv4 != NULL) ? ipv4 : "");
 
 		WalPrint("node->nodeMacId : %s node->status: %s node->interface: %s node->hostname: %s node->ipv4: %s\n",node->nodeMacId,node->status, node->interface, node->hostname, node->ipv4);
-	}
 
-	notifyDataPtr->u.node = node;
+		// changes of the same client are collapsed until its window ends
+		if(aggregateClientNotify(macId, getNodeSignature(node), node) == 0)
+		{
+			return;
+		}
+	}
 
-	(*notifyCbFn)(notifyDataPtr);
+	emitClientNotification(node);
 }
 
 void processDeviceManageableNotification()
@@ -626,6 +698,30 @@ void processDeviceManageableNotification()
 /*                               Internal functions                              */
 /*----------------------------------------------------------------------------*/
 
+/*
+ * @brief armSyncNotifyRetry (re)starts the sync notification retry wait, caller holds sync_mutex
+ */
+static void armSyncNotifyRetry()
+{
+	if(!g_syncRetryStarted)
+	{
+		return;
+	}
+	if(syncRetryTimerId != 0)
+	{
+		cancelWebpaTimer(syncRetryTimerId);
+	}
+	if(g_checkSyncNotifyRetry == 1)
+	{
+		WalInfo("Wait for %d sec to check sync notification retry\n", WEBPA_SYNC_NOTIFY_RETRY_SEC);
+	}
+	syncRetryTimerId = scheduleWebpaWork(WEBPA_SYNC_NOTIFY_RETRY_SEC * 1000UL, 0, syncNotifyRetryTimerCB, NULL);
+	if(syncRetryTimerId == 0)
+	{
+		WalError("Failed to schedule sync notification retry\n");
+	}
+}
+
 /*
  * @brief loadCfgFile To load the config file.
  */
@@ -637,6 +733,12 @@ void loadCfgFile()
 	int ch_count = 0;
 	int flag = 0;
 	size_t sz;
+	cJSON *item = NULL;
+
+	webPaCfg.notifyQueueCapacity = WEBPA_NOTIFY_QUEUE_CAPACITY;
+	webPaCfg.notifyQueuePolicy = NOTIFY_QUEUE_DROP_NEWEST;
+	webPaCfg.clientNotifyWindowSec = WEBPA_CLIENT_NOTIFY_WINDOW_SEC;
+	webPaCfg.metricsLogIntervalSec = WEBPA_NOTIFY_METRICS_LOG_INTERVAL_SEC;
 	fp = fopen(WEBPA_CFG_FILE, "r");
 	if (fp == NULL)
 	{
@@ -691,6 +793,30 @@ void loadCfgFile()
 			{
 				strcpy(webPaCfg.oldFirmwareVersion,"");
 			}
+
+			item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_NOTIFY_QUEUE_CAPACITY);
+			if(item != NULL && item->valueint > 0)
+			{
+				webPaCfg.notifyQueueCapacity = (unsigned int) item->valueint;
+			}
+			item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_NOTIFY_QUEUE_POLICY);
+			if(item != NULL && item->valuestring != NULL && strcmp(item->valuestring, "block") == 0)
+			{
+				webPaCfg.notifyQueuePolicy = NOTIFY_QUEUE_BLOCK;
+			}
+			item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_CLIENT_NOTIFY_WINDOW);
+			if(item != NULL && cJSON_IsNumber(item) && item->valueint >= 0)
+			{
+				webPaCfg.clientNotifyWindowSec = (unsigned int) item->valueint;
+			}
+			item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_METRICS_LOG_INTERVAL);
+			if(item != NULL && cJSON_IsNumber(item) && item->valueint >= 0)
+			{
+				webPaCfg.metricsLogIntervalSec = (unsigned int) item->valueint;
+			}
+			WalPrint("notifyQueueCapacity : %u notifyQueuePolicy : %d clientNotifyWindowSec : %u notifyMetricsLogIntervalSec : %u\n", webPaCfg.notifyQueueCapacity, webPaCfg.notifyQueuePolicy, webPaCfg.clientNotifyWindowSec, webPaCfg.metricsLogIntervalSec);
+			loadCompressConfig(webpa_cfg);
+			loadRequestLimits(webpa_cfg);
                         cJSON_Delete(webpa_cfg);
 		}
 		else
@@ -711,6 +837,83 @@ void loadCfgFile()
 	free(cfg_file_content);
 }
 
+/*
+ * @brief loadCompressConfig applies the payload compression settings found in
+ * the config, e.g. "compressThreshold": 8192, "compressNotifications": true
+ */
+static void loadCompressConfig(cJSON *webpa_cfg)
+{
+	cJSON *item = NULL;
+	size_t threshold = WEBPA_COMPRESS_THRESHOLD;
+	int compressEvents = 0;
+
+	item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_COMPRESS_THRESHOLD);
+	if(item != NULL && cJSON_IsNumber(item) && item->valueint >= 0)
+	{
+		threshold = (size_t) item->valueint;
+	}
+	item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_COMPRESS_NOTIFICATIONS);
+	if(item != NULL && cJSON_IsTrue(item))
+	{
+		compressEvents = 1;
+	}
+	setCompressConfig(threshold, compressEvents);
+}
+
+/*
+ * @brief loadRequestLimits applies the request admission limits and bulk sources
+ * found in the config, e.g. "requestMaxPerType": {"REPLACE_ROWS": 1}
+ */
+static void loadRequestLimits(cJSON *webpa_cfg)
+{
+	WebpaRequestLimits limits;
+	cJSON *item = NULL, *typeItem = NULL;
+	const char *sources[WEBPA_REQUEST_BULK_SOURCES_MAX];
+	int reqType = -1, sourceCount = 0;
+
+	getWebpaRequestLimits(&limits);
+	item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_REQUEST_MAX_IN_FLIGHT);
+	if(item != NULL && cJSON_IsNumber(item) && item->valueint >= 0)
+	{
+		limits.maxInFlight = (unsigned int) item->valueint;
+	}
+	item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_REQUEST_MAX_WAIT);
+	if(item != NULL && cJSON_IsNumber(item) && item->valueint >= 0)
+	{
+		limits.maxWaitMs = (unsigned int) item->valueint;
+	}
+	item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_REQUEST_MAX_PER_TYPE);
+	if(item != NULL && cJSON_IsObject(item))
+	{
+		for(typeItem = item->child; typeItem != NULL; typeItem = typeItem->next)
+		{
+			reqType = getRequestTypeByName(typeItem->string);
+			if(reqType >= 0 && reqType < WEBPA_REQUEST_TYPES && cJSON_IsNumber(typeItem) && typeItem->valueint >= 0)
+			{
+				limits.maxPerType[reqType] = (unsigned int) typeItem->valueint;
+			}
+			else
+			{
+				WalError("Ignoring request limit for %s\n", (typeItem->string != NULL) ? typeItem->string : "NULL");
+			}
+		}
+	}
+	setWebpaRequestLimits(&limits);
+
+	item = cJSON_GetObjectItem(webpa_cfg, WEBPA_CFG_REQUEST_BULK_SOURCES);
+	if(item != NULL && cJSON_IsArray(item))
+	{
+		for(typeItem = item->child; typeItem != NULL && sourceCount < WEBPA_REQUEST_BULK_SOURCES_MAX; typeItem = typeItem->next)
+		{
+			if(cJSON_IsString(typeItem))
+			{
+				sources[sourceCount++] = typeItem->valuestring;
+			}
+		}
+		setWebpaRequestBulkSources(sources, sourceCount);
+	}
+}
+
 /**
  * @brief getNotifyParamList Get notification parameters from intial NotifList
  *      returns notif parameter names and size of list
@@ -774,114 +977,393 @@ static void getNotifyParamList(const char ***paramList, int *size)
 	*paramList = notifyparameters;
 }
 
+/**
+ * @brief groupInitialNotifyParams Groups the initial notification parameters by
+ * the component that owns them so that notification can be turned ON with one
+ * SetAttributes call per component. Parameters whose component cannot be
+ * resolved yet are placed in a group of their own.
+ *
+ * @param[in] paramList Initial Notif parameters list
+ * @param[in] paramCount Notif List array size
+ * @param[out] groupCount number of groups formed
+ * @return InitialNotifyGroup* array of parameter groups
+ */
+static InitialNotifyGroup * groupInitialNotifyParams(const char **paramList, int paramCount, int *groupCount)
+{
+	int i = 0, j = 0, error = 0, count = 0, grpCount = 0;
+	char paramName[MAX_PARAMETERNAME_LEN] = {'\0'};
+	char **compName = NULL;
+	char **dbusPath = NULL;
+	InitialNotifyGroup *groups = NULL;
+
+	*groupCount = 0;
+	groups = (InitialNotifyGroup *) malloc(sizeof(InitialNotifyGroup) * paramCount);
+	if(groups == NULL)
+	{
+		WalError("Failed to allocate %d initial notify groups\n", paramCount);
+		return NULL;
+	}
+	memset(groups, 0, sizeof(InitialNotifyGroup) * paramCount);
+
+	for(i = 0; i < paramCount; i++)
+	{
+		error = 0;
+		count = 0;
+		compName = NULL;
+		dbusPath = NULL;
+		walStrncpy(paramName, paramList[i], sizeof(paramName));
+		getComponentDetails(paramName, &compName, &dbusPath, &error, &count);
+		if(error == 1 || count == 0)
+		{
+			WalError("Unable to resolve component for %s, it will be set individually\n", paramList[i]);
+			j = grpCount;
+		}
+		else
+		{
+			for(j = 0; j < grpCount; j++)
+			{
+				if(groups[j].compName != NULL && strcmp(groups[j].compName, compName[0]) == 0)
+				{
+					break;
+				}
+			}
+			if(j == grpCount)
+			{
+				groups[j].compName = strdup(compName[0]);
+			}
+			free_componentDetails(compName, dbusPath, count);
+		}
+
+		if(j == grpCount)
+		{
+			// max number of parameters in a group is the remaining parameters to be iterated
+			groups[j].paramNames = (const char **) malloc(sizeof(char *) * (paramCount - i));
+			if(groups[j].paramNames == NULL)
+			{
+				WalError("Failed to allocate initial notify group for %s\n", paramList[i]);
+				freeInitialNotifyGroups(groups, grpCount + 1);
+				return NULL;
+			}
+			groups[j].backoffCount = 2;
+			grpCount++;
+		}
+		groups[j].paramNames[groups[j].paramCount++] = paramList[i];
+	}
+
+	WalInfo("Initial notify parameters %d grouped into %d components\n", paramCount, grpCount);
+	*groupCount = grpCount;
+	return groups;
+}
+
+/*
+ * @brief freeInitialNotifyGroups frees the groups formed by groupInitialNotifyParams
+ */
+static void freeInitialNotifyGroups(InitialNotifyGroup *groups, int groupCount)
+{
+	int i = 0;
+
+	for(i = 0; i < groupCount; i++)
+	{
+		free(groups[i].compName);
+		free(groups[i].paramNames);
+	}
+	free(groups);
+}
+
+/**
+ * @brief setInitialNotifyParams Turns ON notification for parameters of one component
+ * in a single SetAttributes call.
+ *
+ * @param[in] paramNames parameter names
+ * @param[in] paramCount number of parameters
+ * @return WDMP_STATUS status of the SetAttributes call
+ */
+static WDMP_STATUS setInitialNotifyParams(const char **paramNames, int paramCount)
+{
+	int i = 0;
+	WDMP_STATUS ret = WDMP_FAILURE;
+	param_t *attArr = NULL;
+
+	attArr = (param_t *) malloc(sizeof(param_t) * paramCount);
+	if(attArr == NULL)
+	{
+		WalError("Failed to allocate attributes of %d initial notify parameters\n", paramCount);
+		return WDMP_FAILURE;
+	}
+	for(i = 0; i < paramCount; i++)
+	{
+		attArr[i].name = (char *) paramNames[i];
+		attArr[i].value = "1";
+		attArr[i].type = WDMP_INT;
+		WalPrint("notifyparameters[%d]: %s\n", i, paramNames[i]);
+	}
+	setAttributes(attArr, paramCount, NULL, &ret);
+	WAL_FREE(attArr);
+	return ret;
+}
+
+/**
+ * @brief setInitialNotifyForGroup Turns ON notification for all the parameters of a group
+ * in a single SetAttributes call. The call is rejected as a whole when one of the
+ * parameters is bad, so a group failing with a parameter error is set again one
+ * parameter at a time and only the parameters that still fail are kept in the group
+ * for the next attempt. Any other failure, such as a timeout of a component that is
+ * not up yet, retries the whole group.
+ *
+ * @param[in] group parameter group belonging to one component
+ * @return WDMP_STATUS WDMP_SUCCESS once every parameter of the group is set
+ */
+static WDMP_STATUS setInitialNotifyForGroup(InitialNotifyGroup *group)
+{
+	int i = 0, failed = 0;
+	WDMP_STATUS ret = WDMP_FAILURE, paramRet = WDMP_FAILURE;
+
+	ret = setInitialNotifyParams(group->paramNames, group->paramCount);
+	if(ret == WDMP_SUCCESS || group->paramCount == 1 || !isInitialNotifyParamError(ret))
+	{
+		return ret;
+	}
+
+	WalError("Failed to turn notification ON for %s group ret: %d, setting its %d parameters individually\n",
+			(group->compName != NULL) ? group->compName : group->paramNames[0], ret, group->paramCount);
+	for(i = 0; i < group->paramCount; i++)
+	{
+		paramRet = setInitialNotifyParams(&group->paramNames[i], 1);
+		if(paramRet == WDMP_SUCCESS)
+		{
+			WalInfo("Successfully set notification ON for parameter : %s ret: %d\n", group->paramNames[i], paramRet);
+		}
+		else
+		{
+			ret = paramRet;
+			group->paramNames[failed++] = group->paramNames[i];
+		}
+	}
+	group->paramCount = failed;
+	return (failed == 0) ? WDMP_SUCCESS : ret;
+}
+
 /**
  * @brief To turn on notification for the parameters extracted from the notifyList of the config file.
+ * Parameters are set per component group and only the failed groups are retried from the
+ * timer work thread, each one following its own backoff schedule.
  */
 static void setInitialNotify()
 {
 	WalPrint("***************Inside setInitialNotify*****************\n");
-	int i = 0, isError = 0, retry = 0;
-	char notif[20] = "";
+	int i = 0, groupCount = 0, failed = 0;
 	const char **notifyparameters = NULL;
 	int notifyListSize = 0;
+	InitialNotifyGroup *groups = NULL;
+	WDMP_STATUS ret = WDMP_FAILURE;
 
-	int backoffRetryTime = 0;
-	int backoff_max_time = 10;
-        int max_retry_sleep;
-	//Retry Backoff count will start at c=2 & calculate 2^c - 1.
-	int c = 2;
-	
-	max_retry_sleep = (int) pow(2, backoff_max_time) -1;
-        WalInfo("setInitialNotify max_retry_sleep is %d\n", max_retry_sleep );
+	WalInfo("setInitialNotify max_retry_sleep is %d\n", (int) pow(2, WEBPA_SET_INITIAL_NOTIFY_BACKOFF_MAX) - 1);
 
 	getNotifyParamList(&notifyparameters, &notifyListSize);
 
 	//notifyparameters is empty for webpa-video
-	if (notifyparameters != NULL)
+	if (notifyparameters == NULL)
 	{
-		int *setInitialNotifStatus = (int *) malloc(
-				sizeof(int) * notifyListSize);
-
-		WDMP_STATUS ret = WDMP_FAILURE;
-		param_t *attArr = NULL;
+		WalError("Initial Notification list is empty\n");
+		return;
+	}
 
-		for (i = 0; i < notifyListSize; i++)
+	WalPrint("notify List Size: %d\n", notifyListSize);
+	groups = groupInitialNotifyParams(notifyparameters, notifyListSize, &groupCount);
+	if(groups == NULL)
+	{
+		WalError("Unable to group initial notify parameters, setting them individually\n");
+		for(i = 0; i < notifyListSize; i++)
+		{
+			ret = setInitialNotifyParams(&notifyparameters[i], 1);
+			if(ret == WDMP_SUCCESS)
+			{
+				WalInfo("Successfully set notification ON for parameter : %s ret: %d\n", notifyparameters[i], ret);
+			}
+			else
+			{
+				WalError("Failed to turn notification ON for parameter : %s ret: %d\n", notifyparameters[i], ret);
+				failed++;
+			}
+		}
+		if(failed > 0)
 		{
-			setInitialNotifStatus[i] = 0;
+			scheduleInitialNotifySetup();
 		}
+		return;
+	}
+
+	initialNotifyGroups = groups;
+	initialNotifyGroupCount = groupCount;
+	startWebpaTimerTask();
+	runInitialNotify();
+	WalPrint("**********************End of setInitial Notify************************\n");
+}
 
-		do
+/*
+ * @brief retryInitialNotifyGroups sets the groups whose backoff expired
+ * @param[in] now current monotonic time
+ * @param[out] nextAttempt earliest retry of the groups still pending
+ * @return number of groups still pending
+ */
+static int retryInitialNotifyGroups(time_t now, time_t *nextAttempt)
+{
+	InitialNotifyGroup *groups = initialNotifyGroups;
+	int i = 0, j = 0, pending = 0;
+	WDMP_STATUS ret = WDMP_FAILURE;
+
+	*nextAttempt = 0;
+	for(i = 0; i < initialNotifyGroupCount; i++)
+	{
+		if(groups[i].done)
+		{
+			continue;
+		}
+		if(groups[i].nextAttempt <= now)
 		{
-			if(backoffRetryTime < max_retry_sleep)
-                	{
-				backoffRetryTime = (int) pow(2, c) - 1;
+			ret = setInitialNotifyForGroup(&groups[i]);
+			if(ret == WDMP_SUCCESS)
+			{
+				groups[i].done = 1;
+				for(j = 0; j < groups[i].paramCount; j++)
+				{
+					WalInfo("Successfully set notification ON for parameter : %s ret: %d\n", groups[i].paramNames[j], ret);
+				}
+				continue;
 			}
-			
-			WalPrint("setInitialNotify backoffRetryTime calculated as %d seconds\n", backoffRetryTime);
 
-			isError = 0;
-			WalPrint("notify List Size: %d\n", notifyListSize);
-			attArr = (param_t *) malloc(sizeof(param_t));
-			for (i = 0; i < notifyListSize; i++)
+			WalError("Failed to turn notification ON for %d parameters of %s ret: %d Attempt Number: %d\n",
+					groups[i].paramCount, (groups[i].compName != NULL) ? groups[i].compName : groups[i].paramNames[0], ret, groups[i].retry + 1);
+			if(groups[i].retry++ >= WEBPA_SET_INITIAL_NOTIFY_RETRY_COUNT)
 			{
-				if (setInitialNotifStatus[i] == 0)
+				for(j = 0; j < groups[i].paramCount; j++)
 				{
-					snprintf(notif, sizeof(notif), "%d", 1);
-					attArr[0].value = (char *) malloc(sizeof(char) * 20);
-					walStrncpy(attArr[0].value, notif, 20);
-					attArr[0].name = (char *) notifyparameters[i];
-					attArr[0].type = WDMP_INT;
-					WalPrint("notifyparameters[%d]: %s\n", i,notifyparameters[i]);
-					setAttributes(attArr, 1, NULL, &ret);
-					if (ret != WDMP_SUCCESS)
-					{
-						isError = 1;
-						setInitialNotifStatus[i] = 0;
-						WalError("Failed to turn notification ON for parameter : %s ret: %d Attempt Number: %d\n",
-								notifyparameters[i], ret, retry + 1);
-					}
-					else
-					{
-						setInitialNotifStatus[i] = 1;
-						WalInfo("Successfully set notification ON for parameter : %s ret: %d\n",notifyparameters[i], ret);
-					}
-					WAL_FREE(attArr[0].value);
+					WalError("Giving up turning notification ON for parameter : %s\n", groups[i].paramNames[j]);
 				}
+				groups[i].done = 1;
+				continue;
 			}
 
-			WAL_FREE(attArr);
+			groups[i].nextAttempt = now + getInitialNotifyBackoff(&groups[i].backoffCount, &groups[i].backoffRetryTime);
+			WalInfo("setInitialNotify %s backoffRetryTime %d seconds, retry:%d\n", (groups[i].compName != NULL) ? groups[i].compName : groups[i].paramNames[0], (int) (groups[i].nextAttempt - now), groups[i].retry);
+		}
+		pending++;
+		if(*nextAttempt == 0 || groups[i].nextAttempt < *nextAttempt)
+		{
+			*nextAttempt = groups[i].nextAttempt;
+		}
+	}
+	return pending;
+}
+
+/*
+ * @brief runInitialNotify sets the due groups and schedules the next retry, the groups are freed once all are done
+ */
+static void runInitialNotify()
+{
+	struct timespec now;
+	time_t nextAttempt = 0;
+	int pending = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pending = retryInitialNotifyGroups(now.tv_sec, &nextAttempt);
+	if(pending > 0)
+	{
+		if(scheduleWebpaWork((nextAttempt > now.tv_sec) ? (unsigned long) (nextAttempt - now.tv_sec) * 1000UL : 0, 0, initialNotifyTimerCB, NULL) != 0)
+		{
+			return;
+		}
+		WalError("Failed to schedule initial notify retry, %d component groups are not set\n", pending);
+	}
+	else
+	{
+		WalInfo("Initial notification setup completed for %d component groups\n", initialNotifyGroupCount);
+	}
+	freeInitialNotifyGroups(initialNotifyGroups, initialNotifyGroupCount);
+	initialNotifyGroups = NULL;
+	initialNotifyGroupCount = 0;
+}
+
+static void initialNotifyTimerCB(void *arg)
+{
+	(void) arg;
+	runInitialNotify();
+}
+
+/*
+ * @brief scheduleInitialNotifySetup runs setInitialNotify again after a backoff,
+ * used when the parameters could not be grouped and some of them failed
+ */
+static void scheduleInitialNotifySetup()
+{
+	int delay = 0;
 
-			if (isError == 0)
-			{
-				WalInfo("Successfully set initial notifications\n");
-				break;
-			}
+	if(initialNotifySetupRetry++ >= WEBPA_SET_INITIAL_NOTIFY_RETRY_COUNT)
+	{
+		WalError("Giving up turning initial notification ON after %d attempts\n", initialNotifySetupRetry);
+		return;
+	}
+	delay = getInitialNotifyBackoff(&initialNotifySetupBackoffCount, &initialNotifySetupBackoffTime);
+	WalInfo("setInitialNotify backoffRetryTime %d seconds, retry:%d\n", delay, initialNotifySetupRetry);
+	startWebpaTimerTask();
+	if(scheduleWebpaWork((unsigned long) delay * 1000UL, 0, initialNotifySetupTimerCB, NULL) == 0)
+	{
+		WalError("Failed to schedule initial notify retry\n");
+	}
+}
 
-			WalInfo("setInitialNotify backoffRetryTime %d seconds, retry:%d\n",	backoffRetryTime, retry);
-			sleep(backoffRetryTime);
-			c++;
-			
-			if(backoffRetryTime == 127) // after 127s backoff delay, next delay will be 2^10 - 1 = 1023s i.e. > 15mins
-                        {
-                                c = 10; // skip c = 8,9
-                                WalInfo("setInitialNotify backoffRetryTime reached 127s, wait for more than 15mins for next retry\n");
-                        }
-			else if(backoffRetryTime == max_retry_sleep)
-                        {
-                        	c = 2;
-                        	backoffRetryTime = 0;
-                        	WalInfo("setInitialNotify backoffRetryTime reached max value, reseting to initial value\n");
-                        }
+static void initialNotifySetupTimerCB(void *arg)
+{
+	(void) arg;
+	setInitialNotify();
+}
 
-		} while (retry++ < WEBPA_SET_INITIAL_NOTIFY_RETRY_COUNT);
+/*
+ * @brief getInitialNotifyBackoff returns the next retry delay in seconds and advances the backoff.
+ * Retry Backoff count will start at c=2 & calculate 2^c - 1.
+ */
+static int getInitialNotifyBackoff(int *backoffCount, int *backoffRetryTime)
+{
+	int max_retry_sleep = (int) pow(2, WEBPA_SET_INITIAL_NOTIFY_BACKOFF_MAX) - 1;
+	int delay = 0;
 
-		WAL_FREE(setInitialNotifStatus);
+	if(*backoffRetryTime < max_retry_sleep)
+	{
+		*backoffRetryTime = (int) pow(2, *backoffCount) - 1;
+	}
+	delay = *backoffRetryTime;
+	(*backoffCount)++;
 
-		WalPrint("**********************End of setInitial Notify************************\n");
+	if(*backoffRetryTime == 127) // after 127s backoff delay, next delay will be 2^10 - 1 = 1023s i.e. > 15mins
+	{
+		*backoffCount = 10; // skip c = 8,9
 	}
-	else
+	else if(*backoffRetryTime == max_retry_sleep)
 	{
-		WalError("Initial Notification list is empty\n");
+		*backoffCount = 2;
+		*backoffRetryTime = 0;
+	}
+	return delay;
+}
+
+/*
+ * @brief isInitialNotifyParamError returns 1 for the statuses caused by one bad parameter,
+ * the only failures worth splitting a group into single parameter calls
+ */
+static int isInitialNotifyParamError(WDMP_STATUS ret)
+{
+	switch(ret)
+	{
+		case WDMP_ERR_NOT_EXIST:
+		case WDMP_ERR_INVALID_PARAMETER_NAME:
+		case WDMP_ERR_INVALID_PARAMETER_TYPE:
+		case WDMP_ERR_INVALID_PARAMETER_VALUE:
+		case WDMP_ERR_NOT_WRITABLE:
+		case WDMP_ERR_SETATTRIBUTE_REJECTED:
+		case WDMP_ERR_INVALID_ATTRIBUTES:
+			return 1;
+		default:
+			return 0;
 	}
 }
 
@@ -997,9 +1479,28 @@ static void *notifyTask(void *status)
 {
 	pthread_detach(pthread_self());
 	getDeviceMac();
-	loadCfgFile();
+	notifyQueue = notifyPriorityQueueCreate(NOTIFY_CLASS_COUNT, webPaCfg.notifyQueueCapacity, notifyClassWeights, webPaCfg.notifyQueuePolicy);
+	if(notifyQueue == NULL && webPaCfg.notifyQueueCapacity != WEBPA_NOTIFY_QUEUE_CAPACITY)
+	{
+		WalError("Failed to create notification queue of capacity %u, retrying with %u\n", webPaCfg.notifyQueueCapacity, WEBPA_NOTIFY_QUEUE_CAPACITY);
+		webPaCfg.notifyQueueCapacity = WEBPA_NOTIFY_QUEUE_CAPACITY;
+		notifyQueue = notifyPriorityQueueCreate(NOTIFY_CLASS_COUNT, webPaCfg.notifyQueueCapacity, notifyClassWeights, webPaCfg.notifyQueuePolicy);
+	}
+	if(notifyQueue == NULL)
+	{
+		WalError("Failed to create notification queue, notifications are disabled\n");
+		OnboardLog("Failed to create notification queue, notifications are disabled\n");
+		WAL_FREE(status);
+		return NULL;
+	}
 	processDeviceStatusNotification(*(int *)status);
 	RegisterNotifyCB(&notifyCallback);
+	initClientNotifyAggregator(webPaCfg.clientNotifyWindowSec, emitClientNotification, freeNodeData);
+	if(webPaCfg.clientNotifyWindowSec > 0)
+	{
+		startClientNotifyTask();
+	}
+	startNotifyMetricsTask(webPaCfg.metricsLogIntervalSec, logNotifyPipelineStats);
 	sendNotificationForFactoryReset();
 	WalInfo("Registered notifyCallback, create /tmp/webpanotifyready file\n");
 	system("touch /tmp/webpanotifyready");
@@ -1026,40 +1527,25 @@ static void notifyCallback(NotifyData *notifyData)
  */
 static void addNotifyMsgToQueue(NotifyData *notifyData)
 {
-	NotifyMsg *message;
-
+	NotifyQueueStats stats;
+	unsigned int notifyClass = 0;
 
-	message = (NotifyMsg *)malloc(sizeof(NotifyMsg));
-
-	if(message)
+	if(notifyQueue == NULL)
 	{
-		message->notifyData = notifyData;
-		message->next = NULL;
-		pthread_mutex_lock (&mut);
-		WalPrint("addNotifyMsgToQueue :mutex lock in producer thread\n");
-		if(notifyMsgQ == NULL)
-		{
-			notifyMsgQ = message;
-			WalPrint("addNotifyMsgToQueue : Producer added message\n");
-		 	pthread_cond_signal(&con);
-			pthread_mutex_unlock (&mut);
-			WalPrint("addNotifyMsgToQueue :mutex unlock in producer thread\n");
-		}
-		else
-		{
-			NotifyMsg *temp = notifyMsgQ;
-			while(temp->next)
-			{
-				temp = temp->next;
-			}
-			temp->next = message;
-                        pthread_mutex_unlock (&mut);
-		}
+		WalError("Notification queue is not initialized, dropping notification type %d\n", notifyData->type);
+		freeNotifyMessage(notifyData);
+		return;
 	}
-	else
+
+	notifyClass = getNotifyClass(notifyData->type);
+	notifyMetricsStart(&notifyData->queueTime);
+	if(notifyPriorityQueuePush(notifyQueue, notifyClass, notifyData) != 0)
 	{
-		//Memory allocation failed
-		WalError("Memory allocation is failed\n");
+		notifyPriorityQueueGetStats(notifyQueue, notifyClass, &stats);
+		WalError("Notification queue %s is full (capacity %u), dropped notification type %d, total dropped %lu\n", notifyClassNames[notifyClass], stats.capacity, notifyData->type, stats.dropCount);
+		OnboardLog("Notification queue is full, dropped notification type %d\n", notifyData->type);
+		freeNotifyMessage(notifyData);
+		return;
 	}
 	WalPrint("*****Returned from addNotifyMsgToQueue*****\n");
 }
@@ -1117,36 +1603,116 @@ static void handleNotificationEvents()
 		FR_CloudSyncCheck();
 	}
 
-	//thread for retrying sync notifications when cloud and CPE are out of sync
-	if(!g_syncRetryThreadStarted)
-	{
-		SyncNotifyRetryTask();
-	}
+	//timer for retrying sync notifications when cloud and CPE are out of sync
+	SyncNotifyRetryTask();
 
 	while(1)
 	{
-		pthread_mutex_lock (&mut);
-		WalPrint("handleNotificationEvents : mutex lock in consumer thread\n");
-		if(notifyMsgQ != NULL)
+		NotifyData *notifyData = (NotifyData *) notifyPriorityQueuePop(notifyQueue, NULL);
+		if(notifyData != NULL)
 		{
-			NotifyMsg *message = notifyMsgQ;
-			notifyMsgQ = notifyMsgQ->next;
-			pthread_mutex_unlock (&mut);
-			WalPrint("handleNotificationEvents : mutex unlock in consumer thread\n");
-			NotifyData *notifyData = message->notifyData;
+			recordNotifyLatency(NOTIFY_METRIC_QUEUE_WAIT, &notifyData->queueTime);
 			processNotification(notifyData);
-			WAL_FREE(message);
 		}
 		else
-		{		
+		{
+			logNotifyQueueStats();
 			g_syncNotifyInProgress = 0;
 			WalInfo("g_syncNotifyInProgress is set to 0\n");
-			WalPrint("handleNotificationEvents : Before pthread cond wait in consumer thread\n");   
-			pthread_cond_wait(&con, &mut);
-			pthread_mutex_unlock (&mut);
-			WalPrint("handleNotificationEvents : mutex unlock in consumer thread after cond wait\n");
+			WalPrint("handleNotificationEvents : waiting for notifications in consumer thread\n");
+			notifyPriorityQueueWait(notifyQueue);
+		}
+	}
+}
+
+/*
+ * @brief getNotifyClass maps a notification type to its queue priority class.
+ * Replies and device state changes are never queued behind client or value change floods.
+ */
+static unsigned int getNotifyClass(NOTIFY_TYPE type)
+{
+	switch(type)
+	{
+		case TRANS_STATUS:
+		case DEVICE_STATUS:
+		case FACTORY_RESET:
+		case FIRMWARE_UPGRADE:
+			return NOTIFY_CLASS_CONTROL;
+		case CONNECTED_CLIENT_NOTIFY:
+			return NOTIFY_CLASS_CLIENT;
+		case PARAM_NOTIFY:
+		case PARAM_NOTIFY_RETRY:
+		default:
+			return NOTIFY_CLASS_PARAM;
+	}
+}
+
+/*
+ * @brief logNotifyQueueStats logs depth and queueing latency of each priority class
+ */
+static void logNotifyQueueStats()
+{
+	NotifyQueueStats stats;
+	unsigned int i = 0;
+
+	for(i = 0; i < NOTIFY_CLASS_COUNT; i++)
+	{
+		notifyPriorityQueueGetStats(notifyQueue, i, &stats);
+		WalPrint("Notification queue %s: depth %lu enqueued %lu dequeued %lu dropped %lu high watermark %lu latency avg %lu ms max %lu ms\n",
+			notifyClassNames[i], stats.depth, stats.enqueueCount, stats.dequeueCount, stats.dropCount, stats.highWatermark, stats.latencyAvgMs, stats.latencyMaxMs);
+	}
+}
+
+void getNotifyQueueTotals(NotifyQueueStats *stats)
+{
+	NotifyQueueStats classStats;
+	unsigned int i = 0;
+
+	memset(stats, 0, sizeof(NotifyQueueStats));
+	if(notifyQueue == NULL)
+	{
+		return;
+	}
+	for(i = 0; i < NOTIFY_CLASS_COUNT; i++)
+	{
+		notifyPriorityQueueGetStats(notifyQueue, i, &classStats);
+		stats->capacity += classStats.capacity;
+		stats->depth += classStats.depth;
+		stats->enqueueCount += classStats.enqueueCount;
+		stats->dequeueCount += classStats.dequeueCount;
+		stats->dropCount += classStats.dropCount;
+		stats->highWatermark += classStats.highWatermark;
+		stats->latencyAvgMs += classStats.latencyAvgMs * classStats.dequeueCount;
+		if(classStats.latencyMaxMs > stats->latencyMaxMs)
+		{
+			stats->latencyMaxMs = classStats.latencyMaxMs;
 		}
 	}
+	stats->latencyAvgMs = (stats->dequeueCount > 0) ? stats->latencyAvgMs / stats->dequeueCount : 0;
+}
+
+/*
+ * @brief logNotifyPipelineStats adds queue, retry and client window counters to the periodic metrics summary
+ */
+static void logNotifyPipelineStats()
+{
+	NotifyQueueStats stats;
+	NotifyRetryStats retryStats;
+	ClientNotifyStats clientStats;
+	unsigned int i = 0;
+
+	for(i = 0; i < NOTIFY_CLASS_COUNT && notifyQueue != NULL; i++)
+	{
+		notifyPriorityQueueGetStats(notifyQueue, i, &stats);
+		WalInfo("Notification queue %s: depth %lu enqueued %lu dequeued %lu dropped %lu high watermark %lu\n",
+			notifyClassNames[i], stats.depth, stats.enqueueCount, stats.dequeueCount, stats.dropCount, stats.highWatermark);
+	}
+	getNotifyRetryStats(&retryStats);
+	WalInfo("Notification retry: pending %lu retried %lu recovered %lu dropped %lu oldest %ld sec\n",
+		retryStats.pendingCount, retryStats.retryCount, retryStats.retrySuccessCount, retryStats.dropCount, retryStats.oldestPendingAgeSec);
+	getClientNotifyStats(&clientStats);
+	WalInfo("Connected client window: received %lu emitted %lu merged %lu suppressed %lu pending %lu\n",
+		clientStats.receivedCount, clientStats.emittedCount, clientStats.mergedCount, clientStats.suppressedCount, clientStats.pendingCount);
 }
 
 /*
@@ -1325,19 +1891,24 @@ void processNotification(NotifyData *notifyData)
 	char device_id[32] = { '\0' };
 	char *cid = NULL, *dest = NULL, *version = NULL, *timeStamp =
 			NULL, *nodeMacId = NULL, *source = NULL, *reboot_reason = NULL;
-	cJSON * notifyPayload;
-	cJSON * nodes, *one_node, *parameter;
+	NotifyJsonWriter notifyPayload;
+	char payloadBuf[WEBPA_NOTIFY_JSON_BUFFER_SIZE];
 	char *stringifiedNotifyPayload = NULL;
-	notifyPayload = cJSON_CreateObject();
-	unsigned int cmc;
+	unsigned int cmc, oldCMC = 0;
 	char *strBootTime = NULL;
 	char *reason = NULL;
 	char *sync_transaction_uuid = NULL;	
+	struct timespec processStart;
+	int notifyType = notifyData->type;
 
+	notifyMetricsStart(&processStart);
 	snprintf(device_id, sizeof(device_id), "mac:%s", deviceMAC);
 	WalPrint("Device_id %s\n", device_id);
 
-	cJSON_AddStringToObject(notifyPayload, "device_id", device_id);
+	// payloads have a fixed shape per type, fields are written in order straight into payloadBuf
+	notifyJsonInit(&notifyPayload, payloadBuf, sizeof(payloadBuf));
+	notifyJsonBeginObject(&notifyPayload, NULL);
+	notifyJsonAddString(&notifyPayload, "device_id", device_id);
 
 	dest = (char*) malloc(sizeof(char) * WEBPA_NOTIFY_EVENT_MAX_LENGTH);
 
@@ -1351,39 +1922,60 @@ void processNotification(NotifyData *notifyData)
 	        	{
 	        		strcpy(dest, "event:SYNC_NOTIFICATION");
 
-	        		ret = processParamNotification(notifyData->u.notify, &cmc, &cid);
+	        		coalesceParamNotifications(notifyData->u.notify);
+	        		ret = getCmcValue(&oldCMC);
+	        		if (ret == WDMP_SUCCESS)
+	        		{
+	        			// Events that leave CMC unchanged are dropped without waiting for values to settle
+	        			if(isSyncNotifyPending(notifyData->u.notify, oldCMC))
+	        			{
+	        				// Settle delay also acts as the window in which further value change events are merged into this one
+	        				settleParamNotification();
+	        				coalesceParamNotifications(notifyData->u.notify);
+	        			}
+	        			ret = processParamNotification(notifyData->u.notify, oldCMC, &cmc, &cid);
+	        		}
+	        		else
+	        		{
+	        			WalError("Failed to Get CMC Value, hence ignoring the notification\n");
+	        		}
 				g_checkSyncNotifyIgnore = 1;
 	        		if (ret != WDMP_SUCCESS)
 	        		{
 	        			free(dest);
-                                        cJSON_Delete(notifyPayload);
+                                        notifyJsonRelease(&notifyPayload);
                                         freeNotifyMessage(notifyData);
 	        			return;
 	        		}
-	        		cJSON_AddNumberToObject(notifyPayload, "cmc", cmc);
-	        		cJSON_AddStringToObject(notifyPayload, "cid", cid);
+	        		notifyJsonAddNumber(&notifyPayload, "cmc", cmc);
+	        		notifyJsonAddString(&notifyPayload, "cid", cid);
 				OnboardLog("%s/%d/%s\n",dest,cmc,cid);
                                 WAL_FREE(cid);
 				memset(param_notify_string, 0, sizeof(param_notify_string));
 				//sending parameter details when CMC is 768 during unknown value change event				
 				if(cmc == 768)
 				{
-					cJSON *parameter = cJSON_CreateObject();
-					cJSON_AddStringToObject(parameter, "name",(notifyData->u.notify->paramName != NULL) ? notifyData->u.notify->paramName : "unknown");
-					cJSON_AddStringToObject(parameter, "old_value", (notifyData->u.notify->oldValue != NULL) ? notifyData->u.notify->oldValue : "unknown");
-					cJSON_AddStringToObject(parameter, "new_value", (notifyData->u.notify->newValue != NULL) ? notifyData->u.notify->newValue : "unknown");
-					cJSON_AddNumberToObject(parameter, "dataType", notifyData->u.notify->type);
-					char *param_string = cJSON_PrintUnformatted(parameter);
-					if(param_string != NULL)
+					NotifyJsonWriter parameter;
+					char parameterBuf[sizeof(param_notify_string)];
+
+					notifyJsonInit(&parameter, parameterBuf, sizeof(parameterBuf));
+					notifyJsonBeginObject(&parameter, NULL);
+					notifyJsonAddString(&parameter, "name",(notifyData->u.notify->paramName != NULL) ? notifyData->u.notify->paramName : "unknown");
+					notifyJsonAddString(&parameter, "old_value", (notifyData->u.notify->oldValue != NULL) ? notifyData->u.notify->oldValue : "unknown");
+					notifyJsonAddString(&parameter, "new_value", (notifyData->u.notify->newValue != NULL) ? notifyData->u.notify->newValue : "unknown");
+					notifyJsonAddNumber(&parameter, "dataType", notifyData->u.notify->type);
+					notifyJsonEndObject(&parameter);
+					if(notifyJsonGet(&parameter) != NULL)
 					{
-						strncpy(param_notify_string,param_string,sizeof(param_notify_string));
-						WAL_FREE(param_string);
+						strncpy(param_notify_string,notifyJsonGet(&parameter),sizeof(param_notify_string) - 1);
+						// written once, the same text is embedded in the payload
+						notifyJsonAddRaw(&notifyPayload, "parameter", notifyJsonGet(&parameter));
 					}
 					else
 					{
-						WalError("Failed to print JSON, cJSON_PrintUnformatted returned NULL\n");
+						WalError("Failed to write parameter JSON\n");
 					}
-					cJSON_AddItemToObject(notifyPayload, "parameter", parameter);
+					notifyJsonRelease(&parameter);
 
 					if(write_sync_notify_into_file(param_notify_string) == 1)
 					{
@@ -1391,22 +1983,11 @@ void processNotification(NotifyData *notifyData)
 					}					
 				}
 				sync_transaction_uuid = generate_trans_uuid();
-				cJSON_AddStringToObject(notifyPayload, "sync_transaction_uuid", (sync_transaction_uuid != NULL) ? sync_transaction_uuid : "unknown");
+				notifyJsonAddString(&notifyPayload, "sync_transaction_uuid", (sync_transaction_uuid != NULL) ? sync_transaction_uuid : "unknown");
 				WAL_FREE(sync_transaction_uuid);
 
-			#if defined(_SCER11BEL_PRODUCT_REQ_)
-                               //XER10-1536: Added delay of 8s in XER10 platform to fix wifi captive portal issue where sync notifications are sent before wifi updates the parameter values in device DB
-				WalInfo("Sleeping for 8 sec before sending SYNC_NOTIFICATION\n");
-				sleep(8);
-			#else
-				//Added delay of 5s to fix wifi captive portal issue where sync notifications are sent before wifi updates the parameter values in device DB
-				WalInfo("Sleeping for 5 sec before sending SYNC_NOTIFICATION\n");
-				sleep(5);
-			#endif
-				//Signaling sync notification retry to reset the timer whenever any new notifications are received
-				pthread_mutex_lock (&sync_mutex);
-				pthread_cond_signal(&sync_condition);
-				pthread_mutex_unlock(&sync_mutex);
+				//Reset the sync notification retry timer whenever any new notifications are received
+				resetSyncNotifyRetry();
 	        	}
 	        		break;
 
@@ -1421,16 +2002,16 @@ void processNotification(NotifyData *notifyData)
 	        		if (ret != WDMP_SUCCESS)
 	        		{
 	        			free(dest);
-                                        cJSON_Delete(notifyPayload);
+                                        notifyJsonRelease(&notifyPayload);
                                         freeNotifyMessage(notifyData);
 	        			return;
 	        		}
 	        		WalPrint("Framing notifyPayload for Factory reset\n");
-	        		cJSON_AddNumberToObject(notifyPayload, "cmc", cmc);
-	        		cJSON_AddStringToObject(notifyPayload, "cid", cid);
-				cJSON_AddStringToObject(notifyPayload, "reboot_reason", (NULL != reboot_reason) ? reboot_reason : "NULL");
+	        		notifyJsonAddNumber(&notifyPayload, "cmc", cmc);
+	        		notifyJsonAddString(&notifyPayload, "cid", cid);
+				notifyJsonAddString(&notifyPayload, "reboot_reason", (NULL != reboot_reason) ? reboot_reason : "NULL");
 				sync_transaction_uuid = generate_trans_uuid();
-				cJSON_AddStringToObject(notifyPayload, "sync_transaction_uuid", (sync_transaction_uuid != NULL) ? sync_transaction_uuid : "unknown");
+				notifyJsonAddString(&notifyPayload, "sync_transaction_uuid", (sync_transaction_uuid != NULL) ? sync_transaction_uuid : "unknown");
 				WAL_FREE(cid);
 				WAL_FREE(reboot_reason);
 				WAL_FREE(sync_transaction_uuid);
@@ -1448,13 +2029,13 @@ void processNotification(NotifyData *notifyData)
 	        			if (ret != WDMP_SUCCESS)
 	        			{
 	        				free(dest);
-                                                cJSON_Delete(notifyPayload);
+                                                notifyJsonRelease(&notifyPayload);
                                                 freeNotifyMessage(notifyData);
 	        				return;
 	        			}
 	        			WalPrint("Framing notifyPayload for Firmware upgrade\n");
-	        			cJSON_AddNumberToObject(notifyPayload, "cmc", cmc);
-	        			cJSON_AddStringToObject(notifyPayload, "cid", cid);
+	        			notifyJsonAddNumber(&notifyPayload, "cmc", cmc);
+	        			notifyJsonAddString(&notifyPayload, "cid", cid);
 					OnboardLog("FIRMWARE_UPGRADE/%d/%s\n",cmc,cid);
                                         WAL_FREE(cid);
 	        		}
@@ -1466,24 +2047,25 @@ void processNotification(NotifyData *notifyData)
 	        		processConnectedClientNotification(notifyData->u.node, device_id,
 	        				&version, &nodeMacId, &timeStamp, &dest);
 
-	        		cJSON_AddStringToObject(notifyPayload, "timestamp",
+	        		notifyJsonAddString(&notifyPayload, "timestamp",
 	        				(NULL != timeStamp) ? timeStamp : "unknown");
-	        		cJSON_AddItemToObject(notifyPayload, "nodes", nodes =
-	        				cJSON_CreateArray());
-	        		cJSON_AddItemToArray(nodes, one_node = cJSON_CreateObject());
-	        		cJSON_AddStringToObject(one_node, "name", WEBPA_PARAM_HOSTS_NAME);
-	        		cJSON_AddNumberToObject(one_node, "version",
+	        		notifyJsonBeginArray(&notifyPayload, "nodes");
+	        		notifyJsonBeginObject(&notifyPayload, NULL);
+	        		notifyJsonAddString(&notifyPayload, "name", WEBPA_PARAM_HOSTS_NAME);
+	        		notifyJsonAddNumber(&notifyPayload, "version",
 	        				(NULL != version) ? atoi(version) : 0);
-	        		cJSON_AddStringToObject(one_node, "node-mac",
+	        		notifyJsonAddString(&notifyPayload, "node-mac",
 	        				(NULL != nodeMacId) ? nodeMacId : "unknown");
-	        		cJSON_AddStringToObject(one_node, "interface",
+	        		notifyJsonAddString(&notifyPayload, "interface",
 	        				(NULL != notifyData->u.node->interface) ? notifyData->u.node->interface : "unknown");
-	        		cJSON_AddStringToObject(one_node, "hostname",
+	        		notifyJsonAddString(&notifyPayload, "hostname",
 	        				(NULL != notifyData->u.node->hostname) ? notifyData->u.node->hostname : "unknown");
-	        		cJSON_AddStringToObject(one_node, "status",
+	        		notifyJsonAddString(&notifyPayload, "status",
 	        				(NULL != notifyData->u.node->status) ? notifyData->u.node->status : "unknown");
-	        		cJSON_AddStringToObject(one_node, "ipv4-address",
+	        		notifyJsonAddString(&notifyPayload, "ipv4-address",
 					        (NULL != notifyData->u.node->ipv4) ? notifyData->u.node->ipv4 : "");
+	        		notifyJsonEndObject(&notifyPayload);
+	        		notifyJsonEndArray(&notifyPayload);
 	        		if (NULL != nodeMacId) {
 	        			free(nodeMacId);
 	        		}
@@ -1501,16 +2083,16 @@ void processNotification(NotifyData *notifyData)
 	        	{
 	        		strcpy(dest, "event:transaction-status");
 
-	        		cJSON_AddStringToObject(notifyPayload, "state", "complete");
+	        		notifyJsonAddString(&notifyPayload, "state", "complete");
 	        		if (notifyData->u.status != NULL)
 	        		{
-	        			cJSON_AddStringToObject(notifyPayload, WRP_TRANSACTION_ID,
+	        			notifyJsonAddString(&notifyPayload, WRP_TRANSACTION_ID,
 	        					(NULL != notifyData->u.status->transId)? notifyData->u.status->transId : "unknown");
 	        		}
 	        		else
 	        		{
 	        			free(dest);
-                                        cJSON_Delete(notifyPayload);
+                                        notifyJsonRelease(&notifyPayload);
                                         freeNotifyMessage(notifyData);
 	        			return;
 	        		}
@@ -1527,17 +2109,17 @@ void processNotification(NotifyData *notifyData)
 				        mapComponentStatusToGetReason(notifyData->u.device->status, reason);
 				                        OnboardLog("%s\n",reason);
                                         snprintf(dest, WEBPA_NOTIFY_EVENT_MAX_LENGTH, "event:device-status/%s/non-operational/%s/%s", device_id,(NULL != strBootTime)?strBootTime:"unknown",reason);
-                                        cJSON_AddStringToObject(notifyPayload, "status", "non-operational");
-                                        cJSON_AddStringToObject(notifyPayload, "reason", reason);
+                                        notifyJsonAddString(&notifyPayload, "status", "non-operational");
+                                        notifyJsonAddString(&notifyPayload, "reason", reason);
                                         WAL_FREE(reason);
                                 }
                                 else
                                 {
                                         snprintf(dest, WEBPA_NOTIFY_EVENT_MAX_LENGTH, "event:device-status/%s/operational/%s", device_id,(NULL != strBootTime)?strBootTime:"unknown");
-                                        cJSON_AddStringToObject(notifyPayload, "status", "operational");
+                                        notifyJsonAddString(&notifyPayload, "status", "operational");
                                 }
 				WalPrint("dest: %s\n",dest);
-				cJSON_AddStringToObject(notifyPayload,"boot-time", (NULL != strBootTime)?strBootTime:"unknown");
+				notifyJsonAddString(&notifyPayload, "boot-time", (NULL != strBootTime)?strBootTime:"unknown");
 				if (strBootTime != NULL)
 				{
 					WAL_FREE(strBootTime);
@@ -1553,12 +2135,12 @@ void processNotification(NotifyData *notifyData)
 				if (ret != WDMP_SUCCESS)
 				{
 					free(dest);
-					cJSON_Delete(notifyPayload);
+					notifyJsonRelease(&notifyPayload);
 					freeNotifyMessage(notifyData);
 					return;
 				}					
-				cJSON_AddNumberToObject(notifyPayload, "cmc", cmc);
-				cJSON_AddStringToObject(notifyPayload, "cid", cid);
+				notifyJsonAddNumber(&notifyPayload, "cmc", cmc);
+				notifyJsonAddString(&notifyPayload, "cid", cid);
 				if(cmc == 768)
 				{
 					if(strlen(param_notify_string) == 0)
@@ -1566,18 +2148,28 @@ void processNotification(NotifyData *notifyData)
 						if(read_sync_notify_from_file() == 1)
 						{
 							WalError("Error while reading param_notify_retry_string from file\n");
+							free(dest);
+							WAL_FREE(cid);
+							notifyJsonRelease(&notifyPayload);
+							freeNotifyMessage(notifyData);
 							return;
 						}
 					}
+					// backup file content is embedded as is once it is known to be valid JSON
 					cJSON *parameter = cJSON_Parse(param_notify_string);
 					if (parameter == NULL) {
 						WalError("Error in parsing JSON file '%s' content\n",SYNC_NOTIFY_PARAM_BACKUP_FILE);
+						free(dest);
+						WAL_FREE(cid);
+						notifyJsonRelease(&notifyPayload);
+						freeNotifyMessage(notifyData);
 						return;
 					}
-					cJSON_AddItemToObject(notifyPayload, "parameter", parameter);
+					cJSON_Delete(parameter);
+					notifyJsonAddRaw(&notifyPayload, "parameter", param_notify_string);
 				}
 				sync_transaction_uuid = generate_trans_uuid();							
-				cJSON_AddStringToObject(notifyPayload, "sync_transaction_uuid", (sync_transaction_uuid != NULL) ? sync_transaction_uuid : "unknown");
+				notifyJsonAddString(&notifyPayload, "sync_transaction_uuid", (sync_transaction_uuid != NULL) ? sync_transaction_uuid : "unknown");
 				WAL_FREE(sync_transaction_uuid);												
 				WAL_FREE(cid);
 			}
@@ -1586,7 +2178,8 @@ void processNotification(NotifyData *notifyData)
 	        		break;
 	        }
 
-	        stringifiedNotifyPayload = cJSON_PrintUnformatted(notifyPayload);
+	        notifyJsonEndObject(&notifyPayload);
+	        stringifiedNotifyPayload = notifyJsonDetach(&notifyPayload);
 		if(notifyData->type == PARAM_NOTIFY_RETRY)
 			WalInfo("stringifiedNotifyPayload during sync notify retry is %s\n", stringifiedNotifyPayload);
 		else
@@ -1597,6 +2190,10 @@ void processNotification(NotifyData *notifyData)
 	        {
 	        	source = (char*) malloc(sizeof(char) * sizeof(device_id));
 	        	walStrncpy(source, device_id, sizeof(device_id));
+	        	if(notifyData->queueTime.tv_sec != 0 || notifyData->queueTime.tv_nsec != 0)
+	        	{
+	        		recordNotifyLatency(NOTIFY_METRIC_END_TO_END, &notifyData->queueTime);
+	        	}
 	        	sendNotification(stringifiedNotifyPayload, source, dest);
 	        	WalPrint("After sendNotification\n");
 	        }
@@ -1608,125 +2205,231 @@ void processNotification(NotifyData *notifyData)
 
 	    free(dest);
         }
-		cJSON_Delete(notifyPayload);
+		notifyJsonRelease(&notifyPayload);
+		recordNotifyProcessLatency(notifyType, &processStart);
 }
 
-static WDMP_STATUS processParamNotificationRetry(unsigned int *cmc, char **cid)
+/*
+ * @brief isSyncNotifyPending tells whether a value change event leads to a SYNC_NOTIFICATION,
+ * that is when it changes CMC or when cloud and CPE are out of sync since bootup
+ */
+static int isSyncNotifyPending(ParamNotify *paramNotify, unsigned int cmc)
+{
+	return (((cmc | paramNotify->changeSource) != cmc) || (g_checkSyncNotifyIgnore == 0)) ? 1 : 0;
+}
+
+/*
+ * @brief To wait for the parameter values to settle in device DB before a SYNC_NOTIFICATION
+ */
+static void settleParamNotification()
+{
+	struct timespec settleStart;
+
+	notifyMetricsStart(&settleStart);
+
+#if defined(_SCER11BEL_PRODUCT_REQ_)
+	//XER10-1536: Added delay of 8s in XER10 platform to fix wifi captive portal issue where sync notifications are sent before wifi updates the parameter values in device DB
+	WalInfo("Sleeping for 8 sec before sending SYNC_NOTIFICATION\n");
+	sleep(8);
+#else
+	//Added delay of 5s to fix wifi captive portal issue where sync notifications are sent before wifi updates the parameter values in device DB
+	WalInfo("Sleeping for 5 sec before sending SYNC_NOTIFICATION\n");
+	sleep(5);
+#endif
+	recordNotifyLatency(NOTIFY_METRIC_SETTLE, &settleStart);
+}
+
+/*
+ * @brief To merge the value change events queued behind the current one, so that a burst
+ * of changes results in one CMC update and one SYNC_NOTIFICATION. Change sources are OR'ed
+ * together, parameter details are taken from the latest event changed by an unknown source
+ * (used when CMC is 768), else the latest event.
+ */
+static void coalesceParamNotifications(ParamNotify *paramNotify)
 {
-	char *dbCID = NULL, *dbCMC = NULL;
+	NotifyData *next = NULL;
+	int mergedCount = 0;
+	int detailsFromUnknown = (paramNotify->changeSource & CHANGED_BY_UNKNOWN) ? 1 : 0;
+
+	if(notifyQueue == NULL)
+	{
+		return;
+	}
 
-	dbCMC = getParameterValue(PARAM_CMC);
-	if (NULL != dbCMC)
+	// value change events have a class of their own, so they are merged even when other notifications are queued
+	while((next = (NotifyData *) notifyQueuePeek(notifyQueue->queues[NOTIFY_CLASS_PARAM])) != NULL && next->type == PARAM_NOTIFY)
 	{
-	        dbCID = getParameterValue(PARAM_CID);
-	        if (NULL == dbCID)
+		notifyQueuePop(notifyQueue->queues[NOTIFY_CLASS_PARAM]);
+		recordNotifyLatency(NOTIFY_METRIC_QUEUE_WAIT, &next->queueTime);
+		WalInfo("Coalescing value change of %s, Change Source: %d\n", (next->u.notify->paramName != NULL) ? next->u.notify->paramName : "unknown", next->u.notify->changeSource);
+		paramNotify->changeSource |= next->u.notify->changeSource;
+		if((next->u.notify->changeSource & CHANGED_BY_UNKNOWN) || !detailsFromUnknown)
 		{
-			WAL_FREE(dbCMC);
-			WalError("Error dbCID is NULL!\n");
-			return WDMP_FAILURE;
+			const char *paramName = paramNotify->paramName;
+			const char *oldValue = paramNotify->oldValue;
+			const char *newValue = paramNotify->newValue;
+
+			paramNotify->paramName = next->u.notify->paramName;
+			paramNotify->oldValue = next->u.notify->oldValue;
+			paramNotify->newValue = next->u.notify->newValue;
+			paramNotify->type = next->u.notify->type;
+			next->u.notify->paramName = paramName;
+			next->u.notify->oldValue = oldValue;
+			next->u.notify->newValue = newValue;
+			detailsFromUnknown = (next->u.notify->changeSource & CHANGED_BY_UNKNOWN) ? 1 : 0;
 		}
+		freeNotifyMessage(next);
+		mergedCount++;
 	}
-	else
+
+	if(mergedCount > 0)
 	{
-	        WalError("Error dbCMC is NULL!\n");
-	        return WDMP_FAILURE;
+		WalInfo("Coalesced %d value change events into one SYNC_NOTIFICATION, Change Source: %d\n", mergedCount + 1, paramNotify->changeSource);
 	}
-	(*cmc) = atoi(dbCMC);
-	(*cid) = dbCID;
-	WAL_FREE(dbCMC);
-	return WDMP_SUCCESS;
+}
+
+static WDMP_STATUS processParamNotificationRetry(unsigned int *cmc, char **cid)
+{
+	return getCmcCidValues(cmc, cid);
 }
 
 /*
  * @brief To process notification during value change
  */
 static WDMP_STATUS processParamNotification(ParamNotify *paramNotify,
-		unsigned int *cmc, char **cid)
+		unsigned int oldCMC, unsigned int *cmc, char **cid)
 {
-	char *strCMC = NULL, *strCID = NULL;
-	char strNewCMC[20] = { '\0' };
-	unsigned int oldCMC, newCMC;
+	char *strCID = NULL;
+	unsigned int newCMC;
 	WDMP_STATUS status = WDMP_FAILURE;
 
-	strCMC = getParameterValue(PARAM_CMC);
-	if (strCMC != NULL)
-	{
-		oldCMC = atoi(strCMC);
-		newCMC = oldCMC | paramNotify->changeSource;
-		WalInfo("Notification received from stack Old CMC: %s (%d), newCMC: %d\n",
-				strCMC, oldCMC, newCMC);
+	newCMC = oldCMC | paramNotify->changeSource;
+	WalInfo("Notification received from stack Old CMC: %d, newCMC: %d\n",
+			oldCMC, newCMC);
 
-		WAL_FREE(strCMC);
-		if ((newCMC != oldCMC) || (g_checkSyncNotifyIgnore == 0))
+	if ((newCMC != oldCMC) || (g_checkSyncNotifyIgnore == 0))
+	{
+		if((g_checkSyncNotifyIgnore == 0) && (newCMC == oldCMC))
 		{
-			if((g_checkSyncNotifyIgnore == 0) && (newCMC == oldCMC))
-			{
-				WalInfo("No change in CMC value, but cloud and CPE are out sync during bootup, so sending sync notification\n");
-			}			
-			WalPrint("NewCMC and OldCMC not equal.\n");
-			sprintf(strNewCMC, "%d", newCMC);
-			status = setParameterValue(PARAM_CMC, strNewCMC, WDMP_UINT);
+			WalInfo("No change in CMC value, but cloud and CPE are out sync during bootup, so sending sync notification\n");
+		}			
+		WalPrint("NewCMC and OldCMC not equal.\n");
+		status = setCmcValue(newCMC);
 
-			if (status == WDMP_SUCCESS)
+		if (status == WDMP_SUCCESS)
+		{
+			WalPrint("Successfully set newCMC value %d\n", newCMC);
+			if (getCidValue(&strCID) == WDMP_SUCCESS)
 			{
-				WalPrint("Successfully set newCMC value %s\n", strNewCMC);
-				strCID = getParameterValue(PARAM_CID);
-				if (strCID != NULL)
-				{
-					WalPrint("ConfigID string is : %s\n", strCID);
-					(*cid) = strCID;
-					(*cmc) = newCMC;
+				WalPrint("ConfigID string is : %s\n", strCID);
+				(*cid) = strCID;
+				(*cmc) = newCMC;
 
-					return WDMP_SUCCESS;
-				}
-				else
-				{
-					WalError("Failed to Get CID value\n");
-				}
+				return WDMP_SUCCESS;
 			}
 			else
 			{
-				WalError("Error in setting new CMC value\n");
+				WalError("Failed to Get CID value\n");
+				status = WDMP_FAILURE;
 			}
 		}
 		else
 		{
-			WalInfo("No change in CMC value, ignoring value change event\n");
+			WalError("Error in setting new CMC value\n");
 		}
 	}
 	else
 	{
-		WalError("Failed to Get CMC Value, hence ignoring the notification\n");
+		WalInfo("No change in CMC value, ignoring value change event\n");
 	}
 	return status;
 }
 
 static WDMP_STATUS getCmcCidValues(unsigned int *cmc, char **cid)
 {
-	char *dbCID = NULL, *dbCMC = NULL;
-
-	dbCMC = getParameterValue(PARAM_CMC);
-	if (NULL != dbCMC) 
-	{
-	        dbCID = getParameterValue(PARAM_CID);
-	        if (NULL == dbCID) 
-		{
-			WAL_FREE(dbCMC);
-			WalError("Error dbCID is NULL!\n");
-			return WDMP_FAILURE;
-		}
-	} 
-	else 
+	if (getCmcValue(cmc) != WDMP_SUCCESS)
 	{
 	        WalError("Error dbCMC is NULL!\n");
 	        return WDMP_FAILURE;
 	}
-	(*cmc) = atoi(dbCMC);
-	(*cid) = dbCID;
-	WAL_FREE(dbCMC);
+	if (getCidValue(cid) != WDMP_SUCCESS)
+	{
+		WalError("Error dbCID is NULL!\n");
+		return WDMP_FAILURE;
+	}
 	return WDMP_SUCCESS;	
 }
 
+/*
+ * @brief getCmcValue reads CMC from the in-memory sync state. Before the data
+ * model has initialized it, the value is read through a parameter GET.
+ */
+static WDMP_STATUS getCmcValue(unsigned int *cmc)
+{
+	char *strCMC = NULL;
+	struct timespec start;
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	notifyMetricsStart(&start);
+	if (isSyncStateInitialized())
+	{
+		status = getSyncStateCMC(cmc);
+	}
+	else if ((strCMC = getParameterValue(PARAM_CMC)) != NULL)
+	{
+		(*cmc) = atoi(strCMC);
+		WAL_FREE(strCMC);
+		status = WDMP_SUCCESS;
+	}
+	recordNotifyLatency(NOTIFY_METRIC_CMC_GET, &start);
+	return status;
+}
+
+/*
+ * @brief getCidValue returns a copy of CID from the in-memory sync state, caller frees it
+ */
+static WDMP_STATUS getCidValue(char **cid)
+{
+	if (isSyncStateInitialized())
+	{
+		return getSyncStateCID(cid);
+	}
+	(*cid) = getParameterValue(PARAM_CID);
+	return ((*cid) != NULL) ? WDMP_SUCCESS : WDMP_FAILURE;
+}
+
+/*
+ * @brief setCmcValue updates CMC in memory, the sync state writes it to DB in the background
+ */
+static WDMP_STATUS setCmcValue(unsigned int cmc)
+{
+	char strCMC[32] = {'\0'};
+	struct timespec start;
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	notifyMetricsStart(&start);
+	if (isSyncStateInitialized())
+	{
+		status = updateSyncStateCMC(cmc);
+	}
+	else
+	{
+		snprintf(strCMC, sizeof(strCMC), "%d", cmc);
+		status = setParameterValue(PARAM_CMC, strCMC, WDMP_UINT);
+	}
+	recordNotifyLatency(NOTIFY_METRIC_CMC_SET, &start);
+	return status;
+}
+
+static WDMP_STATUS setCidValue(const char *cid)
+{
+	if (isSyncStateInitialized())
+	{
+		return updateSyncStateCID(cid);
+	}
+	return setParameterValue(PARAM_CID, (char *)cid, WDMP_STRING);
+}
+
 /*
  * @brief To process notification during device status
  */
@@ -1749,16 +2452,14 @@ void processDeviceStatusNotification(int status)
 static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, unsigned int *cmc, char **cid, char **reason)
 {
 	char *dbCID = NULL;
-	char strnewCMC[32]={'\0'};
 	char *reboot_reason = NULL;
-	char *strCMC = NULL;
-	unsigned int oldCMC,newCMC;
-	WDMP_STATUS status = WDMP_FAILURE;
+	unsigned int oldCMC = 0, newCMC;
+	WDMP_STATUS status = WDMP_FAILURE, cmcStatus = WDMP_FAILURE;
 
 	WalPrint("Inside processFactoryResetNotification ..\n");
-	dbCID = getParameterValue(PARAM_CID);
+	getCidValue(&dbCID);
 	WalPrint("dbCID value is %s\n", dbCID);
-	strCMC = getParameterValue(PARAM_CMC);
+	cmcStatus = getCmcValue(&oldCMC);
 	
 	reboot_reason = getParameterValue(PARAM_REBOOT_REASON);
 	WalInfo("Received reboot_reason as:%s\n", reboot_reason ? reboot_reason : "reboot_reason is NULL");
@@ -1767,20 +2468,17 @@ static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, uns
 	if( (NULL != reboot_reason) && (strcmp(reboot_reason,"factory-reset")==0) )
 	{
 		WalInfo("Send factory reset notification to server, reboot reason is %s\n", reboot_reason);
-		if (strCMC != NULL)
+		if (cmcStatus == WDMP_SUCCESS)
 		{
-			oldCMC = atoi(strCMC);
 			if(oldCMC != CHANGED_BY_XPC)
 			{
 				newCMC = oldCMC | CHANGED_BY_FACTORY_DEFAULT;
 				WalInfo("oldCMC is %d and newCMC value is %d\n", oldCMC,newCMC);
-				WAL_FREE(strCMC);
 				if (newCMC != oldCMC)
 				{
 					WalPrint("NewCMC and OldCMC are not equal.\n");
 					// set CMC to the new value
-					snprintf(strnewCMC, sizeof(strnewCMC), "%d", newCMC);
-					status = setParameterValue(PARAM_CMC,strnewCMC, WDMP_UINT);
+					status = setCmcValue(newCMC);
 					if(status == WDMP_SUCCESS)
 					{
 						WalInfo("Successfully Set CMC to %d\n", newCMC);
@@ -1810,7 +2508,6 @@ static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, uns
 			else
 			{
 				WalInfo("CMC is %d, hence ignoring the Factory reset notification\n",CHANGED_BY_XPC);
-				WAL_FREE(strCMC);
 			}
 		}
 		else
@@ -1820,17 +2517,16 @@ static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, uns
 	}
 	// Set CMC, CID to 512, 61f4db9 when they are reset to 0 without factory-reset i.e. PSM DB corruption or reset
 	// Returning status failure as its false FR case 
-	else if( ((NULL != dbCID) && (strcmp(dbCID, "0") ==0)) && ((NULL != strCMC) && (strcmp(strCMC, "0") ==0)) )
+	else if( ((NULL != dbCID) && (strcmp(dbCID, "0") ==0)) && ((cmcStatus == WDMP_SUCCESS) && (oldCMC == 0)) )
 	{
-		snprintf(strnewCMC, sizeof(strnewCMC), "%d", CHANGED_BY_XPC);
-		status = setParameterValue(PARAM_CMC,strnewCMC, WDMP_UINT);
+		status = setCmcValue(CHANGED_BY_XPC);
 		if(status == WDMP_SUCCESS)
-			WalInfo("Successfully reset CMC to %s to avoid false FR notification\n", strnewCMC);
+			WalInfo("Successfully reset CMC to %d to avoid false FR notification\n", CHANGED_BY_XPC);
 		else
 			WalError("Error status %d while re-setting CMC value to avoid false FR notification\n", status);
 
 
-		status = setParameterValue(PARAM_CID,XPC_CID, WDMP_STRING);
+		status = setCidValue(XPC_CID);
                 if(status == WDMP_SUCCESS)
                         WalInfo("Successfully reset CID to %s to avoid false FR notification\n", XPC_CID);
 		else    
@@ -1841,10 +2537,6 @@ static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, uns
 
 	}
 
-	if (NULL != strCMC) {
-		WAL_FREE(strCMC);
-	}
-
 	if (NULL != dbCID) {
 		WAL_FREE(dbCID);
 	}
@@ -1862,36 +2554,27 @@ static WDMP_STATUS processFactoryResetNotification(ParamNotify *paramNotify, uns
  */
 static WDMP_STATUS processFirmwareUpgradeNotification(ParamNotify *paramNotify, unsigned int *cmc, char **cid)
 {
-	char *dbCID = NULL, *dbCMC = NULL;
-	char newCMC[32]={'\0'};
+	char *dbCID = NULL;
+	unsigned int dbCMC = 0, newCMC = 0;
 	WDMP_STATUS status = WDMP_FAILURE;
 
 	WalPrint("processFirmwareUpgradeNotification........\n");
 
-        dbCMC = getParameterValue(PARAM_CMC);
-        if (NULL != dbCMC) {
-                dbCID = getParameterValue(PARAM_CID);
-                if (NULL == dbCID) {
-                WAL_FREE(dbCMC);
-                WalError("Error dbCID is NULL!\n");
-                return status;
-                }
-        } else {
-                WalError("Error dbCMC is NULL!\n");
-                return status;
-        }
-
+	if (getCmcCidValues(&dbCMC, &dbCID) != WDMP_SUCCESS)
+	{
+		return status;
+	}
 
-	snprintf(newCMC, sizeof(newCMC), "%d", (atoi(dbCMC) | CHANGED_BY_FIRMWARE_UPGRADE));
-	WalPrint("newCMC value after firmware upgrade: %s\n", newCMC);
+	newCMC = dbCMC | CHANGED_BY_FIRMWARE_UPGRADE;
+	WalPrint("newCMC value after firmware upgrade: %d\n", newCMC);
 
-	if(atoi(dbCMC) != atoi(newCMC))
+	if(dbCMC != newCMC)
 	{
-		status = setParameterValue(PARAM_CMC, newCMC,WDMP_UINT);
+		status = setCmcValue(newCMC);
 		if(status == WDMP_SUCCESS)
 		{
-			WalInfo("Successfully Set CMC to %d\n", atoi(newCMC));
-			(*cmc) = atoi(newCMC);
+			WalInfo("Successfully Set CMC to %d\n", newCMC);
+			(*cmc) = newCMC;
 			(*cid) = dbCID;
 		}
 		else
@@ -1903,11 +2586,10 @@ static WDMP_STATUS processFirmwareUpgradeNotification(ParamNotify *paramNotify,
 	}
 	else
 	{
-		WalInfo("newCMC %s is same as dbCMC %s, hence firmware upgrade notification was not sent\n",newCMC,dbCMC);
+		WalInfo("newCMC %d is same as dbCMC %d, hence firmware upgrade notification was not sent\n",newCMC,dbCMC);
 		WAL_FREE(dbCID);
 	}
 
-	WAL_FREE(dbCMC);
 	WalPrint("Returned from processFirmwareUpgradeNotification with status %d\n", status);
 	return status;
 
@@ -1959,23 +2641,20 @@ static void processConnectedClientNotification(NodeData *connectedNotify, char *
 
 	WalPrint("(*destination) : %s\n",(*destination));
 
-	*version = getParameterValue(PARAM_HOSTS_VERSION);
+	*version = getCachedNotifyValue(&hostsVersionCache);
 	WalPrint("*version : %s\n",*version);
 
-	*timeStamp = getParameterValue(PARAM_SYSTEM_TIME);
-	if(*timeStamp == NULL)
+	// stamped locally, a cached value would give every event of a burst the same time
+	clock_gettime(CLOCK_REALTIME, &sysTime);
+	if( sysTime.tv_nsec > 999999999L)
 	{
-		clock_gettime(CLOCK_REALTIME, &sysTime);
-		if( sysTime.tv_nsec > 999999999L)
-		{
-			sysTime.tv_nsec = sysTime.tv_nsec - 1000000000L;
-		}
-
-		sprintf(sbuf, "%ld.%09ld", sysTime.tv_sec, sysTime.tv_nsec);
-		*timeStamp = (char *) malloc (sizeof(char) * 64);
-		strcpy(*timeStamp, sbuf);
-		WalPrint("*timeStamp : %s\n",*timeStamp);
+		sysTime.tv_nsec = sysTime.tv_nsec - 1000000000L;
 	}
+
+	sprintf(sbuf, "%ld.%09ld", sysTime.tv_sec, sysTime.tv_nsec);
+	*timeStamp = (char *) malloc (sizeof(char) * 64);
+	strcpy(*timeStamp, sbuf);
+	WalPrint("*timeStamp : %s\n",*timeStamp);
 	WAL_FREE(nodeData);
 	WalPrint("End of processConnectedClientNotification\n");
 
@@ -2022,33 +2701,8 @@ static void freeNotifyMessage(NotifyData *notifyData)
 	}
 	else if(notifyData->type == CONNECTED_CLIENT_NOTIFY)
 	{
-		if(notifyData->u.node->nodeMacId != NULL)
-		{
-			WAL_FREE(notifyData->u.node->nodeMacId);
-			WalPrint("Free notifyData->u.node->nodeMacId\n");
-		}
-		if(notifyData->u.node->status != NULL)
-		{
-			WAL_FREE(notifyData->u.node->status);
-			WalPrint("Free notifyData->u.node->status\n");
-		}
-		if(notifyData->u.node->interface != NULL)
-		{
-			WAL_FREE(notifyData->u.node->interface);
-			WalPrint("Free notifyData->u.node->interface\n");
-		}
-		if(notifyData->u.node->hostname != NULL)
-		{
-			WAL_FREE(notifyData->u.node->hostname);
-			WalPrint("Free notifyData->u.node->hostname\n");
-		}
-		if(notifyData->u.node->ipv4 != NULL)
-		{
-			WAL_FREE(notifyData->u.node->ipv4);
-			WalPrint("Free notifyData->u.node->ipv4\n");
-		}
-		WalPrint("Free notifyData->u.node\n");
-		WAL_FREE(notifyData->u.node);
+		freeNodeData(notifyData->u.node);
+		notifyData->u.node = NULL;
 	}
 	else if(notifyData->type == DEVICE_STATUS)
 	{
@@ -2087,6 +2741,107 @@ static void freeNotifyMessage(NotifyData *notifyData)
 	WalPrint("free done from freeNotifyMessage\n");
 }
 
+/*
+ * @brief To free connected client node data
+ */
+static void freeNodeData(void *data)
+{
+	NodeData *node = (NodeData *) data;
+
+	if(node == NULL)
+	{
+		return;
+	}
+	if(node->nodeMacId != NULL)
+	{
+		WAL_FREE(node->nodeMacId);
+		WalPrint("Free node->nodeMacId\n");
+	}
+	if(node->status != NULL)
+	{
+		WAL_FREE(node->status);
+		WalPrint("Free node->status\n");
+	}
+	if(node->interface != NULL)
+	{
+		WAL_FREE(node->interface);
+		WalPrint("Free node->interface\n");
+	}
+	if(node->hostname != NULL)
+	{
+		WAL_FREE(node->hostname);
+		WalPrint("Free node->hostname\n");
+	}
+	if(node->ipv4 != NULL)
+	{
+		WAL_FREE(node->ipv4);
+		WalPrint("Free node->ipv4\n");
+	}
+	WalPrint("Free node\n");
+	WAL_FREE(node);
+}
+
+/*
+ * @brief emitClientNotification queues the connected client notification of a node
+ */
+static void emitClientNotification(void *node)
+{
+	NotifyData *notifyDataPtr = (NotifyData *) malloc(sizeof(NotifyData) * 1);
+
+	if(notifyDataPtr == NULL)
+	{
+		freeNodeData(node);
+		return;
+	}
+	memset(notifyDataPtr, 0, sizeof(NotifyData));
+	notifyDataPtr->type = CONNECTED_CLIENT_NOTIFY;
+	notifyDataPtr->u.node = (NodeData *) node;
+	(*notifyCbFn)(notifyDataPtr);
+}
+
+/*
+ * @brief getNodeSignature hashes the reported state of a client (FNV-1a), two changes
+ * with the same signature would produce the same notification
+ */
+static unsigned int getNodeSignature(NodeData *node)
+{
+	const char *fields[4] = {node->status, node->interface, node->hostname, node->ipv4};
+	unsigned int hash = 2166136261U;
+	const char *c = NULL;
+	int i = 0;
+
+	for(i = 0; i < 4; i++)
+	{
+		for(c = (fields[i] != NULL) ? fields[i] : ""; *c != '\0'; c++)
+		{
+			hash = (hash ^ (unsigned char) *c) * 16777619U;
+		}
+		hash = (hash ^ '|') * 16777619U;
+	}
+	return hash;
+}
+
+/*
+ * @brief getCachedNotifyValue returns a copy of a parameter value read at most
+ * WEBPA_CLIENT_NOTIFY_GET_CACHE_SEC ago. Only called from the notification thread.
+ */
+static char * getCachedNotifyValue(CachedNotifyValue *cache)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if(cache->value == NULL || now.tv_sec - cache->fetchTime >= WEBPA_CLIENT_NOTIFY_GET_CACHE_SEC)
+	{
+		if(cache->value != NULL)
+		{
+			WAL_FREE(cache->value);
+		}
+		cache->value = getParameterValue(cache->paramName);
+		cache->fetchTime = now.tv_sec;
+	}
+	return (cache->value != NULL) ? strdup(cache->value) : NULL;
+}
+
 static void mapComponentStatusToGetReason(COMPONENT_STATUS status, char *reason)
 {
         if (status == SUCCESS)
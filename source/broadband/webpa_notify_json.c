@@ -0,0 +1,241 @@
+/**
+ * @file webpa_notify_json.c
+ *
+ * @description This file describes the JSON writer used to build outbound
+ * notification payloads without building a cJSON tree
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "webpa_notify_json.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static int reserve(NotifyJsonWriter *writer, size_t extra);
+static void appendBytes(NotifyJsonWriter *writer, const char *data, size_t len);
+static void appendString(NotifyJsonWriter *writer, const char *value);
+static void beginValue(NotifyJsonWriter *writer, const char *key);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void notifyJsonInit(NotifyJsonWriter *writer, char *buf, size_t size)
+{
+	memset(writer, 0, sizeof(NotifyJsonWriter));
+	writer->buf = buf;
+	writer->size = size;
+	if(buf == NULL || size == 0)
+	{
+		writer->failed = 1;
+		return;
+	}
+	writer->buf[0] = '\0';
+}
+
+void notifyJsonRelease(NotifyJsonWriter *writer)
+{
+	if(writer->onHeap && writer->buf != NULL)
+	{
+		WAL_FREE(writer->buf);
+	}
+	writer->buf = NULL;
+	writer->onHeap = 0;
+	writer->len = 0;
+	writer->size = 0;
+}
+
+void notifyJsonBeginObject(NotifyJsonWriter *writer, const char *key)
+{
+	beginValue(writer, key);
+	appendBytes(writer, "{", 1);
+	writer->needComma = 0;
+}
+
+void notifyJsonEndObject(NotifyJsonWriter *writer)
+{
+	appendBytes(writer, "}", 1);
+	writer->needComma = 1;
+}
+
+void notifyJsonBeginArray(NotifyJsonWriter *writer, const char *key)
+{
+	beginValue(writer, key);
+	appendBytes(writer, "[", 1);
+	writer->needComma = 0;
+}
+
+void notifyJsonEndArray(NotifyJsonWriter *writer)
+{
+	appendBytes(writer, "]", 1);
+	writer->needComma = 1;
+}
+
+void notifyJsonAddString(NotifyJsonWriter *writer, const char *key, const char *value)
+{
+	if(value == NULL)
+	{
+		return;
+	}
+	beginValue(writer, key);
+	appendString(writer, value);
+	writer->needComma = 1;
+}
+
+void notifyJsonAddNumber(NotifyJsonWriter *writer, const char *key, long value)
+{
+	char number[24];
+	int len = 0;
+
+	len = snprintf(number, sizeof(number), "%ld", value);
+	beginValue(writer, key);
+	appendBytes(writer, number, (size_t) len);
+	writer->needComma = 1;
+}
+
+void notifyJsonAddRaw(NotifyJsonWriter *writer, const char *key, const char *json)
+{
+	if(json == NULL)
+	{
+		return;
+	}
+	beginValue(writer, key);
+	appendBytes(writer, json, strlen(json));
+	writer->needComma = 1;
+}
+
+const char * notifyJsonGet(NotifyJsonWriter *writer)
+{
+	return writer->failed ? NULL : writer->buf;
+}
+
+char * notifyJsonDetach(NotifyJsonWriter *writer)
+{
+	char *json = NULL;
+
+	if(!writer->failed)
+	{
+		json = (char *) malloc(writer->len + 1);
+		if(json != NULL)
+		{
+			memcpy(json, writer->buf, writer->len + 1);
+		}
+	}
+	notifyJsonRelease(writer);
+	return json;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief reserve makes room for extra bytes plus the terminator, moving the
+ * output to the heap when the caller buffer is too small
+ */
+static int reserve(NotifyJsonWriter *writer, size_t extra)
+{
+	size_t newSize = 0;
+	char *newBuf = NULL;
+
+	if(writer->failed)
+	{
+		return -1;
+	}
+	if(writer->len + extra + 1 <= writer->size)
+	{
+		return 0;
+	}
+	newSize = writer->size * 2;
+	while(newSize < writer->len + extra + 1)
+	{
+		newSize *= 2;
+	}
+	if(writer->onHeap)
+	{
+		newBuf = (char *) realloc(writer->buf, newSize);
+	}
+	else
+	{
+		newBuf = (char *) malloc(newSize);
+		if(newBuf != NULL)
+		{
+			memcpy(newBuf, writer->buf, writer->len + 1);
+		}
+	}
+	if(newBuf == NULL)
+	{
+		WalError("Failed to grow notification payload buffer to %zu bytes\n", newSize);
+		writer->failed = 1;
+		return -1;
+	}
+	writer->buf = newBuf;
+	writer->size = newSize;
+	writer->onHeap = 1;
+	return 0;
+}
+
+static void appendBytes(NotifyJsonWriter *writer, const char *data, size_t len)
+{
+	if(reserve(writer, len) != 0)
+	{
+		return;
+	}
+	memcpy(writer->buf + writer->len, data, len);
+	writer->len += len;
+	writer->buf[writer->len] = '\0';
+}
+
+/*
+ * @brief appendString writes a quoted string escaped the way cJSON prints it
+ */
+static void appendString(NotifyJsonWriter *writer, const char *value)
+{
+	const unsigned char *c = NULL;
+	const char *start = value;
+	char escaped[8];
+
+	appendBytes(writer, "\"", 1);
+	for(c = (const unsigned char *) value; *c != '\0'; c++)
+	{
+		if(*c >= 32 && *c != '"' && *c != '\\')
+		{
+			continue;
+		}
+		// copy the plain run before this character in one go
+		appendBytes(writer, start, (const char *) c - start);
+		switch(*c)
+		{
+			case '"': appendBytes(writer, "\\\"", 2); break;
+			case '\\': appendBytes(writer, "\\\\", 2); break;
+			case '\b': appendBytes(writer, "\\b", 2); break;
+			case '\f': appendBytes(writer, "\\f", 2); break;
+			case '\n': appendBytes(writer, "\\n", 2); break;
+			case '\r': appendBytes(writer, "\\r", 2); break;
+			case '\t': appendBytes(writer, "\\t", 2); break;
+			default:
+				snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+				appendBytes(writer, escaped, 6);
+				break;
+		}
+		start = (const char *) c + 1;
+	}
+	appendBytes(writer, start, (const char *) c - start);
+	appendBytes(writer, "\"", 1);
+}
+
+static void beginValue(NotifyJsonWriter *writer, const char *key)
+{
+	if(writer->needComma)
+	{
+		appendBytes(writer, ",", 1);
+	}
+	if(key != NULL)
+	{
+		appendString(writer, key);
+		appendBytes(writer, ":", 1);
+	}
+}
@@ -0,0 +1,213 @@
+/**
+ * @file webpa_notify_metrics.c
+ *
+ * @description This file describes the latency histograms of the notification
+ * pipeline, from the value change callback to the send to parodus
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "webpa_notify_metrics.h"
+#include "webpa_timer.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static const unsigned long latencyBoundsMs[WEBPA_NOTIFY_LATENCY_BUCKETS - 1] = WEBPA_NOTIFY_LATENCY_BOUNDS_MS;
+static const char *metricNames[NOTIFY_METRIC_COUNT] = {"QueueWait", "CMCGet", "CMCSet", "Settle", "Send", "EndToEnd"};
+static NotifyLatencyStats metricStats[NOTIFY_METRIC_COUNT];
+static NotifyLatencyStats processStats[WEBPA_NOTIFY_METRICS_MAX_TYPES];
+static pthread_mutex_t metricsMutex = PTHREAD_MUTEX_INITIALIZER;
+static int metricsTaskStarted = 0;
+static unsigned int metricsIntervalSec = 0;
+static notifyMetricsLogCB metricsLogExtra = NULL;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static void notifyMetricsTimerCB(void *arg);
+static void addSample(NotifyLatencyStats *stats, const struct timespec *start);
+static void logLatencyStats(const char *name, const NotifyLatencyStats *stats);
+static int getTypeSlot(int type);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void notifyMetricsStart(struct timespec *start)
+{
+	clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+void recordNotifyLatency(NOTIFY_METRIC metric, const struct timespec *start)
+{
+	if(metric < 0 || metric >= NOTIFY_METRIC_COUNT || start == NULL)
+	{
+		return;
+	}
+	addSample(&metricStats[metric], start);
+}
+
+void recordNotifyProcessLatency(int type, const struct timespec *start)
+{
+	if(start == NULL)
+	{
+		return;
+	}
+	addSample(&processStats[getTypeSlot(type)], start);
+}
+
+void getNotifyLatencyStats(NOTIFY_METRIC metric, NotifyLatencyStats *stats)
+{
+	memset(stats, 0, sizeof(NotifyLatencyStats));
+	if(metric < 0 || metric >= NOTIFY_METRIC_COUNT)
+	{
+		return;
+	}
+	pthread_mutex_lock(&metricsMutex);
+	*stats = metricStats[metric];
+	pthread_mutex_unlock(&metricsMutex);
+}
+
+void getNotifyProcessLatencyStats(int type, NotifyLatencyStats *stats)
+{
+	pthread_mutex_lock(&metricsMutex);
+	*stats = processStats[getTypeSlot(type)];
+	pthread_mutex_unlock(&metricsMutex);
+}
+
+int formatNotifyLatencyStats(const NotifyLatencyStats *stats, char *buf, size_t size)
+{
+	int len = 0, i = 0;
+
+	len = snprintf(buf, size, "count=%lu,avg=%lu,max=%lu", stats->count,
+			(stats->count > 0) ? stats->totalMs / stats->count : 0, stats->maxMs);
+	for(i = 0; i < WEBPA_NOTIFY_LATENCY_BUCKETS; i++)
+	{
+		char *pos = ((size_t) len < size) ? buf + len : NULL;
+		size_t left = ((size_t) len < size) ? size - len : 0;
+
+		if(i < WEBPA_NOTIFY_LATENCY_BUCKETS - 1)
+		{
+			len += snprintf(pos, left, ",le%lu=%lu", latencyBoundsMs[i], stats->buckets[i]);
+		}
+		else
+		{
+			len += snprintf(pos, left, ",inf=%lu", stats->buckets[i]);
+		}
+	}
+	return len;
+}
+
+void logNotifyMetrics()
+{
+	NotifyLatencyStats stats;
+	char name[32];
+	int i = 0;
+
+	for(i = 0; i < NOTIFY_METRIC_COUNT; i++)
+	{
+		getNotifyLatencyStats((NOTIFY_METRIC) i, &stats);
+		logLatencyStats(metricNames[i], &stats);
+	}
+	for(i = 0; i < WEBPA_NOTIFY_METRICS_MAX_TYPES; i++)
+	{
+		getNotifyProcessLatencyStats(i, &stats);
+		snprintf(name, sizeof(name), "Process.type%d", i);
+		logLatencyStats(name, &stats);
+	}
+}
+
+void startNotifyMetricsTask(unsigned int intervalSec, notifyMetricsLogCB logExtra)
+{
+	if(intervalSec == 0)
+	{
+		WalInfo("Notification metrics summary is disabled\n");
+		return;
+	}
+	pthread_mutex_lock(&metricsMutex);
+	if(metricsTaskStarted)
+	{
+		pthread_mutex_unlock(&metricsMutex);
+		return;
+	}
+	metricsTaskStarted = 1;
+	metricsIntervalSec = intervalSec;
+	metricsLogExtra = logExtra;
+	pthread_mutex_unlock(&metricsMutex);
+
+	if(scheduleWebpaTimer(intervalSec * 1000UL, 0, notifyMetricsTimerCB, NULL) == 0)
+	{
+		WalError("Failed to schedule the notification metrics summary\n");
+		return;
+	}
+	startWebpaTimerTask();
+	WalInfo("Notification metrics summary is logged every %u seconds\n", intervalSec);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static void notifyMetricsTimerCB(void *arg)
+{
+	(void) arg;
+	WalInfo("Notification pipeline summary for the last %u seconds:\n", metricsIntervalSec);
+	if(metricsLogExtra != NULL)
+	{
+		metricsLogExtra();
+	}
+	logNotifyMetrics();
+	// armed again only after logging so a slow summary never overlaps the next one
+	scheduleWebpaTimer(metricsIntervalSec * 1000UL, 0, notifyMetricsTimerCB, NULL);
+}
+
+static void addSample(NotifyLatencyStats *stats, const struct timespec *start)
+{
+	struct timespec now;
+	long elapsedMs = 0;
+	unsigned long ms = 0;
+	int i = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsedMs = (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+	ms = (elapsedMs > 0) ? (unsigned long) elapsedMs : 0;
+	while(i < WEBPA_NOTIFY_LATENCY_BUCKETS - 1 && ms > latencyBoundsMs[i])
+	{
+		i++;
+	}
+
+	pthread_mutex_lock(&metricsMutex);
+	stats->count++;
+	stats->totalMs += ms;
+	if(ms > stats->maxMs)
+	{
+		stats->maxMs = ms;
+	}
+	stats->buckets[i]++;
+	pthread_mutex_unlock(&metricsMutex);
+}
+
+static void logLatencyStats(const char *name, const NotifyLatencyStats *stats)
+{
+	char line[256];
+
+	if(stats->count == 0)
+	{
+		return;
+	}
+	formatNotifyLatencyStats(stats, line, sizeof(line));
+	WalInfo("Notification latency %s: %s\n", name, line);
+}
+
+static int getTypeSlot(int type)
+{
+	if(type < 0)
+	{
+		return 0;
+	}
+	return (type < WEBPA_NOTIFY_METRICS_MAX_TYPES) ? type : WEBPA_NOTIFY_METRICS_MAX_TYPES - 1;
+}
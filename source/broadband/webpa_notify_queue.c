@@ -0,0 +1,442 @@
+/**
+ * @file webpa_notify_queue.c
+ *
+ * @description This file describes the bounded multi-producer single-consumer
+ * notification queue
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "webpa_notify_queue.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define ATOMIC_LOAD(ptr)            __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, val)      __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define ATOMIC_INC(ptr)             __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#define ATOMIC_FENCE()              __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static unsigned int roundUpPowerOfTwo(unsigned int value);
+static int isQueueFull(NotifyQueue *queue);
+static int isQueueEmpty(NotifyQueue *queue);
+static void updateHighWatermark(NotifyQueue *queue, unsigned long pos);
+static void updateLatency(NotifyQueue *queue, struct timespec *enqueueTime);
+static int isPriorityQueueEmpty(NotifyPriorityQueue *queue);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+NotifyQueue * notifyQueueCreate(unsigned int capacity, NOTIFY_QUEUE_OVERFLOW_POLICY policy)
+{
+	NotifyQueue *queue = NULL;
+	unsigned int i = 0;
+
+	if(capacity < 2)
+	{
+		capacity = 2;
+	}
+	else if(capacity > WEBPA_NOTIFY_QUEUE_MAX_CAPACITY)
+	{
+		capacity = WEBPA_NOTIFY_QUEUE_MAX_CAPACITY;
+	}
+	capacity = roundUpPowerOfTwo(capacity);
+
+	queue = (NotifyQueue *) malloc(sizeof(NotifyQueue));
+	if(queue == NULL)
+	{
+		WalError("Failed to allocate notification queue\n");
+		return NULL;
+	}
+	memset(queue, 0, sizeof(NotifyQueue));
+
+	queue->cells = (NotifyQueueCell *) malloc(sizeof(NotifyQueueCell) * capacity);
+	if(queue->cells == NULL)
+	{
+		WalError("Failed to allocate %u notification queue slots\n", capacity);
+		WAL_FREE(queue);
+		return NULL;
+	}
+	for(i = 0; i < capacity; i++)
+	{
+		queue->cells[i].sequence = i;
+		queue->cells[i].data = NULL;
+	}
+	queue->capacity = capacity;
+	queue->mask = capacity - 1;
+	queue->policy = policy;
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->notEmpty, NULL);
+	pthread_cond_init(&queue->notFull, NULL);
+	WalInfo("Notification queue created with capacity %u, overflow policy %d\n", capacity, policy);
+	return queue;
+}
+
+void notifyQueueDestroy(NotifyQueue *queue)
+{
+	if(queue != NULL)
+	{
+		pthread_mutex_destroy(&queue->mutex);
+		pthread_cond_destroy(&queue->notEmpty);
+		pthread_cond_destroy(&queue->notFull);
+		WAL_FREE(queue->cells);
+		WAL_FREE(queue);
+	}
+}
+
+int notifyQueuePush(NotifyQueue *queue, void *data)
+{
+	NotifyQueueCell *cell = NULL;
+	unsigned long pos = 0, seq = 0;
+	long diff = 0;
+
+	pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+	for(;;)
+	{
+		cell = &queue->cells[pos & queue->mask];
+		seq = ATOMIC_LOAD(&cell->sequence);
+		diff = (long) seq - (long) pos;
+		if(diff == 0)
+		{
+			// slot is free, try to reserve it
+			if(__atomic_compare_exchange_n(&queue->enqueuePos, &pos, pos + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if(diff < 0)
+		{
+			// consumer has not released this slot yet, queue is full
+			if(queue->policy == NOTIFY_QUEUE_DROP_NEWEST)
+			{
+				ATOMIC_INC(&queue->dropCount);
+				return -1;
+			}
+			pthread_mutex_lock(&queue->mutex);
+			__atomic_add_fetch(&queue->producersWaiting, 1, __ATOMIC_SEQ_CST);
+			ATOMIC_FENCE();
+			while(isQueueFull(queue))
+			{
+				pthread_cond_wait(&queue->notFull, &queue->mutex);
+			}
+			__atomic_sub_fetch(&queue->producersWaiting, 1, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&queue->mutex);
+			pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			// another producer took this slot, reload the position
+			pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+		}
+	}
+
+	cell->data = data;
+	clock_gettime(CLOCK_MONOTONIC, &cell->enqueueTime);
+	ATOMIC_STORE(&cell->sequence, pos + 1);
+	ATOMIC_INC(&queue->enqueueCount);
+	updateHighWatermark(queue, pos);
+
+	// wake the consumer only when it is sleeping on an empty queue
+	ATOMIC_FENCE();
+	if(__atomic_load_n(&queue->consumerWaiting, __ATOMIC_SEQ_CST))
+	{
+		pthread_mutex_lock(&queue->mutex);
+		pthread_cond_signal(&queue->notEmpty);
+		pthread_mutex_unlock(&queue->mutex);
+	}
+	return 0;
+}
+
+void * notifyQueuePop(NotifyQueue *queue)
+{
+	NotifyQueueCell *cell = NULL;
+	unsigned long pos = queue->dequeuePos;
+	void *data = NULL;
+
+	cell = &queue->cells[pos & queue->mask];
+	if((long) ATOMIC_LOAD(&cell->sequence) - (long) (pos + 1) < 0)
+	{
+		return NULL;
+	}
+	data = cell->data;
+	cell->data = NULL;
+	updateLatency(queue, &cell->enqueueTime);
+	ATOMIC_STORE(&queue->dequeuePos, pos + 1);
+	ATOMIC_STORE(&cell->sequence, pos + queue->mask + 1);
+	ATOMIC_INC(&queue->dequeueCount);
+
+	ATOMIC_FENCE();
+	if(__atomic_load_n(&queue->producersWaiting, __ATOMIC_SEQ_CST) > 0)
+	{
+		pthread_mutex_lock(&queue->mutex);
+		pthread_cond_broadcast(&queue->notFull);
+		pthread_mutex_unlock(&queue->mutex);
+	}
+	return data;
+}
+
+void * notifyQueuePeek(NotifyQueue *queue)
+{
+	NotifyQueueCell *cell = &queue->cells[queue->dequeuePos & queue->mask];
+
+	if((long) ATOMIC_LOAD(&cell->sequence) - (long) (queue->dequeuePos + 1) < 0)
+	{
+		return NULL;
+	}
+	return cell->data;
+}
+
+void notifyQueueWait(NotifyQueue *queue)
+{
+	pthread_mutex_lock(&queue->mutex);
+	__atomic_store_n(&queue->consumerWaiting, 1, __ATOMIC_SEQ_CST);
+	ATOMIC_FENCE();
+	while(isQueueEmpty(queue))
+	{
+		pthread_cond_wait(&queue->notEmpty, &queue->mutex);
+	}
+	__atomic_store_n(&queue->consumerWaiting, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+void notifyQueueGetStats(NotifyQueue *queue, NotifyQueueStats *stats)
+{
+	memset(stats, 0, sizeof(NotifyQueueStats));
+	if(queue != NULL)
+	{
+		stats->capacity = queue->capacity;
+		stats->enqueueCount = ATOMIC_LOAD(&queue->enqueueCount);
+		stats->dequeueCount = ATOMIC_LOAD(&queue->dequeueCount);
+		stats->dropCount = ATOMIC_LOAD(&queue->dropCount);
+		stats->highWatermark = ATOMIC_LOAD(&queue->highWatermark);
+		stats->depth = stats->enqueueCount - stats->dequeueCount;
+		stats->latencyMaxMs = ATOMIC_LOAD(&queue->latencyMaxMs);
+		if(stats->dequeueCount > 0)
+		{
+			stats->latencyAvgMs = (unsigned long) (ATOMIC_LOAD(&queue->latencyTotalMs) / stats->dequeueCount);
+		}
+	}
+}
+
+NotifyPriorityQueue * notifyPriorityQueueCreate(unsigned int classCount, unsigned int capacity, const unsigned int *weights, NOTIFY_QUEUE_OVERFLOW_POLICY policy)
+{
+	NotifyPriorityQueue *queue = NULL;
+	unsigned int i = 0;
+
+	if(classCount == 0 || classCount > WEBPA_NOTIFY_PRIORITY_MAX_CLASSES)
+	{
+		WalError("Invalid notification priority class count %u\n", classCount);
+		return NULL;
+	}
+	queue = (NotifyPriorityQueue *) malloc(sizeof(NotifyPriorityQueue));
+	if(queue == NULL)
+	{
+		WalError("Failed to allocate notification priority queue\n");
+		return NULL;
+	}
+	memset(queue, 0, sizeof(NotifyPriorityQueue));
+	queue->classCount = classCount;
+	for(i = 0; i < classCount; i++)
+	{
+		queue->queues[i] = notifyQueueCreate(capacity, policy);
+		if(queue->queues[i] == NULL)
+		{
+			notifyPriorityQueueDestroy(queue);
+			return NULL;
+		}
+		queue->weights[i] = (weights != NULL && weights[i] > 0) ? weights[i] : 1;
+		queue->credits[i] = queue->weights[i];
+	}
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->notEmpty, NULL);
+	return queue;
+}
+
+void notifyPriorityQueueDestroy(NotifyPriorityQueue *queue)
+{
+	unsigned int i = 0;
+
+	if(queue != NULL)
+	{
+		for(i = 0; i < queue->classCount; i++)
+		{
+			if(queue->queues[i] != NULL)
+			{
+				notifyQueueDestroy(queue->queues[i]);
+			}
+		}
+		pthread_mutex_destroy(&queue->mutex);
+		pthread_cond_destroy(&queue->notEmpty);
+		WAL_FREE(queue);
+	}
+}
+
+int notifyPriorityQueuePush(NotifyPriorityQueue *queue, unsigned int priorityClass, void *data)
+{
+	if(priorityClass >= queue->classCount)
+	{
+		priorityClass = queue->classCount - 1;
+	}
+	if(notifyQueuePush(queue->queues[priorityClass], data) != 0)
+	{
+		return -1;
+	}
+
+	// the consumer sleeps on the priority queue, not on the class rings
+	ATOMIC_FENCE();
+	if(__atomic_load_n(&queue->consumerWaiting, __ATOMIC_SEQ_CST))
+	{
+		pthread_mutex_lock(&queue->mutex);
+		pthread_cond_signal(&queue->notEmpty);
+		pthread_mutex_unlock(&queue->mutex);
+	}
+	return 0;
+}
+
+void * notifyPriorityQueuePop(NotifyPriorityQueue *queue, unsigned int *priorityClass)
+{
+	void *data = NULL;
+	unsigned int i = 0;
+	int pass = 0;
+
+	// second pass starts a new round once every class with data used up its weight
+	for(pass = 0; pass < 2; pass++)
+	{
+		for(i = 0; i < queue->classCount; i++)
+		{
+			if(queue->credits[i] > 0 && (data = notifyQueuePop(queue->queues[i])) != NULL)
+			{
+				queue->credits[i]--;
+				if(priorityClass != NULL)
+				{
+					*priorityClass = i;
+				}
+				return data;
+			}
+		}
+		for(i = 0; i < queue->classCount; i++)
+		{
+			queue->credits[i] = queue->weights[i];
+		}
+	}
+	return NULL;
+}
+
+void notifyPriorityQueueWait(NotifyPriorityQueue *queue)
+{
+	pthread_mutex_lock(&queue->mutex);
+	__atomic_store_n(&queue->consumerWaiting, 1, __ATOMIC_SEQ_CST);
+	ATOMIC_FENCE();
+	while(isPriorityQueueEmpty(queue))
+	{
+		pthread_cond_wait(&queue->notEmpty, &queue->mutex);
+	}
+	__atomic_store_n(&queue->consumerWaiting, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+void notifyPriorityQueueGetStats(NotifyPriorityQueue *queue, unsigned int priorityClass, NotifyQueueStats *stats)
+{
+	memset(stats, 0, sizeof(NotifyQueueStats));
+	if(queue != NULL && priorityClass < queue->classCount)
+	{
+		notifyQueueGetStats(queue->queues[priorityClass], stats);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static unsigned int roundUpPowerOfTwo(unsigned int value)
+{
+	unsigned int power = 1;
+	while(power < value)
+	{
+		power <<= 1;
+	}
+	return power;
+}
+
+/*
+ * @brief isQueueFull returns 1 when the next slot to be reserved is still in use
+ */
+static int isQueueFull(NotifyQueue *queue)
+{
+	unsigned long pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_SEQ_CST);
+	unsigned long seq = ATOMIC_LOAD(&queue->cells[pos & queue->mask].sequence);
+	return ((long) seq - (long) pos < 0) ? 1 : 0;
+}
+
+/*
+ * @brief isQueueEmpty returns 1 when the next slot to be consumed is not yet published
+ */
+static int isQueueEmpty(NotifyQueue *queue)
+{
+	unsigned long pos = queue->dequeuePos;
+	unsigned long seq = __atomic_load_n(&queue->cells[pos & queue->mask].sequence, __ATOMIC_SEQ_CST);
+	return ((long) seq - (long) (pos + 1) < 0) ? 1 : 0;
+}
+
+static void updateHighWatermark(NotifyQueue *queue, unsigned long pos)
+{
+	unsigned long dequeuePos = ATOMIC_LOAD(&queue->dequeuePos);
+	unsigned long current = ATOMIC_LOAD(&queue->highWatermark);
+	unsigned long depth = 0;
+
+	// consumer may already have moved past this slot
+	if((long) (pos + 1 - dequeuePos) <= 0)
+	{
+		return;
+	}
+	depth = pos + 1 - dequeuePos;
+
+	while(depth > current)
+	{
+		if(__atomic_compare_exchange_n(&queue->highWatermark, &current, depth, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+			break;
+		}
+	}
+}
+
+/*
+ * @brief updateLatency adds the time a message spent in the queue, consumer thread only
+ */
+static void updateLatency(NotifyQueue *queue, struct timespec *enqueueTime)
+{
+	struct timespec now;
+	long latencyMs = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	latencyMs = (now.tv_sec - enqueueTime->tv_sec) * 1000 + (now.tv_nsec - enqueueTime->tv_nsec) / 1000000;
+	if(latencyMs < 0)
+	{
+		latencyMs = 0;
+	}
+	ATOMIC_STORE(&queue->latencyTotalMs, queue->latencyTotalMs + (unsigned long long) latencyMs);
+	if((unsigned long) latencyMs > queue->latencyMaxMs)
+	{
+		ATOMIC_STORE(&queue->latencyMaxMs, (unsigned long) latencyMs);
+	}
+}
+
+static int isPriorityQueueEmpty(NotifyPriorityQueue *queue)
+{
+	unsigned int i = 0;
+
+	for(i = 0; i < queue->classCount; i++)
+	{
+		if(!isQueueEmpty(queue->queues[i]))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,309 @@
+/**
+ * @file webpa_notify_retry.c
+ *
+ * @description This file describes the retry scheduler for outbound notifications.
+ * Failed sends wait here instead of sleeping on the notification thread.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "webpa_notify_retry.h"
+#include "webpa_timer.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct _NotifyRetryEntry
+{
+    void *data;
+    notifyRetrySendCB send;
+    notifyRetryFreeCB freeData;
+    int attempts;
+    int maxRetries;
+    struct timespec firstFailure;
+    struct timespec nextAttempt;
+    struct _NotifyRetryEntry *next;
+} NotifyRetryEntry;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static NotifyRetryEntry *retryList = NULL;
+static pthread_mutex_t retryMutex = PTHREAD_MUTEX_INITIALIZER;
+static int retryTaskStarted = 0;
+static unsigned long retryTimerId = 0;
+static unsigned long pendingCount = 0;
+static unsigned long retryCount = 0;
+static unsigned long retrySuccessCount = 0;
+static unsigned long dropCount = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static void notifyRetryTimerCB(void *arg);
+static void armRetryTimer();
+static int getBackoffSec(int attempts);
+static int isDue(struct timespec *when, struct timespec *now);
+static void appendEntry(NotifyRetryEntry *entry);
+static NotifyRetryEntry * takeDueEntry(struct timespec *now);
+static NotifyRetryEntry * getEarliestEntry();
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+int scheduleNotifyRetry(void *data, notifyRetrySendCB send, notifyRetryFreeCB freeData, int maxRetries)
+{
+	NotifyRetryEntry *entry = NULL;
+	unsigned long pending = 0;
+
+	if(send == NULL)
+	{
+		return -1;
+	}
+	entry = (NotifyRetryEntry *) malloc(sizeof(NotifyRetryEntry));
+	if(entry == NULL)
+	{
+		WalError("Failed to allocate notification retry entry\n");
+		return -1;
+	}
+	memset(entry, 0, sizeof(NotifyRetryEntry));
+	entry->data = data;
+	entry->send = send;
+	entry->freeData = freeData;
+	entry->maxRetries = maxRetries;
+	clock_gettime(CLOCK_MONOTONIC, &entry->firstFailure);
+	entry->nextAttempt = entry->firstFailure;
+	entry->nextAttempt.tv_sec += getBackoffSec(0);
+
+	pthread_mutex_lock(&retryMutex);
+	appendEntry(entry);
+	pending = ++pendingCount;
+	armRetryTimer();
+	pthread_mutex_unlock(&retryMutex);
+	WalInfo("Notification scheduled for retry after %d seconds, %lu pending\n", getBackoffSec(0), pending);
+	return 0;
+}
+
+int runNotifyRetries()
+{
+	NotifyRetryEntry *entry = NULL;
+	struct timespec now;
+	int rc = 0, pending = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	while(1)
+	{
+		pthread_mutex_lock(&retryMutex);
+		entry = takeDueEntry(&now);
+		pthread_mutex_unlock(&retryMutex);
+		if(entry == NULL)
+		{
+			break;
+		}
+
+		// send without the lock, the notification thread keeps scheduling meanwhile
+		rc = entry->send(entry->data);
+		entry->attempts++;
+
+		pthread_mutex_lock(&retryMutex);
+		retryCount++;
+		if(rc == 0)
+		{
+			retrySuccessCount++;
+			pendingCount--;
+			WalInfo("Notification sent on retry %d\n", entry->attempts);
+		}
+		else if(entry->maxRetries > 0 && entry->attempts >= entry->maxRetries)
+		{
+			dropCount++;
+			pendingCount--;
+			WalError("Notification dropped after %d retries\n", entry->attempts);
+		}
+		else
+		{
+			entry->nextAttempt = now;
+			entry->nextAttempt.tv_sec += getBackoffSec(entry->attempts);
+			WalPrint("Notification retry %d failed, next retry after %d seconds\n", entry->attempts, getBackoffSec(entry->attempts));
+			appendEntry(entry);
+			entry = NULL;
+		}
+		pthread_mutex_unlock(&retryMutex);
+
+		if(entry != NULL)
+		{
+			if(entry->freeData != NULL)
+			{
+				entry->freeData(entry->data);
+			}
+			WAL_FREE(entry);
+		}
+	}
+
+	pthread_mutex_lock(&retryMutex);
+	pending = (int) pendingCount;
+	armRetryTimer();
+	pthread_mutex_unlock(&retryMutex);
+	return pending;
+}
+
+void startNotifyRetryTask()
+{
+	pthread_mutex_lock(&retryMutex);
+	if(retryTaskStarted)
+	{
+		pthread_mutex_unlock(&retryMutex);
+		return;
+	}
+	retryTaskStarted = 1;
+	// messages scheduled before the start are armed now
+	armRetryTimer();
+	pthread_mutex_unlock(&retryMutex);
+	startWebpaTimerTask();
+	WalInfo("Notification retries are run from the timer work thread\n");
+}
+
+void getNotifyRetryStats(NotifyRetryStats *stats)
+{
+	NotifyRetryEntry *entry = NULL;
+	struct timespec now;
+
+	memset(stats, 0, sizeof(NotifyRetryStats));
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&retryMutex);
+	stats->pendingCount = pendingCount;
+	stats->retryCount = retryCount;
+	stats->retrySuccessCount = retrySuccessCount;
+	stats->dropCount = dropCount;
+	for(entry = retryList; entry != NULL; entry = entry->next)
+	{
+		if(now.tv_sec - entry->firstFailure.tv_sec > stats->oldestPendingAgeSec)
+		{
+			stats->oldestPendingAgeSec = now.tv_sec - entry->firstFailure.tv_sec;
+		}
+	}
+	pthread_mutex_unlock(&retryMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static void notifyRetryTimerCB(void *arg)
+{
+	NotifyRetryStats stats;
+
+	(void) arg;
+	pthread_mutex_lock(&retryMutex);
+	retryTimerId = 0;
+	pthread_mutex_unlock(&retryMutex);
+	if(runNotifyRetries() > 0)
+	{
+		getNotifyRetryStats(&stats);
+		WalInfo("Notification retries: pending %lu, retried %lu, sent %lu, dropped %lu, oldest pending %ld seconds\n",
+			stats.pendingCount, stats.retryCount, stats.retrySuccessCount, stats.dropCount, stats.oldestPendingAgeSec);
+	}
+}
+
+/*
+ * @brief armRetryTimer points the retry timer at the earliest entry, caller holds retryMutex.
+ * The jitter keeps devices that lost the cloud together from retrying in step.
+ */
+static void armRetryTimer()
+{
+	NotifyRetryEntry *earliest = NULL;
+	struct timespec now;
+	long delayMs = 0;
+
+	if(!retryTaskStarted)
+	{
+		return;
+	}
+	if(retryTimerId != 0)
+	{
+		cancelWebpaTimer(retryTimerId);
+		retryTimerId = 0;
+	}
+	earliest = getEarliestEntry();
+	if(earliest == NULL)
+	{
+		return;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	delayMs = (earliest->nextAttempt.tv_sec - now.tv_sec) * 1000 + (earliest->nextAttempt.tv_nsec - now.tv_nsec) / 1000000;
+	retryTimerId = scheduleWebpaWork((delayMs > 0) ? (unsigned long) delayMs : 0, WEBPA_NOTIFY_RETRY_JITTER_MSEC, notifyRetryTimerCB, NULL);
+}
+
+static int getBackoffSec(int attempts)
+{
+	int c = attempts + 2;
+
+	if(c > WEBPA_NOTIFY_RETRY_BACKOFF_MAX)
+	{
+		c = WEBPA_NOTIFY_RETRY_BACKOFF_MAX;
+	}
+	return (1 << c) - 1;
+}
+
+static int isDue(struct timespec *when, struct timespec *now)
+{
+	return (when->tv_sec < now->tv_sec || (when->tv_sec == now->tv_sec && when->tv_nsec <= now->tv_nsec)) ? 1 : 0;
+}
+
+/*
+ * @brief appendEntry adds an entry at the end of the retry list, caller holds retryMutex
+ */
+static void appendEntry(NotifyRetryEntry *entry)
+{
+	NotifyRetryEntry **tail = &retryList;
+
+	while(*tail != NULL)
+	{
+		tail = &(*tail)->next;
+	}
+	entry->next = NULL;
+	*tail = entry;
+}
+
+/*
+ * @brief takeDueEntry unlinks the oldest entry that is due, caller holds retryMutex
+ */
+static NotifyRetryEntry * takeDueEntry(struct timespec *now)
+{
+	NotifyRetryEntry **link = &retryList;
+	NotifyRetryEntry *entry = NULL;
+
+	while(*link != NULL)
+	{
+		if(isDue(&(*link)->nextAttempt, now))
+		{
+			entry = *link;
+			*link = entry->next;
+			entry->next = NULL;
+			return entry;
+		}
+		link = &(*link)->next;
+	}
+	return NULL;
+}
+
+/*
+ * @brief getEarliestEntry returns the entry retried next, caller holds retryMutex
+ */
+static NotifyRetryEntry * getEarliestEntry()
+{
+	NotifyRetryEntry *entry = NULL, *earliest = NULL;
+
+	for(entry = retryList; entry != NULL; entry = entry->next)
+	{
+		if(earliest == NULL || !isDue(&earliest->nextAttempt, &entry->nextAttempt))
+		{
+			earliest = entry;
+		}
+	}
+	return earliest;
+}
@@ -0,0 +1,690 @@
+/**
+ * @file webpa_outbox.c
+ *
+ * @description This file describes the disk-backed outbox for outbound notifications
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "webpa_outbox.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define OUTBOX_MAGIC                0x57504f42
+#define OUTBOX_RECORD_MAGIC         0x57504556
+#define OUTBOX_VERSION              2
+#define OUTBOX_RECORD_PENDING       1
+#define OUTBOX_RECORD_ACKED         2
+#define OUTBOX_ALIGN(len)           (((len) + 7) & ~((uint64_t) 7))
+#define OUTBOX_PATH_LEN             256
+#define OUTBOX_TMP_SUFFIX           ".tmp"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/* File layout: OutboxHeader followed by the event area. Live events are in [head, tail). */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t reserved;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t nextSeq;
+} OutboxHeader;
+
+/* Each event is followed by source, dest and payload, each NUL terminated */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t state;
+    uint64_t seq;
+    int64_t timestamp;
+    uint32_t sourceLen;
+    uint32_t destLen;
+    uint32_t payloadLen;
+    uint32_t size;
+    uint32_t attempts;
+    uint32_t reserved;
+} OutboxRecord;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static OutboxHeader * getHeader(NotifyOutbox *outbox);
+static OutboxRecord * getRecord(NotifyOutbox *outbox, uint64_t offset);
+static int isValidRecord(NotifyOutbox *outbox, uint64_t offset, uint64_t tail);
+static int isExpired(NotifyOutbox *outbox, OutboxRecord *record, time_t now);
+static OutboxRecord * findPendingRecord(NotifyOutbox *outbox, uint64_t seq);
+static unsigned int recordSendFailure(NotifyOutbox *outbox, uint64_t seq);
+static void dropFailedEvents(NotifyOutbox *outbox, uint64_t seq);
+static void syncOutbox(NotifyOutbox *outbox);
+static void resetOutbox(NotifyOutbox *outbox);
+static void recoverOutbox(NotifyOutbox *outbox);
+static void advanceHead(NotifyOutbox *outbox);
+static uint64_t expirePendingEvents(NotifyOutbox *outbox, time_t now);
+static int compactOutbox(NotifyOutbox *outbox);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+NotifyOutbox * outboxOpen(const char *path, unsigned int capacity, unsigned int maxAgeSec)
+{
+	NotifyOutbox *outbox = NULL;
+	OutboxHeader *header = NULL;
+	struct stat st;
+	int reinit = 0;
+
+	capacity = (unsigned int) OUTBOX_ALIGN(capacity);
+	if(path == NULL || capacity < sizeof(OutboxRecord))
+	{
+		return NULL;
+	}
+	outbox = (NotifyOutbox *) malloc(sizeof(NotifyOutbox));
+	if(outbox == NULL)
+	{
+		WalError("Failed to allocate notification outbox\n");
+		return NULL;
+	}
+	memset(outbox, 0, sizeof(NotifyOutbox));
+	outbox->capacity = capacity;
+	outbox->maxAgeSec = maxAgeSec;
+	outbox->mapSize = sizeof(OutboxHeader) + capacity;
+	outbox->fd = -1;
+	outbox->path = strdup(path);
+	if(outbox->path == NULL || strlen(path) + sizeof(OUTBOX_TMP_SUFFIX) > OUTBOX_PATH_LEN)
+	{
+		WalError("Invalid notification outbox path %s\n", path);
+		goto error;
+	}
+
+	outbox->fd = open(path, O_RDWR | O_CREAT, 0600);
+	if(outbox->fd < 0 || fstat(outbox->fd, &st) != 0)
+	{
+		WalError("Failed to open notification outbox %s\n", path);
+		goto error;
+	}
+	if((size_t) st.st_size != outbox->mapSize)
+	{
+		reinit = 1;
+		if(ftruncate(outbox->fd, outbox->mapSize) != 0)
+		{
+			WalError("Failed to size notification outbox %s\n", path);
+			goto error;
+		}
+	}
+	outbox->map = (unsigned char *) mmap(NULL, outbox->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, outbox->fd, 0);
+	if(outbox->map == MAP_FAILED)
+	{
+		WalError("Failed to map notification outbox %s\n", path);
+		outbox->map = NULL;
+		goto error;
+	}
+	pthread_mutex_init(&outbox->mutex, NULL);
+	outbox->lastSync = time(NULL);
+
+	header = getHeader(outbox);
+	if(reinit || header->magic != OUTBOX_MAGIC || header->version != OUTBOX_VERSION || header->capacity != capacity)
+	{
+		resetOutbox(outbox);
+	}
+	else
+	{
+		recoverOutbox(outbox);
+	}
+	WalInfo("Notification outbox %s opened with capacity %u, %lu pending events\n", path, capacity, outbox->pendingCount);
+	return outbox;
+
+error:
+	if(outbox->fd >= 0)
+	{
+		close(outbox->fd);
+	}
+	free(outbox->path);
+	WAL_FREE(outbox);
+	return NULL;
+}
+
+void outboxClose(NotifyOutbox *outbox)
+{
+	if(outbox != NULL)
+	{
+		if(outbox->dirty)
+		{
+			msync(outbox->map, outbox->mapSize, MS_SYNC);
+		}
+		munmap(outbox->map, outbox->mapSize);
+		close(outbox->fd);
+		pthread_mutex_destroy(&outbox->mutex);
+		WAL_FREE(outbox->path);
+		WAL_FREE(outbox);
+	}
+}
+
+int outboxAppend(NotifyOutbox *outbox, const char *source, const char *dest, const char *payload, size_t payloadLen, uint64_t *seq)
+{
+	OutboxHeader *header = NULL;
+	OutboxRecord *record = NULL;
+	unsigned char *data = NULL;
+	size_t sourceLen = (source != NULL) ? strlen(source) : 0;
+	size_t destLen = (dest != NULL) ? strlen(dest) : 0;
+	uint64_t need = 0, offset = 0, pendingBytes = 0;
+	time_t now = time(NULL);
+
+	if(payload == NULL)
+	{
+		payloadLen = 0;
+	}
+	need = OUTBOX_ALIGN(sizeof(OutboxRecord) + sourceLen + destLen + payloadLen + 3);
+	if(need > outbox->capacity)
+	{
+		WalError("Notification of %zu bytes does not fit in the outbox\n", payloadLen);
+		pthread_mutex_lock(&outbox->mutex);
+		outbox->dropCount++;
+		pthread_mutex_unlock(&outbox->mutex);
+		return -1;
+	}
+
+	pthread_mutex_lock(&outbox->mutex);
+	header = getHeader(outbox);
+	if(header->tail + need > outbox->capacity)
+	{
+		// drop expired events, then the oldest pending ones until the new one fits
+		pendingBytes = expirePendingEvents(outbox, now);
+		for(offset = header->head; pendingBytes + need > outbox->capacity && offset < header->tail; offset += record->size)
+		{
+			record = getRecord(outbox, offset);
+			if(record->state == OUTBOX_RECORD_PENDING)
+			{
+				WalError("Notification outbox full, dropping pending event %llu\n", (unsigned long long) record->seq);
+				record->state = OUTBOX_RECORD_ACKED;
+				pendingBytes -= record->size;
+				outbox->pendingCount--;
+				outbox->dropCount++;
+			}
+		}
+		if(compactOutbox(outbox) != 0)
+		{
+			WalError("Notification of %zu bytes dropped, outbox could not be compacted\n", payloadLen);
+			outbox->dropCount++;
+			pthread_mutex_unlock(&outbox->mutex);
+			return -1;
+		}
+		header = getHeader(outbox);
+	}
+
+	record = getRecord(outbox, header->tail);
+	memset(record, 0, sizeof(OutboxRecord));
+	record->magic = OUTBOX_RECORD_MAGIC;
+	record->state = OUTBOX_RECORD_PENDING;
+	record->seq = header->nextSeq++;
+	record->timestamp = (int64_t) now;
+	record->sourceLen = (uint32_t) sourceLen;
+	record->destLen = (uint32_t) destLen;
+	record->payloadLen = (uint32_t) payloadLen;
+	record->size = (uint32_t) need;
+	data = (unsigned char *) (record + 1);
+	memcpy(data, (sourceLen > 0) ? source : "", sourceLen + 1);
+	data += sourceLen + 1;
+	memcpy(data, (destLen > 0) ? dest : "", destLen + 1);
+	data += destLen + 1;
+	if(payloadLen > 0)
+	{
+		memcpy(data, payload, payloadLen);
+	}
+	data[payloadLen] = '\0';
+	// event is complete before it becomes visible to recovery
+	header->tail += need;
+	if(seq != NULL)
+	{
+		*seq = record->seq;
+	}
+	outbox->pendingCount++;
+	outbox->appendCount++;
+	syncOutbox(outbox);
+	pthread_mutex_unlock(&outbox->mutex);
+	return 0;
+}
+
+int outboxAck(NotifyOutbox *outbox, uint64_t seq)
+{
+	OutboxHeader *header = NULL;
+	OutboxRecord *record = NULL;
+	uint64_t offset = 0;
+	int ret = -1;
+
+	pthread_mutex_lock(&outbox->mutex);
+	header = getHeader(outbox);
+	for(offset = header->head; offset < header->tail; offset += record->size)
+	{
+		record = getRecord(outbox, offset);
+		if(record->seq == seq)
+		{
+			if(record->state == OUTBOX_RECORD_PENDING)
+			{
+				record->state = OUTBOX_RECORD_ACKED;
+				outbox->pendingCount--;
+				outbox->ackCount++;
+				syncOutbox(outbox);
+				ret = 0;
+			}
+			break;
+		}
+	}
+	advanceHead(outbox);
+	pthread_mutex_unlock(&outbox->mutex);
+	return ret;
+}
+
+int outboxReplay(NotifyOutbox *outbox, outboxSendCB send, void *userData)
+{
+	OutboxHeader *header = NULL;
+	OutboxRecord *record = NULL;
+	uint64_t offset = 0, seq = 0, lastSeq = 0;
+	char *source = NULL, *dest = NULL, *payload = NULL;
+	size_t payloadLen = 0;
+	int sent = 0, found = 0, skipped = 0, rc = 0;
+	time_t now;
+
+	for(;;)
+	{
+		found = 0;
+		pthread_mutex_lock(&outbox->mutex);
+		header = getHeader(outbox);
+		now = time(NULL);
+		for(offset = header->head; offset < header->tail; offset += record->size)
+		{
+			record = getRecord(outbox, offset);
+			// each event is tried once per replay, events keep their order when compacted
+			if(record->state != OUTBOX_RECORD_PENDING || record->seq <= lastSeq)
+			{
+				continue;
+			}
+			if(isExpired(outbox, record, now))
+			{
+				WalInfo("Dropping outbox event %llu older than %u seconds\n", (unsigned long long) record->seq, outbox->maxAgeSec);
+				record->state = OUTBOX_RECORD_ACKED;
+				outbox->pendingCount--;
+				outbox->expiredCount++;
+				syncOutbox(outbox);
+				continue;
+			}
+			// copy out, the event may be moved by an append while it is being sent
+			source = strdup((char *) (record + 1));
+			dest = strdup((char *) (record + 1) + record->sourceLen + 1);
+			payloadLen = record->payloadLen;
+			payload = (char *) malloc(payloadLen + 1);
+			if(payload != NULL)
+			{
+				memcpy(payload, (char *) (record + 1) + record->sourceLen + record->destLen + 2, payloadLen + 1);
+			}
+			seq = record->seq;
+			found = 1;
+			break;
+		}
+		advanceHead(outbox);
+		pthread_mutex_unlock(&outbox->mutex);
+
+		if(!found)
+		{
+			break;
+		}
+		lastSeq = seq;
+		if(source == NULL || dest == NULL || payload == NULL)
+		{
+			WalError("Failed to allocate memory for outbox event %llu\n", (unsigned long long) seq);
+			rc = WEBPA_OUTBOX_SEND_FAILED;
+		}
+		else
+		{
+			rc = send(source, dest, payload, payloadLen, userData);
+		}
+		free(source);
+		free(dest);
+		free(payload);
+		if(rc == WEBPA_OUTBOX_SEND_OK)
+		{
+			outboxAck(outbox, seq);
+			sent++;
+			if(skipped)
+			{
+				// parodus accepts events, the ones skipped before this one are rejected for good
+				dropFailedEvents(outbox, seq);
+				skipped = 0;
+			}
+			continue;
+		}
+		// a transport failure ends the pass without counting against the event
+		if(rc != WEBPA_OUTBOX_SEND_REJECTED || recordSendFailure(outbox, seq) < WEBPA_OUTBOX_MAX_ATTEMPTS)
+		{
+			return -1;
+		}
+		WalError("Outbox event %llu rejected %d times, sending the events behind it\n", (unsigned long long) seq, WEBPA_OUTBOX_MAX_ATTEMPTS);
+		skipped = 1;
+	}
+	return skipped ? -1 : sent;
+}
+
+void outboxGetStats(NotifyOutbox *outbox, NotifyOutboxStats *stats)
+{
+	memset(stats, 0, sizeof(NotifyOutboxStats));
+	if(outbox != NULL)
+	{
+		pthread_mutex_lock(&outbox->mutex);
+		stats->capacity = outbox->capacity;
+		stats->used = (unsigned int) (getHeader(outbox)->tail - getHeader(outbox)->head);
+		stats->pendingCount = outbox->pendingCount;
+		stats->appendCount = outbox->appendCount;
+		stats->ackCount = outbox->ackCount;
+		stats->dropCount = outbox->dropCount;
+		stats->expiredCount = outbox->expiredCount;
+		stats->syncCount = outbox->syncCount;
+		pthread_mutex_unlock(&outbox->mutex);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static OutboxHeader * getHeader(NotifyOutbox *outbox)
+{
+	return (OutboxHeader *) outbox->map;
+}
+
+static OutboxRecord * getRecord(NotifyOutbox *outbox, uint64_t offset)
+{
+	return (OutboxRecord *) (outbox->map + sizeof(OutboxHeader) + offset);
+}
+
+/*
+ * @brief isValidRecord checks an event read back from the file lies within [offset, tail)
+ */
+static int isValidRecord(NotifyOutbox *outbox, uint64_t offset, uint64_t tail)
+{
+	OutboxRecord *record = NULL;
+
+	if(offset + sizeof(OutboxRecord) > tail)
+	{
+		return 0;
+	}
+	record = getRecord(outbox, offset);
+	if(record->magic != OUTBOX_RECORD_MAGIC || record->size != OUTBOX_ALIGN(record->size) ||
+		(uint64_t) record->size < sizeof(OutboxRecord) + (uint64_t) record->sourceLen + record->destLen + record->payloadLen + 3 ||
+		offset + record->size > tail)
+	{
+		return 0;
+	}
+	return 1;
+}
+
+static int isExpired(NotifyOutbox *outbox, OutboxRecord *record, time_t now)
+{
+	return (outbox->maxAgeSec > 0 && (int64_t) now - record->timestamp > (int64_t) outbox->maxAgeSec) ? 1 : 0;
+}
+
+/*
+ * @brief findPendingRecord returns the pending event of a sequence number, called with the lock held
+ */
+static OutboxRecord * findPendingRecord(NotifyOutbox *outbox, uint64_t seq)
+{
+	OutboxHeader *header = getHeader(outbox);
+	OutboxRecord *record = NULL;
+	uint64_t offset = 0;
+
+	for(offset = header->head; offset < header->tail; offset += record->size)
+	{
+		record = getRecord(outbox, offset);
+		if(record->seq == seq)
+		{
+			return (record->state == OUTBOX_RECORD_PENDING) ? record : NULL;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief recordSendFailure counts a rejected send of an event, the count is kept across restarts
+ * @return number of rejected sends, WEBPA_OUTBOX_MAX_ATTEMPTS when the event is gone
+ */
+static unsigned int recordSendFailure(NotifyOutbox *outbox, uint64_t seq)
+{
+	OutboxRecord *record = NULL;
+	unsigned int attempts = WEBPA_OUTBOX_MAX_ATTEMPTS;
+
+	pthread_mutex_lock(&outbox->mutex);
+	record = findPendingRecord(outbox, seq);
+	if(record != NULL)
+	{
+		attempts = ++record->attempts;
+	}
+	pthread_mutex_unlock(&outbox->mutex);
+	return attempts;
+}
+
+/*
+ * @brief dropFailedEvents drops the events ahead of seq that reached the attempt limit
+ */
+static void dropFailedEvents(NotifyOutbox *outbox, uint64_t seq)
+{
+	OutboxHeader *header = NULL;
+	OutboxRecord *record = NULL;
+	uint64_t offset = 0;
+
+	pthread_mutex_lock(&outbox->mutex);
+	header = getHeader(outbox);
+	for(offset = header->head; offset < header->tail; offset += record->size)
+	{
+		record = getRecord(outbox, offset);
+		if(record->seq >= seq)
+		{
+			break;
+		}
+		if(record->state == OUTBOX_RECORD_PENDING && record->attempts >= WEBPA_OUTBOX_MAX_ATTEMPTS)
+		{
+			WalError("Dropping outbox event %llu, it was rejected %u times while later events were sent\n", (unsigned long long) record->seq, record->attempts);
+			record->state = OUTBOX_RECORD_ACKED;
+			outbox->pendingCount--;
+			outbox->dropCount++;
+			syncOutbox(outbox);
+		}
+	}
+	advanceHead(outbox);
+	pthread_mutex_unlock(&outbox->mutex);
+}
+
+/*
+ * @brief syncOutbox marks the outbox changed and flushes it to disk when the last
+ * flush is WEBPA_OUTBOX_SYNC_INTERVAL_SEC ago, called with the lock held
+ */
+static void syncOutbox(NotifyOutbox *outbox)
+{
+	time_t now = time(NULL);
+
+	outbox->dirty = 1;
+	if(now - outbox->lastSync >= WEBPA_OUTBOX_SYNC_INTERVAL_SEC || now < outbox->lastSync)
+	{
+		msync(outbox->map, outbox->mapSize, MS_SYNC);
+		outbox->lastSync = now;
+		outbox->dirty = 0;
+		outbox->syncCount++;
+	}
+}
+
+static void resetOutbox(NotifyOutbox *outbox)
+{
+	OutboxHeader *header = getHeader(outbox);
+
+	memset(header, 0, sizeof(OutboxHeader));
+	header->magic = OUTBOX_MAGIC;
+	header->version = OUTBOX_VERSION;
+	header->capacity = outbox->capacity;
+	header->nextSeq = 1;
+	outbox->dirty = 1;
+}
+
+/*
+ * @brief recoverOutbox counts events left by a previous run and cuts off a
+ * partially written tail
+ */
+static void recoverOutbox(NotifyOutbox *outbox)
+{
+	OutboxHeader *header = getHeader(outbox);
+	OutboxRecord *record = NULL;
+	uint64_t offset = 0;
+
+	if(header->head > header->tail || header->tail > outbox->capacity)
+	{
+		WalError("Notification outbox is corrupted, resetting it\n");
+		resetOutbox(outbox);
+		return;
+	}
+	for(offset = header->head; offset < header->tail; offset += record->size)
+	{
+		if(!isValidRecord(outbox, offset, header->tail))
+		{
+			WalError("Notification outbox truncated at invalid event offset %llu\n", (unsigned long long) offset);
+			header->tail = offset;
+			outbox->dirty = 1;
+			break;
+		}
+		record = getRecord(outbox, offset);
+		if(record->state == OUTBOX_RECORD_PENDING)
+		{
+			outbox->pendingCount++;
+		}
+		if(record->seq >= header->nextSeq)
+		{
+			header->nextSeq = record->seq + 1;
+		}
+	}
+	advanceHead(outbox);
+}
+
+/*
+ * @brief advanceHead skips acknowledged events at the head, an empty outbox restarts at offset 0
+ */
+static void advanceHead(NotifyOutbox *outbox)
+{
+	OutboxHeader *header = getHeader(outbox);
+	OutboxRecord *record = NULL;
+
+	while(header->head < header->tail)
+	{
+		record = getRecord(outbox, header->head);
+		if(record->state == OUTBOX_RECORD_PENDING)
+		{
+			break;
+		}
+		header->head += record->size;
+	}
+	if(header->head >= header->tail)
+	{
+		header->head = 0;
+		header->tail = 0;
+	}
+}
+
+/*
+ * @brief expirePendingEvents drops expired events and returns the space the pending ones use
+ */
+static uint64_t expirePendingEvents(NotifyOutbox *outbox, time_t now)
+{
+	OutboxHeader *header = getHeader(outbox);
+	OutboxRecord *record = NULL;
+	uint64_t offset = 0, pendingBytes = 0;
+
+	for(offset = header->head; offset < header->tail; offset += record->size)
+	{
+		record = getRecord(outbox, offset);
+		if(record->state == OUTBOX_RECORD_PENDING && isExpired(outbox, record, now))
+		{
+			record->state = OUTBOX_RECORD_ACKED;
+			outbox->pendingCount--;
+			outbox->expiredCount++;
+		}
+		if(record->state == OUTBOX_RECORD_PENDING)
+		{
+			pendingBytes += record->size;
+		}
+	}
+	return pendingBytes;
+}
+
+/*
+ * @brief compactOutbox writes the pending events to the start of a new file which
+ * then replaces the outbox. Events are never moved within the mapped file, so a
+ * crash leaves either the old or the new outbox and no half moved event.
+ */
+static int compactOutbox(NotifyOutbox *outbox)
+{
+	OutboxHeader *header = getHeader(outbox), *newHeader = NULL;
+	OutboxRecord *record = NULL;
+	unsigned char *map = NULL;
+	char tmpPath[OUTBOX_PATH_LEN];
+	uint64_t offset = 0, writeOffset = 0;
+	int fd = -1;
+
+	snprintf(tmpPath, sizeof(tmpPath), "%s%s", outbox->path, OUTBOX_TMP_SUFFIX);
+	fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if(fd < 0 || ftruncate(fd, outbox->mapSize) != 0)
+	{
+		goto error;
+	}
+	map = (unsigned char *) mmap(NULL, outbox->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		map = NULL;
+		goto error;
+	}
+
+	newHeader = (OutboxHeader *) map;
+	memcpy(newHeader, header, sizeof(OutboxHeader));
+	for(offset = header->head; offset < header->tail; offset += record->size)
+	{
+		record = getRecord(outbox, offset);
+		if(record->state == OUTBOX_RECORD_PENDING)
+		{
+			memcpy(map + sizeof(OutboxHeader) + writeOffset, record, record->size);
+			writeOffset += record->size;
+		}
+	}
+	newHeader->head = 0;
+	newHeader->tail = writeOffset;
+	if(msync(map, outbox->mapSize, MS_SYNC) != 0 || rename(tmpPath, outbox->path) != 0)
+	{
+		goto error;
+	}
+
+	munmap(outbox->map, outbox->mapSize);
+	close(outbox->fd);
+	outbox->map = map;
+	outbox->fd = fd;
+	outbox->lastSync = time(NULL);
+	outbox->dirty = 0;
+	outbox->syncCount++;
+	return 0;
+
+error:
+	WalError("Failed to compact notification outbox %s\n", outbox->path);
+	if(map != NULL)
+	{
+		munmap(map, outbox->mapSize);
+	}
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+	unlink(tmpPath);
+	return -1;
+}
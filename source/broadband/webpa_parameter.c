@@ -476,6 +476,12 @@ static int getParamValues(char *parameterNames[], int paramCount, char *CompName
             	ret = getWebpaParameterValues(parameterNamesLocal, paramCount, &val_size, &parameterval);
 			}
         }
+        else if(!isComponentReachable(CompName))
+        {
+            // fail fast instead of waiting for the bus to time out
+            WalError("%s is not reachable, skipping GetValue\n", CompName);
+            ret = CCSP_ERR_COMPONENT_UNREACHABLE;
+        }
         else
         {
             ret = CcspBaseIf_getParameterValues(bus_handle,CompName,dbusPath,parameterNamesLocal,paramCount, &val_size, &parameterval);
@@ -485,6 +491,7 @@ static int getParamValues(char *parameterNames[], int paramCount, char *CompName
         {
             WalError("Error:Failed to GetValue for parameters ret: %d\n", ret);
             OnboardLog("Error:Failed to GetValue for parameters ret: %d\n", ret);
+            reportComponentFailure(CompName, dbusPath, ret);
         }
         else
         {
@@ -786,7 +793,19 @@ static int setParamValues(param_t *paramVal, char *CompName, char *dbusPath, int
 			}
 		}
 #endif
-            ret = CcspBaseIf_setParameterValues(bus_handle, CompName, dbusPath, 0, writeID, val, paramCount, TRUE, &faultParam);
+            if(!isComponentReachable(CompName))
+            {
+                WalError("%s is not reachable, skipping SetValue\n", CompName);
+                ret = CCSP_ERR_COMPONENT_UNREACHABLE;
+            }
+            else
+            {
+                ret = CcspBaseIf_setParameterValues(bus_handle, CompName, dbusPath, 0, writeID, val, paramCount, TRUE, &faultParam);
+            }
+            if(ret != CCSP_SUCCESS)
+            {
+                reportComponentFailure(CompName, dbusPath, ret);
+            }
         }
 
         if(!strcmp(CompName,RDKB_WIFI_FULL_COMPONENT_NAME) && setType != WEBPA_ATOMIC_SET_WEBCONFIG)
@@ -0,0 +1,521 @@
+/**
+ * @file webpa_request_parser.c
+ *
+ * @description This file describes the parser of WebPA request payloads.
+ * Most requests are a plain GET of names or a flat SET, those are read in two
+ * passes over the payload without building a cJSON tree: the first one checks
+ * the shape and sizes the request, the second fills a single allocation.
+ * Strings are found with memchr, which the C library scans a word or a
+ * vector at a time.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "webpa_request_parser.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define FAST_KEY_COMMAND                (1 << 0)
+#define FAST_KEY_NAMES                  (1 << 1)
+#define FAST_KEY_PARAMETERS             (1 << 2)
+#define FAST_KEY_NAME                   (1 << 0)
+#define FAST_KEY_VALUE                  (1 << 1)
+#define FAST_KEY_DATATYPE               (1 << 2)
+#define FAST_MAX_DATATYPE_DIGITS        3
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/* Parse state, strings, names and params are NULL in the sizing pass */
+typedef struct
+{
+    const char *pos;
+    const char *end;
+    char *strings;
+    size_t stringSize;
+    char **names;
+    param_t *params;
+    size_t count;
+    int reqType;
+} FastParser;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static int parsePayload(FastParser *p);
+static int parseNames(FastParser *p);
+static int parseParams(FastParser *p);
+static int parseParam(FastParser *p, param_t *param);
+static int parseDataType(FastParser *p, DATA_TYPE *type);
+static int parseString(FastParser *p, char **out);
+static int parseEscapedString(FastParser *p, char **out);
+static int parseKey(FastParser *p, const char **key, size_t *keyLen);
+static int isKey(const char *key, size_t keyLen, const char *name);
+static int nextItem(FastParser *p, char close);
+static int expectChar(FastParser *p, char c);
+static void skipSpace(FastParser *p);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+WEBPA_REQUEST_PARSER parseWebpaRequest(char *payload, req_struct **reqObj)
+{
+	*reqObj = NULL;
+	if(payload == NULL)
+	{
+		return WEBPA_PARSER_NONE;
+	}
+	if(parseFastRequest(payload, strlen(payload), reqObj) == 0)
+	{
+		return WEBPA_PARSER_FAST;
+	}
+	wdmp_parse_request(payload, reqObj);
+	return (*reqObj != NULL) ? WEBPA_PARSER_FULL : WEBPA_PARSER_NONE;
+}
+
+int parseFastRequest(const char *payload, size_t payloadSize, req_struct **reqObj)
+{
+	FastParser p;
+	req_struct *req = NULL;
+	size_t headerSize = 0;
+
+	*reqObj = NULL;
+	if(payload == NULL)
+	{
+		return -1;
+	}
+	memset(&p, 0, sizeof(FastParser));
+	p.pos = payload;
+	p.end = payload + payloadSize;
+	if(parsePayload(&p) != 0)
+	{
+		return -1;
+	}
+
+	headerSize = sizeof(req_struct);
+	if(p.reqType == GET)
+	{
+		headerSize += sizeof(get_req_t) + (sizeof(char *) * p.count);
+	}
+	else
+	{
+		headerSize += sizeof(set_req_t) + (sizeof(param_t) * p.count);
+	}
+	req = (req_struct *) malloc(headerSize + p.stringSize);
+	if(req == NULL)
+	{
+		return -1;
+	}
+	memset(req, 0, sizeof(req_struct));
+	req->reqType = (REQ_TYPE) p.reqType;
+	if(p.reqType == GET)
+	{
+		req->u.getReq = (get_req_t *) (req + 1);
+		req->u.getReq->paramCnt = p.count;
+		req->u.getReq->paramNames = (char **) (req->u.getReq + 1);
+		p.names = req->u.getReq->paramNames;
+	}
+	else
+	{
+		req->u.setReq = (set_req_t *) (req + 1);
+		req->u.setReq->paramCnt = p.count;
+		req->u.setReq->param = (param_t *) (req->u.setReq + 1);
+		p.params = req->u.setReq->param;
+	}
+	p.strings = (char *) req + headerSize;
+	p.pos = payload;
+	p.stringSize = 0;
+	p.count = 0;
+	if(parsePayload(&p) != 0)
+	{
+		free(req);
+		return -1;
+	}
+	*reqObj = req;
+	return 0;
+}
+
+void freeWebpaRequest(req_struct *reqObj, WEBPA_REQUEST_PARSER parser)
+{
+	if(reqObj == NULL)
+	{
+		return;
+	}
+	if(parser == WEBPA_PARSER_FAST)
+	{
+		free(reqObj);
+	}
+	else
+	{
+		wdmp_free_req_struct(reqObj);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief parsePayload reads the top level object, any key other than command,
+ * names and parameters sends the request to the full parser
+ */
+static int parsePayload(FastParser *p)
+{
+	const char *key = NULL;
+	size_t keyLen = 0;
+	int seen = 0, next = 0;
+
+	p->reqType = -1;
+	if(expectChar(p, '{') != 0)
+	{
+		return -1;
+	}
+	do
+	{
+		if(parseKey(p, &key, &keyLen) != 0 || expectChar(p, ':') != 0)
+		{
+			return -1;
+		}
+		skipSpace(p);
+		if(isKey(key, keyLen, "command") && !(seen & FAST_KEY_COMMAND))
+		{
+			seen |= FAST_KEY_COMMAND;
+			if(parseKey(p, &key, &keyLen) != 0)
+			{
+				return -1;
+			}
+			if(isKey(key, keyLen, "GET"))
+			{
+				p->reqType = GET;
+			}
+			else if(isKey(key, keyLen, "SET"))
+			{
+				p->reqType = SET;
+			}
+			else
+			{
+				return -1;
+			}
+		}
+		else if(isKey(key, keyLen, "names") && !(seen & FAST_KEY_NAMES))
+		{
+			seen |= FAST_KEY_NAMES;
+			if(parseNames(p) != 0)
+			{
+				return -1;
+			}
+		}
+		else if(isKey(key, keyLen, "parameters") && !(seen & FAST_KEY_PARAMETERS))
+		{
+			seen |= FAST_KEY_PARAMETERS;
+			if(parseParams(p) != 0)
+			{
+				return -1;
+			}
+		}
+		else
+		{
+			return -1;
+		}
+		next = nextItem(p, '}');
+	} while(next == 1);
+
+	if(next != 0)
+	{
+		return -1;
+	}
+	skipSpace(p);
+	if(p->pos < p->end && *p->pos != '\0')
+	{
+		return -1;
+	}
+	if(p->count == 0)
+	{
+		return -1;
+	}
+	if(p->reqType == GET)
+	{
+		return (seen == (FAST_KEY_COMMAND | FAST_KEY_NAMES)) ? 0 : -1;
+	}
+	return (seen == (FAST_KEY_COMMAND | FAST_KEY_PARAMETERS)) ? 0 : -1;
+}
+
+static int parseNames(FastParser *p)
+{
+	int next = 0;
+
+	if(expectChar(p, '[') != 0)
+	{
+		return -1;
+	}
+	do
+	{
+		skipSpace(p);
+		if(parseString(p, (p->names != NULL) ? &p->names[p->count] : NULL) != 0)
+		{
+			return -1;
+		}
+		p->count++;
+		next = nextItem(p, ']');
+	} while(next == 1);
+	return next;
+}
+
+static int parseParams(FastParser *p)
+{
+	int next = 0;
+
+	if(expectChar(p, '[') != 0)
+	{
+		return -1;
+	}
+	do
+	{
+		if(parseParam(p, (p->params != NULL) ? &p->params[p->count] : NULL) != 0)
+		{
+			return -1;
+		}
+		p->count++;
+		next = nextItem(p, ']');
+	} while(next == 1);
+	return next;
+}
+
+/*
+ * @brief parseParam reads {"name":"..","value":"..","dataType":n} in any key
+ * order, a value that is not a string sends the request to the full parser
+ */
+static int parseParam(FastParser *p, param_t *param)
+{
+	const char *key = NULL;
+	size_t keyLen = 0;
+	DATA_TYPE type = WDMP_NONE;
+	int seen = 0, next = 0;
+
+	if(expectChar(p, '{') != 0)
+	{
+		return -1;
+	}
+	do
+	{
+		if(parseKey(p, &key, &keyLen) != 0 || expectChar(p, ':') != 0)
+		{
+			return -1;
+		}
+		skipSpace(p);
+		if(isKey(key, keyLen, "name") && !(seen & FAST_KEY_NAME))
+		{
+			seen |= FAST_KEY_NAME;
+			if(parseString(p, (param != NULL) ? &param->name : NULL) != 0)
+			{
+				return -1;
+			}
+		}
+		else if(isKey(key, keyLen, "value") && !(seen & FAST_KEY_VALUE))
+		{
+			seen |= FAST_KEY_VALUE;
+			if(parseString(p, (param != NULL) ? &param->value : NULL) != 0)
+			{
+				return -1;
+			}
+		}
+		else if(isKey(key, keyLen, "dataType") && !(seen & FAST_KEY_DATATYPE))
+		{
+			seen |= FAST_KEY_DATATYPE;
+			if(parseDataType(p, &type) != 0)
+			{
+				return -1;
+			}
+			if(param != NULL)
+			{
+				param->type = type;
+			}
+		}
+		else
+		{
+			return -1;
+		}
+		next = nextItem(p, '}');
+	} while(next == 1);
+	if(next != 0)
+	{
+		return -1;
+	}
+	return (seen == (FAST_KEY_NAME | FAST_KEY_VALUE | FAST_KEY_DATATYPE)) ? 0 : -1;
+}
+
+static int parseDataType(FastParser *p, DATA_TYPE *type)
+{
+	int value = 0, digits = 0;
+
+	while(p->pos < p->end && *p->pos >= '0' && *p->pos <= '9' && digits < FAST_MAX_DATATYPE_DIGITS)
+	{
+		value = (value * 10) + (*p->pos - '0');
+		p->pos++;
+		digits++;
+	}
+	if(digits == 0 || value > WDMP_NONE || (p->pos < p->end && *p->pos >= '0' && *p->pos <= '9'))
+	{
+		return -1;
+	}
+	*type = (DATA_TYPE) value;
+	return 0;
+}
+
+/*
+ * @brief parseString reads a string value, copied into the request when out
+ * is not NULL. Strings without escapes are copied with a single memcpy.
+ */
+static int parseString(FastParser *p, char **out)
+{
+	const char *start = NULL, *quote = NULL;
+	size_t len = 0;
+
+	if(p->pos >= p->end || *p->pos != '"')
+	{
+		return -1;
+	}
+	start = p->pos + 1;
+	quote = (const char *) memchr(start, '"', p->end - start);
+	if(quote == NULL)
+	{
+		return -1;
+	}
+	if(memchr(start, '\\', quote - start) != NULL)
+	{
+		return parseEscapedString(p, out);
+	}
+	len = quote - start;
+	if(out != NULL)
+	{
+		*out = p->strings + p->stringSize;
+		memcpy(*out, start, len);
+		(*out)[len] = '\0';
+	}
+	p->stringSize += len + 1;
+	p->pos = quote + 1;
+	return 0;
+}
+
+/*
+ * @brief parseEscapedString is the slow path of parseString, \u escapes are
+ * left to the full parser
+ */
+static int parseEscapedString(FastParser *p, char **out)
+{
+	char *dst = (out != NULL) ? p->strings + p->stringSize : NULL;
+	size_t len = 0;
+	char c = '\0';
+
+	p->pos++;
+	while(p->pos < p->end && *p->pos != '"')
+	{
+		c = *p->pos++;
+		if(c == '\\')
+		{
+			if(p->pos >= p->end)
+			{
+				return -1;
+			}
+			switch(*p->pos++)
+			{
+				case '"': c = '"'; break;
+				case '\\': c = '\\'; break;
+				case '/': c = '/'; break;
+				case 'b': c = '\b'; break;
+				case 'f': c = '\f'; break;
+				case 'n': c = '\n'; break;
+				case 'r': c = '\r'; break;
+				case 't': c = '\t'; break;
+				default: return -1;
+			}
+		}
+		if(dst != NULL)
+		{
+			dst[len] = c;
+		}
+		len++;
+	}
+	if(p->pos >= p->end)
+	{
+		return -1;
+	}
+	if(dst != NULL)
+	{
+		dst[len] = '\0';
+		*out = dst;
+	}
+	p->stringSize += len + 1;
+	p->pos++;
+	return 0;
+}
+
+/*
+ * @brief parseKey reads a string without escapes and returns it in place
+ */
+static int parseKey(FastParser *p, const char **key, size_t *keyLen)
+{
+	const char *quote = NULL;
+
+	skipSpace(p);
+	if(p->pos >= p->end || *p->pos != '"')
+	{
+		return -1;
+	}
+	quote = (const char *) memchr(p->pos + 1, '"', p->end - (p->pos + 1));
+	if(quote == NULL || memchr(p->pos + 1, '\\', quote - (p->pos + 1)) != NULL)
+	{
+		return -1;
+	}
+	*key = p->pos + 1;
+	*keyLen = quote - (p->pos + 1);
+	p->pos = quote + 1;
+	return 0;
+}
+
+static int isKey(const char *key, size_t keyLen, const char *name)
+{
+	return (keyLen == strlen(name) && memcmp(key, name, keyLen) == 0);
+}
+
+/*
+ * @brief nextItem reads the separator after an item, returns 1 after ',',
+ * 0 after the closing character and -1 otherwise
+ */
+static int nextItem(FastParser *p, char close)
+{
+	skipSpace(p);
+	if(p->pos < p->end && *p->pos == ',')
+	{
+		p->pos++;
+		return 1;
+	}
+	if(p->pos < p->end && *p->pos == close)
+	{
+		p->pos++;
+		return 0;
+	}
+	return -1;
+}
+
+static int expectChar(FastParser *p, char c)
+{
+	skipSpace(p);
+	if(p->pos >= p->end || *p->pos != c)
+	{
+		return -1;
+	}
+	p->pos++;
+	return 0;
+}
+
+static void skipSpace(FastParser *p)
+{
+	while(p->pos < p->end && (*p->pos == ' ' || *p->pos == '\t' || *p->pos == '\n' || *p->pos == '\r'))
+	{
+		p->pos++;
+	}
+}
@@ -0,0 +1,499 @@
+/**
+ * @file webpa_request_queue.c
+ *
+ * @description This file describes the queue between the parodus receiver and
+ * the worker threads. The receiver keeps pulling messages while the workers
+ * process earlier requests, so requests to different components overlap and
+ * each response is sent as soon as it is ready. Requests over the admission
+ * limits are turned away at once so the server can back off. Control requests
+ * are served from their own queue so they do not wait behind bulk data pulls.
+ * Writes share the apply state of webpa and run one at a time, reads fan out.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "webpa_request_queue.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define WEBPA_REBOOT_PARAM                 "RebootDevice"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct _WebpaRequestNode
+{
+    void *request;
+    int reqType;
+    REQUEST_CLASS reqClass;
+    struct timespec queuedAt;
+    struct _WebpaRequestNode *next;
+} WebpaRequestNode;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static WebpaRequestNode *requestHead[REQUEST_CLASS_COUNT];
+static WebpaRequestNode *requestTail[REQUEST_CLASS_COUNT];
+static const unsigned int requestWeights[REQUEST_CLASS_COUNT] = {WEBPA_REQUEST_CLASS_WEIGHT_CONTROL, WEBPA_REQUEST_CLASS_WEIGHT_INTERACTIVE, WEBPA_REQUEST_CLASS_WEIGHT_BULK};
+// requests each class may still take in this round
+static unsigned int requestCredits[REQUEST_CLASS_COUNT] = {WEBPA_REQUEST_CLASS_WEIGHT_CONTROL, WEBPA_REQUEST_CLASS_WEIGHT_INTERACTIVE, WEBPA_REQUEST_CLASS_WEIGHT_BULK};
+static char bulkSources[WEBPA_REQUEST_BULK_SOURCES_MAX][WEBPA_REQUEST_SOURCE_LEN];
+static int bulkSourceCount = 0;
+static webpaRequestCB requestHandler = NULL;
+static webpaRejectCB rejectHandler = NULL;
+static pthread_mutex_t requestMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t requestCond = PTHREAD_COND_INITIALIZER;
+static int requestWorkers = 0;
+static WebpaRequestStats requestStats;
+static WebpaRequestLimits requestLimits = { WEBPA_REQUEST_MAX_IN_FLIGHT, {0}, WEBPA_REQUEST_MAX_WAIT_MS };
+// queued and active requests of each type
+static unsigned int inFlightPerType[WEBPA_REQUEST_TYPES];
+// a write is being processed, queued writes wait for it
+static int writeActive = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static void *requestWorkerTask(void *arg);
+static WebpaRequestNode * startNextRequest(int *expired);
+static void runRequest(WebpaRequestNode *node, int expired);
+static int isOverLimit(int reqType);
+static int isKnownType(int reqType);
+static int isWriteType(int reqType);
+static long waitedMs(const struct timespec *queuedAt);
+static WebpaRequestNode * takeNextNode();
+static int isBulkSource(const char *sourceService);
+static int isWildcardGet(const char *payload, size_t payloadSize);
+static int payloadContains(const char *payload, size_t payloadSize, const char *key);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void initRequestQueue(webpaRequestCB handler, webpaRejectCB reject)
+{
+	pthread_mutex_lock(&requestMutex);
+	requestHandler = handler;
+	rejectHandler = reject;
+	pthread_mutex_unlock(&requestMutex);
+}
+
+void setWebpaRequestLimits(const WebpaRequestLimits *limits)
+{
+	if(limits == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&requestMutex);
+	requestLimits = *limits;
+	pthread_mutex_unlock(&requestMutex);
+	WalInfo("Request limits maxInFlight : %u maxWaitMs : %u\n", limits->maxInFlight, limits->maxWaitMs);
+}
+
+void getWebpaRequestLimits(WebpaRequestLimits *limits)
+{
+	pthread_mutex_lock(&requestMutex);
+	*limits = requestLimits;
+	pthread_mutex_unlock(&requestMutex);
+}
+
+void setWebpaRequestBulkSources(const char **sources, int count)
+{
+	int i = 0;
+
+	pthread_mutex_lock(&requestMutex);
+	bulkSourceCount = 0;
+	for(i = 0; sources != NULL && i < count && bulkSourceCount < WEBPA_REQUEST_BULK_SOURCES_MAX; i++)
+	{
+		if(sources[i] != NULL)
+		{
+			snprintf(bulkSources[bulkSourceCount++], WEBPA_REQUEST_SOURCE_LEN, "%s", sources[i]);
+		}
+	}
+	pthread_mutex_unlock(&requestMutex);
+}
+
+REQUEST_CLASS getWebpaRequestClass(int reqType, const char *payload, size_t payloadSize, const char *sourceService)
+{
+	if(isBulkSource(sourceService))
+	{
+		return REQUEST_CLASS_BULK;
+	}
+	switch(reqType)
+	{
+		case TEST_AND_SET:
+			return REQUEST_CLASS_CONTROL;
+		case SET:
+		case SET_ATTRIBUTES:
+			if(payloadSize <= WEBPA_REQUEST_SMALL_PAYLOAD || payloadContains(payload, payloadSize, WEBPA_REBOOT_PARAM))
+			{
+				return REQUEST_CLASS_CONTROL;
+			}
+			return REQUEST_CLASS_BULK;
+		case GET:
+		case GET_ATTRIBUTES:
+			if(payloadSize > WEBPA_REQUEST_SMALL_PAYLOAD || isWildcardGet(payload, payloadSize))
+			{
+				return REQUEST_CLASS_BULK;
+			}
+			return REQUEST_CLASS_INTERACTIVE;
+		case REPLACE_ROWS:
+			return REQUEST_CLASS_BULK;
+		default:
+			return REQUEST_CLASS_INTERACTIVE;
+	}
+}
+
+int submitWebpaRequest(void *request, int reqType, REQUEST_CLASS reqClass)
+{
+	WebpaRequestNode *node = NULL;
+
+	if(request == NULL || reqClass >= REQUEST_CLASS_COUNT)
+	{
+		return -1;
+	}
+	node = (WebpaRequestNode *) malloc(sizeof(WebpaRequestNode));
+	if(node == NULL)
+	{
+		WalError("Failed to allocate request node, processing it in the receiver\n");
+		return -1;
+	}
+	node->request = request;
+	node->reqType = reqType;
+	node->reqClass = reqClass;
+	node->next = NULL;
+	clock_gettime(CLOCK_MONOTONIC, &node->queuedAt);
+
+	pthread_mutex_lock(&requestMutex);
+	// without workers nobody would pick it up
+	if(requestHandler == NULL || requestWorkers == 0)
+	{
+		pthread_mutex_unlock(&requestMutex);
+		WAL_FREE(node);
+		return -1;
+	}
+	if(isOverLimit(reqType))
+	{
+		// counted in the stats, a burst over the limits must not flood the log
+		requestStats.rejectedCount++;
+		pthread_mutex_unlock(&requestMutex);
+		WAL_FREE(node);
+		WalPrint("Request of type %d is over the request limits, rejecting it\n", reqType);
+		return 1;
+	}
+	if(requestTail[reqClass] != NULL)
+	{
+		requestTail[reqClass]->next = node;
+	}
+	else
+	{
+		requestHead[reqClass] = node;
+	}
+	requestTail[reqClass] = node;
+	if(isKnownType(reqType))
+	{
+		inFlightPerType[reqType]++;
+	}
+	requestStats.submittedCount++;
+	requestStats.submittedPerClass[reqClass]++;
+	requestStats.pendingCount++;
+	pthread_cond_signal(&requestCond);
+	pthread_mutex_unlock(&requestMutex);
+	return 0;
+}
+
+int processNextRequest()
+{
+	WebpaRequestNode *node = NULL;
+	int expired = 0;
+
+	pthread_mutex_lock(&requestMutex);
+	node = startNextRequest(&expired);
+	pthread_mutex_unlock(&requestMutex);
+	if(node == NULL)
+	{
+		return 0;
+	}
+	runRequest(node, expired);
+	return 1;
+}
+
+int startRequestWorkers(unsigned int count)
+{
+	pthread_t threadId;
+	unsigned int i = 0;
+	int started = 0, err = 0;
+
+	for(i = 0; i < count; i++)
+	{
+		err = pthread_create(&threadId, NULL, requestWorkerTask, NULL);
+		if (err != 0)
+		{
+			WalError("Error creating requestWorkerTask thread %u :[%s]\n", i, strerror(err));
+			continue;
+		}
+		pthread_mutex_lock(&requestMutex);
+		requestWorkers++;
+		pthread_mutex_unlock(&requestMutex);
+		started++;
+	}
+	WalInfo("%d request workers created Successfully\n", started);
+	return started;
+}
+
+void getWebpaRequestStats(WebpaRequestStats *stats)
+{
+	pthread_mutex_lock(&requestMutex);
+	*stats = requestStats;
+	pthread_mutex_unlock(&requestMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+static void *requestWorkerTask(void *arg)
+{
+	WebpaRequestNode *node = NULL;
+	int expired = 0;
+
+	(void) arg;
+	pthread_detach(pthread_self());
+	while(FOREVER())
+	{
+		pthread_mutex_lock(&requestMutex);
+		// queued writes are not taken while another write runs
+		while((node = startNextRequest(&expired)) == NULL)
+		{
+			pthread_cond_wait(&requestCond, &requestMutex);
+		}
+		pthread_mutex_unlock(&requestMutex);
+		runRequest(node, expired);
+	}
+	return NULL;
+}
+
+/*
+ * @brief startNextRequest takes the next request and accounts for it, caller holds requestMutex
+ * @param[out] expired 1 when the request waited too long and has to be rejected
+ */
+static WebpaRequestNode * startNextRequest(int *expired)
+{
+	WebpaRequestNode *node = takeNextNode();
+
+	*expired = 0;
+	if(node == NULL)
+	{
+		return NULL;
+	}
+	requestStats.pendingCount--;
+	// the server has most likely given up on it already
+	if(requestLimits.maxWaitMs > 0 && rejectHandler != NULL && waitedMs(&node->queuedAt) > (long) requestLimits.maxWaitMs)
+	{
+		*expired = 1;
+		requestStats.expiredCount++;
+		return node;
+	}
+	requestStats.activeCount++;
+	if(requestStats.activeCount > requestStats.maxActiveCount)
+	{
+		requestStats.maxActiveCount = requestStats.activeCount;
+	}
+	if(isWriteType(node->reqType))
+	{
+		writeActive = 1;
+	}
+	return node;
+}
+
+/*
+ * @brief runRequest processes or rejects a request taken by startNextRequest and frees its node
+ */
+static void runRequest(WebpaRequestNode *node, int expired)
+{
+	webpaRequestCB handler = NULL;
+	webpaRejectCB reject = NULL;
+
+	pthread_mutex_lock(&requestMutex);
+	handler = requestHandler;
+	reject = rejectHandler;
+	pthread_mutex_unlock(&requestMutex);
+
+	if(expired)
+	{
+		WalPrint("Request of type %d waited too long for a worker, rejecting it\n", node->reqType);
+		reject(node->request, node->reqType);
+	}
+	else
+	{
+		handler(node->request);
+	}
+
+	pthread_mutex_lock(&requestMutex);
+	if(isKnownType(node->reqType))
+	{
+		inFlightPerType[node->reqType]--;
+	}
+	if(!expired)
+	{
+		requestStats.activeCount--;
+		requestStats.completedCount++;
+		if(isWriteType(node->reqType))
+		{
+			writeActive = 0;
+			// a worker may be idle while the next write is queued
+			pthread_cond_broadcast(&requestCond);
+		}
+	}
+	pthread_mutex_unlock(&requestMutex);
+	WAL_FREE(node);
+}
+
+/*
+ * @brief isOverLimit returns 1 when one more request of the type would break a limit, caller holds requestMutex
+ */
+static int isOverLimit(int reqType)
+{
+	unsigned long inFlight = requestStats.pendingCount + requestStats.activeCount;
+
+	if(requestLimits.maxInFlight > 0 && inFlight >= requestLimits.maxInFlight)
+	{
+		return 1;
+	}
+	if(isKnownType(reqType) && requestLimits.maxPerType[reqType] > 0 && inFlightPerType[reqType] >= requestLimits.maxPerType[reqType])
+	{
+		return 1;
+	}
+	return 0;
+}
+
+static int isKnownType(int reqType)
+{
+	return (reqType >= 0 && reqType < WEBPA_REQUEST_TYPES);
+}
+
+/*
+ * @brief isWriteType returns 1 for requests that change parameters, they share the
+ * restart radio, apply settings and transaction state of webpa
+ */
+static int isWriteType(int reqType)
+{
+	switch(reqType)
+	{
+		case SET:
+		case SET_ATTRIBUTES:
+		case TEST_AND_SET:
+		case REPLACE_ROWS:
+		case ADD_ROWS:
+		case DELETE_ROW:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * @brief takeNextNode removes the oldest request of the next class by weight,
+ * skipping writes while another write runs. Caller holds requestMutex.
+ */
+static WebpaRequestNode * takeNextNode()
+{
+	WebpaRequestNode *node = NULL, *prev = NULL;
+	int i = 0, pass = 0;
+
+	// second pass starts a new round once every class with requests used up its weight
+	for(pass = 0; pass < 2; pass++)
+	{
+		for(i = 0; i < REQUEST_CLASS_COUNT; i++)
+		{
+			if(requestCredits[i] == 0)
+			{
+				continue;
+			}
+			// reads queued behind a waiting write are not held up by it
+			prev = NULL;
+			for(node = requestHead[i]; node != NULL && writeActive && isWriteType(node->reqType); node = node->next)
+			{
+				prev = node;
+			}
+			if(node != NULL)
+			{
+				if(prev != NULL)
+				{
+					prev->next = node->next;
+				}
+				else
+				{
+					requestHead[i] = node->next;
+				}
+				if(requestTail[i] == node)
+				{
+					requestTail[i] = prev;
+				}
+				requestCredits[i]--;
+				return node;
+			}
+		}
+		for(i = 0; i < REQUEST_CLASS_COUNT; i++)
+		{
+			requestCredits[i] = requestWeights[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief isBulkSource returns 1 when the source service is configured as bulk
+ */
+static int isBulkSource(const char *sourceService)
+{
+	int i = 0, found = 0;
+
+	if(sourceService == NULL)
+	{
+		return 0;
+	}
+	pthread_mutex_lock(&requestMutex);
+	for(i = 0; i < bulkSourceCount && !found; i++)
+	{
+		found = (strcmp(bulkSources[i], sourceService) == 0);
+	}
+	pthread_mutex_unlock(&requestMutex);
+	return found;
+}
+
+/*
+ * @brief isWildcardGet returns 1 when a requested name ends with a dot
+ */
+static int isWildcardGet(const char *payload, size_t payloadSize)
+{
+	return payloadContains(payload, payloadSize, ".\"");
+}
+
+static int payloadContains(const char *payload, size_t payloadSize, const char *key)
+{
+	size_t keyLen = strlen(key), i = 0;
+
+	for(i = 0; payload != NULL && i + keyLen <= payloadSize; i++)
+	{
+		if(payload[i] == key[0] && strncmp(payload + i, key, keyLen) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static long waitedMs(const struct timespec *queuedAt)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((now.tv_sec - queuedAt->tv_sec) * 1000) + ((now.tv_nsec - queuedAt->tv_nsec) / 1000000);
+}
@@ -0,0 +1,608 @@
+/**
+ * @file webpa_response_format.c
+ *
+ * @description This file describes the JSON and msgpack encodings of WebPA
+ * responses. Successful GET responses, the large ones, are written straight
+ * from the response structure instead of going through a cJSON tree, and so
+ * are msgpack error responses.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <msgpack.h>
+#include <cJSON.h>
+#include "webpa_response_format.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define WEBPA_STATUS_SUCCESS_CODE          200
+#define WEBPA_STATUS_SUCCESS_MESSAGE       "Success"
+#define WEBPA_JSON_NUMBER_LEN              24
+#define WEBPA_ERROR_STATUS_MAX             64
+#define WEBPA_ERROR_MESSAGE_LEN            128
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+/* Output of the JSON writer, buf is NULL while sizing */
+typedef struct
+{
+    char *buf;
+    size_t len;
+} JsonWriter;
+
+/* statusCode and message of the wdmp error response for one WDMP_STATUS */
+typedef struct
+{
+    int state;      /* 0 not looked up yet, 1 known, -1 not a statusCode/message response */
+    int statusCode;
+    char message[WEBPA_ERROR_MESSAGE_LEN];
+} ErrorStatus;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static ErrorStatus errorStatus[WEBPA_ERROR_STATUS_MAX];
+static pthread_mutex_t errorStatusMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static int canPackGetResponse(const res_struct *resObj);
+static void packGetResponse(msgpack_packer *pk, const res_struct *resObj);
+static int getErrorStatus(const res_struct *resObj, int *statusCode, char *message);
+static void loadErrorStatus(WDMP_STATUS status, ErrorStatus *entry);
+static void writeGetResponse(JsonWriter *w, const res_struct *resObj);
+static void writeParam(JsonWriter *w, const param_t *param, int withStatus);
+static void writeKey(JsonWriter *w, const char *key);
+static void writeString(JsonWriter *w, const char *str);
+static void writeNumber(JsonWriter *w, long long value);
+static void writeRaw(JsonWriter *w, const char *str, size_t len);
+static void packParam(msgpack_packer *pk, const param_t *param, int withStatus);
+static void packJson(msgpack_packer *pk, const cJSON *item);
+static void packString(msgpack_packer *pk, const char *str);
+static int isWildcard(const char *name);
+static int isMsgpackType(const char *contentType);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+WEBPA_RESPONSE_FORMAT getResponseFormat(const char *contentType, const headers_t *headers)
+{
+	const char *value = NULL;
+	size_t i = 0;
+
+	if(isMsgpackType(contentType))
+	{
+		return WEBPA_FORMAT_MSGPACK;
+	}
+	for(i = 0; headers != NULL && i < headers->count; i++)
+	{
+		if(headers->headers[i] != NULL && strncasecmp(headers->headers[i], WEBPA_ACCEPT_HEADER, strlen(WEBPA_ACCEPT_HEADER)) == 0)
+		{
+			value = headers->headers[i] + strlen(WEBPA_ACCEPT_HEADER);
+			while(*value == ' ')
+			{
+				value++;
+			}
+			if(isMsgpackType(value))
+			{
+				return WEBPA_FORMAT_MSGPACK;
+			}
+		}
+	}
+	return WEBPA_FORMAT_JSON;
+}
+
+int formMsgpackResponse(res_struct *resObj, char **payload, size_t *payloadSize)
+{
+	msgpack_sbuffer sbuf;
+	msgpack_packer pk;
+	char *json = NULL;
+	char message[WEBPA_ERROR_MESSAGE_LEN];
+	int ret = 0, statusCode = 0, isGet = 0;
+
+	*payload = NULL;
+	*payloadSize = 0;
+	if(resObj == NULL)
+	{
+		return -1;
+	}
+	isGet = canPackGetResponse(resObj);
+	if(!isGet && getErrorStatus(resObj, &statusCode, message) != 0)
+	{
+		// the remaining shapes are small, reuse the wdmp schema as is
+		wdmp_form_response(resObj, &json);
+		ret = convertJsonToMsgpack(json, payload, payloadSize);
+		free(json);
+		return ret;
+	}
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	if(isGet)
+	{
+		packGetResponse(&pk, resObj);
+	}
+	else
+	{
+		msgpack_pack_map(&pk, 2);
+		packString(&pk, "statusCode");
+		msgpack_pack_int(&pk, statusCode);
+		packString(&pk, "message");
+		packString(&pk, message);
+	}
+	*payloadSize = sbuf.size;
+	*payload = msgpack_sbuffer_release(&sbuf);
+	if(*payload == NULL)
+	{
+		*payloadSize = 0;
+		return -1;
+	}
+	return 0;
+}
+
+size_t estimateJsonResponseSize(const res_struct *resObj)
+{
+	JsonWriter w;
+
+	if(resObj == NULL || !canPackGetResponse(resObj))
+	{
+		return 0;
+	}
+	memset(&w, 0, sizeof(JsonWriter));
+	writeGetResponse(&w, resObj);
+	return w.len + 1;
+}
+
+int formJsonResponse(res_struct *resObj, char **payload, size_t *payloadSize)
+{
+	JsonWriter w;
+	size_t size = estimateJsonResponseSize(resObj);
+
+	*payload = NULL;
+	*payloadSize = 0;
+	if(size == 0)
+	{
+		wdmp_form_response(resObj, payload);
+		*payloadSize = (*payload != NULL) ? strlen(*payload) : 0;
+		return (*payload != NULL) ? 0 : -1;
+	}
+	memset(&w, 0, sizeof(JsonWriter));
+	w.buf = (char *) malloc(size);
+	if(w.buf == NULL)
+	{
+		return -1;
+	}
+	writeGetResponse(&w, resObj);
+	w.buf[w.len] = '\0';
+	*payload = w.buf;
+	*payloadSize = w.len;
+	return 0;
+}
+
+int convertJsonToMsgpack(const char *json, char **payload, size_t *payloadSize)
+{
+	msgpack_sbuffer sbuf;
+	msgpack_packer pk;
+	cJSON *root = NULL;
+
+	*payload = NULL;
+	*payloadSize = 0;
+	if(json == NULL || (root = cJSON_Parse(json)) == NULL)
+	{
+		WalError("Failed to parse response for msgpack encoding\n");
+		return -1;
+	}
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	packJson(&pk, root);
+	cJSON_Delete(root);
+	*payloadSize = sbuf.size;
+	*payload = msgpack_sbuffer_release(&sbuf);
+	if(*payload == NULL)
+	{
+		*payloadSize = 0;
+		return -1;
+	}
+	return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief canPackGetResponse returns 1 for a GET response where every name
+ * succeeded and has values, the only shape written without wdmp
+ */
+static int canPackGetResponse(const res_struct *resObj)
+{
+	const get_res_t *getRes = resObj->u.getRes;
+	size_t i = 0, j = 0, count = 0;
+
+	if(resObj->reqType != GET || getRes == NULL || resObj->retStatus == NULL || getRes->paramNames == NULL || getRes->params == NULL || getRes->retParamCnt == NULL || getRes->paramCnt != resObj->paramCnt)
+	{
+		return 0;
+	}
+	for(i = 0; i < getRes->paramCnt; i++)
+	{
+		if(resObj->retStatus[i] != WDMP_SUCCESS || getRes->paramNames[i] == NULL || getRes->params[i] == NULL)
+		{
+			return 0;
+		}
+		count = isWildcard(getRes->paramNames[i]) ? getRes->retParamCnt[i] : 1;
+		if(count == 0)
+		{
+			return 0;
+		}
+		for(j = 0; j < count; j++)
+		{
+			if(getRes->params[i][j].name == NULL || getRes->params[i][j].value == NULL)
+			{
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * @brief packGetResponse packs {"parameters":[...],"statusCode":200}, a name
+ * ending with a dot carries its values as an array like in the JSON response
+ */
+static void packGetResponse(msgpack_packer *pk, const res_struct *resObj)
+{
+	const get_res_t *getRes = resObj->u.getRes;
+	size_t i = 0, j = 0;
+
+	msgpack_pack_map(pk, 2);
+	packString(pk, "parameters");
+	msgpack_pack_array(pk, getRes->paramCnt);
+	for(i = 0; i < getRes->paramCnt; i++)
+	{
+		if(!isWildcard(getRes->paramNames[i]))
+		{
+			packParam(pk, &getRes->params[i][0], 1);
+			continue;
+		}
+		msgpack_pack_map(pk, 5);
+		packString(pk, "name");
+		packString(pk, getRes->paramNames[i]);
+		packString(pk, "value");
+		msgpack_pack_array(pk, getRes->retParamCnt[i]);
+		for(j = 0; j < getRes->retParamCnt[i]; j++)
+		{
+			packParam(pk, &getRes->params[i][j], 0);
+		}
+		packString(pk, "dataType");
+		msgpack_pack_int(pk, WDMP_NONE);
+		packString(pk, "parameterCount");
+		msgpack_pack_int64(pk, (int64_t) getRes->retParamCnt[i]);
+		packString(pk, "message");
+		packString(pk, WEBPA_STATUS_SUCCESS_MESSAGE);
+	}
+	packString(pk, "statusCode");
+	msgpack_pack_int(pk, WEBPA_STATUS_SUCCESS_CODE);
+}
+
+/*
+ * @brief getErrorStatus returns 0 with the statusCode and message of a failed
+ * response that wdmp answers with only those two keys, the same failure for
+ * every name and no per-name results
+ */
+static int getErrorStatus(const res_struct *resObj, int *statusCode, char *message)
+{
+	WDMP_STATUS status = WDMP_SUCCESS;
+	ErrorStatus *entry = NULL;
+	size_t i = 0;
+	int ret = -1;
+
+	if(resObj->retStatus == NULL || resObj->paramCnt == 0)
+	{
+		return -1;
+	}
+	status = resObj->retStatus[0];
+	if(status == WDMP_SUCCESS || (int) status < 0 || status >= WEBPA_ERROR_STATUS_MAX)
+	{
+		return -1;
+	}
+	for(i = 1; i < resObj->paramCnt; i++)
+	{
+		if(resObj->retStatus[i] != status)
+		{
+			return -1;
+		}
+	}
+	// SET failures list the names that failed
+	if((resObj->reqType == SET || resObj->reqType == SET_ATTRIBUTES || resObj->reqType == TEST_AND_SET) && resObj->u.paramRes != NULL && resObj->u.paramRes->params != NULL)
+	{
+		return -1;
+	}
+	pthread_mutex_lock(&errorStatusMutex);
+	entry = &errorStatus[status];
+	if(entry->state == 0)
+	{
+		loadErrorStatus(status, entry);
+	}
+	if(entry->state == 1)
+	{
+		*statusCode = entry->statusCode;
+		strcpy(message, entry->message);
+		ret = 0;
+	}
+	pthread_mutex_unlock(&errorStatusMutex);
+	return ret;
+}
+
+/*
+ * @brief loadErrorStatus asks wdmp once for the response of a failed GET so
+ * the status codes and messages stay the ones wdmp maps the status to
+ */
+static void loadErrorStatus(WDMP_STATUS status, ErrorStatus *entry)
+{
+	res_struct resObj;
+	WDMP_STATUS retStatus = status;
+	cJSON *root = NULL, *code = NULL, *message = NULL;
+	char *json = NULL;
+
+	entry->state = -1;
+	memset(&resObj, 0, sizeof(res_struct));
+	resObj.reqType = GET;
+	resObj.paramCnt = 1;
+	resObj.retStatus = &retStatus;
+	wdmp_form_response(&resObj, &json);
+	if(json == NULL || (root = cJSON_Parse(json)) == NULL)
+	{
+		free(json);
+		return;
+	}
+	code = cJSON_GetObjectItem(root, "statusCode");
+	message = cJSON_GetObjectItem(root, "message");
+	if(cJSON_GetArraySize(root) == 2 && cJSON_IsNumber(code) && code->valueint > 0 && cJSON_IsString(message) && strlen(message->valuestring) < WEBPA_ERROR_MESSAGE_LEN)
+	{
+		entry->statusCode = code->valueint;
+		strcpy(entry->message, message->valuestring);
+		entry->state = 1;
+	}
+	WalPrint("Error response for status %d : %s\n", status, json);
+	cJSON_Delete(root);
+	free(json);
+}
+
+static void packParam(msgpack_packer *pk, const param_t *param, int withStatus)
+{
+	msgpack_pack_map(pk, withStatus ? 5 : 3);
+	packString(pk, "name");
+	packString(pk, param->name);
+	packString(pk, "value");
+	packString(pk, param->value);
+	packString(pk, "dataType");
+	msgpack_pack_int(pk, param->type);
+	if(withStatus)
+	{
+		packString(pk, "parameterCount");
+		msgpack_pack_int(pk, 1);
+		packString(pk, "message");
+		packString(pk, WEBPA_STATUS_SUCCESS_MESSAGE);
+	}
+}
+
+/*
+ * @brief writeGetResponse writes the JSON of packGetResponse(), or only sizes
+ * it when w->buf is NULL. Keys and escaping follow wdmp_form_response().
+ */
+static void writeGetResponse(JsonWriter *w, const res_struct *resObj)
+{
+	const get_res_t *getRes = resObj->u.getRes;
+	size_t i = 0, j = 0;
+
+	writeRaw(w, "{\"parameters\":[", strlen("{\"parameters\":["));
+	for(i = 0; i < getRes->paramCnt; i++)
+	{
+		if(i > 0)
+		{
+			writeRaw(w, ",", 1);
+		}
+		if(!isWildcard(getRes->paramNames[i]))
+		{
+			writeParam(w, &getRes->params[i][0], 1);
+			continue;
+		}
+		writeKey(w, "{\"name\"");
+		writeString(w, getRes->paramNames[i]);
+		writeKey(w, ",\"value\"");
+		writeRaw(w, "[", 1);
+		for(j = 0; j < getRes->retParamCnt[i]; j++)
+		{
+			if(j > 0)
+			{
+				writeRaw(w, ",", 1);
+			}
+			writeParam(w, &getRes->params[i][j], 0);
+		}
+		writeRaw(w, "]", 1);
+		writeKey(w, ",\"dataType\"");
+		writeNumber(w, WDMP_NONE);
+		writeKey(w, ",\"parameterCount\"");
+		writeNumber(w, (long long) getRes->retParamCnt[i]);
+		writeKey(w, ",\"message\"");
+		writeString(w, WEBPA_STATUS_SUCCESS_MESSAGE);
+		writeRaw(w, "}", 1);
+	}
+	writeKey(w, "],\"statusCode\"");
+	writeNumber(w, WEBPA_STATUS_SUCCESS_CODE);
+	writeRaw(w, "}", 1);
+}
+
+static void writeParam(JsonWriter *w, const param_t *param, int withStatus)
+{
+	writeKey(w, "{\"name\"");
+	writeString(w, param->name);
+	writeKey(w, ",\"value\"");
+	writeString(w, param->value);
+	writeKey(w, ",\"dataType\"");
+	writeNumber(w, param->type);
+	if(withStatus)
+	{
+		writeKey(w, ",\"parameterCount\"");
+		writeNumber(w, 1);
+		writeKey(w, ",\"message\"");
+		writeString(w, WEBPA_STATUS_SUCCESS_MESSAGE);
+	}
+	writeRaw(w, "}", 1);
+}
+
+static void writeKey(JsonWriter *w, const char *key)
+{
+	writeRaw(w, key, strlen(key));
+	writeRaw(w, ":", 1);
+}
+
+/*
+ * @brief writeString writes a quoted string escaped like cJSON does, runs of
+ * plain characters are copied at once
+ */
+static void writeString(JsonWriter *w, const char *str)
+{
+	const unsigned char *run = (const unsigned char *) str;
+	const unsigned char *c = run;
+	char escape[8];
+
+	writeRaw(w, "\"", 1);
+	for(; *c != '\0'; c++)
+	{
+		if(*c >= ' ' && *c != '"' && *c != '\\')
+		{
+			continue;
+		}
+		writeRaw(w, (const char *) run, c - run);
+		run = c + 1;
+		switch(*c)
+		{
+			case '"': writeRaw(w, "\\\"", 2); break;
+			case '\\': writeRaw(w, "\\\\", 2); break;
+			case '\b': writeRaw(w, "\\b", 2); break;
+			case '\f': writeRaw(w, "\\f", 2); break;
+			case '\n': writeRaw(w, "\\n", 2); break;
+			case '\r': writeRaw(w, "\\r", 2); break;
+			case '\t': writeRaw(w, "\\t", 2); break;
+			default:
+				snprintf(escape, sizeof(escape), "\\u%04x", *c);
+				writeRaw(w, escape, 6);
+				break;
+		}
+	}
+	writeRaw(w, (const char *) run, c - run);
+	writeRaw(w, "\"", 1);
+}
+
+static void writeNumber(JsonWriter *w, long long value)
+{
+	char number[WEBPA_JSON_NUMBER_LEN];
+	int len = snprintf(number, sizeof(number), "%lld", value);
+
+	writeRaw(w, number, (size_t) len);
+}
+
+static void writeRaw(JsonWriter *w, const char *str, size_t len)
+{
+	if(w->buf != NULL)
+	{
+		memcpy(w->buf + w->len, str, len);
+	}
+	w->len += len;
+}
+
+static void packJson(msgpack_packer *pk, const cJSON *item)
+{
+	const cJSON *child = NULL;
+	size_t count = 0;
+
+	if(cJSON_IsObject(item) || cJSON_IsArray(item))
+	{
+		for(child = item->child; child != NULL; child = child->next)
+		{
+			count++;
+		}
+		if(cJSON_IsObject(item))
+		{
+			msgpack_pack_map(pk, count);
+		}
+		else
+		{
+			msgpack_pack_array(pk, count);
+		}
+		for(child = item->child; child != NULL; child = child->next)
+		{
+			if(cJSON_IsObject(item))
+			{
+				packString(pk, child->string);
+			}
+			packJson(pk, child);
+		}
+	}
+	else if(cJSON_IsString(item))
+	{
+		packString(pk, item->valuestring);
+	}
+	else if(cJSON_IsNumber(item))
+	{
+		if(item->valuedouble == (double) item->valueint)
+		{
+			msgpack_pack_int64(pk, item->valueint);
+		}
+		else
+		{
+			msgpack_pack_double(pk, item->valuedouble);
+		}
+	}
+	else if(cJSON_IsBool(item))
+	{
+		if(cJSON_IsTrue(item))
+		{
+			msgpack_pack_true(pk);
+		}
+		else
+		{
+			msgpack_pack_false(pk);
+		}
+	}
+	else
+	{
+		msgpack_pack_nil(pk);
+	}
+}
+
+static void packString(msgpack_packer *pk, const char *str)
+{
+	size_t len = (str != NULL) ? strlen(str) : 0;
+
+	msgpack_pack_str(pk, len);
+	msgpack_pack_str_body(pk, (str != NULL) ? str : "", len);
+}
+
+static int isWildcard(const char *name)
+{
+	size_t len = strlen(name);
+
+	return (len > 0 && name[len - 1] == '.');
+}
+
+/*
+ * @brief isMsgpackType returns 1 for "application/msgpack", parameters after ';' are ignored
+ */
+static int isMsgpackType(const char *contentType)
+{
+	size_t len = strlen(CONTENT_TYPE_MSGPACK);
+
+	if(contentType == NULL || strncasecmp(contentType, CONTENT_TYPE_MSGPACK, len) != 0)
+	{
+		return 0;
+	}
+	return (contentType[len] == '\0' || contentType[len] == ';' || contentType[len] == ' ' || contentType[len] == ',');
+}
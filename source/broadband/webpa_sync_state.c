@@ -0,0 +1,294 @@
+/**
+ * @file webpa_sync_state.c
+ *
+ * @description This file describes the in-memory CMC/CID sync state. Updates are
+ * visible to readers immediately and written to DB by a background thread.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "webpa_sync_state.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct
+{
+    int dirty;      /* value changed in memory and not yet persisted */
+    int storing;    /* value is being written by the persist path */
+} SyncStateItem;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static pthread_mutex_t syncStateMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t syncStateCond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t syncStoreMutex = PTHREAD_MUTEX_INITIALIZER;
+static int syncStateInitialized = 0;
+static unsigned int stateCMC = 0;
+static char stateCID[SYNC_STATE_CID_LEN] = {'\0'};
+static SyncStateItem cmcItem;
+static SyncStateItem cidItem;
+static syncStateStoreCB storeCB = NULL;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static void *syncStateWriter(void *arg);
+static int isSyncStatePending();
+static WDMP_STATUS persistPendingValues();
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+void initSyncState(unsigned int cmc, const char *cid, syncStateStoreCB store)
+{
+	int err = 0, startWriter = 0;
+	pthread_t threadId;
+
+	pthread_mutex_lock(&syncStateMutex);
+	stateCMC = cmc;
+	snprintf(stateCID, sizeof(stateCID), "%s", (cid != NULL) ? cid : "");
+	memset(&cmcItem, 0, sizeof(SyncStateItem));
+	memset(&cidItem, 0, sizeof(SyncStateItem));
+	storeCB = store;
+	startWriter = !syncStateInitialized;
+	syncStateInitialized = 1;
+	pthread_mutex_unlock(&syncStateMutex);
+	WalInfo("Sync state initialized with CMC %u CID %s\n", cmc, (cid != NULL) ? cid : "");
+
+	if(startWriter)
+	{
+		err = pthread_create(&threadId, NULL, syncStateWriter, NULL);
+		if (err != 0)
+		{
+			WalError("Error creating syncStateWriter thread :[%s]\n", strerror(err));
+		}
+	}
+}
+
+int isSyncStateInitialized()
+{
+	int initialized = 0;
+
+	pthread_mutex_lock(&syncStateMutex);
+	initialized = syncStateInitialized;
+	pthread_mutex_unlock(&syncStateMutex);
+	return initialized;
+}
+
+WDMP_STATUS getSyncStateCMC(unsigned int *cmc)
+{
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		*cmc = stateCMC;
+		status = WDMP_SUCCESS;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+	return status;
+}
+
+WDMP_STATUS getSyncStateCID(char **cid)
+{
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		*cid = strdup(stateCID);
+		status = (*cid != NULL) ? WDMP_SUCCESS : WDMP_FAILURE;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+	return status;
+}
+
+WDMP_STATUS getSyncStateValues(unsigned int *cmc, char *cid, size_t cidLen)
+{
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		*cmc = stateCMC;
+		snprintf(cid, cidLen, "%s", stateCID);
+		status = WDMP_SUCCESS;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+	return status;
+}
+
+WDMP_STATUS updateSyncStateCMC(unsigned int cmc)
+{
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		if(stateCMC != cmc)
+		{
+			stateCMC = cmc;
+			cmcItem.dirty = 1;
+			pthread_cond_signal(&syncStateCond);
+		}
+		status = WDMP_SUCCESS;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+	return status;
+}
+
+WDMP_STATUS updateSyncStateCID(const char *cid)
+{
+	WDMP_STATUS status = WDMP_FAILURE;
+
+	if(cid == NULL)
+	{
+		return status;
+	}
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		if(strcmp(stateCID, cid) != 0)
+		{
+			snprintf(stateCID, sizeof(stateCID), "%s", cid);
+			cidItem.dirty = 1;
+			pthread_cond_signal(&syncStateCond);
+		}
+		status = WDMP_SUCCESS;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+	return status;
+}
+
+void refreshSyncStateCMC(unsigned int cmc)
+{
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		stateCMC = cmc;
+		// an older value being written right now would overwrite DB, write this one after it
+		cmcItem.dirty = cmcItem.storing;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+}
+
+void refreshSyncStateCID(const char *cid)
+{
+	if(cid == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&syncStateMutex);
+	if(syncStateInitialized)
+	{
+		snprintf(stateCID, sizeof(stateCID), "%s", cid);
+		cidItem.dirty = cidItem.storing;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+}
+
+WDMP_STATUS flushSyncState()
+{
+	return persistPendingValues();
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief syncStateWriter persists values as they are updated, failed writes are
+ * retried after SYNC_STATE_STORE_RETRY_SEC
+ */
+static void *syncStateWriter(void *arg)
+{
+	pthread_detach(pthread_self());
+	(void) arg;
+
+	while(FOREVER())
+	{
+		pthread_mutex_lock(&syncStateMutex);
+		while(!isSyncStatePending())
+		{
+			pthread_cond_wait(&syncStateCond, &syncStateMutex);
+		}
+		pthread_mutex_unlock(&syncStateMutex);
+
+		if(persistPendingValues() != WDMP_SUCCESS)
+		{
+			WalError("Failed to persist sync state, retrying after %d seconds\n", SYNC_STATE_STORE_RETRY_SEC);
+			sleep(SYNC_STATE_STORE_RETRY_SEC);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * @brief isSyncStatePending returns 1 when a value is waiting to be persisted, caller holds syncStateMutex
+ */
+static int isSyncStatePending()
+{
+	return (cmcItem.dirty || cidItem.dirty) ? 1 : 0;
+}
+
+/*
+ * @brief persistPendingValues writes a snapshot of the dirty values outside of
+ * syncStateMutex so readers never wait on DB
+ */
+static WDMP_STATUS persistPendingValues()
+{
+	char cmcValue[32] = {'\0'};
+	char cidValue[SYNC_STATE_CID_LEN] = {'\0'};
+	int storeCMC = 0, storeCID = 0;
+	WDMP_STATUS status = WDMP_SUCCESS;
+	syncStateStoreCB store = NULL;
+
+	pthread_mutex_lock(&syncStoreMutex);
+	pthread_mutex_lock(&syncStateMutex);
+	store = storeCB;
+	if(cmcItem.dirty)
+	{
+		snprintf(cmcValue, sizeof(cmcValue), "%u", stateCMC);
+		cmcItem.dirty = 0;
+		cmcItem.storing = 1;
+		storeCMC = 1;
+	}
+	if(cidItem.dirty)
+	{
+		snprintf(cidValue, sizeof(cidValue), "%s", stateCID);
+		cidItem.dirty = 0;
+		cidItem.storing = 1;
+		storeCID = 1;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+
+	if(storeCMC)
+	{
+		storeCMC = (store != NULL && store(SYNC_STATE_CMC_NAME, cmcValue) == WDMP_SUCCESS) ? 0 : 1;
+	}
+	if(storeCID)
+	{
+		storeCID = (store != NULL && store(SYNC_STATE_CID_NAME, cidValue) == WDMP_SUCCESS) ? 0 : 1;
+	}
+
+	pthread_mutex_lock(&syncStateMutex);
+	cmcItem.storing = 0;
+	cidItem.storing = 0;
+	if(storeCMC || storeCID)
+	{
+		// keep failed values pending, a newer update may already have marked them
+		cmcItem.dirty |= storeCMC;
+		cidItem.dirty |= storeCID;
+		status = WDMP_FAILURE;
+	}
+	pthread_mutex_unlock(&syncStateMutex);
+	pthread_mutex_unlock(&syncStoreMutex);
+	return status;
+}
@@ -0,0 +1,530 @@
+/**
+ * @file webpa_timer.c
+ *
+ * @description This file describes a hierarchical timer wheel driven by one
+ * thread. Level 0 holds the timers due within 64 ticks, every further level
+ * covers 64 times the span of the previous one and is cascaded down when the
+ * lower level wraps around. Callbacks that block on D-Bus or sockets are
+ * scheduled as work and handed to a worker thread so they never hold up the
+ * other timers.
+ *
+ * Copyright (c) 2015  Comcast
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "webpa_timer.h"
+#include "webpa_adapter.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define WHEEL_SIZE          (1 << WEBPA_TIMER_WHEEL_BITS)
+#define WHEEL_MASK          (WHEEL_SIZE - 1)
+#define LEVEL_SPAN(level)   (1ULL << (WEBPA_TIMER_WHEEL_BITS * ((level) + 1)))
+/* Longest sleep of the timer thread so catching up never walks more than two levels of ticks */
+#define MAX_WAIT_TICKS      LEVEL_SPAN(1)
+
+/*----------------------------------------------------------------------------*/
+/*                               Data Structures                              */
+/*----------------------------------------------------------------------------*/
+typedef struct _WebpaTimer
+{
+    unsigned long id;
+    unsigned long long expires;
+    webpaTimerCB cb;
+    void *arg;
+    int work;
+    struct _WebpaTimer *next;
+} WebpaTimer;
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static WebpaTimer *timerWheel[WEBPA_TIMER_WHEEL_LEVELS][WHEEL_SIZE];
+static pthread_mutex_t timerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timerCond = PTHREAD_COND_INITIALIZER;
+static struct timespec wheelBase;
+static unsigned long long wheelTick = 0;
+static int wheelInitialized = 0;
+static int timerTaskStarted = 0;
+static unsigned long nextTimerId = 1;
+static unsigned int jitterSeed = 0;
+static WebpaTimerStats timerStats;
+static WebpaTimer *workList = NULL;
+static WebpaTimer **workTail = &workList;
+static pthread_mutex_t workMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workCond = PTHREAD_COND_INITIALIZER;
+static int workTaskStarted = 0;
+static unsigned long workPendingCount = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                             Function Prototypes                            */
+/*----------------------------------------------------------------------------*/
+static unsigned long addTimer(unsigned long delayMs, unsigned long jitterMs, webpaTimerCB cb, void *arg, int work);
+static void *webpaTimerTask(void *arg);
+static void *webpaTimerWorkTask(void *arg);
+static int startWorkTask();
+static int queueWork(WebpaTimer *timer);
+static void initWheel(struct timespec *now);
+static unsigned long long getElapsedMs(struct timespec *now);
+static unsigned long long getTick(struct timespec *now);
+static void addToWheel(WebpaTimer *timer);
+static void cascadeSlot(int level, int index);
+static WebpaTimer * advanceTick();
+static int getNextExpiry(unsigned long long *expires);
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+unsigned long scheduleWebpaTimer(unsigned long delayMs, unsigned long jitterMs, webpaTimerCB cb, void *arg)
+{
+	return addTimer(delayMs, jitterMs, cb, arg, 0);
+}
+
+unsigned long scheduleWebpaWork(unsigned long delayMs, unsigned long jitterMs, webpaTimerCB cb, void *arg)
+{
+	if(cb == NULL)
+	{
+		return 0;
+	}
+	if(startWorkTask() != 0)
+	{
+		WalError("Timer work task is not running, work runs on the timer thread\n");
+	}
+	return addTimer(delayMs, jitterMs, cb, arg, 1);
+}
+
+int cancelWebpaTimer(unsigned long timerId)
+{
+	WebpaTimer **link = NULL, *timer = NULL;
+	int level = 0, index = 0;
+
+	if(timerId == 0)
+	{
+		return -1;
+	}
+	pthread_mutex_lock(&timerMutex);
+	for(level = 0; level < WEBPA_TIMER_WHEEL_LEVELS && timer == NULL; level++)
+	{
+		for(index = 0; index < WHEEL_SIZE && timer == NULL; index++)
+		{
+			for(link = &timerWheel[level][index]; *link != NULL; link = &(*link)->next)
+			{
+				if((*link)->id == timerId)
+				{
+					timer = *link;
+					*link = timer->next;
+					break;
+				}
+			}
+		}
+	}
+	if(timer != NULL)
+	{
+		timerStats.pendingCount--;
+		timerStats.cancelledCount++;
+	}
+	pthread_mutex_unlock(&timerMutex);
+
+	if(timer == NULL)
+	{
+		return -1;
+	}
+	WAL_FREE(timer);
+	return 0;
+}
+
+int runWebpaTimers()
+{
+	WebpaTimer *expired = NULL, **tail = &expired, *timer = NULL;
+	struct timespec now;
+	unsigned long long nowTick = 0;
+	int count = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&timerMutex);
+	initWheel(&now);
+	nowTick = getTick(&now);
+	if(timerStats.pendingCount == 0 && wheelTick < nowTick)
+	{
+		wheelTick = nowTick;
+	}
+	while(wheelTick <= nowTick)
+	{
+		*tail = advanceTick();
+		while(*tail != NULL)
+		{
+			tail = &(*tail)->next;
+			timerStats.pendingCount--;
+			timerStats.firedCount++;
+		}
+	}
+	pthread_mutex_unlock(&timerMutex);
+
+	// callbacks run without the lock so they can schedule or cancel timers
+	while(expired != NULL)
+	{
+		timer = expired;
+		expired = timer->next;
+		count++;
+		if(timer->work && queueWork(timer) == 0)
+		{
+			continue;
+		}
+		timer->cb(timer->arg);
+		WAL_FREE(timer);
+	}
+	return count;
+}
+
+void startWebpaTimerTask()
+{
+	pthread_condattr_t attr;
+	pthread_t threadId;
+	int err = 0;
+
+	pthread_mutex_lock(&timerMutex);
+	if(timerTaskStarted)
+	{
+		pthread_mutex_unlock(&timerMutex);
+		return;
+	}
+	// waits are measured on CLOCK_MONOTONIC like the wheel ticks
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_destroy(&timerCond);
+	pthread_cond_init(&timerCond, &attr);
+	pthread_condattr_destroy(&attr);
+	timerTaskStarted = 1;
+	pthread_mutex_unlock(&timerMutex);
+
+	err = pthread_create(&threadId, NULL, webpaTimerTask, NULL);
+	if (err != 0)
+	{
+		WalError("Error creating webpaTimerTask thread :[%s]\n", strerror(err));
+	}
+	else
+	{
+		WalInfo("webpaTimerTask thread created Successfully\n");
+	}
+}
+
+void getWebpaTimerStats(WebpaTimerStats *stats)
+{
+	pthread_mutex_lock(&timerMutex);
+	*stats = timerStats;
+	pthread_mutex_unlock(&timerMutex);
+	pthread_mutex_lock(&workMutex);
+	stats->workPendingCount = workPendingCount;
+	pthread_mutex_unlock(&workMutex);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                               Internal functions                           */
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief addTimer puts a timer on the wheel, work timers are run by the work task
+ */
+static unsigned long addTimer(unsigned long delayMs, unsigned long jitterMs, webpaTimerCB cb, void *arg, int work)
+{
+	WebpaTimer *timer = NULL;
+	struct timespec now;
+	unsigned long long delay = delayMs;
+	unsigned long id = 0;
+
+	if(cb == NULL)
+	{
+		return 0;
+	}
+	timer = (WebpaTimer *) malloc(sizeof(WebpaTimer));
+	if(timer == NULL)
+	{
+		WalError("Failed to allocate timer\n");
+		return 0;
+	}
+	memset(timer, 0, sizeof(WebpaTimer));
+	timer->cb = cb;
+	timer->arg = arg;
+	timer->work = work;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&timerMutex);
+	initWheel(&now);
+	// an empty wheel skips the idle ticks instead of walking them later
+	if(timerStats.pendingCount == 0)
+	{
+		wheelTick = getTick(&now);
+	}
+	if(jitterMs > 0)
+	{
+		delay += (unsigned long) rand_r(&jitterSeed) % (jitterMs + 1);
+	}
+	// rounded up so a timer never fires before its delay
+	timer->expires = (getElapsedMs(&now) + delay + WEBPA_TIMER_TICK_MSEC - 1) / WEBPA_TIMER_TICK_MSEC;
+	id = nextTimerId++;
+	if(nextTimerId == 0)
+	{
+		nextTimerId = 1;
+	}
+	timer->id = id;
+	addToWheel(timer);
+	timerStats.pendingCount++;
+	// the thread may sleep past the new expiry, let it recompute its deadline
+	if(timerTaskStarted)
+	{
+		pthread_cond_signal(&timerCond);
+	}
+	pthread_mutex_unlock(&timerMutex);
+	WalPrint("Timer %lu scheduled after %llu ms\n", id, delay);
+	return id;
+}
+
+static void *webpaTimerTask(void *arg)
+{
+	unsigned long long expires = 0, ticks = 0;
+	struct timespec deadline;
+
+	(void) arg;
+	pthread_detach(pthread_self());
+	while(FOREVER())
+	{
+		runWebpaTimers();
+
+		// deadline is taken under the lock so a newly scheduled timer is never missed
+		pthread_mutex_lock(&timerMutex);
+		if(!getNextExpiry(&expires))
+		{
+			pthread_cond_wait(&timerCond, &timerMutex);
+		}
+		else
+		{
+			ticks = (expires > wheelTick + MAX_WAIT_TICKS) ? wheelTick + MAX_WAIT_TICKS : expires;
+			deadline = wheelBase;
+			deadline.tv_sec += (time_t) (ticks * WEBPA_TIMER_TICK_MSEC / 1000);
+			deadline.tv_nsec += (long) (ticks * WEBPA_TIMER_TICK_MSEC % 1000) * 1000000;
+			if(deadline.tv_nsec >= 1000000000)
+			{
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000;
+			}
+			pthread_cond_timedwait(&timerCond, &timerMutex, &deadline);
+		}
+		pthread_mutex_unlock(&timerMutex);
+	}
+	return NULL;
+}
+
+/*
+ * @brief webpaTimerWorkTask runs the expired work timers one at a time, off the timer thread
+ */
+static void *webpaTimerWorkTask(void *arg)
+{
+	WebpaTimer *timer = NULL;
+
+	(void) arg;
+	pthread_detach(pthread_self());
+	while(FOREVER())
+	{
+		pthread_mutex_lock(&workMutex);
+		while(workList == NULL)
+		{
+			pthread_cond_wait(&workCond, &workMutex);
+		}
+		timer = workList;
+		workList = timer->next;
+		if(workList == NULL)
+		{
+			workTail = &workList;
+		}
+		workPendingCount--;
+		pthread_mutex_unlock(&workMutex);
+
+		timer->cb(timer->arg);
+		WAL_FREE(timer);
+	}
+	return NULL;
+}
+
+/*
+ * @brief startWorkTask starts the work thread once
+ * @return 0 when the work thread is running, -1 otherwise
+ */
+static int startWorkTask()
+{
+	pthread_t threadId;
+	int err = 0;
+
+	pthread_mutex_lock(&workMutex);
+	if(!workTaskStarted)
+	{
+		err = pthread_create(&threadId, NULL, webpaTimerWorkTask, NULL);
+		if(err != 0)
+		{
+			WalError("Error creating webpaTimerWorkTask thread :[%s]\n", strerror(err));
+		}
+		else
+		{
+			workTaskStarted = 1;
+			WalInfo("webpaTimerWorkTask thread created Successfully\n");
+		}
+	}
+	pthread_mutex_unlock(&workMutex);
+	return workTaskStarted ? 0 : -1;
+}
+
+/*
+ * @brief queueWork hands an expired work timer to the work thread
+ * @return 0 when queued, -1 when there is no work thread to run it
+ */
+static int queueWork(WebpaTimer *timer)
+{
+	pthread_mutex_lock(&workMutex);
+	if(!workTaskStarted)
+	{
+		pthread_mutex_unlock(&workMutex);
+		return -1;
+	}
+	timer->next = NULL;
+	*workTail = timer;
+	workTail = &timer->next;
+	workPendingCount++;
+	pthread_cond_signal(&workCond);
+	pthread_mutex_unlock(&workMutex);
+	return 0;
+}
+
+/*
+ * @brief initWheel sets tick 0 of the wheel at the first use, caller holds timerMutex
+ */
+static void initWheel(struct timespec *now)
+{
+	if(!wheelInitialized)
+	{
+		wheelBase = *now;
+		wheelTick = 0;
+		jitterSeed = (unsigned int) (now->tv_sec ^ now->tv_nsec);
+		wheelInitialized = 1;
+	}
+}
+
+static unsigned long long getElapsedMs(struct timespec *now)
+{
+	long long elapsedMs = (long long) (now->tv_sec - wheelBase.tv_sec) * 1000 + (now->tv_nsec - wheelBase.tv_nsec) / 1000000;
+
+	return (elapsedMs > 0) ? (unsigned long long) elapsedMs : 0;
+}
+
+static unsigned long long getTick(struct timespec *now)
+{
+	return getElapsedMs(now) / WEBPA_TIMER_TICK_MSEC;
+}
+
+/*
+ * @brief addToWheel puts a timer in the lowest level that spans its expiry. Timers
+ * beyond the top level wait in its last slot and are placed again when it cascades.
+ * Caller holds timerMutex.
+ */
+static void addToWheel(WebpaTimer *timer)
+{
+	unsigned long long delta = (timer->expires > wheelTick) ? timer->expires - wheelTick : 0;
+	unsigned long long slotTick = (delta > 0) ? timer->expires : wheelTick;
+	int level = 0, index = 0;
+
+	while(level < WEBPA_TIMER_WHEEL_LEVELS && delta >= LEVEL_SPAN(level))
+	{
+		level++;
+	}
+	if(level == WEBPA_TIMER_WHEEL_LEVELS)
+	{
+		level = WEBPA_TIMER_WHEEL_LEVELS - 1;
+		slotTick = wheelTick + LEVEL_SPAN(level) - 1;
+	}
+	index = (int) ((slotTick >> (WEBPA_TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+	timer->next = timerWheel[level][index];
+	timerWheel[level][index] = timer;
+}
+
+/*
+ * @brief cascadeSlot moves the timers of a higher level slot down, caller holds timerMutex
+ */
+static void cascadeSlot(int level, int index)
+{
+	WebpaTimer *timer = timerWheel[level][index], *next = NULL;
+
+	timerWheel[level][index] = NULL;
+	while(timer != NULL)
+	{
+		next = timer->next;
+		addToWheel(timer);
+		timer = next;
+	}
+}
+
+/*
+ * @brief advanceTick processes the current tick and returns its expired timers, caller holds timerMutex
+ */
+static WebpaTimer * advanceTick()
+{
+	WebpaTimer *timer = NULL, *next = NULL, *expired = NULL, **tail = &expired;
+	int index = (int) (wheelTick & WHEEL_MASK), level = 0, levelIndex = 0;
+
+	// level 0 wrapped around, refill it from the levels above
+	for(level = 1; index == 0 && level < WEBPA_TIMER_WHEEL_LEVELS; level++)
+	{
+		levelIndex = (int) ((wheelTick >> (WEBPA_TIMER_WHEEL_BITS * level)) & WHEEL_MASK);
+		cascadeSlot(level, levelIndex);
+		if(levelIndex != 0)
+		{
+			break;
+		}
+	}
+
+	timer = timerWheel[0][index];
+	timerWheel[0][index] = NULL;
+	wheelTick++;
+	while(timer != NULL)
+	{
+		next = timer->next;
+		if(timer->expires < wheelTick)
+		{
+			timer->next = NULL;
+			*tail = timer;
+			tail = &timer->next;
+		}
+		else
+		{
+			addToWheel(timer);
+		}
+		timer = next;
+	}
+	return expired;
+}
+
+/*
+ * @brief getNextExpiry finds the earliest pending expiry, caller holds timerMutex
+ */
+static int getNextExpiry(unsigned long long *expires)
+{
+	WebpaTimer *timer = NULL;
+	int level = 0, index = 0, found = 0;
+
+	for(level = 0; level < WEBPA_TIMER_WHEEL_LEVELS; level++)
+	{
+		for(index = 0; index < WHEEL_SIZE; index++)
+		{
+			for(timer = timerWheel[level][index]; timer != NULL; timer = timer->next)
+			{
+				if(!found || timer->expires < *expires)
+				{
+					*expires = timer->expires;
+					found = 1;
+				}
+			}
+		}
+	}
+	return found;
+}
@@ -50,6 +50,12 @@ typedef enum
     WEBPA_ATOMIC_SET_WEBCONFIG
 } WEBPA_SET_TYPE;
 
+typedef enum
+{
+    WEBPA_FORMAT_JSON = 0,
+    WEBPA_FORMAT_MSGPACK
+} WEBPA_RESPONSE_FORMAT;
+
 /**
  * @brief Initializes the Message Bus and registers WebPA component with the stack.
  *
@@ -106,6 +112,45 @@ long timeValDiff(struct timespec *starttime, struct timespec *finishtime);
  */
 void processRequest(char *reqPayload, char *transactionId, char **resPayload, headers_t *req_headers, headers_t *res_headers);
 
+/**
+ * @brief processRequestFormat processes the request and returns the response
+ * payload in the asked encoding
+ *
+ * @param[in] reqPayload input request to process
+ * @param[in] format response encoding asked for
+ * @param[out] resPayload response payload
+ * @param[out] resPayloadSize response payload length, may be NULL
+ * @return encoding used, JSON when msgpack encoding failed
+ */
+WEBPA_RESPONSE_FORMAT processRequestFormat(char *reqPayload, char *transactionId, WEBPA_RESPONSE_FORMAT format, char **resPayload, size_t *resPayloadSize, headers_t *req_headers, headers_t *res_headers);
+
+/**
+ * @brief getRequestType reads the command of a request payload without
+ * parsing the whole request
+ *
+ * @param[in] payload request payload
+ * @param[in] payloadSize payload length
+ * @return REQ_TYPE of the command, -1 when it is missing or unknown
+ */
+int getRequestType(const char *payload, size_t payloadSize);
+
+/**
+ * @brief getRequestTypeByName maps a command name such as "GET" to its REQ_TYPE
+ *
+ * @param[in] command command name
+ * @return REQ_TYPE of the command, -1 when it is unknown
+ */
+int getRequestTypeByName(const char *command);
+
+/**
+ * @brief formRejectResponse forms the response of a request that is not processed
+ *
+ * @param[in] reqType REQ_TYPE of the request, -1 when unknown
+ * @param[in] status status to report, e.g. WDMP_ERR_MAX_REQUEST
+ * @param[out] resPayload response payload, NULL on allocation failure
+ */
+void formRejectResponse(int reqType, WDMP_STATUS status, char **resPayload);
+
 /**
  * @brief getValues Returns the parameter values from stack for GET request
  *
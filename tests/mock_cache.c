@@ -71,6 +71,7 @@ void getCompDetails()
         SubComponentValArray[i].comp_name=subCompNameList[i];
         SubComponentValArray[i].dbus_path=subDbusPathList[i];
     }
+    publishComponentValCache();
 }
 
 componentStruct_t **getDeviceInfoCompDetails()
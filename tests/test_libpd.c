@@ -28,6 +28,7 @@
 
 #include "../source/include/webpa_adapter.h"
 #include "../source/app/libpd.h"
+#include "../source/broadband/include/webpa_notify_retry.h"
 #include <cimplog/cimplog.h>
 #include <libparodus.h>
 
@@ -43,6 +44,10 @@
 extern libpd_instance_t current_instance;
 extern int wakeUpFlag;
 int numLoops=1;
+static char sentSource[64];
+static char sentDest[64];
+static char sentTransId[64];
+static char sentContentType[32];
 /*----------------------------------------------------------------------------*/
 /*                                   Mocks                                    */
 /*----------------------------------------------------------------------------*/
@@ -104,6 +109,38 @@ void processRequest(char *reqPayload, char *transactionId, char **resPayload, he
     }
 }
 
+WEBPA_RESPONSE_FORMAT processRequestFormat(char *reqPayload, char *transactionId, WEBPA_RESPONSE_FORMAT format, char **resPayload, size_t *resPayloadSize, headers_t *req_headers, headers_t *res_headers)
+{
+    UNUSED(format);
+    processRequest(reqPayload, transactionId, resPayload, req_headers, res_headers);
+    if(resPayloadSize != NULL)
+    {
+        *resPayloadSize = (*resPayload != NULL) ? strlen(*resPayload) : 0;
+    }
+    return WEBPA_FORMAT_JSON;
+}
+
+WEBPA_RESPONSE_FORMAT getResponseFormat(const char *contentType, const headers_t *headers)
+{
+    UNUSED(contentType);
+    UNUSED(headers);
+    return WEBPA_FORMAT_JSON;
+}
+
+int getRequestType(const char *payload, size_t payloadSize)
+{
+    UNUSED(payload);
+    UNUSED(payloadSize);
+    return GET;
+}
+
+void formRejectResponse(int reqType, WDMP_STATUS status, char **resPayload)
+{
+    UNUSED(reqType);
+    UNUSED(status);
+    *resPayload = strdup("{\"statusCode\":520,\"message\":\"Max request limit reached\"}");
+}
+
 int libparodus_init (libpd_instance_t *instance, libpd_cfg_t *libpd_cfg)
 {
     UNUSED(instance);
@@ -114,7 +151,13 @@ int libparodus_init (libpd_instance_t *instance, libpd_cfg_t *libpd_cfg)
 int libparodus_send (libpd_instance_t instance, wrp_msg_t *msg)
 {
     UNUSED(instance);
-    UNUSED(msg);
+    if(msg->msg_type == WRP_MSG_TYPE__REQ)
+    {
+        snprintf(sentSource, sizeof(sentSource), "%s", msg->u.req.source);
+        snprintf(sentDest, sizeof(sentDest), "%s", msg->u.req.dest);
+        snprintf(sentTransId, sizeof(sentTransId), "%s", msg->u.req.transaction_uuid);
+        snprintf(sentContentType, sizeof(sentContentType), "%s", msg->u.req.content_type);
+    }
     function_called();
     return (int) mock();
 }
@@ -194,15 +237,17 @@ void err_sendNotification()
     char *source =  (char *) malloc(sizeof(char)*16);
     char *payload =  (char *) malloc(sizeof(char)*100);
     char destination[16] = "destination";
+    NotifyRetryStats stats;
     strcpy(source, "source");
     strcpy(payload, "Hello Webpa!");
 
+    // failed send is handed to the retry task instead of being retried in place
     will_return(libparodus_send, (intptr_t)-404);
-    will_return(libparodus_send, (intptr_t)-404);
-    will_return(libparodus_send, (intptr_t)-404);
-    will_return(libparodus_send, (intptr_t)-404);
-    expect_function_calls(libparodus_send, 4);
+    expect_function_calls(libparodus_send, 1);
     sendNotification(payload, source, destination);
+    getNotifyRetryStats(&stats);
+    assert_int_equal(1, stats.pendingCount);
+    assert_int_equal(1, runNotifyRetries());
 }
 
 void test_getConnCloudStatus()
@@ -256,6 +301,10 @@ void test_parallelProcessTask()
     will_return(libparodus_send, (intptr_t)0);
     expect_function_call(libparodus_send);
     parallelProcessTask(NULL);             
+    assert_string_equal("mac:dcebxxxxxxxx/config", sentSource);
+    assert_string_equal("dns:uvxyz.webpa.comcast.net", sentDest);
+    assert_string_equal("RYjWZTaP4TTTkZ6HhwjGLA", sentTransId);
+    assert_string_equal("application/json", sentContentType);
 }
 
 void test_cloudstatus_parallelProcessTask()
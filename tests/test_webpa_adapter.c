@@ -237,6 +237,49 @@ void test_processRequest_WildcardsGet()
     cJSON_Delete(response);
 }
 
+void test_getRequestType()
+{
+    const char *getPayload = "{\"names\":[\"Device.DeviceInfo.Webpa.\"],\"command\":\"GET\"}";
+    const char *attrPayload = "{\"names\":[\"Device.DeviceInfo.Webpa.\"], \"command\" : \"GET_ATTRIBUTES\"}";
+    const char *addPayload = "{\"row\":{\"DeviceName\":\"Device1\"},\"command\":\"ADD_ROW\",\"table\":\"Device.X.Table.\"}";
+
+    assert_int_equal(GET, getRequestType(getPayload, strlen(getPayload)));
+    assert_int_equal(GET_ATTRIBUTES, getRequestType(attrPayload, strlen(attrPayload)));
+    assert_int_equal(ADD_ROWS, getRequestType(addPayload, strlen(addPayload)));
+    assert_int_equal(TEST_AND_SET, getRequestTypeByName("TEST_AND_SET"));
+    assert_int_equal(REPLACE_ROWS, getRequestTypeByName("REPLACE_ROWS"));
+}
+
+void test_formRejectResponse()
+{
+    char *resPayload = NULL;
+    cJSON *response = NULL;
+
+    formRejectResponse(GET, WDMP_ERR_MAX_REQUEST, &resPayload);
+    assert_non_null(resPayload);
+    response = cJSON_Parse(resPayload);
+    assert_non_null(response);
+    assert_non_null(cJSON_GetObjectItem(response, "statusCode"));
+    assert_int_not_equal(200, cJSON_GetObjectItem(response, "statusCode")->valueint);
+    cJSON_Delete(response);
+    free(resPayload);
+}
+
+void err_getRequestType()
+{
+    const char *noCommand = "{\"names\":[\"Device.DeviceInfo.Webpa.\"]}";
+    const char *badCommand = "{\"command\":\"GETX\"}";
+    const char *cutPayload = "{\"command\":\"GET\"}";
+
+    assert_int_equal(-1, getRequestType(NULL, 0));
+    assert_int_equal(-1, getRequestType(noCommand, strlen(noCommand)));
+    assert_int_equal(-1, getRequestType(badCommand, strlen(badCommand)));
+    // the command value is past the payload size
+    assert_int_equal(-1, getRequestType(cutPayload, 14));
+    assert_int_equal(-1, getRequestTypeByName("DELETE"));
+    assert_int_equal(-1, getRequestTypeByName(NULL));
+}
+
 /*----------------------------------------------------------------------------*/
 /*                             External Functions                             */
 /*----------------------------------------------------------------------------*/
@@ -246,6 +289,9 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_processRequest_singleGet),
         cmocka_unit_test(test_processRequest_WildcardsGet),
+        cmocka_unit_test(test_getRequestType),
+        cmocka_unit_test(test_formRejectResponse),
+        cmocka_unit_test(err_getRequestType),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,231 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_attribute_cache.h"
+
+#define UNUSED(x) (void )(x)
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static time_t monotonicNow = 1000;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+int clock_gettime(clockid_t clockId, struct timespec *now)
+{
+    UNUSED(clockId);
+    now->tv_sec = monotonicNow;
+    now->tv_nsec = 0;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+static int lookupNotify(const char *name)
+{
+    int notification = -1;
+
+    if(lookupAttrCache(name, &notification) != 0)
+    {
+        return -1;
+    }
+    return notification;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_attrCacheHitAndMiss()
+{
+    AttrCacheStats before, after;
+
+    invalidateAttrCache(NULL);
+    getAttrCacheStats(&before);
+    addAttrCache("Device.DeviceInfo.Webpa.Enable", "eRT.com.cisco.spvtg.ccsp.pam", 1);
+    addAttrCache("Device.WiFi.SSID.10001.SSID", "eRT.com.cisco.spvtg.ccsp.wifi", 0);
+
+    assert_int_equal(1, lookupNotify("Device.DeviceInfo.Webpa.Enable"));
+    assert_int_equal(0, lookupNotify("Device.WiFi.SSID.10001.SSID"));
+    assert_int_equal(-1, lookupNotify("Device.DeviceInfo.Webpa.Version"));
+    assert_int_equal(-1, lookupNotify("Device.DeviceInfo.Webpa."));
+    // a later set replaces the mirrored attribute
+    addAttrCache("Device.DeviceInfo.Webpa.Enable", "eRT.com.cisco.spvtg.ccsp.pam", 0);
+    assert_int_equal(0, lookupNotify("Device.DeviceInfo.Webpa.Enable"));
+
+    getAttrCacheStats(&after);
+    assert_int_equal(2, after.entryCount);
+    assert_int_equal(3, after.hitCount - before.hitCount);
+    assert_int_equal(2, after.missCount - before.missCount);
+    invalidateAttrCache(NULL);
+}
+
+void test_attrCacheExpiry()
+{
+    AttrCacheStats before, after;
+
+    invalidateAttrCache(NULL);
+    getAttrCacheStats(&before);
+    addAttrCache("Device.DeviceInfo.Webpa.Enable", "eRT.com.cisco.spvtg.ccsp.pam", 1);
+    monotonicNow += WEBPA_ATTR_CACHE_TTL_SEC - 1;
+    assert_int_equal(1, lookupNotify("Device.DeviceInfo.Webpa.Enable"));
+    // a hit does not extend the entry, it may have been changed over TR-069
+    monotonicNow += 1;
+    assert_int_equal(-1, lookupNotify("Device.DeviceInfo.Webpa.Enable"));
+
+    getAttrCacheStats(&after);
+    assert_int_equal(0, after.entryCount);
+    assert_int_equal(1, after.expiredCount - before.expiredCount);
+    // setting it again starts a new period
+    addAttrCache("Device.DeviceInfo.Webpa.Enable", "eRT.com.cisco.spvtg.ccsp.pam", 0);
+    assert_int_equal(0, lookupNotify("Device.DeviceInfo.Webpa.Enable"));
+    invalidateAttrCache(NULL);
+}
+
+void test_attrCacheEvictsLeastRecentlyUsed()
+{
+    AttrCacheStats before, after;
+    char name[64];
+    int i = 0;
+
+    invalidateAttrCache(NULL);
+    getAttrCacheStats(&before);
+    for(i = 0; i < WEBPA_ATTR_CACHE_MAX_ENTRIES; i++)
+    {
+        snprintf(name, sizeof(name), "Device.X_RDK_Test.%d.Enable", i);
+        addAttrCache(name, "eRT.com.test", i % 2);
+    }
+    // touch the oldest so the second oldest goes first
+    assert_int_equal(0, lookupNotify("Device.X_RDK_Test.0.Enable"));
+    addAttrCache("Device.X_RDK_New.Enable", "eRT.com.test", 1);
+
+    assert_int_equal(0, lookupNotify("Device.X_RDK_Test.0.Enable"));
+    assert_int_equal(-1, lookupNotify("Device.X_RDK_Test.1.Enable"));
+    assert_int_equal(0, lookupNotify("Device.X_RDK_Test.2.Enable"));
+    assert_int_equal(1, lookupNotify("Device.X_RDK_New.Enable"));
+
+    getAttrCacheStats(&after);
+    assert_int_equal(WEBPA_ATTR_CACHE_MAX_ENTRIES, after.entryCount);
+    assert_int_equal(1, after.evictionCount - before.evictionCount);
+    invalidateAttrCache(NULL);
+}
+
+void test_attrCacheCollidingNames()
+{
+    AttrCacheStats stats;
+    char name[64];
+    int i = 0;
+
+    // more entries than buckets, every bucket holds a chain
+    invalidateAttrCache(NULL);
+    for(i = 0; i < WEBPA_ATTR_CACHE_MAX_ENTRIES; i++)
+    {
+        snprintf(name, sizeof(name), "Device.X_RDK_Test.%d.Enable", i);
+        addAttrCache(name, (i % 2) ? "eRT.com.test.odd" : "eRT.com.test.even", i % 2);
+    }
+    for(i = 0; i < WEBPA_ATTR_CACHE_MAX_ENTRIES; i++)
+    {
+        snprintf(name, sizeof(name), "Device.X_RDK_Test.%d.Enable", i);
+        assert_int_equal(i % 2, lookupNotify(name));
+    }
+    // dropping entries from the chains keeps the ones next to them
+    assert_int_equal(WEBPA_ATTR_CACHE_MAX_ENTRIES / 2, invalidateAttrCache("eRT.com.test.odd"));
+    for(i = 0; i < WEBPA_ATTR_CACHE_MAX_ENTRIES; i++)
+    {
+        snprintf(name, sizeof(name), "Device.X_RDK_Test.%d.Enable", i);
+        assert_int_equal((i % 2) ? -1 : 0, lookupNotify(name));
+    }
+    getAttrCacheStats(&stats);
+    assert_int_equal(WEBPA_ATTR_CACHE_MAX_ENTRIES / 2, stats.entryCount);
+    assert_int_equal(WEBPA_ATTR_CACHE_MAX_ENTRIES / 2, invalidateAttrCache(NULL));
+    getAttrCacheStats(&stats);
+    assert_int_equal(0, stats.entryCount);
+}
+
+void test_attrCacheInvalidatePrefix()
+{
+    AttrCacheStats stats;
+
+    invalidateAttrCache(NULL);
+    addAttrCache("Device.WiFi.SSID.10001.Enable", "eRT.com.cisco.spvtg.ccsp.wifi", 1);
+    addAttrCache("Device.WiFi.SSID.10001.SSID", "eRT.com.cisco.spvtg.ccsp.wifi", 1);
+    addAttrCache("Device.WiFi.SSID.100010.Enable", "eRT.com.cisco.spvtg.ccsp.wifi", 1);
+    addAttrCache("Device.WiFi.SSID.10002.Enable", "eRT.com.cisco.spvtg.ccsp.wifi", 1);
+
+    // an object name stands for every leaf below it
+    addAttrCache("Device.WiFi.SSID.10001.", "eRT.com.cisco.spvtg.ccsp.wifi", 0);
+    assert_int_equal(-1, lookupNotify("Device.WiFi.SSID.10001.Enable"));
+    assert_int_equal(-1, lookupNotify("Device.WiFi.SSID.10001.SSID"));
+    assert_int_equal(1, lookupNotify("Device.WiFi.SSID.100010.Enable"));
+    assert_int_equal(1, lookupNotify("Device.WiFi.SSID.10002.Enable"));
+
+    // a leaf name only drops itself
+    addAttrCache("Device.WiFi.SSID.10002.EnableOnline", "eRT.com.cisco.spvtg.ccsp.wifi", 1);
+    assert_int_equal(1, invalidateAttrCacheByName("Device.WiFi.SSID.10002.Enable"));
+    assert_int_equal(1, lookupNotify("Device.WiFi.SSID.10002.EnableOnline"));
+    assert_int_equal(2, invalidateAttrCacheByName("Device.WiFi."));
+    getAttrCacheStats(&stats);
+    assert_int_equal(0, stats.entryCount);
+}
+
+void err_attrCacheInvalidEntries()
+{
+    AttrCacheStats stats;
+    int notification = 0;
+
+    invalidateAttrCache(NULL);
+    addAttrCache(NULL, "eRT.com.test", 1);
+    addAttrCache("Device.X_RDK_Test.Enable", NULL, 1);
+    addAttrCache("", "eRT.com.test", 1);
+    assert_int_equal(-1, lookupAttrCache(NULL, &notification));
+    assert_int_equal(-1, lookupAttrCache("", &notification));
+    assert_int_equal(-1, lookupNotify("Device.X_RDK_Test.Enable"));
+    assert_int_equal(0, invalidateAttrCacheByName(NULL));
+    assert_int_equal(0, invalidateAttrCacheByName(""));
+    assert_int_equal(0, invalidateAttrCache("eRT.com.test"));
+    getAttrCacheStats(&stats);
+    assert_int_equal(0, stats.entryCount);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_attrCacheHitAndMiss),
+        cmocka_unit_test(test_attrCacheExpiry),
+        cmocka_unit_test(test_attrCacheEvictsLeastRecentlyUsed),
+        cmocka_unit_test(test_attrCacheCollidingNames),
+        cmocka_unit_test(test_attrCacheInvalidatePrefix),
+        cmocka_unit_test(err_attrCacheInvalidEntries)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
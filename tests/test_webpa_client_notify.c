@@ -0,0 +1,187 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <time.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_client_notify.h"
+
+#define MAX_EMITTED     8
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+int numLoops = 0;
+static time_t fakeNow = 1000;
+static char emitted[MAX_EMITTED][32];
+static int emitCount = 0;
+static int freeCount = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+    (void) clk_id;
+    tp->tv_sec = fakeNow;
+    tp->tv_nsec = 0;
+    return 0;
+}
+
+static void emitNode(void *node)
+{
+    snprintf(emitted[emitCount++], sizeof(emitted[0]), "%s", (char *) node);
+    free(node);
+}
+
+static void freeNode(void *node)
+{
+    freeCount++;
+    free(node);
+}
+
+static void resetCounters()
+{
+    emitCount = 0;
+    freeCount = 0;
+    memset(emitted, 0, sizeof(emitted));
+    // forget clients of the previous test
+    flushClientNotify(1);
+    emitCount = 0;
+    freeCount = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_clientNotifyWaitsForWindow()
+{
+    initClientNotifyAggregator(2, emitNode, freeNode);
+    resetCounters();
+
+    assert_int_equal(0, aggregateClientNotify("AA:BB:CC:00:00:01", 1, strdup("online")));
+    fakeNow += 1;
+    assert_int_equal(1, flushClientNotify(0));
+    assert_int_equal(0, emitCount);
+    fakeNow += 1;
+    assert_int_equal(0, flushClientNotify(0));
+    assert_int_equal(1, emitCount);
+    assert_string_equal("online", emitted[0]);
+}
+
+void test_clientNotifyKeepsLatestState()
+{
+    ClientNotifyStats before, after;
+
+    initClientNotifyAggregator(2, emitNode, freeNode);
+    resetCounters();
+    getClientNotifyStats(&before);
+
+    assert_int_equal(0, aggregateClientNotify("aa:bb:cc:00:00:02", 1, strdup("online")));
+    assert_int_equal(0, aggregateClientNotify("AA:BB:CC:00:00:02", 2, strdup("offline")));
+    assert_int_equal(1, freeCount);
+    fakeNow += 2;
+    flushClientNotify(0);
+    assert_int_equal(1, emitCount);
+    assert_string_equal("offline", emitted[0]);
+
+    getClientNotifyStats(&after);
+    assert_int_equal(before.receivedCount + 2, after.receivedCount);
+    assert_int_equal(before.mergedCount + 1, after.mergedCount);
+    assert_int_equal(0, after.pendingCount);
+}
+
+void test_clientNotifySuppressesFlap()
+{
+    ClientNotifyStats stats;
+
+    initClientNotifyAggregator(2, emitNode, freeNode);
+    resetCounters();
+
+    aggregateClientNotify("aa:bb:cc:00:00:03", 1, strdup("online"));
+    fakeNow += 2;
+    flushClientNotify(0);
+    assert_int_equal(1, emitCount);
+
+    // offline and back online inside one window is not reported
+    aggregateClientNotify("aa:bb:cc:00:00:03", 2, strdup("offline"));
+    aggregateClientNotify("aa:bb:cc:00:00:03", 1, strdup("online"));
+    fakeNow += 2;
+    flushClientNotify(0);
+    assert_int_equal(1, emitCount);
+    assert_int_equal(2, freeCount);
+    getClientNotifyStats(&stats);
+    assert_true(stats.suppressedCount >= 1);
+
+    // a real change is still reported
+    aggregateClientNotify("aa:bb:cc:00:00:03", 2, strdup("offline"));
+    fakeNow += 2;
+    flushClientNotify(0);
+    assert_int_equal(2, emitCount);
+    assert_string_equal("offline", emitted[1]);
+}
+
+void test_clientNotifyClientsAreIndependent()
+{
+    initClientNotifyAggregator(2, emitNode, freeNode);
+    resetCounters();
+
+    aggregateClientNotify("aa:bb:cc:00:00:04", 1, strdup("first"));
+    fakeNow += 1;
+    aggregateClientNotify("aa:bb:cc:00:00:05", 1, strdup("second"));
+    fakeNow += 1;
+    assert_int_equal(1, flushClientNotify(0));
+    assert_int_equal(1, emitCount);
+    assert_string_equal("first", emitted[0]);
+    fakeNow += 1;
+    assert_int_equal(0, flushClientNotify(0));
+    assert_string_equal("second", emitted[1]);
+}
+
+void err_clientNotifyDisabled()
+{
+    char *node = strdup("online");
+
+    initClientNotifyAggregator(0, emitNode, freeNode);
+    assert_int_equal(-1, aggregateClientNotify("aa:bb:cc:00:00:06", 1, node));
+    assert_int_equal(-1, aggregateClientNotify(NULL, 1, node));
+    free(node);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_clientNotifyWaitsForWindow),
+        cmocka_unit_test(test_clientNotifyKeepsLatestState),
+        cmocka_unit_test(test_clientNotifySuppressesFlap),
+        cmocka_unit_test(test_clientNotifyClientsAreIndependent),
+        cmocka_unit_test(err_clientNotifyDisabled)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,206 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_component_cache.h"
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+static void addSingle(const char *name, const char *comp, const char *path)
+{
+    char *compName[1], *dbusPath[1];
+
+    compName[0] = (char *) comp;
+    dbusPath[0] = (char *) path;
+    addComponentCache(name, compName, dbusPath, 1);
+}
+
+static void freeOwners(char **compName, char **dbusPath, int count)
+{
+    int i = 0;
+
+    for(i = 0; i < count; i++)
+    {
+        free(compName[i]);
+        free(dbusPath[i]);
+    }
+    free(compName);
+    free(dbusPath);
+}
+
+static int lookupOwner(const char *name, char *comp, size_t size)
+{
+    char **compName = NULL, **dbusPath = NULL;
+    int count = 0;
+
+    if(lookupComponentCache(name, &compName, &dbusPath, &count) != 0)
+    {
+        return -1;
+    }
+    snprintf(comp, size, "%s", compName[0]);
+    freeOwners(compName, dbusPath, count);
+    return count;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_componentCacheDeepestObject()
+{
+    char comp[64];
+
+    clearComponentCache();
+    addSingle("Device.X_RDK_Test.", "eRT.com.test.outer", "/com/test/outer");
+    addSingle("Device.X_RDK_Test.Inner.", "eRT.com.test.inner", "/com/test/inner");
+
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Test.Inner.Enable", comp, sizeof(comp)));
+    assert_string_equal("eRT.com.test.inner", comp);
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Test.Inner.", comp, sizeof(comp)));
+    assert_string_equal("eRT.com.test.inner", comp);
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Test.Other.1.Name", comp, sizeof(comp)));
+    assert_string_equal("eRT.com.test.outer", comp);
+    // a leaf name only matches itself
+    addSingle("Device.X_RDK_Leaf.Name", "eRT.com.test.leaf", "/com/test/leaf");
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_Leaf.NameSuffix", comp, sizeof(comp)));
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_Leaf.", comp, sizeof(comp)));
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_Tes", comp, sizeof(comp)));
+}
+
+void test_componentCacheSharedObject()
+{
+    char *owners[2] = {"eRT.com.ccsp.pam", "eRT.com.ccsp.webpa"};
+    char *paths[2] = {"/com/ccsp/pam", "/com/ccsp/webpa"};
+    char **compName = NULL, **dbusPath = NULL;
+    char comp[64];
+    int count = 0;
+
+    clearComponentCache();
+    addComponentCache("Device.DeviceInfo.", owners, paths, 2);
+    assert_int_equal(0, lookupComponentCache("Device.DeviceInfo.", &compName, &dbusPath, &count));
+    assert_int_equal(2, count);
+    assert_string_equal("eRT.com.ccsp.webpa", compName[1]);
+    assert_string_equal("/com/ccsp/webpa", dbusPath[1]);
+    freeOwners(compName, dbusPath, count);
+    // an object with several owners does not tell which one has a name below it
+    assert_int_equal(-1, lookupOwner("Device.DeviceInfo.SerialNumber", comp, sizeof(comp)));
+    addSingle("Device.DeviceInfo.SerialNumber", "eRT.com.ccsp.pam", "/com/ccsp/pam");
+    assert_int_equal(1, lookupOwner("Device.DeviceInfo.SerialNumber", comp, sizeof(comp)));
+    assert_string_equal("eRT.com.ccsp.pam", comp);
+}
+
+void test_componentCacheEvictsLeastRecentlyUsed()
+{
+    ComponentCacheStats stats;
+    char name[64];
+    char comp[64];
+    int i = 0;
+
+    clearComponentCache();
+    for(i = 0; i < WEBPA_COMPONENT_CACHE_SIZE; i++)
+    {
+        snprintf(name, sizeof(name), "Device.X_RDK_Obj%d.", i);
+        addSingle(name, "eRT.com.test", "/com/test");
+    }
+    // touch the oldest so the second oldest goes first
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Obj0.Value", comp, sizeof(comp)));
+    addSingle("Device.X_RDK_New.", "eRT.com.test.new", "/com/test/new");
+
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Obj0.Value", comp, sizeof(comp)));
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_Obj1.Value", comp, sizeof(comp)));
+    assert_int_equal(1, lookupOwner("Device.X_RDK_New.Value", comp, sizeof(comp)));
+    assert_string_equal("eRT.com.test.new", comp);
+
+    getComponentCacheStats(&stats);
+    assert_int_equal(WEBPA_COMPONENT_CACHE_SIZE, stats.entryCount);
+    assert_true(stats.evictionCount >= 1);
+    assert_true(stats.hitCount >= 3);
+    assert_true(stats.missCount >= 1);
+    clearComponentCache();
+    getComponentCacheStats(&stats);
+    assert_int_equal(0, stats.entryCount);
+}
+
+void test_componentCacheInvalidateOwner()
+{
+    char *owners[2] = {"eRT.com.ccsp.pam", "eRT.com.ccsp.webpa"};
+    char *paths[2] = {"/com/ccsp/pam", "/com/ccsp/webpa"};
+    ComponentCacheStats stats;
+    char comp[64];
+
+    clearComponentCache();
+    addSingle("Device.X_RDK_Pam.", "eRT.com.ccsp.pam", "/com/ccsp/pam");
+    addSingle("Device.X_RDK_Wifi.", "eRT.com.ccsp.wifi", "/com/ccsp/wifi");
+    addComponentCache("Device.DeviceInfo.", owners, paths, 2);
+
+    assert_int_equal(2, invalidateComponentCache("eRT.com.ccsp.pam"));
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_Pam.Enable", comp, sizeof(comp)));
+    assert_int_equal(-1, lookupOwner("Device.DeviceInfo.", comp, sizeof(comp)));
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Wifi.Enable", comp, sizeof(comp)));
+    assert_string_equal("eRT.com.ccsp.wifi", comp);
+    assert_int_equal(0, invalidateComponentCache("eRT.com.ccsp.pam"));
+    assert_int_equal(0, invalidateComponentCache(NULL));
+    getComponentCacheStats(&stats);
+    assert_int_equal(1, stats.entryCount);
+    // a dropped name is learned again
+    addSingle("Device.X_RDK_Pam.", "eRT.com.ccsp.pam", "/com/ccsp/pam2");
+    assert_int_equal(1, lookupOwner("Device.X_RDK_Pam.Enable", comp, sizeof(comp)));
+    clearComponentCache();
+}
+
+void err_componentCacheInvalidEntries()
+{
+    char *owners[WEBPA_COMPONENT_CACHE_MAX_OWNERS + 1];
+    char comp[64];
+    int i = 0;
+
+    clearComponentCache();
+    for(i = 0; i <= WEBPA_COMPONENT_CACHE_MAX_OWNERS; i++)
+    {
+        owners[i] = "eRT.com.test";
+    }
+    addComponentCache("Device.X_RDK_Many.", owners, owners, WEBPA_COMPONENT_CACHE_MAX_OWNERS + 1);
+    addComponentCache("Device.X_RDK_None.", owners, owners, 0);
+    addComponentCache(NULL, owners, owners, 1);
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_Many.", comp, sizeof(comp)));
+    assert_int_equal(-1, lookupOwner("Device.X_RDK_None.", comp, sizeof(comp)));
+    assert_int_equal(-1, lookupOwner("", comp, sizeof(comp)));
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_componentCacheDeepestObject),
+        cmocka_unit_test(test_componentCacheSharedObject),
+        cmocka_unit_test(test_componentCacheEvictsLeastRecentlyUsed),
+        cmocka_unit_test(test_componentCacheInvalidateOwner),
+        cmocka_unit_test(err_componentCacheInvalidEntries)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,195 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_component_health.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+int numLoops = 0;
+static time_t fakeNowSec = 5000;
+static ComponentHealth pamHealth = COMPONENT_HEALTH_GREEN;
+static ComponentHealth wifiHealth = COMPONENT_HEALTH_RED;
+static int pamProbes = 0;
+static int wifiProbes = 0;
+static char lastPath[64];
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+    (void) clk_id;
+    tp->tv_sec = fakeNowSec;
+    tp->tv_nsec = 0;
+    return 0;
+}
+
+static ComponentHealth probeHealth(const char *compName, const char *dbusPath)
+{
+    snprintf(lastPath, sizeof(lastPath), "%s", dbusPath);
+    if(strcmp(compName, "com.ccsp.pam") == 0)
+    {
+        pamProbes++;
+        return pamHealth;
+    }
+    wifiProbes++;
+    return wifiHealth;
+}
+
+static void resetProbes()
+{
+    pamProbes = 0;
+    wifiProbes = 0;
+    lastPath[0] = '\0';
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_componentHealthProbeSchedule()
+{
+    ComponentHealthStats stats;
+    int i = 0;
+
+    resetProbes();
+    initComponentHealthMonitor(probeHealth);
+    assert_int_equal(COMPONENT_HEALTH_UNKNOWN, getComponentHealth("com.ccsp.pam"));
+    assert_int_equal(0, watchComponentHealth("com.ccsp.pam", "/com/ccsp/pam"));
+    assert_int_equal(0, watchComponentHealth("com.ccsp.wifi", "/com/ccsp/wifi"));
+
+    assert_int_equal(2, runComponentHealthChecks());
+    assert_int_equal(COMPONENT_HEALTH_GREEN, getComponentHealth("com.ccsp.pam"));
+    assert_int_equal(COMPONENT_HEALTH_RED, getComponentHealth("com.ccsp.wifi"));
+    assert_int_equal(0, runComponentHealthChecks());
+
+    // components that are not Green are probed again sooner
+    fakeNowSec += WEBPA_COMPONENT_HEALTH_RETRY_SEC;
+    wifiHealth = COMPONENT_HEALTH_GREEN;
+    assert_int_equal(1, runComponentHealthChecks());
+    assert_int_equal(1, pamProbes);
+    assert_int_equal(2, wifiProbes);
+    assert_int_equal(COMPONENT_HEALTH_GREEN, getComponentHealth("com.ccsp.wifi"));
+
+    fakeNowSec += WEBPA_COMPONENT_HEALTH_INTERVAL_SEC;
+    pamHealth = COMPONENT_HEALTH_DOWN;
+    assert_int_equal(2, runComponentHealthChecks());
+    // one failed query keeps the last health, the component is probed again sooner
+    assert_int_equal(COMPONENT_HEALTH_GREEN, getComponentHealth("com.ccsp.pam"));
+    for(i = 1; i < WEBPA_COMPONENT_HEALTH_DOWN_PROBES; i++)
+    {
+        fakeNowSec += WEBPA_COMPONENT_HEALTH_RETRY_SEC;
+        assert_int_equal(1, runComponentHealthChecks());
+    }
+    assert_int_equal(COMPONENT_HEALTH_DOWN, getComponentHealth("com.ccsp.pam"));
+
+    getComponentHealthStats(&stats);
+    assert_int_equal(2, stats.watchedCount);
+    assert_int_equal(4 + WEBPA_COMPONENT_HEALTH_DOWN_PROBES, stats.probeCount);
+    assert_int_equal(4, stats.changeCount);
+}
+
+void test_componentHealthRefresh()
+{
+    resetProbes();
+    assert_int_equal(0, runComponentHealthChecks());
+    refreshComponentHealth("com.ccsp.wifi");
+    refreshComponentHealth("com.ccsp.unknown");
+    assert_int_equal(1, runComponentHealthChecks());
+    assert_int_equal(1, wifiProbes);
+
+    // same path is not a change, a new path is probed right away
+    assert_int_equal(0, watchComponentHealth("com.ccsp.wifi", "/com/ccsp/wifi"));
+    assert_int_equal(0, runComponentHealthChecks());
+    assert_int_equal(0, watchComponentHealth("com.ccsp.wifi", "/com/ccsp/wifi2"));
+    assert_int_equal(1, runComponentHealthChecks());
+    assert_string_equal("/com/ccsp/wifi2", lastPath);
+}
+
+void err_componentHealthFailuresMustBeConsecutive()
+{
+    int i = 0;
+
+    pamHealth = COMPONENT_HEALTH_GREEN;
+    refreshComponentHealth("com.ccsp.pam");
+    runComponentHealthChecks();
+    assert_int_equal(COMPONENT_HEALTH_GREEN, getComponentHealth("com.ccsp.pam"));
+
+    // a query that answers in between starts the count again
+    for(i = 0; i < 2 * WEBPA_COMPONENT_HEALTH_DOWN_PROBES - 1; i++)
+    {
+        pamHealth = (i == WEBPA_COMPONENT_HEALTH_DOWN_PROBES - 1) ? COMPONENT_HEALTH_GREEN : COMPONENT_HEALTH_DOWN;
+        refreshComponentHealth("com.ccsp.pam");
+        runComponentHealthChecks();
+    }
+    assert_int_equal(COMPONENT_HEALTH_GREEN, getComponentHealth("com.ccsp.pam"));
+}
+
+void test_componentHealthWaitWithoutTask()
+{
+    pamHealth = COMPONENT_HEALTH_RED;
+    refreshComponentHealth("com.ccsp.pam");
+    runComponentHealthChecks();
+    // no monitor thread, the wait returns the known health
+    assert_int_equal(COMPONENT_HEALTH_RED, waitForComponentHealth("com.ccsp.pam", 300));
+    assert_int_equal(COMPONENT_HEALTH_UNKNOWN, waitForComponentHealth("com.ccsp.unknown", 300));
+}
+
+void err_componentHealthTableFull()
+{
+    char name[32];
+    int i = 0, failed = 0;
+
+    assert_int_equal(-1, watchComponentHealth(NULL, "/com/ccsp/x"));
+    assert_int_equal(-1, watchComponentHealth("com.ccsp.x", NULL));
+    assert_int_equal(COMPONENT_HEALTH_UNKNOWN, getComponentHealth(NULL));
+    for(i = 0; i <= WEBPA_COMPONENT_HEALTH_MAX; i++)
+    {
+        snprintf(name, sizeof(name), "com.ccsp.extra%d", i);
+        if(watchComponentHealth(name, "/com/ccsp/extra") != 0)
+        {
+            failed++;
+        }
+    }
+    // two places are taken by pam and wifi
+    assert_int_equal(3, failed);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_componentHealthProbeSchedule),
+        cmocka_unit_test(test_componentHealthRefresh),
+        cmocka_unit_test(err_componentHealthFailuresMustBeConsecutive),
+        cmocka_unit_test(test_componentHealthWaitWithoutTask),
+        cmocka_unit_test(err_componentHealthTableFull)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
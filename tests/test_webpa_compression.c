@@ -0,0 +1,194 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_compression.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Helpers                                  */
+/*----------------------------------------------------------------------------*/
+static char * newJsonPayload(size_t size)
+{
+    static const char row[] = "{\"name\":\"Device.Hosts.Host.1.HostName\",\"value\":\"host\"},";
+    char *payload = (char *) malloc(size + 1);
+    size_t i = 0;
+
+    for(i = 0; i < size; i++)
+    {
+        payload[i] = row[i % (sizeof(row) - 1)];
+    }
+    payload[size] = '\0';
+    return payload;
+}
+
+static void assertInflates(const char *expected, size_t expectedSize, void *compressed, size_t compressedSize)
+{
+    z_stream strm;
+    char *out = (char *) malloc(expectedSize + 1);
+
+    memset(&strm, 0, sizeof(z_stream));
+    assert_int_equal(Z_OK, inflateInit2(&strm, 15 + 16));
+    strm.next_in = (Bytef *) compressed;
+    strm.avail_in = (uInt) compressedSize;
+    strm.next_out = (Bytef *) out;
+    strm.avail_out = (uInt) expectedSize + 1;
+    assert_int_equal(Z_STREAM_END, inflate(&strm, Z_FINISH));
+    assert_int_equal(expectedSize, strm.total_out);
+    assert_memory_equal(expected, out, expectedSize);
+    inflateEnd(&strm);
+    free(out);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_compressPayload()
+{
+    char *payload = newJsonPayload(64 * 1024);
+    void *compressed = NULL;
+    size_t compressedSize = 0;
+    WebpaCompressStats stats;
+
+    setCompressConfig(WEBPA_COMPRESS_THRESHOLD, 1);
+    assert_int_equal(1, isEventCompressEnabled());
+    assert_int_equal(0, compressPayload(payload, strlen(payload), &compressed, &compressedSize));
+    assert_non_null(compressed);
+    assert_true(compressedSize < strlen(payload) / 10);
+    assertInflates(payload, strlen(payload), compressed, compressedSize);
+    getCompressStats(&stats);
+    assert_int_equal(1, stats.compressedCount);
+    assert_int_equal(strlen(payload), stats.bytesIn);
+    assert_int_equal(compressedSize, stats.bytesOut);
+    free(compressed);
+    free(payload);
+}
+
+void test_compressThreshold()
+{
+    char *payload = newJsonPayload(WEBPA_COMPRESS_THRESHOLD);
+    void *compressed = NULL;
+    size_t compressedSize = 0;
+
+    // smaller than the threshold
+    setCompressConfig(WEBPA_COMPRESS_THRESHOLD, 0);
+    assert_int_equal(0, isEventCompressEnabled());
+    assert_int_equal(1, compressPayload(payload, WEBPA_COMPRESS_THRESHOLD - 1, &compressed, &compressedSize));
+    assert_null(compressed);
+    assert_int_equal(0, compressedSize);
+    assert_int_equal(0, compressPayload(payload, WEBPA_COMPRESS_THRESHOLD, &compressed, &compressedSize));
+    free(compressed);
+
+    // disabled
+    setCompressConfig(0, 1);
+    assert_int_equal(0, isEventCompressEnabled());
+    assert_int_equal(1, compressPayload(payload, WEBPA_COMPRESS_THRESHOLD, &compressed, &compressedSize));
+    assert_null(compressed);
+    setCompressConfig(WEBPA_COMPRESS_THRESHOLD, 0);
+    free(payload);
+}
+
+void test_compressIncompressible()
+{
+    unsigned char payload[WEBPA_COMPRESS_THRESHOLD];
+    void *compressed = NULL;
+    size_t compressedSize = 0, i = 0;
+    unsigned int seed = 12345;
+    WebpaCompressStats before, after;
+
+    for(i = 0; i < sizeof(payload); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        payload[i] = (unsigned char) (seed >> 16);
+    }
+    getCompressStats(&before);
+    assert_int_equal(1, compressPayload(payload, sizeof(payload), &compressed, &compressedSize));
+    assert_null(compressed);
+    getCompressStats(&after);
+    assert_int_equal(before.skippedCount + 1, after.skippedCount);
+    assert_int_equal(before.compressedCount, after.compressedCount);
+}
+
+void test_acceptsCompression()
+{
+    headers_t *headers = (headers_t *) malloc(sizeof(headers_t) + sizeof(char *) * 3);
+
+    assert_int_equal(0, acceptsCompression(NULL));
+    headers->count = 3;
+    headers->headers[0] = "traceparent: 00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01";
+    headers->headers[1] = NULL;
+    headers->headers[2] = "Accept-Encoding: gzip";
+    assert_int_equal(1, acceptsCompression(headers));
+    headers->headers[2] = "accept-encoding: deflate, GZIP;q=0.8";
+    assert_int_equal(1, acceptsCompression(headers));
+    headers->headers[2] = "Accept-Encoding: deflate, gzipx";
+    assert_int_equal(0, acceptsCompression(headers));
+    headers->headers[2] = "Accept: application/gzip";
+    assert_int_equal(0, acceptsCompression(headers));
+    free(headers);
+}
+
+void test_addContentEncoding()
+{
+    headers_t *headers = NULL;
+
+    assert_int_equal(0, addContentEncoding(&headers));
+    assert_non_null(headers);
+    assert_int_equal(1, headers->count);
+    assert_string_equal(WEBPA_CONTENT_ENCODING_GZIP, headers->headers[0]);
+
+    assert_int_equal(0, addContentEncoding(&headers));
+    assert_int_equal(2, headers->count);
+    assert_string_equal(WEBPA_CONTENT_ENCODING_GZIP, headers->headers[1]);
+    free(headers->headers[0]);
+    free(headers->headers[1]);
+    free(headers);
+}
+
+void err_compressPayload()
+{
+    void *compressed = (void *) 1;
+    size_t compressedSize = 1;
+
+    assert_int_equal(1, compressPayload(NULL, WEBPA_COMPRESS_THRESHOLD, &compressed, &compressedSize));
+    assert_null(compressed);
+    assert_int_equal(0, compressedSize);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_compressPayload),
+        cmocka_unit_test(test_compressThreshold),
+        cmocka_unit_test(test_compressIncompressible),
+        cmocka_unit_test(test_acceptsCompression),
+        cmocka_unit_test(test_addContentEncoding),
+        cmocka_unit_test(err_compressPayload)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -317,6 +317,14 @@ void test_ccsp_message_bus_oom()
     CU_ASSERT_EQUAL(WDMP_ERR_MAX_REQUEST, ret);
 }
 
+//Test Case to check mapstatus CCSP_ERR_COMPONENT_UNREACHABLE
+void test_ccsp_err_component_unreachable()
+{
+    int input = CCSP_ERR_COMPONENT_UNREACHABLE;
+    WDMP_STATUS ret = mapStatus(input);
+    CU_ASSERT_EQUAL(WDMP_ERR_TIMEOUT, ret);
+}
+
 void add_suites( CU_pSuite *suite )
 {
 	*suite = CU_add_suite( "tests", NULL, NULL );
@@ -339,6 +347,7 @@ void add_suites( CU_pSuite *suite )
     CU_add_test( *suite, "test ccsp_err_method_not_supported", test_ccsp_err_method_not_supported);
     CU_add_test( *suite, "test ccsp_err_session_in_progress", test_ccsp_err_session_in_progress);
     CU_add_test( *suite, "test ccsp_message_bus_oom", test_ccsp_message_bus_oom);
+    CU_add_test( *suite, "test ccsp_err_component_unreachable", test_ccsp_err_component_unreachable);
 }
 
 
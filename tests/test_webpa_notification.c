@@ -61,6 +61,8 @@ extern int numLoops;
 extern char* cloud_status;
 extern int g_checkSyncNotifyRetry;
 extern int g_syncNotifyInProgress;
+extern void syncNotifyRetryTimerCB(void *arg);
+extern void resetSyncNotifyRetry();
 /*----------------------------------------------------------------------------*/
 /*                                   Mocks                                    */
 /*----------------------------------------------------------------------------*/
@@ -707,26 +709,11 @@ void test_processNotification()
     version[0]->parameterValue =strdup("123456");
     version[0]->type = ccsp_string;
 
-	parameterValStruct_t **systemTime = (parameterValStruct_t **) malloc(sizeof(parameterValStruct_t*));
-    systemTime[0] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t));
-    systemTime[0]->parameterName = strdup("Device.DeviceInfo.X_RDKCENTRAL-COM_SystemTime");
-    systemTime[0]->parameterValue =strdup("546543280");
-    systemTime[0]->type = ccsp_string;
 	getCompDetails();
 	will_return(get_global_values, version);
     will_return(get_global_parameters_count, 1);
     expect_function_call(CcspBaseIf_getParameterValues);
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
-    expect_value(CcspBaseIf_getParameterValues, size, 1);
-	will_return(get_global_components, getDeviceInfoCompDetails());
-    will_return(get_global_component_size, 1);
-    expect_function_call(CcspBaseIf_discComponentSupportingNamespace);
-    will_return(CcspBaseIf_discComponentSupportingNamespace, CCSP_SUCCESS);
-    expect_function_call(free_componentStruct_t);
-	will_return(get_global_values, systemTime);
-    will_return(get_global_parameters_count, 1);
-    expect_function_call(CcspBaseIf_getParameterValues);
-    will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 	will_return(libparodus_send, (intptr_t)0);
     expect_function_call(libparodus_send);
@@ -795,9 +782,6 @@ void test_processNotification_PARAM_NOTIFY()
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
     will_return(libparodus_send, (intptr_t)0);
     expect_function_call(libparodus_send);
 	processNotification(notifyData);
@@ -865,9 +849,6 @@ void test_processNotification_PARAM_NOTIFY_CMC_768()
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
     will_return(libparodus_send, (intptr_t)0);
     expect_function_call(libparodus_send);
 	processNotification(notifyData);
@@ -1734,16 +1715,9 @@ void test_FR_CloudSyncCheck_FRSyncFailed()
 
 void test_syncNotifyRetry()
 {
-    numLoops = 1;
     getCompDetails();
     strcpy(deviceMAC, "abcdeg1234");
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 0;
 
@@ -1759,21 +1733,14 @@ void test_syncNotifyRetry()
     expect_value(CcspBaseIf_getParameterValues, size, 1);
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
 
-    SyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
 }
 
 void test_syncNotifyRetry_timedout()
 {
 
-    numLoops = 1;
     getCompDetails();
     strcpy(deviceMAC, "abcdeg1234");
-    
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-   
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);   
 
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 0;
@@ -1817,86 +1784,16 @@ void test_syncNotifyRetry_timedout()
     will_return(libparodus_send, (intptr_t)0);
     expect_function_call(libparodus_send);
 
-    SyncNotifyRetry();
-}
-
-void test_syncNotifyRetry_pthread_error()
-{
-    numLoops = 2;
-    getCompDetails();
-    strcpy(deviceMAC, "abcdeg1234");
-    
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)2);
-    expect_function_call(pthread_cond_timedwait);
-
-     will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-    
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-    
-    g_checkSyncNotifyRetry = 1;
-    g_syncNotifyInProgress = 0;
-    
-    parameterValStruct_t **cidList = (parameterValStruct_t **) malloc(sizeof(parameterValStruct_t*));
-    cidList[0] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t)*1);
-    cidList[0]->parameterName = strndup(PARAM_CID,MAX_PARAMETER_LEN);
-    cidList[0]->parameterValue = strndup("61f4db9",MAX_PARAMETER_LEN);
-    cidList[0]->type = ccsp_string;
-    
-    parameterValStruct_t **cmcList = (parameterValStruct_t **) malloc(sizeof(parameterValStruct_t*));
-    cmcList[0] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t)*1);
-    cmcList[0]->parameterName = strndup(PARAM_CMC,MAX_PARAMETER_LEN);
-    cmcList[0]->parameterValue = strndup("768",MAX_PARAMETER_LEN);
-    cmcList[0]->type = ccsp_int;
-  
-    parameterValStruct_t **cmcList2 = (parameterValStruct_t **) malloc(sizeof(parameterValStruct_t*));
-    cmcList2[0] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t)*1);
-    cmcList2[0]->parameterName = strndup(PARAM_CMC,MAX_PARAMETER_LEN);
-    cmcList2[0]->parameterValue = strndup("512",MAX_PARAMETER_LEN);
-    cmcList2[0]->type = ccsp_int;
-    
-    will_return(get_global_values, cmcList);
-    will_return(get_global_parameters_count, 1);
-    expect_function_call(CcspBaseIf_getParameterValues);
-    will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
-    expect_value(CcspBaseIf_getParameterValues, size, 1);
-    
-    will_return(get_global_values, cmcList2);
-    will_return(get_global_parameters_count, 1);
-    expect_function_call(CcspBaseIf_getParameterValues);
-    will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
-    expect_value(CcspBaseIf_getParameterValues, size, 1);
-    
-    will_return(get_global_values, cidList);
-    will_return(get_global_parameters_count, 1);
-    expect_function_call(CcspBaseIf_getParameterValues);
-    will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
-    expect_value(CcspBaseIf_getParameterValues, size, 1);
-    
-    will_return(libparodus_send, (intptr_t)0);
-    expect_function_call(libparodus_send);
-
-    SyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
 }
 
 void test_syncNotifyRetry_Retry_Until_CMC_Is_512()
 {
-    numLoops = 2;
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 0;
     getCompDetails();
     strcpy(deviceMAC, "00:11:22:33:44:55");
 
-    will_return(pthread_cond_signal, 0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     parameterValStruct_t **cmcList1 = malloc(sizeof(parameterValStruct_t *));
     cmcList1[0] = malloc(sizeof(parameterValStruct_t));
     cmcList1[0]->parameterName = strndup(PARAM_CMC, MAX_PARAMETER_LEN);
@@ -1936,12 +1833,6 @@ void test_syncNotifyRetry_Retry_Until_CMC_Is_512()
     will_return(libparodus_send, 0);
     expect_function_call(libparodus_send);
 
-    will_return(pthread_cond_signal, 0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     parameterValStruct_t **cmcList2 = malloc(sizeof(parameterValStruct_t *));
     cmcList2[0] = malloc(sizeof(parameterValStruct_t));
     cmcList2[0]->parameterName = strndup(PARAM_CMC, MAX_PARAMETER_LEN);
@@ -1954,42 +1845,29 @@ void test_syncNotifyRetry_Retry_Until_CMC_Is_512()
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 
-    SyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
+    syncNotifyRetryTimerCB(NULL);
     assert_int_equal(g_syncNotifyInProgress, 0);
 }
 
 void test_syncNotifyRetry_NotifyInProgress()
 {
-    numLoops = 1;
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 1;
     getCompDetails();
     strcpy(deviceMAC, "00:11:22:33:44:55");
 
-    will_return(pthread_cond_signal, 0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait,  (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
-    SyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
 }
 
 void test_syncNotifyRetry_Skip_CMC_Check()
 {
-    numLoops = 2;
     getCompDetails();
     strcpy(deviceMAC, "00:11:22:33:44:55");
 
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 0;
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     parameterValStruct_t **cmcList = (parameterValStruct_t **) malloc(sizeof(parameterValStruct_t*));
     cmcList[0] = (parameterValStruct_t *) malloc(sizeof(parameterValStruct_t)*1);
     cmcList[0]->parameterName = strndup(PARAM_CMC,MAX_PARAMETER_LEN);
@@ -2002,42 +1880,24 @@ void test_syncNotifyRetry_Skip_CMC_Check()
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
-    SyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
+    syncNotifyRetryTimerCB(NULL);
 }
 
 void test_syncNotifyRetry_dbCMC_NULL()
 {
-    numLoops = 2;
     getCompDetails();
     strcpy(deviceMAC, "00:11:22:33:44:55");
 
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 0;
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     will_return(get_global_values, NULL);
     will_return(get_global_parameters_count, 0);
     expect_function_call(CcspBaseIf_getParameterValues);
     will_return(CcspBaseIf_getParameterValues, CCSP_FAILURE);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     parameterValStruct_t **cmcList = malloc(sizeof(parameterValStruct_t*));
     cmcList[0] = malloc(sizeof(parameterValStruct_t));
     cmcList[0]->parameterName = strndup(PARAM_CMC, MAX_PARAMETER_LEN);
@@ -2050,21 +1910,15 @@ void test_syncNotifyRetry_dbCMC_NULL()
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
 
-    SyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
+    syncNotifyRetryTimerCB(NULL);
 }
 
 void test_syncNotifyRetry_Signalled()
 {
-    numLoops = 2;
     getCompDetails();
     strcpy(deviceMAC, "abcdeg1234");
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)0);
-    expect_function_call(pthread_cond_timedwait);
-
     g_checkSyncNotifyRetry = 1;
     g_syncNotifyInProgress = 0;
 
@@ -2074,19 +1928,15 @@ void test_syncNotifyRetry_Signalled()
     cmcList[0]->parameterValue = strndup("512",MAX_PARAMETER_LEN);
     cmcList[0]->type = ccsp_int;
 
-    will_return(pthread_cond_signal, (intptr_t)0);
-    expect_function_call(pthread_cond_signal);
-
-    will_return(pthread_cond_timedwait, (intptr_t)ETIMEDOUT);
-    expect_function_call(pthread_cond_timedwait);
-
     will_return(get_global_values, cmcList);
     will_return(get_global_parameters_count, 1);
     expect_function_call(CcspBaseIf_getParameterValues);
     expect_value(CcspBaseIf_getParameterValues, size, 1);
     will_return(CcspBaseIf_getParameterValues, CCSP_SUCCESS);
 
-    SyncNotifyRetry();
+    // a new sync notification restarts the wait before it expires
+    resetSyncNotifyRetry();
+    syncNotifyRetryTimerCB(NULL);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -2127,7 +1977,6 @@ int main(void)
         cmocka_unit_test(test_FR_CloudSyncCheck_FRSyncFailed),
         cmocka_unit_test(test_syncNotifyRetry),
         cmocka_unit_test(test_syncNotifyRetry_timedout),
-        cmocka_unit_test(test_syncNotifyRetry_pthread_error),
         cmocka_unit_test(test_syncNotifyRetry_Retry_Until_CMC_Is_512),
         cmocka_unit_test(test_syncNotifyRetry_NotifyInProgress),
         cmocka_unit_test(test_syncNotifyRetry_Skip_CMC_Check),
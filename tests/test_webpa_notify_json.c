@@ -0,0 +1,261 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cJSON.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_notify_json.h"
+
+#define BENCHMARK_ITERATIONS    20000
+
+/*----------------------------------------------------------------------------*/
+/*                             Internal functions                             */
+/*----------------------------------------------------------------------------*/
+static char * writeSyncNotification(char *buf, size_t size)
+{
+    NotifyJsonWriter writer;
+    char parameter[512];
+    NotifyJsonWriter paramWriter;
+
+    notifyJsonInit(&paramWriter, parameter, sizeof(parameter));
+    notifyJsonBeginObject(&paramWriter, NULL);
+    notifyJsonAddString(&paramWriter, "name", "Device.DeviceInfo.X_RDKCENTRAL-COM_ConfigureWiFi");
+    notifyJsonAddString(&paramWriter, "old_value", "true");
+    notifyJsonAddString(&paramWriter, "new_value", "false");
+    notifyJsonAddNumber(&paramWriter, "dataType", 3);
+    notifyJsonEndObject(&paramWriter);
+
+    notifyJsonInit(&writer, buf, size);
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonAddString(&writer, "device_id", "mac:14cfe2142xxx");
+    notifyJsonAddNumber(&writer, "cmc", 768);
+    notifyJsonAddString(&writer, "cid", "61f4db9");
+    notifyJsonAddRaw(&writer, "parameter", notifyJsonGet(&paramWriter));
+    notifyJsonAddString(&writer, "sync_transaction_uuid", "7c4e9b2a-1f2d-4c3b-9a8e-5d6f7a8b9c0d");
+    notifyJsonEndObject(&writer);
+    notifyJsonRelease(&paramWriter);
+    return notifyJsonDetach(&writer);
+}
+
+static char * writeNodeChange(char *buf, size_t size)
+{
+    NotifyJsonWriter writer;
+
+    notifyJsonInit(&writer, buf, size);
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonAddString(&writer, "device_id", "mac:14cfe2142xxx");
+    notifyJsonAddString(&writer, "timestamp", "1571214120");
+    notifyJsonBeginArray(&writer, "nodes");
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonAddString(&writer, "name", "Device.Hosts.Host");
+    notifyJsonAddNumber(&writer, "version", 12);
+    notifyJsonAddString(&writer, "node-mac", "b4:75:0e:8a:13:f2");
+    notifyJsonAddString(&writer, "interface", "WiFi");
+    notifyJsonAddString(&writer, "hostname", "living \"room\" tv");
+    notifyJsonAddString(&writer, "status", "Online");
+    notifyJsonAddString(&writer, "ipv4-address", "10.0.0.23");
+    notifyJsonEndObject(&writer);
+    notifyJsonEndArray(&writer);
+    notifyJsonEndObject(&writer);
+    return notifyJsonDetach(&writer);
+}
+
+static char * printSyncNotification()
+{
+    cJSON *payload = cJSON_CreateObject();
+    cJSON *parameter = cJSON_CreateObject();
+    char *json = NULL;
+
+    cJSON_AddStringToObject(payload, "device_id", "mac:14cfe2142xxx");
+    cJSON_AddNumberToObject(payload, "cmc", 768);
+    cJSON_AddStringToObject(payload, "cid", "61f4db9");
+    cJSON_AddStringToObject(parameter, "name", "Device.DeviceInfo.X_RDKCENTRAL-COM_ConfigureWiFi");
+    cJSON_AddStringToObject(parameter, "old_value", "true");
+    cJSON_AddStringToObject(parameter, "new_value", "false");
+    cJSON_AddNumberToObject(parameter, "dataType", 3);
+    // the old path printed the parameter object on its own as well
+    json = cJSON_PrintUnformatted(parameter);
+    free(json);
+    cJSON_AddItemToObject(payload, "parameter", parameter);
+    cJSON_AddStringToObject(payload, "sync_transaction_uuid", "7c4e9b2a-1f2d-4c3b-9a8e-5d6f7a8b9c0d");
+    json = cJSON_PrintUnformatted(payload);
+    cJSON_Delete(payload);
+    return json;
+}
+
+static char * printNodeChange()
+{
+    cJSON *payload = cJSON_CreateObject();
+    cJSON *nodes = NULL, *node = NULL;
+    char *json = NULL;
+
+    cJSON_AddStringToObject(payload, "device_id", "mac:14cfe2142xxx");
+    cJSON_AddStringToObject(payload, "timestamp", "1571214120");
+    cJSON_AddItemToObject(payload, "nodes", nodes = cJSON_CreateArray());
+    cJSON_AddItemToArray(nodes, node = cJSON_CreateObject());
+    cJSON_AddStringToObject(node, "name", "Device.Hosts.Host");
+    cJSON_AddNumberToObject(node, "version", 12);
+    cJSON_AddStringToObject(node, "node-mac", "b4:75:0e:8a:13:f2");
+    cJSON_AddStringToObject(node, "interface", "WiFi");
+    cJSON_AddStringToObject(node, "hostname", "living \"room\" tv");
+    cJSON_AddStringToObject(node, "status", "Online");
+    cJSON_AddStringToObject(node, "ipv4-address", "10.0.0.23");
+    json = cJSON_PrintUnformatted(payload);
+    cJSON_Delete(payload);
+    return json;
+}
+
+static double elapsedMs(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_notifyJsonEscapesStrings()
+{
+    NotifyJsonWriter writer;
+    char buf[128];
+
+    notifyJsonInit(&writer, buf, sizeof(buf));
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonAddString(&writer, "value", "a\"b\\c\n\t\x01/");
+    notifyJsonAddString(&writer, "skipped", NULL);
+    notifyJsonAddNumber(&writer, "number", -42);
+    notifyJsonEndObject(&writer);
+    assert_string_equal("{\"value\":\"a\\\"b\\\\c\\n\\t\\u0001/\",\"number\":-42}", notifyJsonGet(&writer));
+    assert_int_equal(0, writer.onHeap);
+    notifyJsonRelease(&writer);
+}
+
+void test_notifyJsonNestsContainers()
+{
+    NotifyJsonWriter writer;
+    char buf[128];
+    char *json = NULL;
+
+    notifyJsonInit(&writer, buf, sizeof(buf));
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonBeginArray(&writer, "nodes");
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonAddString(&writer, "name", "one");
+    notifyJsonEndObject(&writer);
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonEndObject(&writer);
+    notifyJsonEndArray(&writer);
+    notifyJsonAddRaw(&writer, "parameter", "{\"a\":1}");
+    notifyJsonEndObject(&writer);
+    json = notifyJsonDetach(&writer);
+    assert_non_null(json);
+    assert_string_equal("{\"nodes\":[{\"name\":\"one\"},{}],\"parameter\":{\"a\":1}}", json);
+    free(json);
+}
+
+void test_notifyJsonGrowsToHeap()
+{
+    NotifyJsonWriter writer;
+    char buf[16];
+    char value[300];
+    char *json = NULL;
+
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    notifyJsonInit(&writer, buf, sizeof(buf));
+    notifyJsonBeginObject(&writer, NULL);
+    notifyJsonAddString(&writer, "key", value);
+    notifyJsonEndObject(&writer);
+    assert_int_equal(1, writer.onHeap);
+    assert_int_equal(strlen(value) + 10, writer.len);
+    json = notifyJsonDetach(&writer);
+    assert_non_null(json);
+    assert_int_equal(0, strncmp("{\"key\":\"xxx", json, 11));
+    free(json);
+}
+
+/*
+ * Writes the same payloads through the writer and through a cJSON tree, checks
+ * the output is identical and prints how long each path takes.
+ */
+void test_notifyJsonBenchmark()
+{
+    char buf[WEBPA_NOTIFY_JSON_BUFFER_SIZE];
+    char *written = NULL, *printed = NULL;
+    struct timespec start, end;
+    double writerMs = 0, cjsonMs = 0;
+    int i = 0;
+
+    written = writeSyncNotification(buf, sizeof(buf));
+    printed = printSyncNotification();
+    assert_non_null(written);
+    assert_non_null(printed);
+    assert_string_equal(printed, written);
+    free(written);
+    free(printed);
+
+    written = writeNodeChange(buf, sizeof(buf));
+    printed = printNodeChange();
+    assert_non_null(written);
+    assert_non_null(printed);
+    assert_string_equal(printed, written);
+    free(written);
+    free(printed);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        free(writeSyncNotification(buf, sizeof(buf)));
+        free(writeNodeChange(buf, sizeof(buf)));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    writerMs = elapsedMs(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        free(printSyncNotification());
+        free(printNodeChange());
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cjsonMs = elapsedMs(&start, &end);
+
+    printf("notify json benchmark: %d payload pairs, writer %.2f ms, cJSON %.2f ms\n",
+            BENCHMARK_ITERATIONS, writerMs, cjsonMs);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_notifyJsonEscapesStrings),
+        cmocka_unit_test(test_notifyJsonNestsContainers),
+        cmocka_unit_test(test_notifyJsonGrowsToHeap),
+        cmocka_unit_test(test_notifyJsonBenchmark)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
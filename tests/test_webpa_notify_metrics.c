@@ -0,0 +1,155 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_notify_metrics.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+int numLoops = 0;
+static long fakeNowMs = 1000000;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+    (void) clk_id;
+    tp->tv_sec = fakeNowMs / 1000;
+    tp->tv_nsec = (fakeNowMs % 1000) * 1000000;
+    return 0;
+}
+
+static void recordAfter(NOTIFY_METRIC metric, long ms)
+{
+    struct timespec start;
+
+    notifyMetricsStart(&start);
+    fakeNowMs += ms;
+    recordNotifyLatency(metric, &start);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_notifyLatencyBuckets()
+{
+    NotifyLatencyStats stats;
+
+    recordAfter(NOTIFY_METRIC_SEND, 0);
+    recordAfter(NOTIFY_METRIC_SEND, 1);
+    recordAfter(NOTIFY_METRIC_SEND, 7);
+    recordAfter(NOTIFY_METRIC_SEND, 5000);
+    recordAfter(NOTIFY_METRIC_SEND, 20000);
+
+    getNotifyLatencyStats(NOTIFY_METRIC_SEND, &stats);
+    assert_int_equal(5, stats.count);
+    assert_int_equal(25008, stats.totalMs);
+    assert_int_equal(20000, stats.maxMs);
+    assert_int_equal(2, stats.buckets[0]);
+    assert_int_equal(1, stats.buckets[2]);
+    assert_int_equal(1, stats.buckets[7]);
+    assert_int_equal(1, stats.buckets[WEBPA_NOTIFY_LATENCY_BUCKETS - 1]);
+
+    // other stages are kept apart
+    getNotifyLatencyStats(NOTIFY_METRIC_QUEUE_WAIT, &stats);
+    assert_int_equal(0, stats.count);
+}
+
+void test_notifyLatencyFormat()
+{
+    NotifyLatencyStats stats;
+    char buf[256];
+    char small[16];
+    int len = 0;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.count = 4;
+    stats.totalMs = 100;
+    stats.maxMs = 60;
+    stats.buckets[1] = 3;
+    stats.buckets[4] = 1;
+
+    len = formatNotifyLatencyStats(&stats, buf, sizeof(buf));
+    assert_string_equal("count=4,avg=25,max=60,le1=0,le5=3,le10=0,le50=0,le100=1,le500=0,le1000=0,le5000=0,le10000=0,inf=0", buf);
+    assert_int_equal(strlen(buf), len);
+
+    // truncated output still reports the full length
+    assert_int_equal(len, formatNotifyLatencyStats(&stats, small, sizeof(small)));
+    assert_int_equal(sizeof(small) - 1, strlen(small));
+}
+
+void test_notifyProcessLatencyPerType()
+{
+    NotifyLatencyStats stats;
+    struct timespec start;
+
+    notifyMetricsStart(&start);
+    fakeNowMs += 30;
+    recordNotifyProcessLatency(2, &start);
+    recordNotifyProcessLatency(WEBPA_NOTIFY_METRICS_MAX_TYPES + 3, &start);
+
+    getNotifyProcessLatencyStats(2, &stats);
+    assert_int_equal(1, stats.count);
+    assert_int_equal(30, stats.maxMs);
+    getNotifyProcessLatencyStats(1, &stats);
+    assert_int_equal(0, stats.count);
+    // unknown types share the last slot
+    getNotifyProcessLatencyStats(WEBPA_NOTIFY_METRICS_MAX_TYPES - 1, &stats);
+    assert_int_equal(1, stats.count);
+}
+
+void err_notifyLatencyInvalidMetric()
+{
+    NotifyLatencyStats stats;
+    struct timespec start;
+
+    notifyMetricsStart(&start);
+    recordNotifyLatency(NOTIFY_METRIC_COUNT, &start);
+    recordNotifyLatency(NOTIFY_METRIC_SETTLE, NULL);
+    getNotifyLatencyStats(NOTIFY_METRIC_COUNT, &stats);
+    assert_int_equal(0, stats.count);
+    getNotifyLatencyStats(NOTIFY_METRIC_SETTLE, &stats);
+    assert_int_equal(0, stats.count);
+    // summary disabled, no thread is started
+    startNotifyMetricsTask(0, NULL);
+    logNotifyMetrics();
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_notifyLatencyBuckets),
+        cmocka_unit_test(test_notifyLatencyFormat),
+        cmocka_unit_test(test_notifyProcessLatencyPerType),
+        cmocka_unit_test(err_notifyLatencyInvalidMetric)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,257 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_notify_queue.h"
+
+#define PRODUCER_COUNT          4
+#define MESSAGES_PER_PRODUCER   2000
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static NotifyQueue *producerQueue = NULL;
+static NotifyPriorityQueue *producerPriorityQueue = NULL;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+static void *producerThread(void *arg)
+{
+    intptr_t base = (intptr_t) arg;
+    intptr_t i = 0;
+
+    for(i = 1; i <= MESSAGES_PER_PRODUCER; i++)
+    {
+        notifyQueuePush(producerQueue, (void *) (base + i));
+    }
+    return NULL;
+}
+
+static void *priorityProducerThread(void *arg)
+{
+    (void) arg;
+    usleep(10000);
+    notifyPriorityQueuePush(producerPriorityQueue, 1, (void *) 7);
+    return NULL;
+}
+
+void test_notifyQueueFifoOrder()
+{
+    NotifyQueueStats stats;
+    intptr_t i = 0;
+    NotifyQueue *queue = notifyQueueCreate(8, NOTIFY_QUEUE_DROP_NEWEST);
+    assert_non_null(queue);
+
+    assert_null(notifyQueuePop(queue));
+    for(i = 1; i <= 5; i++)
+    {
+        assert_int_equal(0, notifyQueuePush(queue, (void *) i));
+    }
+    assert_int_equal(1, (intptr_t) notifyQueuePeek(queue));
+    for(i = 1; i <= 5; i++)
+    {
+        assert_int_equal(i, (intptr_t) notifyQueuePop(queue));
+    }
+    assert_null(notifyQueuePeek(queue));
+    assert_null(notifyQueuePop(queue));
+
+    notifyQueueGetStats(queue, &stats);
+    assert_int_equal(8, stats.capacity);
+    assert_int_equal(5, stats.enqueueCount);
+    assert_int_equal(5, stats.dequeueCount);
+    assert_int_equal(0, stats.depth);
+    assert_int_equal(5, stats.highWatermark);
+    notifyQueueDestroy(queue);
+}
+
+void test_notifyQueueCapacityRoundedUp()
+{
+    NotifyQueueStats stats;
+    NotifyQueue *queue = notifyQueueCreate(100, NOTIFY_QUEUE_DROP_NEWEST);
+    assert_non_null(queue);
+    notifyQueueGetStats(queue, &stats);
+    assert_int_equal(128, stats.capacity);
+    notifyQueueDestroy(queue);
+}
+
+void err_notifyQueueDropNewestWhenFull()
+{
+    NotifyQueueStats stats;
+    intptr_t i = 0;
+    NotifyQueue *queue = notifyQueueCreate(4, NOTIFY_QUEUE_DROP_NEWEST);
+    assert_non_null(queue);
+
+    for(i = 1; i <= 4; i++)
+    {
+        assert_int_equal(0, notifyQueuePush(queue, (void *) i));
+    }
+    assert_int_equal(-1, notifyQueuePush(queue, (void *) 5));
+    notifyQueueGetStats(queue, &stats);
+    assert_int_equal(1, stats.dropCount);
+    assert_int_equal(4, stats.depth);
+
+    // oldest messages are kept, slot is reusable after a pop
+    assert_int_equal(1, (intptr_t) notifyQueuePop(queue));
+    assert_int_equal(0, notifyQueuePush(queue, (void *) 6));
+    for(i = 2; i <= 4; i++)
+    {
+        assert_int_equal(i, (intptr_t) notifyQueuePop(queue));
+    }
+    assert_int_equal(6, (intptr_t) notifyQueuePop(queue));
+    notifyQueueDestroy(queue);
+}
+
+void test_notifyQueueMultipleProducers()
+{
+    pthread_t producers[PRODUCER_COUNT];
+    intptr_t lastSeen[PRODUCER_COUNT] = {0};
+    NotifyQueueStats stats;
+    int i = 0, received = 0;
+
+    producerQueue = notifyQueueCreate(64, NOTIFY_QUEUE_BLOCK);
+    assert_non_null(producerQueue);
+    for(i = 0; i < PRODUCER_COUNT; i++)
+    {
+        pthread_create(&producers[i], NULL, producerThread, (void *) (intptr_t) (i * 100000));
+    }
+
+    while(received < PRODUCER_COUNT * MESSAGES_PER_PRODUCER)
+    {
+        intptr_t value = (intptr_t) notifyQueuePop(producerQueue);
+        if(value == 0)
+        {
+            notifyQueueWait(producerQueue);
+            continue;
+        }
+        // messages of one producer are received in the order they were added
+        assert_true((value % 100000) > lastSeen[value / 100000]);
+        lastSeen[value / 100000] = value % 100000;
+        received++;
+    }
+
+    for(i = 0; i < PRODUCER_COUNT; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    notifyQueueGetStats(producerQueue, &stats);
+    assert_int_equal(PRODUCER_COUNT * MESSAGES_PER_PRODUCER, stats.enqueueCount);
+    assert_int_equal(0, stats.dropCount);
+    assert_true(stats.highWatermark <= 64);
+    notifyQueueDestroy(producerQueue);
+    producerQueue = NULL;
+}
+
+void test_notifyPriorityQueueWeightedOrder()
+{
+    unsigned int weights[3] = {2, 1, 1};
+    unsigned int priorityClass = 0;
+    intptr_t expected[] = {101, 102, 201, 301, 103, 104, 202, 302, 303};
+    intptr_t i = 0;
+    NotifyPriorityQueue *queue = notifyPriorityQueueCreate(3, 16, weights, NOTIFY_QUEUE_DROP_NEWEST);
+    assert_non_null(queue);
+
+    assert_null(notifyPriorityQueuePop(queue, NULL));
+    // low class flood is queued first
+    for(i = 1; i <= 3; i++)
+    {
+        assert_int_equal(0, notifyPriorityQueuePush(queue, 2, (void *) (300 + i)));
+    }
+    for(i = 1; i <= 2; i++)
+    {
+        assert_int_equal(0, notifyPriorityQueuePush(queue, 1, (void *) (200 + i)));
+    }
+    for(i = 1; i <= 4; i++)
+    {
+        assert_int_equal(0, notifyPriorityQueuePush(queue, 0, (void *) (100 + i)));
+    }
+
+    for(i = 0; i < (intptr_t) (sizeof(expected) / sizeof(expected[0])); i++)
+    {
+        assert_int_equal(expected[i], (intptr_t) notifyPriorityQueuePop(queue, &priorityClass));
+        assert_int_equal(expected[i] / 100 - 1, priorityClass);
+    }
+    assert_null(notifyPriorityQueuePop(queue, NULL));
+    notifyPriorityQueueDestroy(queue);
+}
+
+void test_notifyPriorityQueueClassStats()
+{
+    NotifyQueueStats stats;
+    NotifyPriorityQueue *queue = notifyPriorityQueueCreate(2, 4, NULL, NOTIFY_QUEUE_DROP_NEWEST);
+    assert_non_null(queue);
+
+    notifyPriorityQueuePush(queue, 1, (void *) 1);
+    notifyPriorityQueuePush(queue, 1, (void *) 2);
+    // unknown class goes to the lowest one
+    notifyPriorityQueuePush(queue, 5, (void *) 3);
+    notifyPriorityQueueGetStats(queue, 1, &stats);
+    assert_int_equal(3, stats.depth);
+    notifyPriorityQueueGetStats(queue, 0, &stats);
+    assert_int_equal(0, stats.depth);
+
+    usleep(20000);
+    assert_int_equal(1, (intptr_t) notifyPriorityQueuePop(queue, NULL));
+    notifyPriorityQueueGetStats(queue, 1, &stats);
+    assert_int_equal(2, stats.depth);
+    assert_true(stats.latencyMaxMs >= 20);
+    assert_true(stats.latencyAvgMs >= 20);
+    notifyPriorityQueueDestroy(queue);
+}
+
+void test_notifyPriorityQueueWakesConsumer()
+{
+    pthread_t producer;
+    NotifyPriorityQueue *queue = notifyPriorityQueueCreate(3, 8, NULL, NOTIFY_QUEUE_DROP_NEWEST);
+    assert_non_null(queue);
+
+    producerPriorityQueue = queue;
+    pthread_create(&producer, NULL, priorityProducerThread, NULL);
+    notifyPriorityQueueWait(queue);
+    assert_int_equal(7, (intptr_t) notifyPriorityQueuePop(queue, NULL));
+    pthread_join(producer, NULL);
+    producerPriorityQueue = NULL;
+    notifyPriorityQueueDestroy(queue);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_notifyQueueFifoOrder),
+        cmocka_unit_test(test_notifyQueueCapacityRoundedUp),
+        cmocka_unit_test(err_notifyQueueDropNewestWhenFull),
+        cmocka_unit_test(test_notifyQueueMultipleProducers),
+        cmocka_unit_test(test_notifyPriorityQueueWeightedOrder),
+        cmocka_unit_test(test_notifyPriorityQueueClassStats),
+        cmocka_unit_test(test_notifyPriorityQueueWakesConsumer)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,163 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <time.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_notify_retry.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+int numLoops = 0;
+static time_t fakeNow = 1000;
+static int sendCount = 0;
+static int freeCount = 0;
+static int failSends = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+    (void) clk_id;
+    tp->tv_sec = fakeNow;
+    tp->tv_nsec = 0;
+    return 0;
+}
+
+static int sendMessage(void *data)
+{
+    (void) data;
+    sendCount++;
+    return (sendCount <= failSends) ? -1 : 0;
+}
+
+static void freeMessage(void *data)
+{
+    freeCount++;
+    free(data);
+}
+
+static void resetCounters(int failures)
+{
+    sendCount = 0;
+    freeCount = 0;
+    failSends = failures;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_retryAfterBackoff()
+{
+    NotifyRetryStats stats;
+
+    resetCounters(0);
+    assert_int_equal(0, scheduleNotifyRetry(strdup("event"), sendMessage, freeMessage, WEBPA_NOTIFY_MAX_RETRY_COUNT));
+
+    // first retry waits 3 seconds
+    fakeNow += 2;
+    assert_int_equal(1, runNotifyRetries());
+    assert_int_equal(0, sendCount);
+    getNotifyRetryStats(&stats);
+    assert_int_equal(1, stats.pendingCount);
+    assert_int_equal(2, stats.oldestPendingAgeSec);
+
+    fakeNow += 1;
+    assert_int_equal(0, runNotifyRetries());
+    assert_int_equal(1, sendCount);
+    assert_int_equal(1, freeCount);
+    getNotifyRetryStats(&stats);
+    assert_int_equal(0, stats.pendingCount);
+    assert_int_equal(1, stats.retrySuccessCount);
+    assert_int_equal(0, stats.oldestPendingAgeSec);
+}
+
+void err_retryDropsAfterMaxRetries()
+{
+    NotifyRetryStats before, after;
+
+    getNotifyRetryStats(&before);
+    resetCounters(10);
+    assert_int_equal(0, scheduleNotifyRetry(strdup("event"), sendMessage, freeMessage, WEBPA_NOTIFY_MAX_RETRY_COUNT));
+
+    // retries back off 3, 7 and 15 seconds like the old send loop
+    fakeNow += 3;
+    assert_int_equal(1, runNotifyRetries());
+    fakeNow += 6;
+    assert_int_equal(1, runNotifyRetries());
+    assert_int_equal(1, sendCount);
+    fakeNow += 1;
+    assert_int_equal(1, runNotifyRetries());
+    fakeNow += 15;
+    assert_int_equal(0, runNotifyRetries());
+    assert_int_equal(3, sendCount);
+    assert_int_equal(1, freeCount);
+
+    getNotifyRetryStats(&after);
+    assert_int_equal(before.dropCount + 1, after.dropCount);
+    assert_int_equal(before.retryCount + 3, after.retryCount);
+}
+
+void test_retryMessagesBackOffIndependently()
+{
+    resetCounters(1);
+    // first message fails its first retry, second one is sent on its own schedule
+    assert_int_equal(0, scheduleNotifyRetry(strdup("first"), sendMessage, freeMessage, 0));
+    fakeNow += 2;
+    assert_int_equal(0, scheduleNotifyRetry(strdup("second"), sendMessage, freeMessage, 0));
+    fakeNow += 1;
+    assert_int_equal(2, runNotifyRetries());
+    assert_int_equal(1, sendCount);
+    fakeNow += 2;
+    assert_int_equal(1, runNotifyRetries());
+    assert_int_equal(2, sendCount);
+    assert_int_equal(1, freeCount);
+    fakeNow += 5;
+    assert_int_equal(0, runNotifyRetries());
+    assert_int_equal(3, sendCount);
+    assert_int_equal(2, freeCount);
+}
+
+void err_scheduleWithoutSendCallback()
+{
+    assert_int_equal(-1, scheduleNotifyRetry(NULL, NULL, NULL, 0));
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_retryAfterBackoff),
+        cmocka_unit_test(err_retryDropsAfterMaxRetries),
+        cmocka_unit_test(test_retryMessagesBackOffIndependently),
+        cmocka_unit_test(err_scheduleWithoutSendCallback)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
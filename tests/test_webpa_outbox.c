@@ -0,0 +1,326 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_outbox.h"
+
+#define TEST_OUTBOX_FILE        "/tmp/test_webpa_outbox.bin"
+#define MAX_SENT_EVENTS         16
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static char sentPayloads[MAX_SENT_EVENTS][64];
+static int sentCount = 0;
+static int failAfter = -1;
+static const char *rejectPayload = NULL;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+static int sendEvent(const char *source, const char *dest, const char *payload, size_t payloadLen, void *userData)
+{
+    (void) userData;
+    if(failAfter >= 0 && sentCount >= failAfter)
+    {
+        return WEBPA_OUTBOX_SEND_FAILED;
+    }
+    if(rejectPayload != NULL && strcmp(rejectPayload, payload) == 0)
+    {
+        return WEBPA_OUTBOX_SEND_REJECTED;
+    }
+    assert_string_equal("mac:112233445566/config", source);
+    assert_string_equal("event:SYNC_NOTIFICATION", dest);
+    assert_int_equal(strlen(payload), payloadLen);
+    strncpy(sentPayloads[sentCount], payload, sizeof(sentPayloads[0]) - 1);
+    sentCount++;
+    return WEBPA_OUTBOX_SEND_OK;
+}
+
+static NotifyOutbox * openTestOutbox(unsigned int capacity, unsigned int maxAgeSec)
+{
+    sentCount = 0;
+    failAfter = -1;
+    rejectPayload = NULL;
+    memset(sentPayloads, 0, sizeof(sentPayloads));
+    return outboxOpen(TEST_OUTBOX_FILE, capacity, maxAgeSec);
+}
+
+static int appendEvent(NotifyOutbox *outbox, const char *payload, uint64_t *seq)
+{
+    return outboxAppend(outbox, "mac:112233445566/config", "event:SYNC_NOTIFICATION", payload, strlen(payload), seq);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_outboxReplayInOrder()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    assert_int_equal(0, appendEvent(outbox, "{\"cmc\":1}", NULL));
+    assert_int_equal(0, appendEvent(outbox, "{\"cmc\":2}", NULL));
+    assert_int_equal(0, appendEvent(outbox, "{\"cmc\":3}", NULL));
+
+    assert_int_equal(3, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":1}", sentPayloads[0]);
+    assert_string_equal("{\"cmc\":2}", sentPayloads[1]);
+    assert_string_equal("{\"cmc\":3}", sentPayloads[2]);
+
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(0, stats.pendingCount);
+    assert_int_equal(3, stats.ackCount);
+    assert_int_equal(0, stats.used);
+    assert_int_equal(0, outboxReplay(outbox, sendEvent, NULL));
+    outboxClose(outbox);
+}
+
+void err_outboxReplayStopsAtSendFailure()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    appendEvent(outbox, "{\"cmc\":1}", NULL);
+    appendEvent(outbox, "{\"cmc\":2}", NULL);
+    appendEvent(outbox, "{\"cmc\":3}", NULL);
+
+    failAfter = 1;
+    assert_int_equal(-1, outboxReplay(outbox, sendEvent, NULL));
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(2, stats.pendingCount);
+
+    // parodus is back, remaining events go out in the order they were added
+    failAfter = -1;
+    assert_int_equal(2, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":2}", sentPayloads[1]);
+    assert_string_equal("{\"cmc\":3}", sentPayloads[2]);
+    outboxClose(outbox);
+}
+
+void err_outboxRejectedEventIsDropped()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+    int i = 0;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    appendEvent(outbox, "{\"cmc\":1}", NULL);
+    appendEvent(outbox, "{\"cmc\":2}", NULL);
+
+    rejectPayload = "{\"cmc\":1}";
+    for(i = 1; i < WEBPA_OUTBOX_MAX_ATTEMPTS; i++)
+    {
+        assert_int_equal(-1, outboxReplay(outbox, sendEvent, NULL));
+    }
+    assert_int_equal(0, sentCount);
+
+    // failed attempts are kept across a reopen
+    outboxClose(outbox);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    rejectPayload = "{\"cmc\":1}";
+
+    // the rejected event no longer holds back the one behind it and is dropped once that is sent
+    assert_int_equal(1, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":2}", sentPayloads[0]);
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(0, stats.pendingCount);
+    assert_int_equal(1, stats.dropCount);
+    outboxClose(outbox);
+}
+
+void err_outboxSendFailureKeepsEvents()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+    int i = 0;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    appendEvent(outbox, "{\"cmc\":1}", NULL);
+    appendEvent(outbox, "{\"cmc\":2}", NULL);
+
+    // an event held back by a rejected one is not sent while parodus is down
+    rejectPayload = "{\"cmc\":1}";
+    for(i = 1; i < WEBPA_OUTBOX_MAX_ATTEMPTS; i++)
+    {
+        assert_int_equal(-1, outboxReplay(outbox, sendEvent, NULL));
+    }
+    failAfter = 0;
+    for(i = 0; i < 2 * WEBPA_OUTBOX_MAX_ATTEMPTS; i++)
+    {
+        assert_int_equal(-1, outboxReplay(outbox, sendEvent, NULL));
+    }
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(2, stats.pendingCount);
+    assert_int_equal(0, stats.dropCount);
+
+    // parodus is back, both events go out in order
+    failAfter = -1;
+    rejectPayload = NULL;
+    assert_int_equal(2, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":1}", sentPayloads[0]);
+    assert_string_equal("{\"cmc\":2}", sentPayloads[1]);
+    outboxClose(outbox);
+}
+
+void test_outboxAppendsAreNotSyncedEach()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+    int i = 0;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    for(i = 0; i < 10; i++)
+    {
+        assert_int_equal(0, appendEvent(outbox, "{\"cmc\":1}", NULL));
+    }
+    assert_int_equal(10, outboxReplay(outbox, sendEvent, NULL));
+
+    // appends and acks within the sync interval stay in the page cache
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(0, stats.syncCount);
+    outboxClose(outbox);
+}
+
+void test_outboxPendingEventsSurviveReopen()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+    uint64_t seq = 0;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    appendEvent(outbox, "{\"cmc\":1}", &seq);
+    appendEvent(outbox, "{\"cmc\":2}", NULL);
+    assert_int_equal(0, outboxAck(outbox, seq));
+    assert_int_equal(-1, outboxAck(outbox, seq));
+    outboxClose(outbox);
+
+    outbox = openTestOutbox(4096, 0);
+    assert_non_null(outbox);
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(1, stats.pendingCount);
+    assert_int_equal(1, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":2}", sentPayloads[0]);
+
+    // sequence numbers continue after a reopen
+    appendEvent(outbox, "{\"cmc\":3}", &seq);
+    assert_int_equal(3, seq);
+    outboxClose(outbox);
+
+    // a different size starts a new outbox
+    outbox = openTestOutbox(8192, 0);
+    assert_non_null(outbox);
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(0, stats.pendingCount);
+    outboxClose(outbox);
+}
+
+void err_outboxFullDropsOldestPending()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+    char payload[32];
+    char large[512];
+    int i = 0;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(256, 0);
+    assert_non_null(outbox);
+    for(i = 0; i < 8; i++)
+    {
+        snprintf(payload, sizeof(payload), "{\"cmc\":%d}", i);
+        assert_int_equal(0, appendEvent(outbox, payload, NULL));
+    }
+    outboxGetStats(outbox, &stats);
+    assert_true(stats.dropCount > 0);
+    assert_true(stats.used <= 256);
+    assert_int_equal(8 - stats.dropCount, stats.pendingCount);
+    // compaction replaced the outbox file
+    assert_int_equal(-1, access(TEST_OUTBOX_FILE ".tmp", F_OK));
+
+    // newest events are kept
+    assert_int_equal(stats.pendingCount, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":7}", sentPayloads[sentCount - 1]);
+
+    memset(large, 'x', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\0';
+    assert_int_equal(-1, appendEvent(outbox, large, NULL));
+    outboxClose(outbox);
+}
+
+void test_outboxExpiredEventsAreNotSent()
+{
+    NotifyOutboxStats stats;
+    NotifyOutbox *outbox = NULL;
+
+    remove(TEST_OUTBOX_FILE);
+    outbox = openTestOutbox(4096, 1);
+    assert_non_null(outbox);
+    appendEvent(outbox, "{\"cmc\":1}", NULL);
+    sleep(2);
+    appendEvent(outbox, "{\"cmc\":2}", NULL);
+    assert_int_equal(1, outboxReplay(outbox, sendEvent, NULL));
+    assert_string_equal("{\"cmc\":2}", sentPayloads[0]);
+    outboxGetStats(outbox, &stats);
+    assert_int_equal(1, stats.expiredCount);
+    outboxClose(outbox);
+    remove(TEST_OUTBOX_FILE);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_outboxReplayInOrder),
+        cmocka_unit_test(err_outboxReplayStopsAtSendFailure),
+        cmocka_unit_test(err_outboxRejectedEventIsDropped),
+        cmocka_unit_test(err_outboxSendFailureKeepsEvents),
+        cmocka_unit_test(test_outboxAppendsAreNotSyncedEach),
+        cmocka_unit_test(test_outboxPendingEventsSurviveReopen),
+        cmocka_unit_test(err_outboxFullDropsOldestPending),
+        cmocka_unit_test(test_outboxExpiredEventsAreNotSent)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,264 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_request_parser.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define BENCH_GET_NAMES     32
+#define BENCH_SET_PARAMS    64
+#define BENCH_ROUNDS        2000
+
+/*----------------------------------------------------------------------------*/
+/*                                   Helpers                                  */
+/*----------------------------------------------------------------------------*/
+static int parseFast(const char *payload, req_struct **reqObj)
+{
+    return parseFastRequest(payload, strlen(payload), reqObj);
+}
+
+static void assertFallback(const char *payload)
+{
+    req_struct *reqObj = (req_struct *) 1;
+
+    assert_int_equal(-1, parseFast(payload, &reqObj));
+    assert_null(reqObj);
+}
+
+/*
+ * @brief newGetPayload is a GET of count names spread over the WiFi and Hosts
+ * objects, about 40 bytes per name
+ */
+static char * newGetPayload(int count)
+{
+    char *payload = (char *) malloc(64 * (count + 1));
+    size_t len = 0;
+    int i = 0;
+
+    len = sprintf(payload, "{\"names\":[");
+    for(i = 0; i < count; i++)
+    {
+        len += sprintf(payload + len, "%s\"Device.WiFi.SSID.%d.Stats.BytesSent\"", (i > 0) ? "," : "", 10001 + i);
+    }
+    sprintf(payload + len, "],\"command\":\"GET\"}");
+    return payload;
+}
+
+static char * newSetPayload(int count)
+{
+    char *payload = (char *) malloc(128 * (count + 1));
+    size_t len = 0;
+    int i = 0;
+
+    len = sprintf(payload, "{\"parameters\":[");
+    for(i = 0; i < count; i++)
+    {
+        len += sprintf(payload + len, "%s{\"name\":\"Device.NAT.PortMapping.%d.Description\",\"value\":\"rule \\\"%d\\\"\",\"dataType\":0}", (i > 0) ? "," : "", i + 1, i);
+    }
+    sprintf(payload + len, "],\"command\":\"SET\"}");
+    return payload;
+}
+
+static void assertSameRequest(const req_struct *expected, const req_struct *actual)
+{
+    size_t i = 0;
+
+    assert_int_equal(expected->reqType, actual->reqType);
+    if(expected->reqType == GET)
+    {
+        assert_int_equal(expected->u.getReq->paramCnt, actual->u.getReq->paramCnt);
+        for(i = 0; i < expected->u.getReq->paramCnt; i++)
+        {
+            assert_string_equal(expected->u.getReq->paramNames[i], actual->u.getReq->paramNames[i]);
+        }
+        return;
+    }
+    assert_int_equal(expected->u.setReq->paramCnt, actual->u.setReq->paramCnt);
+    for(i = 0; i < expected->u.setReq->paramCnt; i++)
+    {
+        assert_string_equal(expected->u.setReq->param[i].name, actual->u.setReq->param[i].name);
+        assert_string_equal(expected->u.setReq->param[i].value, actual->u.setReq->param[i].value);
+        assert_int_equal(expected->u.setReq->param[i].type, actual->u.setReq->param[i].type);
+    }
+}
+
+static long elapsedUs(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start->tv_sec) * 1000000) + ((end.tv_nsec - start->tv_nsec) / 1000);
+}
+
+/*
+ * @brief benchParsers parses a payload with both parsers, checks they agree
+ * and prints the time per request
+ */
+static void benchParsers(const char *label, char *payload)
+{
+    struct timespec start;
+    req_struct *fullReq = NULL, *fastReq = NULL;
+    long fullUs = 0, fastUs = 0;
+    int i = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        wdmp_parse_request(payload, &fullReq);
+        wdmp_free_req_struct(fullReq);
+    }
+    fullUs = elapsedUs(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        assert_int_equal(0, parseFast(payload, &fastReq));
+        free(fastReq);
+    }
+    fastUs = elapsedUs(&start);
+
+    printf("%s of %zu bytes: wdmp %.2f us, fast path %.2f us per request\n", label, strlen(payload), (double) fullUs / BENCH_ROUNDS, (double) fastUs / BENCH_ROUNDS);
+    wdmp_parse_request(payload, &fullReq);
+    assert_non_null(fullReq);
+    assert_int_equal(0, parseFast(payload, &fastReq));
+    assertSameRequest(fullReq, fastReq);
+    wdmp_free_req_struct(fullReq);
+    free(fastReq);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_fastGetRequest()
+{
+    req_struct *reqObj = NULL;
+
+    assert_int_equal(0, parseFast("{ \"names\":[\"Device.WiFi.SSID.10001.name\",\"Device.Webpa.\"],\"command\": \"GET\"}", &reqObj));
+    assert_non_null(reqObj);
+    assert_int_equal(GET, reqObj->reqType);
+    assert_int_equal(2, reqObj->u.getReq->paramCnt);
+    assert_string_equal("Device.WiFi.SSID.10001.name", reqObj->u.getReq->paramNames[0]);
+    assert_string_equal("Device.Webpa.", reqObj->u.getReq->paramNames[1]);
+    free(reqObj);
+
+    assert_int_equal(0, parseFast("\r\n{\n\t\"command\" : \"GET\" ,\n\t\"names\" : [ \"Device.DeviceInfo.\" ]\n}\n", &reqObj));
+    assert_int_equal(1, reqObj->u.getReq->paramCnt);
+    assert_string_equal("Device.DeviceInfo.", reqObj->u.getReq->paramNames[0]);
+    free(reqObj);
+}
+
+void test_fastSetRequest()
+{
+    req_struct *reqObj = NULL;
+
+    assert_int_equal(0, parseFast("{\"parameters\":[{\"name\":\"Device.WiFi.SSID.10001.SSID\",\"value\":\"my \\\"home\\\"\\\\net\\n\",\"dataType\":0},{\"dataType\":3,\"value\":\"true\",\"name\":\"Device.WiFi.SSID.10001.Enable\"}],\"command\":\"SET\"}", &reqObj));
+    assert_non_null(reqObj);
+    assert_int_equal(SET, reqObj->reqType);
+    assert_int_equal(2, reqObj->u.setReq->paramCnt);
+    assert_string_equal("Device.WiFi.SSID.10001.SSID", reqObj->u.setReq->param[0].name);
+    assert_string_equal("my \"home\"\\net\n", reqObj->u.setReq->param[0].value);
+    assert_int_equal(WDMP_STRING, reqObj->u.setReq->param[0].type);
+    assert_string_equal("Device.WiFi.SSID.10001.Enable", reqObj->u.setReq->param[1].name);
+    assert_string_equal("true", reqObj->u.setReq->param[1].value);
+    assert_int_equal(WDMP_BOOLEAN, reqObj->u.setReq->param[1].type);
+    free(reqObj);
+}
+
+void test_fastRequestFallback()
+{
+    // shapes left to wdmp_parse_request
+    assertFallback("{ \"names\":[\"Device.DeviceInfo.Webpa.Enable\"],\"attributes\":\"notify\",\"command\": \"GET_ATTRIBUTES\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":1,\"dataType\":1}],\"command\":\"SET\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":\"\\u00e9\",\"dataType\":0}],\"command\":\"SET\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":\"a\",\"dataType\":1.5}],\"command\":\"SET\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":\"a\"}],\"command\":\"SET\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":\"a\",\"dataType\":0,\"attributes\":{\"notify\":1}}],\"command\":\"SET\"}");
+    assertFallback("{\"names\":[\"Device.X\"],\"command\":\"SET\"}");
+    assertFallback("{\"names\":[],\"command\":\"GET\"}");
+    assertFallback("{\"names\":[\"Device.X\"]}");
+    assertFallback("{\"names\":[\"Device.X\"],\"names\":[\"Device.Y\"],\"command\":\"GET\"}");
+    assertFallback("{\"names\":[\"Device.X\"],\"command\":\"GET\",\"new-cid\":\"abc\"}");
+}
+
+void test_parseWebpaRequest()
+{
+    req_struct *reqObj = NULL;
+
+    assert_int_equal(WEBPA_PARSER_NONE, parseWebpaRequest(NULL, &reqObj));
+    assert_null(reqObj);
+    assert_int_equal(WEBPA_PARSER_FAST, parseWebpaRequest("{\"names\":[\"Device.X\"],\"command\":\"GET\"}", &reqObj));
+    freeWebpaRequest(reqObj, WEBPA_PARSER_FAST);
+    freeWebpaRequest(NULL, WEBPA_PARSER_FULL);
+}
+
+void test_requestParserBenchmark()
+{
+    char *payload = NULL;
+
+    benchParsers("Single GET", "{ \"names\":[\"Device.DeviceInfo.Webpa.Enable\"],\"command\": \"GET\"}");
+    payload = newGetPayload(BENCH_GET_NAMES);
+    benchParsers("GET", payload);
+    free(payload);
+    payload = newSetPayload(BENCH_SET_PARAMS);
+    benchParsers("SET", payload);
+    free(payload);
+}
+
+void err_parseFastRequest()
+{
+    req_struct *reqObj = NULL;
+
+    assert_int_equal(-1, parseFastRequest(NULL, 0, &reqObj));
+    assert_null(reqObj);
+
+    // malformed payloads
+    assertFallback("");
+    assertFallback("{\"names\":[\"Device.X\"],\"command\":\"GET\"");
+    assertFallback("{\"names\":[\"Device.X],\"command\":\"GET\"}");
+    assertFallback("{\"names\":[\"Device.X\",],\"command\":\"GET\"}");
+    assertFallback("{\"names\":[\"Device.X\"],\"command\":\"GET\"} trailing");
+    assertFallback("{\"names\":[\"Device.X\"] \"command\":\"GET\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":\"a\\q\",\"dataType\":0}],\"command\":\"SET\"}");
+    assertFallback("{\"parameters\":[{\"name\":\"Device.X\",\"value\":\"a\",\"dataType\":12}],\"command\":\"SET\"}");
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_fastGetRequest),
+        cmocka_unit_test(test_fastSetRequest),
+        cmocka_unit_test(test_fastRequestFallback),
+        cmocka_unit_test(test_parseWebpaRequest),
+        cmocka_unit_test(err_parseFastRequest),
+        cmocka_unit_test(test_requestParserBenchmark)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
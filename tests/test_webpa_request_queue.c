@@ -0,0 +1,329 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_request_queue.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+int numLoops = 0;
+static int handled[16];
+static int handledCount = 0;
+static int blockedCount = 0;
+static int rejected[8];
+static int rejectedCount = 0;
+static pthread_mutex_t testMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t testCond = PTHREAD_COND_INITIALIZER;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+static void recordRequest(void *request)
+{
+    handled[handledCount++] = *((int *) request);
+}
+
+static void rejectRequest(void *request, int reqType)
+{
+    (void) reqType;
+    rejected[rejectedCount++] = *((int *) request);
+}
+
+// holds each request until two are processed at the same time
+static void blockingRequest(void *request)
+{
+    struct timespec deadline;
+
+    (void) request;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+    pthread_mutex_lock(&testMutex);
+    blockedCount++;
+    pthread_cond_broadcast(&testCond);
+    while(blockedCount < 2)
+    {
+        if(pthread_cond_timedwait(&testCond, &testMutex, &deadline) != 0)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&testMutex);
+}
+
+// while the first write runs, the test acts as a second worker
+static void nestedRequest(void *request)
+{
+    handled[handledCount++] = *((int *) request);
+    if(*((int *) request) == 1)
+    {
+        assert_int_equal(1, processNextRequest());
+        // only the second write is left and it waits for the first one
+        assert_int_equal(0, processNextRequest());
+    }
+}
+
+static void *processTask(void *arg)
+{
+    (void) arg;
+    processNextRequest();
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_requestQueueWithoutWorkers()
+{
+    int request = 1;
+
+    assert_int_equal(-1, submitWebpaRequest(&request, GET, REQUEST_CLASS_INTERACTIVE));
+    initRequestQueue(recordRequest, rejectRequest);
+    // no workers yet, the receiver processes the request itself
+    assert_int_equal(-1, submitWebpaRequest(&request, GET, REQUEST_CLASS_INTERACTIVE));
+    assert_int_equal(0, processNextRequest());
+}
+
+void test_requestQueueOrder()
+{
+    WebpaRequestStats stats;
+    int requests[3] = {1, 2, 3};
+    int i = 0;
+
+    // numLoops is 0, the worker exits at once and the test drains the queue
+    initRequestQueue(recordRequest, rejectRequest);
+    assert_int_equal(1, startRequestWorkers(1));
+    for(i = 0; i < 3; i++)
+    {
+        assert_int_equal(0, submitWebpaRequest(&requests[i], GET, REQUEST_CLASS_INTERACTIVE));
+    }
+    getWebpaRequestStats(&stats);
+    assert_int_equal(3, stats.submittedCount);
+    assert_int_equal(3, stats.pendingCount);
+
+    while(processNextRequest());
+    assert_int_equal(3, handledCount);
+    for(i = 0; i < 3; i++)
+    {
+        assert_int_equal(requests[i], handled[i]);
+    }
+    getWebpaRequestStats(&stats);
+    assert_int_equal(3, stats.completedCount);
+    assert_int_equal(0, stats.pendingCount);
+    assert_int_equal(0, stats.activeCount);
+}
+
+void test_requestQueueOverlap()
+{
+    WebpaRequestStats stats;
+    pthread_t threads[2];
+    int requests[2] = {1, 2};
+    int i = 0;
+
+    initRequestQueue(blockingRequest, rejectRequest);
+    for(i = 0; i < 2; i++)
+    {
+        assert_int_equal(0, submitWebpaRequest(&requests[i], GET, REQUEST_CLASS_INTERACTIVE));
+    }
+    for(i = 0; i < 2; i++)
+    {
+        pthread_create(&threads[i], NULL, processTask, NULL);
+    }
+    for(i = 0; i < 2; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    // the second request started before the first one finished
+    getWebpaRequestStats(&stats);
+    assert_int_equal(2, blockedCount);
+    assert_int_equal(2, stats.maxActiveCount);
+    assert_int_equal(5, stats.completedCount);
+}
+
+void test_requestQueueLimits()
+{
+    WebpaRequestLimits limits;
+    WebpaRequestStats stats;
+    int requests[4] = {1, 2, 3, 4};
+
+    getWebpaRequestLimits(&limits);
+    assert_int_equal(WEBPA_REQUEST_MAX_IN_FLIGHT, limits.maxInFlight);
+    assert_int_equal(WEBPA_REQUEST_MAX_WAIT_MS, limits.maxWaitMs);
+
+    memset(&limits, 0, sizeof(limits));
+    limits.maxInFlight = 3;
+    limits.maxPerType[REPLACE_ROWS] = 1;
+    setWebpaRequestLimits(&limits);
+    initRequestQueue(recordRequest, rejectRequest);
+    handledCount = 0;
+
+    assert_int_equal(0, submitWebpaRequest(&requests[0], REPLACE_ROWS, REQUEST_CLASS_INTERACTIVE));
+    // one REPLACE_ROWS at a time, other types are still admitted
+    assert_int_equal(1, submitWebpaRequest(&requests[1], REPLACE_ROWS, REQUEST_CLASS_INTERACTIVE));
+    assert_int_equal(0, submitWebpaRequest(&requests[1], GET, REQUEST_CLASS_INTERACTIVE));
+    assert_int_equal(0, submitWebpaRequest(&requests[2], -1, REQUEST_CLASS_INTERACTIVE));
+    // in flight limit reached
+    assert_int_equal(1, submitWebpaRequest(&requests[3], GET, REQUEST_CLASS_INTERACTIVE));
+    getWebpaRequestStats(&stats);
+    assert_int_equal(2, stats.rejectedCount);
+
+    while(processNextRequest());
+    assert_int_equal(3, handledCount);
+    assert_int_equal(0, submitWebpaRequest(&requests[3], REPLACE_ROWS, REQUEST_CLASS_INTERACTIVE));
+    while(processNextRequest());
+    assert_int_equal(4, handledCount);
+    assert_int_equal(0, rejectedCount);
+}
+
+void test_requestQueueWaitLimit()
+{
+    WebpaRequestLimits limits;
+    WebpaRequestStats stats;
+    struct timespec pause = {0, 20 * 1000000};
+    int requests[2] = {1, 2};
+
+    memset(&limits, 0, sizeof(limits));
+    limits.maxWaitMs = 10;
+    setWebpaRequestLimits(&limits);
+    initRequestQueue(recordRequest, rejectRequest);
+    handledCount = 0;
+
+    assert_int_equal(0, submitWebpaRequest(&requests[0], SET, REQUEST_CLASS_INTERACTIVE));
+    nanosleep(&pause, NULL);
+    assert_int_equal(0, submitWebpaRequest(&requests[1], SET, REQUEST_CLASS_INTERACTIVE));
+    // only the first request is old enough to expire
+    assert_int_equal(1, processNextRequest());
+    limits.maxWaitMs = 0;
+    setWebpaRequestLimits(&limits);
+    assert_int_equal(1, processNextRequest());
+    assert_int_equal(1, rejectedCount);
+    assert_int_equal(requests[0], rejected[0]);
+    assert_int_equal(1, handledCount);
+    assert_int_equal(requests[1], handled[0]);
+    getWebpaRequestStats(&stats);
+    assert_int_equal(1, stats.expiredCount);
+    assert_int_equal(0, stats.pendingCount);
+}
+
+void test_requestQueuePriority()
+{
+    int control[10], bulk[3];
+    int i = 0;
+
+    initRequestQueue(recordRequest, rejectRequest);
+    handledCount = 0;
+    for(i = 0; i < 3; i++)
+    {
+        bulk[i] = 100 + i;
+        assert_int_equal(0, submitWebpaRequest(&bulk[i], REPLACE_ROWS, REQUEST_CLASS_BULK));
+    }
+    for(i = 0; i < 10; i++)
+    {
+        control[i] = i;
+        assert_int_equal(0, submitWebpaRequest(&control[i], TEST_AND_SET, REQUEST_CLASS_CONTROL));
+    }
+    while(processNextRequest());
+    assert_int_equal(13, handledCount);
+    // control requests go first, a bulk request gets its turn once per round
+    for(i = 0; i < WEBPA_REQUEST_CLASS_WEIGHT_CONTROL; i++)
+    {
+        assert_int_equal(i, handled[i]);
+    }
+    assert_int_equal(100, handled[WEBPA_REQUEST_CLASS_WEIGHT_CONTROL]);
+    assert_int_equal(8, handled[WEBPA_REQUEST_CLASS_WEIGHT_CONTROL + 1]);
+    assert_int_equal(9, handled[WEBPA_REQUEST_CLASS_WEIGHT_CONTROL + 2]);
+    assert_int_equal(101, handled[WEBPA_REQUEST_CLASS_WEIGHT_CONTROL + 3]);
+    assert_int_equal(102, handled[WEBPA_REQUEST_CLASS_WEIGHT_CONTROL + 4]);
+}
+
+void test_requestClass()
+{
+    const char *smallGet = "{\"names\":[\"Device.DeviceInfo.SerialNumber\"],\"command\":\"GET\"}";
+    const char *wildcardGet = "{\"names\":[\"Device.WiFi.\"],\"command\":\"GET\"}";
+    const char *reboot = "{\"parameters\":[{\"name\":\"Device.X_CISCO_COM_DeviceControl.RebootDevice\",\"value\":\"Device\",\"dataType\":0}],\"command\":\"SET\"}";
+    const char *sources[] = {"harvester"};
+    char largeSet[WEBPA_REQUEST_SMALL_PAYLOAD + 64];
+
+    memset(largeSet, 'a', sizeof(largeSet));
+    assert_int_equal(REQUEST_CLASS_CONTROL, getWebpaRequestClass(TEST_AND_SET, NULL, 0, NULL));
+    assert_int_equal(REQUEST_CLASS_CONTROL, getWebpaRequestClass(SET, reboot, strlen(reboot), "config"));
+    assert_int_equal(REQUEST_CLASS_BULK, getWebpaRequestClass(SET, largeSet, sizeof(largeSet), NULL));
+    assert_int_equal(REQUEST_CLASS_INTERACTIVE, getWebpaRequestClass(GET, smallGet, strlen(smallGet), NULL));
+    assert_int_equal(REQUEST_CLASS_BULK, getWebpaRequestClass(GET, wildcardGet, strlen(wildcardGet), NULL));
+    assert_int_equal(REQUEST_CLASS_BULK, getWebpaRequestClass(REPLACE_ROWS, NULL, 0, NULL));
+    assert_int_equal(REQUEST_CLASS_INTERACTIVE, getWebpaRequestClass(-1, NULL, 0, NULL));
+
+    setWebpaRequestBulkSources(sources, 1);
+    assert_int_equal(REQUEST_CLASS_BULK, getWebpaRequestClass(GET, smallGet, strlen(smallGet), "harvester"));
+    assert_int_equal(REQUEST_CLASS_INTERACTIVE, getWebpaRequestClass(GET, smallGet, strlen(smallGet), "config"));
+    setWebpaRequestBulkSources(NULL, 0);
+    assert_int_equal(REQUEST_CLASS_INTERACTIVE, getWebpaRequestClass(GET, smallGet, strlen(smallGet), "harvester"));
+}
+
+void test_requestQueueWritesRunOneAtATime()
+{
+    int requests[3] = {1, 2, 3};
+
+    initRequestQueue(nestedRequest, rejectRequest);
+    handledCount = 0;
+    assert_int_equal(0, submitWebpaRequest(&requests[0], SET, REQUEST_CLASS_INTERACTIVE));
+    assert_int_equal(0, submitWebpaRequest(&requests[1], ADD_ROWS, REQUEST_CLASS_INTERACTIVE));
+    assert_int_equal(0, submitWebpaRequest(&requests[2], GET, REQUEST_CLASS_INTERACTIVE));
+
+    // the GET overtakes the write that waits, writes keep their order
+    assert_int_equal(1, processNextRequest());
+    assert_int_equal(1, processNextRequest());
+    assert_int_equal(0, processNextRequest());
+    assert_int_equal(3, handledCount);
+    assert_int_equal(1, handled[0]);
+    assert_int_equal(3, handled[1]);
+    assert_int_equal(2, handled[2]);
+}
+
+void err_requestQueueNullRequest()
+{
+    assert_int_equal(-1, submitWebpaRequest(NULL, GET, REQUEST_CLASS_INTERACTIVE));
+    assert_int_equal(-1, submitWebpaRequest(&handledCount, GET, REQUEST_CLASS_COUNT));
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_requestQueueWithoutWorkers),
+        cmocka_unit_test(test_requestQueueOrder),
+        cmocka_unit_test(test_requestQueueOverlap),
+        cmocka_unit_test(test_requestQueueLimits),
+        cmocka_unit_test(test_requestQueueWaitLimit),
+        cmocka_unit_test(test_requestQueuePriority),
+        cmocka_unit_test(test_requestClass),
+        cmocka_unit_test(test_requestQueueWritesRunOneAtATime),
+        cmocka_unit_test(err_requestQueueNullRequest)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,464 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <msgpack.h>
+#include <cJSON.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_response_format.h"
+
+/*----------------------------------------------------------------------------*/
+/*                                   Macros                                   */
+/*----------------------------------------------------------------------------*/
+#define HOST_FIELDS         6
+#define HOST_COUNT          500
+#define BENCH_ROUNDS        20
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+static const char *hostFields[HOST_FIELDS] = {"PhysAddress", "IPAddress", "HostName", "Active", "Layer1Interface", "X_RDKCENTRAL-COM_LastChange"};
+static const char *hostValues[HOST_FIELDS] = {"b8:27:eb:50:a6:1f", "10.0.0.128", "living-room-tv", "true", "Device.WiFi.SSID.10001", "176342"};
+static size_t cjsonInUse = 0;
+static size_t cjsonPeak = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Helpers                                  */
+/*----------------------------------------------------------------------------*/
+static const msgpack_object * mapGet(const msgpack_object *map, const char *key)
+{
+    uint32_t i = 0;
+
+    assert_int_equal(MSGPACK_OBJECT_MAP, map->type);
+    for(i = 0; i < map->via.map.size; i++)
+    {
+        const msgpack_object *k = &map->via.map.ptr[i].key;
+        if(k->type == MSGPACK_OBJECT_STR && k->via.str.size == strlen(key) && strncmp(k->via.str.ptr, key, k->via.str.size) == 0)
+        {
+            return &map->via.map.ptr[i].val;
+        }
+    }
+    return NULL;
+}
+
+static void assertStr(const char *expected, const msgpack_object *obj)
+{
+    assert_non_null(obj);
+    assert_int_equal(MSGPACK_OBJECT_STR, obj->type);
+    assert_int_equal(strlen(expected), obj->via.str.size);
+    assert_memory_equal(expected, obj->via.str.ptr, obj->via.str.size);
+}
+
+static void assertInt(int expected, const msgpack_object *obj)
+{
+    assert_non_null(obj);
+    assert_int_equal(MSGPACK_OBJECT_POSITIVE_INTEGER, obj->type);
+    assert_int_equal(expected, obj->via.u64);
+}
+
+/*
+ * @brief newGetResponse builds a GET response of one wildcard name holding
+ * count rows of the Hosts table, allocated the way processRequest does
+ */
+static res_struct * newGetResponse(int count)
+{
+    res_struct *resObj = NULL;
+    char name[128];
+    int i = 0, j = 0, k = 0;
+
+    resObj = (res_struct *) calloc(1, sizeof(res_struct));
+    resObj->reqType = GET;
+    resObj->paramCnt = 1;
+    resObj->retStatus = (WDMP_STATUS *) calloc(1, sizeof(WDMP_STATUS));
+    resObj->u.getRes = (get_res_t *) calloc(1, sizeof(get_res_t));
+    resObj->u.getRes->paramCnt = 1;
+    resObj->u.getRes->paramNames = (char **) calloc(1, sizeof(char *));
+    resObj->u.getRes->paramNames[0] = strdup("Device.Hosts.Host.");
+    resObj->u.getRes->retParamCnt = (size_t *) calloc(1, sizeof(size_t));
+    resObj->u.getRes->retParamCnt[0] = count * HOST_FIELDS;
+    resObj->u.getRes->params = (param_t **) calloc(1, sizeof(param_t *));
+    resObj->u.getRes->params[0] = (param_t *) calloc(count * HOST_FIELDS, sizeof(param_t));
+    for(i = 0; i < count; i++)
+    {
+        for(j = 0; j < HOST_FIELDS; j++, k++)
+        {
+            snprintf(name, sizeof(name), "Device.Hosts.Host.%d.%s", i + 1, hostFields[j]);
+            resObj->u.getRes->params[0][k].name = strdup(name);
+            resObj->u.getRes->params[0][k].value = strdup(hostValues[j]);
+            resObj->u.getRes->params[0][k].type = (j == 3) ? WDMP_BOOLEAN : WDMP_STRING;
+        }
+    }
+    return resObj;
+}
+
+static void freeGetResponse(res_struct *resObj)
+{
+    size_t i = 0;
+
+    for(i = 0; i < resObj->u.getRes->retParamCnt[0]; i++)
+    {
+        free(resObj->u.getRes->params[0][i].name);
+        free(resObj->u.getRes->params[0][i].value);
+    }
+    free(resObj->u.getRes->params[0]);
+    free(resObj->u.getRes->params);
+    free(resObj->u.getRes->retParamCnt);
+    free(resObj->u.getRes->paramNames[0]);
+    free(resObj->u.getRes->paramNames);
+    free(resObj->u.getRes);
+    free(resObj->retStatus);
+    free(resObj);
+}
+
+/*
+ * cJSON allocations are counted to get the peak memory of wdmp_form_response,
+ * each block keeps its size ahead of the returned pointer
+ */
+static void * countingMalloc(size_t size)
+{
+    size_t *block = (size_t *) malloc((2 * sizeof(size_t)) + size);
+
+    block[0] = size;
+    cjsonInUse += size;
+    if(cjsonInUse > cjsonPeak)
+    {
+        cjsonPeak = cjsonInUse;
+    }
+    return block + 2;
+}
+
+static void countingFree(void *ptr)
+{
+    size_t *block = NULL;
+
+    if(ptr != NULL)
+    {
+        block = (size_t *) ptr - 2;
+        cjsonInUse -= block[0];
+        free(block);
+    }
+}
+
+static long elapsedUs(struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start->tv_sec) * 1000000) + ((end.tv_nsec - start->tv_nsec) / 1000);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_getResponseFormat()
+{
+    headers_t *headers = (headers_t *) malloc(sizeof(headers_t) + sizeof(char *) * 3);
+
+    assert_int_equal(WEBPA_FORMAT_JSON, getResponseFormat(NULL, NULL));
+    assert_int_equal(WEBPA_FORMAT_JSON, getResponseFormat("application/json", NULL));
+    assert_int_equal(WEBPA_FORMAT_MSGPACK, getResponseFormat("application/msgpack", NULL));
+    assert_int_equal(WEBPA_FORMAT_MSGPACK, getResponseFormat("Application/MsgPack; charset=binary", NULL));
+    assert_int_equal(WEBPA_FORMAT_JSON, getResponseFormat("application/msgpackx", NULL));
+
+    headers->count = 3;
+    headers->headers[0] = "traceparent: 00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01";
+    headers->headers[1] = NULL;
+    headers->headers[2] = "accept: application/msgpack";
+    assert_int_equal(WEBPA_FORMAT_MSGPACK, getResponseFormat("application/json", headers));
+    headers->headers[2] = "Accept: application/json";
+    assert_int_equal(WEBPA_FORMAT_JSON, getResponseFormat(NULL, headers));
+    free(headers);
+}
+
+void test_msgpackGetResponse()
+{
+    res_struct *resObj = newGetResponse(2);
+    msgpack_unpacked result;
+    const msgpack_object *params = NULL, *param = NULL, *values = NULL;
+    char *payload = NULL;
+    size_t payloadSize = 0;
+
+    assert_int_equal(0, formMsgpackResponse(resObj, &payload, &payloadSize));
+    assert_non_null(payload);
+    msgpack_unpacked_init(&result);
+    assert_int_equal(MSGPACK_UNPACK_SUCCESS, msgpack_unpack_next(&result, payload, payloadSize, NULL));
+    assertInt(200, mapGet(&result.data, "statusCode"));
+    params = mapGet(&result.data, "parameters");
+    assert_non_null(params);
+    assert_int_equal(MSGPACK_OBJECT_ARRAY, params->type);
+    assert_int_equal(1, params->via.array.size);
+    param = &params->via.array.ptr[0];
+    assertStr("Device.Hosts.Host.", mapGet(param, "name"));
+    assertInt(2 * HOST_FIELDS, mapGet(param, "parameterCount"));
+    assertInt(WDMP_NONE, mapGet(param, "dataType"));
+    assertStr("Success", mapGet(param, "message"));
+    values = mapGet(param, "value");
+    assert_non_null(values);
+    assert_int_equal(2 * HOST_FIELDS, values->via.array.size);
+    assertStr("Device.Hosts.Host.2.HostName", mapGet(&values->via.array.ptr[HOST_FIELDS + 2], "name"));
+    assertStr("living-room-tv", mapGet(&values->via.array.ptr[HOST_FIELDS + 2], "value"));
+    assertInt(WDMP_BOOLEAN, mapGet(&values->via.array.ptr[3], "dataType"));
+    msgpack_unpacked_destroy(&result);
+    free(payload);
+    freeGetResponse(resObj);
+}
+
+void test_msgpackSingleGetResponse()
+{
+    res_struct *resObj = newGetResponse(1);
+    msgpack_unpacked result;
+    const msgpack_object *param = NULL;
+    char *payload = NULL;
+    size_t payloadSize = 0;
+
+    // a name without the trailing dot is answered with its own value
+    free(resObj->u.getRes->paramNames[0]);
+    resObj->u.getRes->paramNames[0] = strdup("Device.Hosts.Host.1.PhysAddress");
+    assert_int_equal(0, formMsgpackResponse(resObj, &payload, &payloadSize));
+    msgpack_unpacked_init(&result);
+    assert_int_equal(MSGPACK_UNPACK_SUCCESS, msgpack_unpack_next(&result, payload, payloadSize, NULL));
+    param = &mapGet(&result.data, "parameters")->via.array.ptr[0];
+    assertStr("Device.Hosts.Host.1.PhysAddress", mapGet(param, "name"));
+    assertStr("b8:27:eb:50:a6:1f", mapGet(param, "value"));
+    assertInt(WDMP_STRING, mapGet(param, "dataType"));
+    assertInt(1, mapGet(param, "parameterCount"));
+    assertStr("Success", mapGet(param, "message"));
+    msgpack_unpacked_destroy(&result);
+    free(payload);
+    freeGetResponse(resObj);
+}
+
+/*
+ * @brief assertSameMsgpack checks that a response packed by formMsgpackResponse
+ * carries the statusCode and message of the wdmp JSON
+ */
+static void assertSameMsgpack(res_struct *resObj)
+{
+    msgpack_unpacked result, expected;
+    const msgpack_object *statusCode = NULL, *message = NULL, *packed = NULL;
+    char *json = NULL, *payload = NULL, *converted = NULL;
+    size_t payloadSize = 0, convertedSize = 0;
+
+    wdmp_form_response(resObj, &json);
+    assert_int_equal(0, convertJsonToMsgpack(json, &converted, &convertedSize));
+    assert_int_equal(0, formMsgpackResponse(resObj, &payload, &payloadSize));
+    msgpack_unpacked_init(&result);
+    msgpack_unpacked_init(&expected);
+    assert_int_equal(MSGPACK_UNPACK_SUCCESS, msgpack_unpack_next(&result, payload, payloadSize, NULL));
+    assert_int_equal(MSGPACK_UNPACK_SUCCESS, msgpack_unpack_next(&expected, converted, convertedSize, NULL));
+    assert_int_equal(expected.data.via.map.size, result.data.via.map.size);
+    statusCode = mapGet(&expected.data, "statusCode");
+    message = mapGet(&expected.data, "message");
+    assert_non_null(statusCode);
+    assertInt(statusCode->via.u64, mapGet(&result.data, "statusCode"));
+    assert_int_not_equal(200, statusCode->via.u64);
+    if(message != NULL)
+    {
+        packed = mapGet(&result.data, "message");
+        assert_non_null(packed);
+        assert_int_equal(message->via.str.size, packed->via.str.size);
+        assert_memory_equal(message->via.str.ptr, packed->via.str.ptr, message->via.str.size);
+    }
+    msgpack_unpacked_destroy(&result);
+    msgpack_unpacked_destroy(&expected);
+    free(converted);
+    free(payload);
+    free(json);
+}
+
+void test_msgpackErrorResponse()
+{
+    res_struct *resObj = newGetResponse(1);
+    res_struct rejected;
+    WDMP_STATUS status = WDMP_ERR_MAX_REQUEST;
+
+    // packed without the wdmp JSON once the status has been seen
+    resObj->retStatus[0] = WDMP_ERR_INVALID_PARAMETER_NAME;
+    assertSameMsgpack(resObj);
+    assertSameMsgpack(resObj);
+    freeGetResponse(resObj);
+
+    // a SET rejected before any name was processed, as formRejectResponse forms it
+    memset(&rejected, 0, sizeof(res_struct));
+    rejected.reqType = SET;
+    rejected.paramCnt = 1;
+    rejected.retStatus = &status;
+    assertSameMsgpack(&rejected);
+}
+
+/*
+ * Payload size, encode time and peak memory of a large Hosts table: JSON from
+ * wdmp, JSON written from the response and msgpack packed from the response.
+ * All carry the same keys and values, so the two JSON payloads are the same
+ * and converting the JSON gives a msgpack payload of the same size.
+ */
+void test_responseFormatBenchmark()
+{
+    res_struct *resObj = newGetResponse(HOST_COUNT);
+    struct timespec start;
+    cJSON_Hooks hooks = {countingMalloc, countingFree};
+    char *json = NULL, *written = NULL, *payload = NULL, *converted = NULL;
+    size_t payloadSize = 0, convertedSize = 0, jsonSize = 0, writtenSize = 0;
+    long jsonUs = 0, writtenUs = 0, msgpackUs = 0;
+    int i = 0;
+
+    cJSON_InitHooks(&hooks);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        countingFree(json);
+        wdmp_form_response(resObj, &json);
+    }
+    jsonUs = elapsedUs(&start) / BENCH_ROUNDS;
+    assert_non_null(json);
+    jsonSize = strlen(json);
+    countingFree(json);
+    json = NULL;
+    cJSON_InitHooks(NULL);
+    wdmp_form_response(resObj, &json);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        free(written);
+        assert_int_equal(0, formJsonResponse(resObj, &written, &writtenSize));
+    }
+    writtenUs = elapsedUs(&start) / BENCH_ROUNDS;
+    printf("Hosts table of %d rows: wdmp JSON %zu bytes %ld us peak %zu bytes, written JSON %zu bytes %ld us peak %zu bytes\n", HOST_COUNT, jsonSize, jsonUs, cjsonPeak, writtenSize, writtenUs, estimateJsonResponseSize(resObj));
+    assert_int_equal(jsonSize, writtenSize);
+    assert_string_equal(json, written);
+    assert_true(estimateJsonResponseSize(resObj) * 2 < cjsonPeak);
+    free(written);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCH_ROUNDS; i++)
+    {
+        free(payload);
+        assert_int_equal(0, formMsgpackResponse(resObj, &payload, &payloadSize));
+    }
+    msgpackUs = elapsedUs(&start) / BENCH_ROUNDS;
+
+    printf("Hosts table of %d rows: msgpack %zu bytes %ld us\n", HOST_COUNT, payloadSize, msgpackUs);
+    assert_true(payloadSize < jsonSize);
+    assert_int_equal(0, convertJsonToMsgpack(json, &converted, &convertedSize));
+    assert_int_equal(convertedSize, payloadSize);
+    free(converted);
+    free(payload);
+    free(json);
+    freeGetResponse(resObj);
+}
+
+/*
+ * @brief assertSameJson checks that formJsonResponse writes the exact JSON of
+ * wdmp_form_response and returns it
+ */
+static char * assertSameJson(res_struct *resObj)
+{
+    char *json = NULL, *payload = NULL;
+    size_t payloadSize = 0;
+
+    wdmp_form_response(resObj, &json);
+    assert_non_null(json);
+    assert_int_equal(0, formJsonResponse(resObj, &payload, &payloadSize));
+    assert_string_equal(json, payload);
+    assert_int_equal(strlen(payload), payloadSize);
+    free(json);
+    return payload;
+}
+
+void test_jsonGetResponse()
+{
+    res_struct *resObj = newGetResponse(1);
+    char *payload = NULL;
+
+    free(resObj->u.getRes->params[0][2].value);
+    resObj->u.getRes->params[0][2].value = strdup("tv \"den\"\\\n\x01");
+    payload = assertSameJson(resObj);
+    assert_string_equal("{\"parameters\":[{\"name\":\"Device.Hosts.Host.\",\"value\":["
+        "{\"name\":\"Device.Hosts.Host.1.PhysAddress\",\"value\":\"b8:27:eb:50:a6:1f\",\"dataType\":0},"
+        "{\"name\":\"Device.Hosts.Host.1.IPAddress\",\"value\":\"10.0.0.128\",\"dataType\":0},"
+        "{\"name\":\"Device.Hosts.Host.1.HostName\",\"value\":\"tv \\\"den\\\"\\\\\\n\\u0001\",\"dataType\":0},"
+        "{\"name\":\"Device.Hosts.Host.1.Active\",\"value\":\"true\",\"dataType\":3},"
+        "{\"name\":\"Device.Hosts.Host.1.Layer1Interface\",\"value\":\"Device.WiFi.SSID.10001\",\"dataType\":0},"
+        "{\"name\":\"Device.Hosts.Host.1.X_RDKCENTRAL-COM_LastChange\",\"value\":\"176342\",\"dataType\":0}],"
+        "\"dataType\":11,\"parameterCount\":6,\"message\":\"Success\"}],\"statusCode\":200}", payload);
+    assert_int_equal(strlen(payload) + 1, estimateJsonResponseSize(resObj));
+    free(payload);
+
+    // a name without the trailing dot is answered with its own value
+    free(resObj->u.getRes->paramNames[0]);
+    resObj->u.getRes->paramNames[0] = strdup("Device.Hosts.Host.1.PhysAddress");
+    resObj->u.getRes->params[0][0].type = WDMP_BOOLEAN;
+    payload = assertSameJson(resObj);
+    assert_string_equal("{\"parameters\":[{\"name\":\"Device.Hosts.Host.1.PhysAddress\",\"value\":\"b8:27:eb:50:a6:1f\",\"dataType\":3,\"parameterCount\":1,\"message\":\"Success\"}],\"statusCode\":200}", payload);
+    free(payload);
+    freeGetResponse(resObj);
+}
+
+void test_jsonErrorResponse()
+{
+    res_struct *resObj = newGetResponse(1);
+    char *payload = NULL;
+    size_t payloadSize = 0;
+
+    // not a plain success, formed by wdmp
+    resObj->retStatus[0] = WDMP_ERR_INVALID_PARAMETER_NAME;
+    assert_int_equal(0, estimateJsonResponseSize(resObj));
+    assert_int_equal(0, formJsonResponse(resObj, &payload, &payloadSize));
+    assert_non_null(payload);
+    assert_int_equal(strlen(payload), payloadSize);
+    assert_null(strstr(payload, "\"statusCode\":200"));
+    free(payload);
+    freeGetResponse(resObj);
+}
+
+void err_formMsgpackResponse()
+{
+    char *payload = NULL;
+    size_t payloadSize = 0;
+
+    assert_int_equal(-1, convertJsonToMsgpack(NULL, &payload, &payloadSize));
+    assert_int_equal(-1, convertJsonToMsgpack("{\"statusCode\":", &payload, &payloadSize));
+    assert_null(payload);
+    assert_int_equal(0, payloadSize);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_getResponseFormat),
+        cmocka_unit_test(test_msgpackGetResponse),
+        cmocka_unit_test(test_msgpackSingleGetResponse),
+        cmocka_unit_test(test_msgpackErrorResponse),
+        cmocka_unit_test(test_jsonGetResponse),
+        cmocka_unit_test(test_jsonErrorResponse),
+        cmocka_unit_test(test_responseFormatBenchmark),
+        cmocka_unit_test(err_formMsgpackResponse)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,158 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_sync_state.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+// write-behind thread exits right away, tests persist with flushSyncState()
+int numLoops = 0;
+static int storeCount = 0;
+static WDMP_STATUS storeResult = WDMP_SUCCESS;
+static char storedCMC[32] = {'\0'};
+static char storedCID[64] = {'\0'};
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+static WDMP_STATUS storeSyncState(const char *name, const char *value)
+{
+    storeCount++;
+    if(storeResult != WDMP_SUCCESS)
+    {
+        return storeResult;
+    }
+    if(strcmp(name, SYNC_STATE_CMC_NAME) == 0)
+    {
+        strncpy(storedCMC, value, sizeof(storedCMC) - 1);
+    }
+    else if(strcmp(name, SYNC_STATE_CID_NAME) == 0)
+    {
+        strncpy(storedCID, value, sizeof(storedCID) - 1);
+    }
+    return WDMP_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void err_syncStateNotInitialized()
+{
+    unsigned int cmc = 0;
+    char *cid = NULL;
+    char cidBuf[SYNC_STATE_CID_LEN] = {'\0'};
+
+    assert_int_equal(0, isSyncStateInitialized());
+    assert_int_equal(WDMP_FAILURE, getSyncStateCMC(&cmc));
+    assert_int_equal(WDMP_FAILURE, getSyncStateCID(&cid));
+    assert_null(cid);
+    assert_int_equal(WDMP_FAILURE, getSyncStateValues(&cmc, cidBuf, sizeof(cidBuf)));
+    assert_int_equal(WDMP_FAILURE, updateSyncStateCMC(512));
+}
+
+void test_syncStateUpdateIsWriteBehind()
+{
+    unsigned int cmc = 0;
+    char *cid = NULL;
+
+    initSyncState(5, "abcd", storeSyncState);
+    assert_int_equal(1, isSyncStateInitialized());
+    assert_int_equal(WDMP_SUCCESS, getSyncStateCMC(&cmc));
+    assert_int_equal(5, cmc);
+    assert_int_equal(WDMP_SUCCESS, getSyncStateCID(&cid));
+    assert_string_equal("abcd", cid);
+    WAL_FREE(cid);
+
+    // new value is visible right away, DB is written on flush
+    assert_int_equal(WDMP_SUCCESS, updateSyncStateCMC(517));
+    assert_int_equal(WDMP_SUCCESS, getSyncStateCMC(&cmc));
+    assert_int_equal(517, cmc);
+    assert_int_equal(0, storeCount);
+
+    assert_int_equal(WDMP_SUCCESS, updateSyncStateCID("61f4db9"));
+    assert_int_equal(WDMP_SUCCESS, flushSyncState());
+    assert_int_equal(2, storeCount);
+    assert_string_equal("517", storedCMC);
+    assert_string_equal("61f4db9", storedCID);
+
+    // unchanged values are not written again
+    assert_int_equal(WDMP_SUCCESS, updateSyncStateCMC(517));
+    assert_int_equal(WDMP_SUCCESS, flushSyncState());
+    assert_int_equal(2, storeCount);
+}
+
+void err_syncStateStoreFailureKeepsValuePending()
+{
+    storeCount = 0;
+    storeResult = WDMP_FAILURE;
+    assert_int_equal(WDMP_SUCCESS, updateSyncStateCMC(512));
+    assert_int_equal(WDMP_FAILURE, flushSyncState());
+    assert_int_equal(1, storeCount);
+
+    storeResult = WDMP_SUCCESS;
+    assert_int_equal(WDMP_SUCCESS, flushSyncState());
+    assert_int_equal(2, storeCount);
+    assert_string_equal("512", storedCMC);
+}
+
+void test_syncStateRefreshIsNotPersisted()
+{
+    unsigned int cmc = 0;
+    char *cid = NULL;
+    char cidBuf[4] = {'\0'};
+
+    storeCount = 0;
+    refreshSyncStateCMC(768);
+    refreshSyncStateCID("xyz");
+    assert_int_equal(WDMP_SUCCESS, getSyncStateCMC(&cmc));
+    assert_int_equal(768, cmc);
+    assert_int_equal(WDMP_SUCCESS, getSyncStateCID(&cid));
+    assert_string_equal("xyz", cid);
+    WAL_FREE(cid);
+    cmc = 0;
+    assert_int_equal(WDMP_SUCCESS, getSyncStateValues(&cmc, cidBuf, sizeof(cidBuf)));
+    assert_int_equal(768, cmc);
+    assert_string_equal("xyz", cidBuf);
+    assert_int_equal(WDMP_SUCCESS, flushSyncState());
+    assert_int_equal(0, storeCount);
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(err_syncStateNotInitialized),
+        cmocka_unit_test(test_syncStateUpdateIsWriteBehind),
+        cmocka_unit_test(err_syncStateStoreFailureKeepsValuePending),
+        cmocka_unit_test(test_syncStateRefreshIsNotPersisted)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
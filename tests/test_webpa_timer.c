@@ -0,0 +1,258 @@
+/**
+ *  Copyright 2010-2016 Comcast Cable Communications Management, LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../source/include/webpa_adapter.h"
+#include "../source/broadband/include/webpa_timer.h"
+
+/*----------------------------------------------------------------------------*/
+/*                            File Scoped Variables                           */
+/*----------------------------------------------------------------------------*/
+int numLoops = 0;
+static long long fakeNowMs = 5000000;
+static int fired[8];
+static int firedOrder[8];
+static int firedCount = 0;
+static unsigned long rearmId = 0;
+static pthread_mutex_t workMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workCond = PTHREAD_COND_INITIALIZER;
+static int workStarted = 0;
+static int workReleased = 0;
+static int workDone = 0;
+
+/*----------------------------------------------------------------------------*/
+/*                                   Mocks                                    */
+/*----------------------------------------------------------------------------*/
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+    (void) clk_id;
+    tp->tv_sec = fakeNowMs / 1000;
+    tp->tv_nsec = (fakeNowMs % 1000) * 1000000;
+    return 0;
+}
+
+static void timerFired(void *arg)
+{
+    int index = *(int *) arg;
+
+    fired[index]++;
+    if(firedCount < 8)
+    {
+        firedOrder[firedCount] = index;
+    }
+    firedCount++;
+}
+
+static void rearmFired(void *arg)
+{
+    fired[0]++;
+    if(fired[0] < 3)
+    {
+        rearmId = scheduleWebpaTimer(1000, 0, rearmFired, arg);
+    }
+}
+
+/* Blocks like a D-Bus call until the test releases it */
+static void blockingWork(void *arg)
+{
+    (void) arg;
+    pthread_mutex_lock(&workMutex);
+    workStarted = 1;
+    pthread_cond_broadcast(&workCond);
+    while(!workReleased)
+    {
+        pthread_cond_wait(&workCond, &workMutex);
+    }
+    workDone = 1;
+    pthread_cond_broadcast(&workCond);
+    pthread_mutex_unlock(&workMutex);
+}
+
+static void resetFired()
+{
+    memset(fired, 0, sizeof(fired));
+    memset(firedOrder, 0, sizeof(firedOrder));
+    firedCount = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*                                   Tests                                    */
+/*----------------------------------------------------------------------------*/
+void test_webpaTimerFiresInOrder()
+{
+    int ids[3] = {0, 1, 2};
+
+    resetFired();
+    assert_true(scheduleWebpaTimer(500, 0, timerFired, &ids[2]) > 0);
+    assert_true(scheduleWebpaTimer(100, 0, timerFired, &ids[0]) > 0);
+    assert_true(scheduleWebpaTimer(250, 0, timerFired, &ids[1]) > 0);
+
+    assert_int_equal(0, runWebpaTimers());
+    fakeNowMs += 99;
+    assert_int_equal(0, runWebpaTimers());
+    fakeNowMs += 1;
+    assert_int_equal(1, runWebpaTimers());
+    // delays are rounded up to the tick, 250 ms fires on the 300 ms tick
+    fakeNowMs += 150;
+    assert_int_equal(0, runWebpaTimers());
+    fakeNowMs += 250;
+    assert_int_equal(2, runWebpaTimers());
+    assert_int_equal(3, firedCount);
+    assert_int_equal(0, firedOrder[0]);
+    assert_int_equal(1, firedOrder[1]);
+    assert_int_equal(2, firedOrder[2]);
+}
+
+void test_webpaTimerCascadesLongDelays()
+{
+    // one per level and one past the top level
+    unsigned long delays[5] = {6000, 400000, 7200000, 1000000000UL, 2000000000UL};
+    int ids[5] = {0, 1, 2, 3, 4};
+    long long start = 0;
+    int i = 0;
+
+    resetFired();
+    start = fakeNowMs;
+    for(i = 0; i < 5; i++)
+    {
+        assert_true(scheduleWebpaTimer(delays[i], 0, timerFired, &ids[i]) > 0);
+    }
+    for(i = 0; i < 5; i++)
+    {
+        fakeNowMs = start + delays[i] - WEBPA_TIMER_TICK_MSEC;
+        runWebpaTimers();
+        assert_int_equal(0, fired[i]);
+        fakeNowMs = start + delays[i];
+        runWebpaTimers();
+        assert_int_equal(1, fired[i]);
+        assert_int_equal(i + 1, firedCount);
+    }
+}
+
+void test_webpaTimerCancelAndRearm()
+{
+    WebpaTimerStats before, after;
+    int ids[2] = {0, 1};
+    unsigned long id = 0;
+
+    resetFired();
+    getWebpaTimerStats(&before);
+    id = scheduleWebpaTimer(300, 0, timerFired, &ids[1]);
+    assert_int_equal(0, cancelWebpaTimer(id));
+    assert_int_equal(-1, cancelWebpaTimer(id));
+    assert_int_equal(-1, cancelWebpaTimer(0));
+
+    // a callback may schedule the next run of itself
+    rearmId = scheduleWebpaTimer(1000, 0, rearmFired, NULL);
+    fakeNowMs += 1000;
+    assert_int_equal(1, runWebpaTimers());
+    fakeNowMs += 1000;
+    assert_int_equal(1, runWebpaTimers());
+    fakeNowMs += 1000;
+    assert_int_equal(1, runWebpaTimers());
+    assert_int_equal(3, fired[0]);
+    assert_int_equal(0, fired[1]);
+    assert_int_equal(-1, cancelWebpaTimer(rearmId));
+
+    getWebpaTimerStats(&after);
+    assert_int_equal(before.pendingCount, after.pendingCount);
+    assert_int_equal(before.cancelledCount + 1, after.cancelledCount);
+    assert_int_equal(before.firedCount + 3, after.firedCount);
+}
+
+void test_webpaTimerJitter()
+{
+    int ids[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int i = 0;
+
+    resetFired();
+    for(i = 0; i < 8; i++)
+    {
+        assert_true(scheduleWebpaTimer(1000, 2000, timerFired, &ids[i]) > 0);
+    }
+    fakeNowMs += 999;
+    assert_int_equal(0, runWebpaTimers());
+    fakeNowMs += 2001;
+    assert_int_equal(8, runWebpaTimers());
+}
+
+void test_webpaTimerWorkDoesNotBlockTimers()
+{
+    WebpaTimerStats stats;
+    int ids[1] = {0};
+
+    resetFired();
+    // the work thread is started by the first work and runs it once
+    numLoops = 1;
+    assert_true(scheduleWebpaWork(100, 0, blockingWork, NULL) > 0);
+    fakeNowMs += 100;
+    // handed to the work thread, the timers keep running while it blocks
+    assert_int_equal(1, runWebpaTimers());
+    pthread_mutex_lock(&workMutex);
+    while(!workStarted)
+    {
+        pthread_cond_wait(&workCond, &workMutex);
+    }
+    pthread_mutex_unlock(&workMutex);
+
+    assert_true(scheduleWebpaTimer(100, 0, timerFired, &ids[0]) > 0);
+    fakeNowMs += 100;
+    assert_int_equal(1, runWebpaTimers());
+    assert_int_equal(1, fired[0]);
+    getWebpaTimerStats(&stats);
+    assert_int_equal(0, stats.workPendingCount);
+
+    pthread_mutex_lock(&workMutex);
+    workReleased = 1;
+    pthread_cond_broadcast(&workCond);
+    while(!workDone)
+    {
+        pthread_cond_wait(&workCond, &workMutex);
+    }
+    pthread_mutex_unlock(&workMutex);
+}
+
+void err_webpaTimerNoCallback()
+{
+    assert_int_equal(0, scheduleWebpaTimer(100, 0, NULL, NULL));
+    assert_int_equal(0, scheduleWebpaWork(100, 0, NULL, NULL));
+}
+
+/*----------------------------------------------------------------------------*/
+/*                             External Functions                             */
+/*----------------------------------------------------------------------------*/
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_webpaTimerFiresInOrder),
+        cmocka_unit_test(test_webpaTimerCascadesLongDelays),
+        cmocka_unit_test(test_webpaTimerCancelAndRearm),
+        cmocka_unit_test(test_webpaTimerJitter),
+        cmocka_unit_test(test_webpaTimerWorkDoesNotBlockTimers),
+        cmocka_unit_test(err_webpaTimerNoCallback)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}